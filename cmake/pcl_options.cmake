@@ -34,6 +34,10 @@ mark_as_advanced(PCL_ONLY_CORE_POINT_TYPES)
 option(PCL_NO_PRECOMPILE "Do not precompile PCL code for any point types at all." OFF)
 mark_as_advanced(PCL_NO_PRECOMPILE)
 
+# Compile the PCL_TRACE_* instrumentation of pcl/common/trace.h into PCL and its users
+option(PCL_ENABLE_TRACING "Record scoped zones and counters of the major processing stages for pcl::trace." OFF)
+mark_as_advanced(PCL_ENABLE_TRACING)
+
 # Enable or Disable the check for SSE optimizations
 option(PCL_ENABLE_SSE "Enable or Disable SSE optimizations." ON)
 mark_as_advanced(PCL_ENABLE_SSE)
@@ -43,6 +43,7 @@
 #include <pcl/point_traits.h>
 #include <pcl/PointIndices.h>
 #include <pcl/cloud_iterator.h>
+#include <pcl/point_cloud_soa.h>
 
 /**
   * \file pcl/common/centroid.h
@@ -105,6 +106,32 @@ namespace pcl
     return (compute3DCentroid <PointT, double> (cloud, centroid));
   }
 
+  /** \brief Compute the 3D (X-Y-Z) centroid of a structure-of-arrays point cloud and return it as a 3D vector.
+    * \param[in] cloud the input point cloud
+    * \param[out] centroid the output centroid
+    * \return number of valid point used to determine the centroid. In case of dense point clouds, this is the same as the size of input cloud.
+    * \note if return value is 0, the centroid is not changed, thus not valid.
+    * The last compononent of the vector is set to 1, this allow to transform the centroid vector with 4x4 matrices.
+    * \ingroup common
+    */
+  template <typename PointT, typename Scalar> inline unsigned int
+  compute3DCentroid (const pcl::PointCloudSoA<PointT> &cloud, 
+                     Eigen::Matrix<Scalar, 4, 1> &centroid);
+
+  template <typename PointT> inline unsigned int
+  compute3DCentroid (const pcl::PointCloudSoA<PointT> &cloud, 
+                     Eigen::Vector4f &centroid)
+  {
+    return (compute3DCentroid <PointT, float> (cloud, centroid));
+  }
+
+  template <typename PointT> inline unsigned int
+  compute3DCentroid (const pcl::PointCloudSoA<PointT> &cloud, 
+                     Eigen::Vector4d &centroid)
+  {
+    return (compute3DCentroid <PointT, double> (cloud, centroid));
+  }
+
   /** \brief Compute the 3D (X-Y-Z) centroid of a set of points using their indices and
     * return it as a 3D vector.
     * \param[in] cloud the input point cloud
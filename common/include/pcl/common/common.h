@@ -39,6 +39,7 @@
 #define PCL_COMMON_H_
 
 #include <pcl/pcl_base.h>
+#include <pcl/point_cloud_soa.h>
 #include <cfloat>
 
 /**
@@ -152,6 +153,17 @@ namespace pcl
   getMinMax3D (const pcl::PointCloud<PointT> &cloud, const pcl::PointIndices &indices, 
                Eigen::Vector4f &min_pt, Eigen::Vector4f &max_pt);
 
+  /** \brief Get the minimum and maximum values on each of the 3 (x-y-z) dimensions in a given
+    * structure-of-arrays pointcloud
+    * \param cloud the point cloud data
+    * \param min_pt the resultant minimum bounds (the fourth coordinate is set to 1)
+    * \param max_pt the resultant maximum bounds (the fourth coordinate is set to 1)
+    * \ingroup common
+    */
+  template <typename PointT> inline void 
+  getMinMax3D (const pcl::PointCloudSoA<PointT> &cloud, 
+               Eigen::Vector4f &min_pt, Eigen::Vector4f &max_pt);
+
   /** \brief Compute the radius of a circumscribed circle for a triangle formed of three points pa, pb, and pc
     * \param pa the first point
     * \param pb the second point
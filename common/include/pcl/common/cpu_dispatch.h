@@ -0,0 +1,194 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef PCL_COMMON_CPU_DISPATCH_H_
+#define PCL_COMMON_CPU_DISPATCH_H_
+
+#include <pcl/pcl_macros.h>
+#include <string>
+
+/** \file cpu_dispatch.h
+  * Runtime selection between several instruction set builds of the same kernel.
+  *
+  * A kernel is compiled once per instruction set level, the variants above the build
+  * baseline being marked with PCL_TARGET_AVX2 / PCL_TARGET_AVX512, and registered with a
+  * pcl::CpuDispatcher. The dispatcher returns the best variant the CPU supports, capped by
+  * the PCL_CPU_ISA environment variable (generic, sse2, sse4.2, avx2 or avx512) or by
+  * pcl::setDispatchCpuIsa (), which is what tests and benchmarks use to compare variants.
+  */
+
+// Function level target attributes, so that a baseline build can still carry AVX kernels
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) && \
+    (defined(__clang__) || (__GNUC__ >= 6))
+  #define PCL_CPU_DISPATCH_X86 1
+  #define PCL_TARGET_SSE4_2 __attribute__ ((target ("sse4.2")))
+  #define PCL_TARGET_AVX2 __attribute__ ((target ("avx2,fma")))
+  #define PCL_TARGET_AVX512 __attribute__ ((target ("avx512f,avx512vl,avx512bw,avx512dq,avx2,fma")))
+
+  // Region versions, for templates: every function defined between PCL_TARGET_*_BEGIN and
+  // PCL_TARGET_END, including template instantiations, is compiled for that target
+  #if defined(__clang__)
+    #define PCL_TARGET_AVX2_BEGIN \
+      _Pragma ("clang attribute push (__attribute__ ((target (\"avx2,fma\"))), apply_to = function)")
+    #define PCL_TARGET_AVX512_BEGIN \
+      _Pragma ("clang attribute push (__attribute__ ((target (\"avx512f,avx512vl,avx512bw,avx512dq,avx2,fma\"))), apply_to = function)")
+    #define PCL_TARGET_END _Pragma ("clang attribute pop")
+  #else
+    #define PCL_TARGET_AVX2_BEGIN _Pragma ("GCC push_options") _Pragma ("GCC target (\"avx2,fma\")")
+    #define PCL_TARGET_AVX512_BEGIN \
+      _Pragma ("GCC push_options") _Pragma ("GCC target (\"avx512f,avx512vl,avx512bw,avx512dq,avx2,fma\")")
+    #define PCL_TARGET_END _Pragma ("GCC pop_options")
+  #endif
+#endif
+
+namespace pcl
+{
+  /** \brief Instruction set levels, in increasing order. Each level implies the ones below it.
+    * \ingroup common
+    */
+  enum CpuIsa
+  {
+    /** \brief Portable C++. */
+    CPU_ISA_GENERIC = 0,
+    /** \brief SSE2, the x86-64 baseline. */
+    CPU_ISA_SSE2 = 1,
+    /** \brief Up to SSE4.2. */
+    CPU_ISA_SSE4_2 = 2,
+    /** \brief AVX2 and FMA (Haswell and later). */
+    CPU_ISA_AVX2 = 3,
+    /** \brief AVX-512 F, VL, BW and DQ (Skylake-SP and later). */
+    CPU_ISA_AVX512 = 4,
+    /** \brief The number of levels. */
+    CPU_ISA_COUNT = 5
+  };
+
+  /** \brief Get the highest instruction set level supported by this CPU and operating system,
+    * among the levels this library was built with kernels for. Detected once.
+    * \ingroup common
+    */
+  PCL_EXPORTS CpuIsa
+  getHostCpuIsa ();
+
+  /** \brief Get the instruction set level dispatched kernels are currently limited to. This is
+    * the host level, capped by the PCL_CPU_ISA environment variable or by setDispatchCpuIsa ().
+    * \ingroup common
+    */
+  PCL_EXPORTS CpuIsa
+  getDispatchCpuIsa ();
+
+  /** \brief Limit dispatched kernels to \a isa. Levels above the host level are clamped to it.
+    * Not thread safe with respect to kernels running concurrently; meant for tests and benchmarks.
+    * \param[in] isa the highest level to use
+    * \ingroup common
+    */
+  PCL_EXPORTS void
+  setDispatchCpuIsa (CpuIsa isa);
+
+  /** \brief Get the lower case name of \a isa, as accepted by PCL_CPU_ISA. */
+  PCL_EXPORTS const char*
+  getCpuIsaName (CpuIsa isa);
+
+  /** \brief Parse an instruction set level name (case insensitive).
+    * \param[in] name the name, e.g. "avx2"
+    * \param[out] isa the parsed level
+    * \return false if \a name is not a known level
+    */
+  PCL_EXPORTS bool
+  parseCpuIsa (const std::string &name, CpuIsa &isa);
+
+  /** \brief Table of the instruction set variants of one kernel.
+    *
+    * \code
+    * static const pcl::CpuDispatcher<KernelFn> dispatcher =
+    *   pcl::CpuDispatcher<KernelFn> (&kernelGeneric).add (pcl::CPU_ISA_AVX2, &kernelAVX2);
+    * dispatcher.get () (args...);
+    * \endcode
+    * \ingroup common
+    */
+  template <typename FunctionT>
+  class CpuDispatcher
+  {
+    public:
+      /** \brief Constructor.
+        * \param[in] generic the portable variant, used when nothing better is registered
+        */
+      explicit CpuDispatcher (FunctionT generic)
+      {
+        for (int i = 0; i < CPU_ISA_COUNT; ++i)
+          functions_[i] = 0;
+        functions_[CPU_ISA_GENERIC] = generic;
+      }
+
+      /** \brief Register the variant built for \a isa. */
+      inline CpuDispatcher&
+      add (CpuIsa isa, FunctionT function)
+      {
+        functions_[isa] = function;
+        return (*this);
+      }
+
+      /** \brief Get the level of the variant get () returns for a limit of \a isa (clamped to the host). */
+      inline CpuIsa
+      resolve (CpuIsa isa) const
+      {
+        int level = isa < getHostCpuIsa () ? isa : getHostCpuIsa ();
+        while (level > CPU_ISA_GENERIC && !functions_[level])
+          --level;
+        return (static_cast<CpuIsa> (level));
+      }
+
+      /** \brief Get the best variant allowed by getDispatchCpuIsa (). */
+      inline FunctionT
+      get () const
+      {
+        return (functions_[resolve (getDispatchCpuIsa ())]);
+      }
+
+      /** \brief Get the best variant for a limit of \a isa (clamped to the host). */
+      inline FunctionT
+      get (CpuIsa isa) const
+      {
+        return (functions_[resolve (isa)]);
+      }
+
+    private:
+      FunctionT functions_[CPU_ISA_COUNT];
+  };
+}
+
+#endif  // PCL_COMMON_CPU_DISPATCH_H_
@@ -135,6 +135,32 @@ namespace pcl
   template <typename Matrix, typename Vector> void
   eigen33 (const Matrix &mat, Matrix &evecs, Vector &evals);
 
+  /** \brief determines the smallest eigenvalue and its eigenvector for each of \a n symmetric positive semi
+    * definite input matrices, as eigen33 (mat, eigenvalue, eigenvector) does for one matrix.
+    *
+    * The matrices are solved several at a time in SIMD lanes (4 with SSE2, 8 with AVX2, 16 with AVX-512,
+    * see pcl::getDispatchCpuIsa ()); the generic build calls eigen33 on each matrix. Results agree with
+    * eigen33 up to float rounding, and an eigenvector may have the opposite sign.
+    * \param[in] matrices \a n symmetric positive semi definite input matrices
+    * \param[in] n the number of matrices
+    * \param[out] eigenvalues the \a n smallest eigenvalues
+    * \param[out] eigenvectors the \a n corresponding unit eigenvectors
+    * \ingroup common
+    */
+  PCL_EXPORTS void
+  eigen33 (const Eigen::Matrix3f *matrices, size_t n, float *eigenvalues, Eigen::Vector3f *eigenvectors);
+
+  /** \brief determines the eigenvalues and eigenvectors of each of \a n symmetric positive semi definite
+    * input matrices, as eigen33 (mat, evecs, evals) does for one matrix. Batched like the overload above.
+    * \param[in] matrices \a n symmetric positive semi definite input matrices
+    * \param[in] n the number of matrices
+    * \param[out] evecs the \a n eigenvector matrices, one eigenvector per column
+    * \param[out] evals the \a n eigenvalue triplets, in ascending order
+    * \ingroup common
+    */
+  PCL_EXPORTS void
+  eigen33 (const Eigen::Matrix3f *matrices, size_t n, Eigen::Matrix3f *evecs, Eigen::Vector3f *evals);
+
   /** \brief Calculate the inverse of a 2x2 matrix
     * \param[in] matrix matrix to be inverted
     * \param[out] inverse the resultant inverted matrix
@@ -0,0 +1,305 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#ifndef PCL_COMMON_FRAME_ARENA_H_
+#define PCL_COMMON_FRAME_ARENA_H_
+
+#include <pcl/pcl_base.h>
+#include <boost/noncopyable.hpp>
+#include <map>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+/** \file frame_arena.h
+  * Recycling of the point clouds and index lists a processing pipeline creates every frame.
+  *
+  * A pcl::FrameArena hands out clouds and indices that are returned to it when the last
+  * shared pointer to them goes away, and hands them out again, emptied but with their capacity,
+  * to the next request of the same type. Once a pipeline has seen its largest frame, its stages
+  * write into buffers that are already large enough and run without heap allocations for them:
+  *
+  * \code
+  * pcl::FrameArena &arena = pcl::FrameArena::getThreadArena ();
+  * while (grabFrame (input))
+  * {
+  *   arena.beginFrame ();
+  *   pcl::PointCloud<pcl::PointXYZ>::Ptr filtered = arena.acquireCloud<pcl::PointXYZ> ();
+  *   {
+  *     pcl::FrameArena::ScopedStage stage (arena, "voxel grid");
+  *     grid.setInputCloud (input);
+  *     grid.filter (*filtered);
+  *   }
+  *   ...
+  * }
+  * \endcode
+  *
+  * The arena also reports, per named stage, the bytes its buffers had to allocate, which drops
+  * to zero in the steady state. Only the containers of the buffers are recycled; temporaries
+  * that algorithms allocate internally are not covered.
+  */
+
+namespace pcl
+{
+  /** \brief Pool of per-frame point clouds and index buffers, see frame_arena.h.
+    * \note An arena is not thread safe. Every thread gets its own with getThreadArena (), buffers
+    * may however be handed to and released by other threads.
+    * \ingroup common
+    */
+  class PCL_EXPORTS FrameArena : boost::noncopyable
+  {
+    public:
+      /** \brief Buffer usage of one stage since the last resetStatistics (). */
+      struct StageStatistics
+      {
+        StageStatistics () : acquisitions (0), buffers_created (0), bytes_allocated (0) {}
+
+        /** \brief Number of buffers handed out while the stage was active. */
+        size_t acquisitions;
+        /** \brief Number of those that had to be created because no free buffer was left. */
+        size_t buffers_created;
+        /** \brief Bytes allocated for new buffers and by the growth of the handed out ones. */
+        size_t bytes_allocated;
+      };
+
+      typedef std::map<std::string, StageStatistics> StatisticsMap;
+
+      /** \brief Activates a stage for the lifetime of the object and restores the previous one. */
+      class ScopedStage : boost::noncopyable
+      {
+        public:
+          ScopedStage (FrameArena &arena, const std::string &name) :
+            arena_ (arena), previous_ (arena.current_stage_)
+          {
+            arena_.setStage (name);
+          }
+
+          ~ScopedStage ()
+          {
+            arena_.accountGrowth ();
+            arena_.current_stage_ = previous_;
+          }
+
+        private:
+          FrameArena &arena_;
+          StatisticsMap::iterator previous_;
+      };
+
+      /** \brief Create an empty arena, with the stage "default" active. */
+      FrameArena ();
+
+      /** \brief The arena of the calling thread, created on first use and destroyed with the thread. */
+      static FrameArena&
+      getThreadArena ();
+
+      /** \brief Get an empty cloud, recycling one that is no longer referenced if possible.
+        * The header, the sensor pose and is_dense are reset, the capacity of the points is kept.
+        */
+      template <typename PointT> typename PointCloud<PointT>::Ptr
+      acquireCloud ()
+      {
+        return (acquire<PointCloud<PointT> > ());
+      }
+
+      /** \brief Get an empty index list, recycling one that is no longer referenced if possible. */
+      IndicesPtr
+      acquireIndices ()
+      {
+        return (acquire<std::vector<int> > ());
+      }
+
+      /** \brief Get empty point indices, recycling ones that are no longer referenced if possible. */
+      PointIndices::Ptr
+      acquirePointIndices ()
+      {
+        return (acquire<PointIndices> ());
+      }
+
+      /** \brief Mark the start of a new frame: account the growth of the buffers used so far. */
+      void
+      beginFrame ();
+
+      /** \brief Make name the stage to which subsequent acquisitions and buffer growth are attributed. */
+      void
+      setStage (const std::string &name);
+
+      /** \brief The name of the active stage. */
+      const std::string&
+      getStage () const
+      {
+        return (current_stage_->first);
+      }
+
+      /** \brief Usage per stage, including growth of buffers that are still in use. */
+      const StatisticsMap&
+      getStatistics ();
+
+      /** \brief Bytes allocated by all stages since the last resetStatistics (). */
+      size_t
+      getBytesAllocated ();
+
+      /** \brief Clear the statistics of all stages. */
+      void
+      resetStatistics ();
+
+      /** \brief Bytes currently held by the buffers of the arena, in use or not. */
+      size_t
+      getBytesReserved () const;
+
+      /** \brief The number of buffers owned by the arena, in use or not. */
+      size_t
+      getNumberOfBuffers () const
+      {
+        return (buffers_.size ());
+      }
+
+      /** \brief The number of buffers currently referenced outside of the arena. */
+      size_t
+      getNumberOfBuffersInUse () const;
+
+      /** \brief Free the buffers that are not in use, e.g. after an unusually large frame. */
+      void
+      trim ();
+
+    private:
+      friend class ScopedStage;
+
+      /** \brief A recycled object, type-erased so that one arena holds every type. */
+      struct Buffer
+      {
+        boost::shared_ptr<void> object;
+        const std::type_info *type;
+        size_t (*bytes) (const void *object);
+        /** \brief Capacity of the object when it was last accounted. */
+        size_t accounted_bytes;
+      };
+
+      template <typename T> static size_t
+      bytesOf (const void *object)
+      {
+        return (capacityBytes (*static_cast<const T*> (object)));
+      }
+
+      template <typename PointT> static size_t
+      capacityBytes (const PointCloud<PointT> &cloud)
+      {
+        return (sizeof (cloud) + cloud.points.capacity () * sizeof (PointT));
+      }
+
+      static size_t
+      capacityBytes (const std::vector<int> &indices)
+      {
+        return (sizeof (indices) + indices.capacity () * sizeof (int));
+      }
+
+      static size_t
+      capacityBytes (const PointIndices &indices)
+      {
+        return (sizeof (indices) + indices.indices.capacity () * sizeof (int));
+      }
+
+      template <typename PointT> static void
+      clearBuffer (PointCloud<PointT> &cloud)
+      {
+        cloud.clear ();
+        cloud.header.seq = 0;
+        cloud.header.stamp = 0;
+        cloud.header.frame_id.clear ();
+        cloud.is_dense = true;
+        cloud.sensor_origin_.setZero ();
+        cloud.sensor_orientation_.setIdentity ();
+      }
+
+      static void
+      clearBuffer (std::vector<int> &indices)
+      {
+        indices.clear ();
+      }
+
+      static void
+      clearBuffer (PointIndices &indices)
+      {
+        indices.header.seq = 0;
+        indices.header.stamp = 0;
+        indices.header.frame_id.clear ();
+        indices.indices.clear ();
+      }
+
+      template <typename T> boost::shared_ptr<T>
+      acquire ()
+      {
+        Buffer *buffer = findFreeBuffer (typeid (T));
+        if (!buffer)
+        {
+          boost::shared_ptr<T> object (new T);
+          buffer = createBuffer (object, typeid (T), &bytesOf<T>);
+        }
+        else
+          clearBuffer (*static_cast<T*> (buffer->object.get ()));
+        return (boost::static_pointer_cast<T> (buffer->object));
+      }
+
+      /** \brief Account the growth of a free buffer of type and hand it to the active stage.
+        * \return the buffer, or NULL if every buffer of this type is in use
+        */
+      Buffer*
+      findFreeBuffer (const std::type_info &type);
+
+      /** \brief Take ownership of a new object and charge its size to the active stage. */
+      Buffer*
+      createBuffer (const boost::shared_ptr<void> &object, const std::type_info &type,
+                    size_t (*bytes) (const void*));
+
+      /** \brief Charge the growth of buffer since it was last accounted to the active stage. */
+      void
+      accountBuffer (Buffer &buffer) const;
+
+      /** \brief Charge the growth of every buffer to the active stage, done before every stage switch
+        * so that a buffer's growth goes to the stage that was active while it grew.
+        */
+      void
+      accountGrowth ();
+
+      std::vector<Buffer> buffers_;
+      StatisticsMap statistics_;
+      StatisticsMap::iterator current_stage_;
+  };
+}
+
+#endif // PCL_COMMON_FRAME_ARENA_H_
@@ -45,6 +45,326 @@
 #include <pcl/conversions.h>
 #include <boost/mpl/size.hpp>
 
+#ifdef _OPENMP
+#include <omp.h>
+#include <pcl/common/task_scheduler.h>
+#endif
+
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Inputs with at least this many points are reduced in blocks, in double precision and
+      * across OpenMP threads. Smaller inputs (e.g. search neighborhoods) keep the plain loops, so
+      * their results are unchanged.
+      */
+    const size_t centroid_reduction_threshold = 16384;
+
+    /** \brief First and second order sums of a set of points, taken relative to \a shift. */
+    struct CentroidMoments
+    {
+      CentroidMoments () : count (0)
+      {
+        for (int d = 0; d < 3; ++d)
+          shift[d] = sum[d] = 0;
+        for (int d = 0; d < 6; ++d)
+          sqr_sum[d] = 0;
+      }
+
+      /** \brief Reference point subtracted from every point before accumulating. */
+      double shift[3];
+      /** \brief Sum of the shifted x, y, z. */
+      double sum[3];
+      /** \brief Sum of the shifted xx, xy, xz, yy, yz, zz. */
+      double sqr_sum[6];
+      /** \brief The number of points accumulated. */
+      size_t count;
+    };
+
+    /** \brief Number of points whose coordinates are gathered before they are summed, a multiple of 8. */
+    const int centroid_chunk = 128;
+
+    /** \brief Copy the coordinates of points [begin, end) (or of the points they index) into \a x,
+      * \a y and \a z, skipping non-finite points if CheckFinite is set, and pad them with \a pad
+      * to a multiple of 8.
+      * \return the number of points copied, without the padding
+      */
+    template <bool CheckFinite, typename PointT> inline int
+    gatherCentroidChunk (const pcl::PointCloud<PointT> &cloud, const int *indices, size_t begin, size_t end,
+                         const float *pad, float *x, float *y, float *z)
+    {
+      int nr = 0;
+      if (indices)
+      {
+        for (size_t i = begin; i < end; ++i)
+        {
+          const PointT &pt = cloud[indices[i]];
+          if (CheckFinite && !isFinite (pt))
+            continue;
+          x[nr] = pt.x; y[nr] = pt.y; z[nr] = pt.z;
+          ++nr;
+        }
+      }
+      else
+      {
+        for (size_t i = begin; i < end; ++i)
+        {
+          const PointT &pt = cloud[i];
+          if (CheckFinite && !isFinite (pt))
+            continue;
+          x[nr] = pt.x; y[nr] = pt.y; z[nr] = pt.z;
+          ++nr;
+        }
+      }
+      for (int i = nr; i % 8 != 0; ++i)
+      {
+        x[i] = pad[0]; y[i] = pad[1]; z[i] = pad[2];
+      }
+      return (nr);
+    }
+
+    /** \brief Add a point, relative to \a shift, to the float sums \a x, \a y and \a z. */
+    template <bool CheckFinite, typename PointT> inline void
+    addCentroidSum (const PointT &pt, const float *shift, float &x, float &y, float &z, size_t &count)
+    {
+      if (CheckFinite && !isFinite (pt))
+        return;
+      x += pt.x - shift[0]; y += pt.y - shift[1]; z += pt.z - shift[2];
+      ++count;
+    }
+
+    /** \brief First order part of accumulateCentroidBlock, for which gathering the coordinates
+      * costs more than summing them in scalar registers.
+      */
+    template <bool CheckFinite, typename PointT> void
+    accumulateCentroidSums (const pcl::PointCloud<PointT> &cloud, const int *indices,
+                            size_t begin, size_t end, const float *shift, CentroidMoments &moments)
+    {
+      // Two interleaved sets of sums keep the additions independent
+      float x0 = 0, y0 = 0, z0 = 0, x1 = 0, y1 = 0, z1 = 0;
+      size_t count = 0;
+      size_t i = begin;
+      if (indices)
+      {
+        for (; i + 1 < end; i += 2)
+        {
+          addCentroidSum<CheckFinite> (cloud[indices[i]], shift, x0, y0, z0, count);
+          addCentroidSum<CheckFinite> (cloud[indices[i + 1]], shift, x1, y1, z1, count);
+        }
+        if (i < end)
+          addCentroidSum<CheckFinite> (cloud[indices[i]], shift, x0, y0, z0, count);
+      }
+      else
+      {
+        for (; i + 1 < end; i += 2)
+        {
+          addCentroidSum<CheckFinite> (cloud[i], shift, x0, y0, z0, count);
+          addCentroidSum<CheckFinite> (cloud[i + 1], shift, x1, y1, z1, count);
+        }
+        if (i < end)
+          addCentroidSum<CheckFinite> (cloud[i], shift, x0, y0, z0, count);
+      }
+      moments.sum[0] += static_cast<double> (x0) + static_cast<double> (x1);
+      moments.sum[1] += static_cast<double> (y0) + static_cast<double> (y1);
+      moments.sum[2] += static_cast<double> (z0) + static_cast<double> (z1);
+      moments.count += count;
+    }
+
+    /** \brief Accumulate points [begin, end) (or the points they index) into \a moments,
+      * whose shift must be set.
+      *
+      * For the second order sums, the coordinates are gathered in chunks and summed relative to
+      * the shift in eight float lanes, which Eigen keeps in SIMD registers. The float sums are added
+      * to the double precision ones once for the whole range, which the caller keeps to a block of
+      * a few thousand points.
+      */
+    template <bool SecondOrder, bool CheckFinite, typename PointT> void
+    accumulateCentroidBlock (const pcl::PointCloud<PointT> &cloud, const int *indices,
+                             size_t begin, size_t end, CentroidMoments &moments)
+    {
+      typedef Eigen::Array<float, 8, 1> Lanes;
+      typedef Eigen::Map<const Lanes, Eigen::Aligned> LanesMap;
+      const float shift[3] = { static_cast<float> (moments.shift[0]), static_cast<float> (moments.shift[1]),
+                               static_cast<float> (moments.shift[2]) };
+      if (!SecondOrder)
+        return (accumulateCentroidSums<CheckFinite> (cloud, indices, begin, end, shift, moments));
+
+      const Lanes shift_x = Lanes::Constant (shift[0]), shift_y = Lanes::Constant (shift[1]),
+                  shift_z = Lanes::Constant (shift[2]);
+      EIGEN_ALIGN16 float x[centroid_chunk], y[centroid_chunk], z[centroid_chunk];
+      Lanes sum_x = Lanes::Zero (), sum_y = Lanes::Zero (), sum_z = Lanes::Zero ();
+      Lanes sum_xx = Lanes::Zero (), sum_xy = Lanes::Zero (), sum_xz = Lanes::Zero ();
+      Lanes sum_yy = Lanes::Zero (), sum_yz = Lanes::Zero (), sum_zz = Lanes::Zero ();
+      for (size_t start = begin; start < end; start += centroid_chunk)
+      {
+        // Padding with the shift itself adds zeros to every sum
+        const int nr = gatherCentroidChunk<CheckFinite> (cloud, indices, start, std::min (start + centroid_chunk, end),
+                                                         shift, x, y, z);
+        moments.count += nr;
+        for (int i = 0; i < nr; i += 8)
+        {
+          const Lanes dx = LanesMap (x + i) - shift_x, dy = LanesMap (y + i) - shift_y, dz = LanesMap (z + i) - shift_z;
+          sum_x += dx; sum_y += dy; sum_z += dz;
+          sum_xx += dx * dx; sum_xy += dx * dy; sum_xz += dx * dz;
+          sum_yy += dy * dy; sum_yz += dy * dz; sum_zz += dz * dz;
+        }
+      }
+
+      moments.sum[0] += sum_x.cast<double> ().sum ();
+      moments.sum[1] += sum_y.cast<double> ().sum ();
+      moments.sum[2] += sum_z.cast<double> ().sum ();
+      moments.sqr_sum[0] += sum_xx.cast<double> ().sum ();
+      moments.sqr_sum[1] += sum_xy.cast<double> ().sum ();
+      moments.sqr_sum[2] += sum_xz.cast<double> ().sum ();
+      moments.sqr_sum[3] += sum_yy.cast<double> ().sum ();
+      moments.sqr_sum[4] += sum_yz.cast<double> ().sum ();
+      moments.sqr_sum[5] += sum_zz.cast<double> ().sum ();
+    }
+
+    /** \brief Express the sums of \a moments relative to \a shift instead of moments.shift. */
+    inline void
+    shiftCentroidMoments (const double *shift, CentroidMoments &moments)
+    {
+      // With d' = d + delta: sum (d'_a) = sum (d_a) + n delta_a and
+      // sum (d'_a d'_b) = sum (d_a d_b) + delta_a sum (d_b) + delta_b sum (d_a) + n delta_a delta_b
+      const double n = static_cast<double> (moments.count);
+      double delta[3];
+      for (int d = 0; d < 3; ++d)
+        delta[d] = moments.shift[d] - shift[d];
+      const int pairs[6][2] = { {0, 0}, {0, 1}, {0, 2}, {1, 1}, {1, 2}, {2, 2} };
+      for (int k = 0; k < 6; ++k)
+      {
+        const int a = pairs[k][0], b = pairs[k][1];
+        moments.sqr_sum[k] += delta[a] * moments.sum[b] + delta[b] * moments.sum[a] + n * delta[a] * delta[b];
+      }
+      for (int d = 0; d < 3; ++d)
+      {
+        moments.sum[d] += n * delta[d];
+        moments.shift[d] = shift[d];
+      }
+    }
+
+    /** \brief Accumulate the moments of points [0, n) of \a cloud, or of cloud[indices[i]] if
+      * \a indices is not NULL, for large inputs.
+      *
+      * Sums are taken relative to a shift (the given one, or else the first finite point), which
+      * avoids the cancellation of E[xx] - E[x]E[x] for clouds far away from the origin. Each block
+      * of 4096 points is summed in float and added to the sums, which are kept in double.
+      * Blocks are summed independently and merged in a fixed order, so the result does not depend
+      * on the number of threads. They are only spread over OpenMP threads if the caller is neither
+      * inside an OpenMP parallel region nor running a task of pcl::TaskScheduler.
+      * \param[in] cloud the input cloud
+      * \param[in] indices optional indices into \a cloud
+      * \param[in] n the number of points (or indices)
+      * \param[in] check_finite whether to skip points with non-finite coordinates
+      * \param[in] second_order whether to accumulate the second order sums as well
+      * \param[in] shift the reference point, or NULL to pick the first finite point
+      * \param[out] moments the accumulated moments
+      * \return false if \a n is below centroid_reduction_threshold, in which case nothing was done
+      */
+    template <typename PointT> bool
+    computeCentroidMoments (const pcl::PointCloud<PointT> &cloud, const int *indices, size_t n,
+                            bool check_finite, bool second_order, const double *shift,
+                            CentroidMoments &moments)
+    {
+      if (n < centroid_reduction_threshold)
+        return (false);
+
+      // The blocks sum in float relative to a float shift, a given shift is restored at the end
+      moments = CentroidMoments ();
+      if (shift)
+      {
+        for (int d = 0; d < 3; ++d)
+          moments.shift[d] = static_cast<float> (shift[d]);
+      }
+      else
+      {
+        for (size_t i = 0; i < n; ++i)
+        {
+          const PointT &pt = cloud[indices ? indices[i] : i];
+          if (check_finite && !isFinite (pt))
+            continue;
+          moments.shift[0] = pt.x; moments.shift[1] = pt.y; moments.shift[2] = pt.z;
+          break;
+        }
+      }
+
+      void (*accumulate) (const pcl::PointCloud<PointT>&, const int*, size_t, size_t, CentroidMoments&);
+      if (second_order)
+        accumulate = check_finite ? &accumulateCentroidBlock<true, true, PointT> : &accumulateCentroidBlock<true, false, PointT>;
+      else
+        accumulate = check_finite ? &accumulateCentroidBlock<false, true, PointT> : &accumulateCentroidBlock<false, false, PointT>;
+
+      const size_t block = 4096;
+      const int nr_blocks = static_cast<int> ((n + block - 1) / block);
+      std::vector<CentroidMoments> partial (nr_blocks, moments);
+#ifdef _OPENMP
+      // Stay on the calling thread if it is one of many already, e.g. a task of the scheduler
+      const bool split = !omp_in_parallel () && !pcl::TaskScheduler::inTask ();
+#pragma omp parallel for schedule(static) if (split)
+#endif
+      for (int b = 0; b < nr_blocks; ++b)
+      {
+        const size_t begin = static_cast<size_t> (b) * block;
+        accumulate (cloud, indices, begin, std::min (begin + block, n), partial[b]);
+      }
+
+      for (int b = 0; b < nr_blocks; ++b)
+      {
+        for (int d = 0; d < 3; ++d)
+          moments.sum[d] += partial[b].sum[d];
+        for (int d = 0; d < 6; ++d)
+          moments.sqr_sum[d] += partial[b].sqr_sum[d];
+        moments.count += partial[b].count;
+      }
+      if (shift)
+        shiftCentroidMoments (shift, moments);
+      return (true);
+    }
+
+    /** \brief Write the centroid held by \a moments (NaN if no point was accumulated). */
+    template <typename Scalar> inline void
+    getMomentsCentroid (const CentroidMoments &moments, Eigen::Matrix<Scalar, 4, 1> &centroid)
+    {
+      const double count = static_cast<double> (moments.count);
+      for (int d = 0; d < 3; ++d)
+        centroid[d] = static_cast<Scalar> (moments.shift[d] + moments.sum[d] / count);
+      centroid[3] = 1;
+    }
+
+    /** \brief Write the symmetric matrix of the six sums in \a sqr_sum, scaled by \a scale. */
+    template <typename Scalar> inline void
+    setSymmetric3x3 (const double *sqr_sum, double scale, Eigen::Matrix<Scalar, 3, 3> &matrix)
+    {
+      matrix.coeffRef (0) = static_cast<Scalar> (sqr_sum[0] * scale);
+      matrix.coeffRef (1) = matrix.coeffRef (3) = static_cast<Scalar> (sqr_sum[1] * scale);
+      matrix.coeffRef (2) = matrix.coeffRef (6) = static_cast<Scalar> (sqr_sum[2] * scale);
+      matrix.coeffRef (4) = static_cast<Scalar> (sqr_sum[3] * scale);
+      matrix.coeffRef (5) = matrix.coeffRef (7) = static_cast<Scalar> (sqr_sum[4] * scale);
+      matrix.coeffRef (8) = static_cast<Scalar> (sqr_sum[5] * scale);
+    }
+
+    /** \brief Write the centroid and the normalized covariance matrix held by \a moments. */
+    template <typename Scalar> inline void
+    getMomentsMeanAndCovariance (const CentroidMoments &moments, Eigen::Matrix<Scalar, 3, 3> &covariance_matrix,
+                                 Eigen::Matrix<Scalar, 4, 1> &centroid)
+    {
+      getMomentsCentroid (moments, centroid);
+      // Covariance of the shifted points, which is the covariance of the points
+      const double count = static_cast<double> (moments.count);
+      const double *s = moments.sum;
+      double centered[6];
+      centered[0] = moments.sqr_sum[0] - s[0] * s[0] / count;
+      centered[1] = moments.sqr_sum[1] - s[0] * s[1] / count;
+      centered[2] = moments.sqr_sum[2] - s[0] * s[2] / count;
+      centered[3] = moments.sqr_sum[3] - s[1] * s[1] / count;
+      centered[4] = moments.sqr_sum[4] - s[1] * s[2] / count;
+      centered[5] = moments.sqr_sum[5] - s[2] * s[2] / count;
+      setSymmetric3x3 (centered, 1.0 / count, covariance_matrix);
+    }
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT, typename Scalar> inline unsigned int
 pcl::compute3DCentroid (ConstCloudIterator<PointT> &cloud_iterator,
@@ -82,6 +402,13 @@ pcl::compute3DCentroid (const pcl::PointCloud<PointT> &cloud,
   if (cloud.empty ())
     return (0);
 
+  detail::CentroidMoments moments;
+  if (detail::computeCentroidMoments (cloud, NULL, cloud.size (), !cloud.is_dense, false, NULL, moments))
+  {
+    detail::getMomentsCentroid (moments, centroid);
+    return (static_cast<unsigned int> (moments.count));
+  }
+
   // Initialize to 0
   centroid.setZero ();
   // For each point in the cloud
@@ -121,6 +448,50 @@ pcl::compute3DCentroid (const pcl::PointCloud<PointT> &cloud,
   }
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename Scalar> inline unsigned int
+pcl::compute3DCentroid (const pcl::PointCloudSoA<PointT> &cloud, 
+                        Eigen::Matrix<Scalar, 4, 1> &centroid)
+{
+  if (cloud.empty ())
+    return (0);
+
+  const float *x = cloud.x (), *y = cloud.y (), *z = cloud.z ();
+  const size_t n = cloud.size ();
+  Scalar sum_x = 0, sum_y = 0, sum_z = 0;
+  unsigned cp = 0;
+
+  // If the data is dense, we don't need to check for NaN
+  if (cloud.is_dense)
+  {
+    for (size_t i = 0; i < n; ++i)
+    {
+      sum_x += x[i];
+      sum_y += y[i];
+      sum_z += z[i];
+    }
+    cp = static_cast<unsigned> (n);
+  }
+  // NaN or Inf values could exist => check for them
+  else
+  {
+    for (size_t i = 0; i < n; ++i)
+    {
+      if (!pcl_isfinite (x[i]) || !pcl_isfinite (y[i]) || !pcl_isfinite (z[i]))
+        continue;
+      sum_x += x[i];
+      sum_y += y[i];
+      sum_z += z[i];
+      ++cp;
+    }
+  }
+  centroid[0] = sum_x / static_cast<Scalar> (cp);
+  centroid[1] = sum_y / static_cast<Scalar> (cp);
+  centroid[2] = sum_z / static_cast<Scalar> (cp);
+  centroid[3] = 1;
+  return (cp);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT, typename Scalar> inline unsigned int
 pcl::compute3DCentroid (const pcl::PointCloud<PointT> &cloud, 
@@ -130,6 +501,13 @@ pcl::compute3DCentroid (const pcl::PointCloud<PointT> &cloud,
   if (indices.empty ())
     return (0);
 
+  detail::CentroidMoments moments;
+  if (detail::computeCentroidMoments (cloud, &indices[0], indices.size (), !cloud.is_dense, false, NULL, moments))
+  {
+    detail::getMomentsCentroid (moments, centroid);
+    return (static_cast<unsigned int> (moments.count));
+  }
+
   // Initialize to 0
   centroid.setZero ();
   // If the data is dense, we don't need to check for NaN
@@ -184,6 +562,14 @@ pcl::computeCovarianceMatrix (const pcl::PointCloud<PointT> &cloud,
   if (cloud.empty ())
     return (0);
 
+  const double shift[3] = { centroid[0], centroid[1], centroid[2] };
+  detail::CentroidMoments moments;
+  if (detail::computeCentroidMoments (cloud, NULL, cloud.size (), !cloud.is_dense, true, shift, moments))
+  {
+    detail::setSymmetric3x3 (moments.sqr_sum, 1.0, covariance_matrix);
+    return (static_cast<unsigned int> (moments.count));
+  }
+
   // Initialize to 0
   covariance_matrix.setZero ();
 
@@ -268,6 +654,14 @@ pcl::computeCovarianceMatrix (const pcl::PointCloud<PointT> &cloud,
   if (indices.empty ())
     return (0);
 
+  const double shift[3] = { centroid[0], centroid[1], centroid[2] };
+  detail::CentroidMoments moments;
+  if (detail::computeCentroidMoments (cloud, &indices[0], indices.size (), !cloud.is_dense, true, shift, moments))
+  {
+    detail::setSymmetric3x3 (moments.sqr_sum, 1.0, covariance_matrix);
+    return (static_cast<unsigned int> (moments.count));
+  }
+
   // Initialize to 0
   covariance_matrix.setZero ();
 
@@ -490,6 +884,14 @@ pcl::computeMeanAndCovarianceMatrix (const pcl::PointCloud<PointT> &cloud,
                                      Eigen::Matrix<Scalar, 3, 3> &covariance_matrix,
                                      Eigen::Matrix<Scalar, 4, 1> &centroid)
 {
+  detail::CentroidMoments moments;
+  if (detail::computeCentroidMoments (cloud, NULL, cloud.size (), !cloud.is_dense, true, NULL, moments))
+  {
+    if (moments.count != 0)
+      detail::getMomentsMeanAndCovariance (moments, covariance_matrix, centroid);
+    return (static_cast<unsigned int> (moments.count));
+  }
+
   // create the buffer on the stack which is much faster than using cloud[indices[i]] and centroid as a buffer
   Eigen::Matrix<Scalar, 1, 9, Eigen::RowMajor> accu = Eigen::Matrix<Scalar, 1, 9, Eigen::RowMajor>::Zero ();
   size_t point_count;
@@ -556,6 +958,15 @@ pcl::computeMeanAndCovarianceMatrix (const pcl::PointCloud<PointT> &cloud,
                                      Eigen::Matrix<Scalar, 3, 3> &covariance_matrix,
                                      Eigen::Matrix<Scalar, 4, 1> &centroid)
 {
+  detail::CentroidMoments moments;
+  if (detail::computeCentroidMoments (cloud, indices.empty () ? NULL : &indices[0], indices.size (),
+                                      !cloud.is_dense, true, NULL, moments))
+  {
+    if (moments.count != 0)
+      detail::getMomentsMeanAndCovariance (moments, covariance_matrix, centroid);
+    return (static_cast<unsigned int> (moments.count));
+  }
+
   // create the buffer on the stack which is much faster than using cloud[indices[i]] and centroid as a buffer
   Eigen::Matrix<Scalar, 1, 9, Eigen::RowMajor> accu = Eigen::Matrix<Scalar, 1, 9, Eigen::RowMajor>::Zero ();
   size_t point_count;
@@ -298,6 +298,41 @@ pcl::getMinMax3D (const pcl::PointCloud<PointT> &cloud, Eigen::Vector4f &min_pt,
 }
 
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> inline void
+pcl::getMinMax3D (const pcl::PointCloudSoA<PointT> &cloud, Eigen::Vector4f &min_pt, Eigen::Vector4f &max_pt)
+{
+  float min_x = FLT_MAX, min_y = FLT_MAX, min_z = FLT_MAX;
+  float max_x = -FLT_MAX, max_y = -FLT_MAX, max_z = -FLT_MAX;
+  const float *x = cloud.x (), *y = cloud.y (), *z = cloud.z ();
+  const size_t n = cloud.size ();
+
+  // One independent reduction per column, which the compiler can vectorize
+  if (cloud.is_dense)
+  {
+    for (size_t i = 0; i < n; ++i)
+    {
+      min_x = x[i] < min_x ? x[i] : min_x; max_x = x[i] > max_x ? x[i] : max_x;
+      min_y = y[i] < min_y ? y[i] : min_y; max_y = y[i] > max_y ? y[i] : max_y;
+      min_z = z[i] < min_z ? z[i] : min_z; max_z = z[i] > max_z ? z[i] : max_z;
+    }
+  }
+  // NaN or Inf values could exist => check for them
+  else
+  {
+    for (size_t i = 0; i < n; ++i)
+    {
+      if (!pcl_isfinite (x[i]) || !pcl_isfinite (y[i]) || !pcl_isfinite (z[i]))
+        continue;
+      min_x = x[i] < min_x ? x[i] : min_x; max_x = x[i] > max_x ? x[i] : max_x;
+      min_y = y[i] < min_y ? y[i] : min_y; max_y = y[i] > max_y ? y[i] : max_y;
+      min_z = z[i] < min_z ? z[i] : min_z; max_z = z[i] > max_z ? z[i] : max_z;
+    }
+  }
+  min_pt << min_x, min_y, min_z, 1.0f;
+  max_pt << max_x, max_y, max_z, 1.0f;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> inline void
 pcl::getMinMax3D (const pcl::PointCloud<PointT> &cloud, const pcl::PointIndices &indices,
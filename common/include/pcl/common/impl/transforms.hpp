@@ -37,6 +37,71 @@
  *
  */
 
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Returns true if the three floats at \a ox, \a oy and \a oz are packed and followed by a
+      * fourth float inside \a PointT, which is what the batched transformation kernels expect.
+      */
+    template <typename PointT> inline bool
+    isPackedTriplet (size_t ox, size_t oy, size_t oz)
+    {
+      return (oy == ox + sizeof (float) && oz == ox + 2 * sizeof (float) && ox + 4 * sizeof (float) <= sizeof (PointT));
+    }
+
+    /** \brief Returns true if transforming \a PointT xyz data with \a transform can use the batched kernels.
+      * Double precision transforms keep using the generic code.
+      */
+    template <typename PointT, typename Scalar> inline bool
+    canBatchTransform (const Eigen::Transform<Scalar, 3, Eigen::Affine> &)
+    {
+      return (false);
+    }
+
+    template <typename PointT> inline bool
+    canBatchTransform (const Eigen::Transform<float, 3, Eigen::Affine> &)
+    {
+      return (isPackedTriplet<PointT> (pcl::traits::offset<PointT, pcl::fields::x>::value,
+                                       pcl::traits::offset<PointT, pcl::fields::y>::value,
+                                       pcl::traits::offset<PointT, pcl::fields::z>::value));
+    }
+
+    /** \brief Same as canBatchTransform, for xyz data and normals. */
+    template <typename PointT, typename Scalar> inline bool
+    canBatchTransformWithNormals (const Eigen::Transform<Scalar, 3, Eigen::Affine> &transform)
+    {
+      return (canBatchTransform<PointT> (transform) &&
+              isPackedTriplet<PointT> (pcl::traits::offset<PointT, pcl::fields::normal_x>::value,
+                                       pcl::traits::offset<PointT, pcl::fields::normal_y>::value,
+                                       pcl::traits::offset<PointT, pcl::fields::normal_z>::value));
+    }
+
+    /** \brief Transform cloud_out[i] from cloud_in[indices[i]] (or cloud_in[i]) with the batched kernels.
+      * Only valid if canBatchTransform (or canBatchTransformWithNormals) returned true.
+      */
+    template <typename PointT, typename Scalar> void
+    batchTransform (const pcl::PointCloud<PointT> &cloud_in, const std::vector<int> *indices,
+                    pcl::PointCloud<PointT> &cloud_out,
+                    const Eigen::Transform<Scalar, 3, Eigen::Affine> &transform,
+                    bool with_normals, ptrdiff_t normal_offset)
+    {
+      if (cloud_out.points.empty ())
+        return;
+      float matrix[12];
+      for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 4; ++c)
+          matrix[r * 4 + c] = static_cast<float> (transform (r, c));
+
+      const size_t offset_x = pcl::traits::offset<PointT, pcl::fields::x>::value;
+      const float *in = reinterpret_cast<const float*> (reinterpret_cast<const char*> (&cloud_in.points[0]) + offset_x);
+      float *out = reinterpret_cast<float*> (reinterpret_cast<char*> (&cloud_out.points[0]) + offset_x);
+      transformPoints (in, out, cloud_out.points.size (), sizeof (PointT), indices ? &(*indices)[0] : NULL,
+                       with_normals, normal_offset, matrix, !cloud_in.is_dense);
+    }
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT, typename Scalar> void
 pcl::transformPointCloud (const pcl::PointCloud<PointT> &cloud_in, 
@@ -59,6 +124,12 @@ pcl::transformPointCloud (const pcl::PointCloud<PointT> &cloud_in,
     cloud_out.sensor_origin_      = cloud_in.sensor_origin_;
   }
 
+  if (detail::canBatchTransform<PointT> (transform))
+  {
+    detail::batchTransform (cloud_in, NULL, cloud_out, transform, false, 0);
+    return;
+  }
+
   if (cloud_in.is_dense)
   {
     // If the dataset is dense, simply transform it!
@@ -108,6 +179,16 @@ pcl::transformPointCloud (const pcl::PointCloud<PointT> &cloud_in,
   cloud_out.sensor_orientation_ = cloud_in.sensor_orientation_;
   cloud_out.sensor_origin_      = cloud_in.sensor_origin_;
 
+  if (detail::canBatchTransform<PointT> (transform))
+  {
+    // Copy fields first, then transform xyz data
+    if (copy_all_fields)
+      for (size_t i = 0; i < npts; ++i)
+        cloud_out.points[i] = cloud_in.points[indices[i]];
+    detail::batchTransform (cloud_in, &indices, cloud_out, transform, false, 0);
+    return;
+  }
+
   if (cloud_in.is_dense)
   {
     // If the dataset is dense, simply transform it!
@@ -144,6 +225,135 @@ pcl::transformPointCloud (const pcl::PointCloud<PointT> &cloud_in,
   }
 }
 
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Apply the linear part (and, if \a translate is set, the translation) of \a transform
+      * to three coordinate columns. Points with a non-finite input coordinate are skipped unless
+      * \a is_dense is set. The input and output columns may be the same.
+      */
+    template <typename Scalar> void
+    transformColumns (const float *in_x, const float *in_y, const float *in_z,
+                      float *out_x, float *out_y, float *out_z, size_t n,
+                      const Eigen::Transform<Scalar, 3, Eigen::Affine> &transform,
+                      bool translate, bool is_dense)
+    {
+      // Keep the coefficients in registers so that the loop vectorizes over the columns
+      const Scalar m00 = transform (0, 0), m01 = transform (0, 1), m02 = transform (0, 2);
+      const Scalar m10 = transform (1, 0), m11 = transform (1, 1), m12 = transform (1, 2);
+      const Scalar m20 = transform (2, 0), m21 = transform (2, 1), m22 = transform (2, 2);
+      const Scalar t0 = translate ? transform (0, 3) : Scalar (0);
+      const Scalar t1 = translate ? transform (1, 3) : Scalar (0);
+      const Scalar t2 = translate ? transform (2, 3) : Scalar (0);
+
+      if (is_dense)
+      {
+        for (size_t i = 0; i < n; ++i)
+        {
+          const Scalar px = in_x[i], py = in_y[i], pz = in_z[i];
+          out_x[i] = static_cast<float> (m00 * px + m01 * py + m02 * pz + t0);
+          out_y[i] = static_cast<float> (m10 * px + m11 * py + m12 * pz + t1);
+          out_z[i] = static_cast<float> (m20 * px + m21 * py + m22 * pz + t2);
+        }
+      }
+      else
+      {
+        for (size_t i = 0; i < n; ++i)
+        {
+          if (!pcl_isfinite (in_x[i]) || !pcl_isfinite (in_y[i]) || !pcl_isfinite (in_z[i]))
+            continue;
+          const Scalar px = in_x[i], py = in_y[i], pz = in_z[i];
+          out_x[i] = static_cast<float> (m00 * px + m01 * py + m02 * pz + t0);
+          out_y[i] = static_cast<float> (m10 * px + m11 * py + m12 * pz + t1);
+          out_z[i] = static_cast<float> (m20 * px + m21 * py + m22 * pz + t2);
+        }
+      }
+    }
+
+    /** \brief Prepare \a cloud_out to receive the transformed \a cloud_in. */
+    template <typename PointT> void
+    prepareTransformOutput (const pcl::PointCloudSoA<PointT> &cloud_in,
+                            pcl::PointCloudSoA<PointT> &cloud_out, bool copy_all_fields)
+    {
+      if (&cloud_in == &cloud_out)
+        return;
+      if (copy_all_fields)
+        cloud_out = cloud_in;
+      else
+      {
+        cloud_out.clear ();
+        cloud_out.resize (cloud_in.size ());
+        cloud_out.header              = cloud_in.header;
+        cloud_out.is_dense            = cloud_in.is_dense;
+        cloud_out.width               = cloud_in.width;
+        cloud_out.height              = cloud_in.height;
+        cloud_out.sensor_orientation_ = cloud_in.sensor_orientation_;
+        cloud_out.sensor_origin_      = cloud_in.sensor_origin_;
+      }
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename Scalar> void
+pcl::transformPointCloud (const pcl::PointCloudSoA<PointT> &cloud_in, 
+                          pcl::PointCloudSoA<PointT> &cloud_out,
+                          const Eigen::Transform<Scalar, 3, Eigen::Affine> &transform,
+                          bool copy_all_fields)
+{
+  detail::prepareTransformOutput (cloud_in, cloud_out, copy_all_fields);
+  if (cloud_in.empty ())
+    return;
+  detail::transformColumns (cloud_in.x (), cloud_in.y (), cloud_in.z (),
+                            cloud_out.x (), cloud_out.y (), cloud_out.z (), cloud_in.size (),
+                            transform, true, cloud_in.is_dense);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename Scalar> void
+pcl::transformPointCloudWithNormals (const pcl::PointCloudSoA<PointT> &cloud_in, 
+                                     pcl::PointCloudSoA<PointT> &cloud_out,
+                                     const Eigen::Transform<Scalar, 3, Eigen::Affine> &transform,
+                                     bool copy_all_fields)
+{
+  detail::prepareTransformOutput (cloud_in, cloud_out, copy_all_fields);
+  if (cloud_in.empty ())
+    return;
+
+  // Normals are only rotated for points with a finite position, as in the pcl::PointCloud version.
+  // The rotation has to run before the positions are overwritten when transforming in place.
+  const float *nx = cloud_in.template getColumn<float> ("normal_x");
+  const float *ny = cloud_in.template getColumn<float> ("normal_y");
+  const float *nz = cloud_in.template getColumn<float> ("normal_z");
+  if (nx && ny && nz)
+  {
+    float *out_nx = cloud_out.template getColumn<float> ("normal_x");
+    float *out_ny = cloud_out.template getColumn<float> ("normal_y");
+    float *out_nz = cloud_out.template getColumn<float> ("normal_z");
+    if (cloud_in.is_dense)
+      detail::transformColumns (nx, ny, nz, out_nx, out_ny, out_nz, cloud_in.size (), transform, false, true);
+    else
+    {
+      const float *x = cloud_in.x (), *y = cloud_in.y (), *z = cloud_in.z ();
+      const Eigen::Matrix<Scalar, 3, 3> rot = transform.linear ();
+      for (size_t i = 0; i < cloud_in.size (); ++i)
+      {
+        if (!pcl_isfinite (x[i]) || !pcl_isfinite (y[i]) || !pcl_isfinite (z[i]))
+          continue;
+        const Scalar px = nx[i], py = ny[i], pz = nz[i];
+        out_nx[i] = static_cast<float> (rot (0, 0) * px + rot (0, 1) * py + rot (0, 2) * pz);
+        out_ny[i] = static_cast<float> (rot (1, 0) * px + rot (1, 1) * py + rot (1, 2) * pz);
+        out_nz[i] = static_cast<float> (rot (2, 0) * px + rot (2, 1) * py + rot (2, 2) * pz);
+      }
+    }
+  }
+
+  detail::transformColumns (cloud_in.x (), cloud_in.y (), cloud_in.z (),
+                            cloud_out.x (), cloud_out.y (), cloud_out.z (), cloud_in.size (),
+                            transform, true, cloud_in.is_dense);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT, typename Scalar> void
 pcl::transformPointCloudWithNormals (const pcl::PointCloud<PointT> &cloud_in, 
@@ -167,6 +377,14 @@ pcl::transformPointCloudWithNormals (const pcl::PointCloud<PointT> &cloud_in,
     cloud_out.sensor_origin_      = cloud_in.sensor_origin_;
   }
 
+  if (detail::canBatchTransformWithNormals<PointT> (transform))
+  {
+    detail::batchTransform (cloud_in, NULL, cloud_out, transform, true,
+                            static_cast<ptrdiff_t> (pcl::traits::offset<PointT, pcl::fields::normal_x>::value) -
+                            static_cast<ptrdiff_t> (pcl::traits::offset<PointT, pcl::fields::x>::value));
+    return;
+  }
+
   // If the data is dense, we don't need to check for NaN
   if (cloud_in.is_dense)
   {
@@ -230,6 +448,18 @@ pcl::transformPointCloudWithNormals (const pcl::PointCloud<PointT> &cloud_in,
   cloud_out.sensor_orientation_ = cloud_in.sensor_orientation_;
   cloud_out.sensor_origin_      = cloud_in.sensor_origin_;
 
+  if (detail::canBatchTransformWithNormals<PointT> (transform))
+  {
+    // Copy fields first, then transform
+    if (copy_all_fields)
+      for (size_t i = 0; i < npts; ++i)
+        cloud_out.points[i] = cloud_in.points[indices[i]];
+    detail::batchTransform (cloud_in, &indices, cloud_out, transform, true,
+                            static_cast<ptrdiff_t> (pcl::traits::offset<PointT, pcl::fields::normal_x>::value) -
+                            static_cast<ptrdiff_t> (pcl::traits::offset<PointT, pcl::fields::x>::value));
+    return;
+  }
+
   // If the data is dense, we don't need to check for NaN
   if (cloud_in.is_dense)
   {
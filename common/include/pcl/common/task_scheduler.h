@@ -0,0 +1,240 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#ifndef PCL_COMMON_TASK_SCHEDULER_H_
+#define PCL_COMMON_TASK_SCHEDULER_H_
+
+#include <pcl/pcl_macros.h>
+#include <boost/function.hpp>
+#include <boost/bind.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <algorithm>
+
+/** \file task_scheduler.h
+  * A process wide pool of worker threads that PCL algorithms share instead of each starting
+  * their own OpenMP team.
+  *
+  * Tasks are grouped in pcl::TaskGroup objects and run by pcl::TaskScheduler, a work-stealing
+  * thread pool: each worker keeps its own queue, runs its newest task first and steals the
+  * oldest task of another queue when its own is empty. A thread that waits for a group keeps
+  * running queued tasks meanwhile, so tasks may start and wait for nested groups and several
+  * pipelines may run concurrently without ever having more than getConcurrency () busy
+  * threads per waiting caller. The default concurrency is the number of hardware threads,
+  * or the value of the PCL_NUM_THREADS environment variable.
+  */
+
+namespace pcl
+{
+  class TaskGroup;
+
+  /** \brief Work-stealing thread pool shared by PCL algorithms, see task_scheduler.h.
+    * \ingroup common
+    */
+  class PCL_EXPORTS TaskScheduler : boost::noncopyable
+  {
+    public:
+      typedef boost::function<void ()> Task;
+
+      /** \brief Create a scheduler.
+        * \param[in] concurrency the maximum number of threads running tasks, including the
+        * waiting caller, i.e. concurrency - 1 workers are started (0 uses getDefaultConcurrency ())
+        */
+      explicit TaskScheduler (unsigned int concurrency = 0);
+
+      /** \brief Stop the workers. Tasks still queued are dropped. */
+      ~TaskScheduler ();
+
+      /** \brief The scheduler shared by all of PCL, created on first use. */
+      static TaskScheduler&
+      getInstance ();
+
+      /** \brief PCL_NUM_THREADS if set to a positive number, the number of hardware threads otherwise. */
+      static unsigned int
+      getDefaultConcurrency ();
+
+      /** \brief Change the number of threads running tasks, restarting the workers.
+        * \note Only call this while no task group of this scheduler is running.
+        * \param[in] concurrency the new concurrency (0 uses getDefaultConcurrency ())
+        */
+      void
+      setConcurrency (unsigned int concurrency);
+
+      /** \brief The maximum number of threads running tasks, including one waiting caller. */
+      unsigned int
+      getConcurrency () const;
+
+      /** \brief Whether the calling thread is running a task, or its own subrange of a parallel_for.
+        * Code that would split its work across threads on its own (e.g. with OpenMP) should stay
+        * serial then, as the scheduler already keeps its threads busy.
+        */
+      static bool
+      inTask ();
+
+    private:
+      friend class TaskGroup;
+
+      struct Impl;
+
+      /** \brief Queue a task of group, on the calling worker's own queue if called from a task. */
+      void
+      submit (const Task &task, TaskGroup *group);
+
+      /** \brief Run one queued task on the calling thread.
+        * \return false if no task was queued
+        */
+      bool
+      runQueuedTask ();
+
+      boost::shared_ptr<Impl> impl_;
+  };
+
+  /** \brief A set of tasks that can be waited for together.
+    * \code
+    * pcl::TaskGroup group;
+    * group.run (boost::bind (&process, boost::ref (left)));
+    * group.run (boost::bind (&process, boost::ref (right)));
+    * group.wait ();
+    * \endcode
+    * Tasks must not throw; an exception escaping a task is reported with PCL_ERROR and ignored.
+    * \ingroup common
+    */
+  class PCL_EXPORTS TaskGroup : boost::noncopyable
+  {
+    public:
+      /** \brief Create an empty group on a scheduler (the shared one by default). */
+      explicit TaskGroup (TaskScheduler &scheduler = TaskScheduler::getInstance ());
+
+      /** \brief Waits for all tasks of the group. */
+      ~TaskGroup ();
+
+      /** \brief Queue a task. */
+      void
+      run (const TaskScheduler::Task &task);
+
+      /** \brief Run queued tasks (of any group) on the calling thread until all tasks of this group finished. */
+      void
+      wait ();
+
+    private:
+      friend class TaskScheduler;
+
+      /** \brief Called by the scheduler after one of the group's tasks ran. */
+      void
+      finish ();
+
+      TaskScheduler &scheduler_;
+
+      /** \brief Number of queued or running tasks. */
+      size_t pending_;
+
+      boost::mutex mutex_;
+      boost::condition_variable finished_;
+  };
+
+  namespace detail
+  {
+    /** \brief Marks the calling thread as running a task while in scope, see TaskScheduler::inTask (). */
+    class PCL_EXPORTS TaskScope : boost::noncopyable
+    {
+      public:
+        TaskScope ();
+
+        ~TaskScope ();
+    };
+
+    template <typename Body>
+    struct ParallelForRange
+    {
+      ParallelForRange (const Body &body, int begin, int end) : body_ (&body), begin_ (begin), end_ (end) {}
+
+      void
+      operator () () const
+      {
+        (*body_) (begin_, end_);
+      }
+
+      const Body *body_;
+      int begin_, end_;
+    };
+  }
+
+  /** \brief Split [begin, end) into contiguous subranges and call body (sub_begin, sub_end) on each of them as a
+    * task of the shared scheduler, the calling thread taking the first subrange. Returns when all calls did.
+    * \param[in] begin the first index
+    * \param[in] end one past the last index
+    * \param[in] body a functor taking the (int, int) bounds of a subrange; called concurrently, so it must only
+    * write to data owned by its subrange
+    * \param[in] grain_size the minimum number of indices per subrange
+    * \param[in] max_tasks the maximum number of subranges, and so of threads working on the loop
+    * (0 for four subranges per thread of the scheduler, which balances uneven subranges)
+    * \ingroup common
+    */
+  template <typename Body> void
+  parallel_for (int begin, int end, const Body &body, int grain_size = 1, unsigned int max_tasks = 0)
+  {
+    if (end <= begin)
+      return;
+
+    TaskScheduler &scheduler = TaskScheduler::getInstance ();
+    const int64_t size = static_cast<int64_t> (end) - begin;
+    const int64_t grain = std::max (grain_size, 1);
+    int64_t nr_tasks = (size + grain - 1) / grain;
+    nr_tasks = std::min (nr_tasks, static_cast<int64_t> (max_tasks ? max_tasks : 4 * scheduler.getConcurrency ()));
+    if (nr_tasks <= 1 || scheduler.getConcurrency () <= 1)
+    {
+      body (begin, end);
+      return;
+    }
+
+    TaskGroup group (scheduler);
+    for (int64_t t = 1; t < nr_tasks; ++t)
+      group.run (detail::ParallelForRange<Body> (body, static_cast<int> (begin + size * t / nr_tasks),
+                                                 static_cast<int> (begin + size * (t + 1) / nr_tasks)));
+    {
+      detail::TaskScope scope;
+      body (begin, static_cast<int> (begin + size / nr_tasks));
+    }
+    group.wait ();
+  }
+}
+
+#endif  // PCL_COMMON_TASK_SCHEDULER_H_
@@ -0,0 +1,178 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#ifndef PCL_COMMON_TRACE_H_
+#define PCL_COMMON_TRACE_H_
+
+#include <pcl/pcl_macros.h>
+#include <iosfwd>
+#include <string>
+
+/** \file trace.h
+  * Low-overhead tracing of where processing time goes, exported as a Chrome trace.
+  *
+  * Code is instrumented with PCL_TRACE_ZONE (name), which records the time spent in the
+  * enclosing scope, and PCL_TRACE_COUNTER (name, value), which adds value to a named counter
+  * (points processed, search calls, ...). Both compile to nothing unless PCL is configured
+  * with PCL_ENABLE_TRACING, and record nothing until pcl::trace::setEnabled (true).
+  *
+  * Every thread records into its own ring buffer of getBufferSize () events, so recording
+  * takes no lock and a long run keeps its most recent events. Zones of a thread nest by time,
+  * which is how chrome://tracing or Perfetto draw the hierarchy of a writeChromeTrace () file:
+  *
+  * \code
+  * pcl::trace::setEnabled (true);
+  * for (...)
+  *   process (frame);
+  * pcl::trace::setEnabled (false);
+  * pcl::trace::writeChromeTrace ("pipeline.json");
+  * \endcode
+  */
+
+namespace pcl
+{
+  namespace trace
+  {
+    /** \brief Start or stop recording. Off by default. */
+    PCL_EXPORTS void
+    setEnabled (bool enabled);
+
+    /** \brief Whether zones and counters are currently recorded. */
+    PCL_EXPORTS bool
+    isEnabled ();
+
+    /** \brief Set the number of events each thread keeps (default 65536). Clears all recorded events.
+      * \note Only call this while nothing is being recorded.
+      */
+    PCL_EXPORTS void
+    setBufferSize (size_t events_per_thread);
+
+    /** \brief The number of events each thread keeps. */
+    PCL_EXPORTS size_t
+    getBufferSize ();
+
+    /** \brief Drop all recorded events. */
+    PCL_EXPORTS void
+    clear ();
+
+    /** \brief Monotonic time in nanoseconds, the time base of all events. */
+    PCL_EXPORTS uint64_t
+    now ();
+
+    /** \brief A name with static storage duration for a string that may not outlive the trace,
+      * e.g. the name of a filter object. Interning takes a lock; keep it out of inner loops.
+      */
+    PCL_EXPORTS const char*
+    intern (const std::string &name);
+
+    /** \brief Record that the calling thread spent [begin, end) in zone name.
+      * \param[in] name the zone name; must stay valid until the trace is written (a literal or intern ())
+      */
+    PCL_EXPORTS void
+    recordZone (const char *name, uint64_t begin, uint64_t end);
+
+    /** \brief Add value to the counter name; the same rule as for recordZone () applies to name. */
+    PCL_EXPORTS void
+    addCounter (const char *name, int64_t value);
+
+    /** \brief Sum of all recorded additions to counter name still held in the ring buffers. */
+    PCL_EXPORTS int64_t
+    getCounter (const std::string &name);
+
+    /** \brief Write the recorded events as Chrome trace event JSON: one complete ("X") event per
+      * zone and, for each counter, a ("C") event with its running total at each addition.
+      * \note Stop recording first: events recorded while writing may or may not be written.
+      */
+    PCL_EXPORTS void
+    writeChromeTrace (std::ostream &stream);
+
+    /** \brief Write the recorded events to a Chrome trace JSON file.
+      * \return false if the file could not be written
+      */
+    PCL_EXPORTS bool
+    writeChromeTrace (const std::string &file_name);
+
+    /** \brief Records the lifetime of a scope as a zone, see PCL_TRACE_ZONE. */
+    class Zone
+    {
+      public:
+        explicit Zone (const char *name)
+          : name_ (isEnabled () ? name : NULL)
+          , begin_ (name_ ? now () : 0)
+        {
+        }
+
+        explicit Zone (const std::string &name)
+          : name_ (isEnabled () ? intern (name) : NULL)
+          , begin_ (name_ ? now () : 0)
+        {
+        }
+
+        ~Zone ()
+        {
+          if (name_)
+            recordZone (name_, begin_, now ());
+        }
+
+      private:
+        Zone (const Zone&);
+        Zone& operator = (const Zone&);
+
+        const char *name_;
+        uint64_t begin_;
+    };
+  }
+}
+
+#define PCL_TRACE_CONCAT_(a, b) a ## b
+#define PCL_TRACE_CONCAT(a, b) PCL_TRACE_CONCAT_ (a, b)
+
+#ifdef PCL_ENABLE_TRACING
+  /** \brief Record the time spent in the rest of the enclosing scope as zone name
+    * (a string literal, or a std::string that gets interned). */
+  #define PCL_TRACE_ZONE(name) ::pcl::trace::Zone PCL_TRACE_CONCAT (pcl_trace_zone_, __LINE__) (name)
+  /** \brief Add value to the counter name (a string literal). */
+  #define PCL_TRACE_COUNTER(name, value) \
+    do { if (::pcl::trace::isEnabled ()) ::pcl::trace::addCounter ((name), static_cast< ::pcl::int64_t> (value)); } while (false)
+#else
+  #define PCL_TRACE_ZONE(name) do {} while (false)
+  #define PCL_TRACE_COUNTER(name, value) do {} while (false)
+#endif
+
+#endif  // PCL_COMMON_TRACE_H_
@@ -40,6 +40,7 @@
 #define PCL_TRANSFORMS_H_
 
 #include <pcl/point_cloud.h>
+#include <pcl/point_cloud_soa.h>
 #include <pcl/point_types.h>
 #include <pcl/common/centroid.h>
 #include <pcl/common/eigen.h>
@@ -47,6 +48,30 @@
 
 namespace pcl
 {
+  namespace detail
+  {
+    /** \brief Apply a 3x4 affine matrix to the coordinates (and optionally rotate the normals) of
+      * \a n points stored with a fixed stride, as found in a pcl::PointCloud.
+      *
+      * The x, y, z and normal_x, normal_y, normal_z triplets must each be followed by a fourth
+      * float inside the same point; its value is preserved. Large batches are split across
+      * OpenMP threads.
+      * \param[in] in pointer to the x coordinate of the first input point
+      * \param[out] out pointer to the x coordinate of the first output point (may be equal to \a in)
+      * \param[in] n the number of points to transform
+      * \param[in] stride the distance between two points in bytes
+      * \param[in] indices if not NULL, output point i is computed from input point indices[i]
+      * \param[in] with_normals whether to rotate the normal triplet as well
+      * \param[in] normal_offset the byte offset of normal_x relative to x
+      * \param[in] matrix the first three rows of the transformation, row major
+      * \param[in] check_finite if true, points with a non-finite input x, y or z are left unchanged
+      * \note The SSE2, AVX2 or AVX-512 variant is picked at runtime, see pcl::getDispatchCpuIsa ().
+      */
+    PCL_EXPORTS void
+    transformPoints (const float *in, float *out, size_t n, size_t stride, const int *indices,
+                     bool with_normals, ptrdiff_t normal_offset, const float *matrix, bool check_finite);
+  }
+
   /** \brief Apply an affine transform defined by an Eigen Transform
     * \param[in] cloud_in the input point cloud
     * \param[out] cloud_out the resultant output point cloud
@@ -150,6 +175,54 @@ namespace pcl
     return (transformPointCloudWithNormals<PointT, float> (cloud_in, cloud_out, transform, copy_all_fields));
   }
 
+  /** \brief Apply an affine transform defined by an Eigen Transform to a structure-of-arrays cloud
+    * \param[in] cloud_in the input point cloud
+    * \param[out] cloud_out the resultant output point cloud
+    * \param[in] transform an affine transformation (typically a rigid transformation)
+    * \param[in] copy_all_fields flag that controls whether the contents of the fields
+    * (other than x, y, z) should be copied into the new transformed cloud
+    * \note Can be used with cloud_in equal to cloud_out
+    * \ingroup common
+    */
+  template <typename PointT, typename Scalar> void 
+  transformPointCloud (const pcl::PointCloudSoA<PointT> &cloud_in, 
+                       pcl::PointCloudSoA<PointT> &cloud_out, 
+                       const Eigen::Transform<Scalar, 3, Eigen::Affine> &transform,
+                       bool copy_all_fields = true);
+
+  template <typename PointT> void 
+  transformPointCloud (const pcl::PointCloudSoA<PointT> &cloud_in, 
+                       pcl::PointCloudSoA<PointT> &cloud_out, 
+                       const Eigen::Affine3f &transform,
+                       bool copy_all_fields = true)
+  {
+    return (transformPointCloud<PointT, float> (cloud_in, cloud_out, transform, copy_all_fields));
+  }
+
+  /** \brief Transform a structure-of-arrays point cloud and rotate its normals using an Eigen transform.
+    * \param[in] cloud_in the input point cloud
+    * \param[out] cloud_out the resultant output point cloud
+    * \param[in] transform an affine transformation (typically a rigid transformation)
+    * \param[in] copy_all_fields flag that controls whether the contents of the fields
+    * (other than x, y, z, normal_x, normal_y, normal_z) should be copied into the new
+    * transformed cloud
+    * \note Can be used with cloud_in equal to cloud_out
+    */
+  template <typename PointT, typename Scalar> void 
+  transformPointCloudWithNormals (const pcl::PointCloudSoA<PointT> &cloud_in, 
+                                  pcl::PointCloudSoA<PointT> &cloud_out, 
+                                  const Eigen::Transform<Scalar, 3, Eigen::Affine> &transform,
+                                  bool copy_all_fields = true);
+
+  template <typename PointT> void 
+  transformPointCloudWithNormals (const pcl::PointCloudSoA<PointT> &cloud_in, 
+                                  pcl::PointCloudSoA<PointT> &cloud_out, 
+                                  const Eigen::Affine3f &transform,
+                                  bool copy_all_fields = true)
+  {
+    return (transformPointCloudWithNormals<PointT, float> (cloud_in, cloud_out, transform, copy_all_fields));
+  }
+
   /** \brief Transform a point cloud and rotate its normals using an Eigen transform.
     * \param[in] cloud_in the input point cloud
     * \param[in] indices the set of point indices to use from the input point cloud
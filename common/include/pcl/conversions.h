@@ -54,7 +54,9 @@
 #include <pcl/console/print.h>
 #ifndef Q_MOC_RUN
 #include <boost/foreach.hpp>
+#include <boost/shared_ptr.hpp>
 #endif
+#include <typeinfo>
 
 namespace pcl
 {
@@ -119,6 +121,39 @@ namespace pcl
       return (a.serialized_offset < b.serialized_offset);
     }
 
+    /** \brief Copy the fields of field_map out of a width x height grid of serialized points into densely packed
+      * structs of point_size bytes. Every mapping is copied as a fixed-width strided move over blocks of points,
+      * a single mapping spanning the whole point as one memcpy per block, and large clouds are split across
+      * OpenMP threads.
+      * \param[in] msg_data the serialized points
+      * \param[in] point_step the size of one serialized point in bytes
+      * \param[in] row_step the size of one serialized row in bytes (may include padding)
+      * \param[out] cloud_data the width * height destination structs
+      * \param[in] point_size the size of one destination struct in bytes
+      * \param[in] width the number of points per row
+      * \param[in] height the number of rows
+      * \param[in] field_map the (coalesced) field mapping, e.g. from createMapping ()
+      */
+    PCL_EXPORTS void
+    copyFieldMap (const uint8_t* msg_data, size_t point_step, size_t row_step,
+                  uint8_t* cloud_data, size_t point_size, size_t width, size_t height,
+                  const MsgFieldMap& field_map);
+
+    /** \brief Look up the field map cached for a point type and a serialized field layout.
+      * \param[in] point_type the name of the point type, as given by typeid
+      * \param[in] msg_fields the fields of the serialized cloud
+      * \return the cached field map, or a null pointer if there is none
+      */
+    PCL_EXPORTS boost::shared_ptr<const MsgFieldMap>
+    findFieldMap (const char* point_type, const std::vector<pcl::PCLPointField>& msg_fields);
+
+    /** \brief Cache a field map for a point type and a serialized field layout. The least recently used layouts
+      * are dropped once the cache is full; pointers handed out earlier stay valid.
+      */
+    PCL_EXPORTS void
+    storeFieldMap (const char* point_type, const std::vector<pcl::PCLPointField>& msg_fields,
+                   const boost::shared_ptr<const MsgFieldMap>& field_map);
+
   } //namespace detail
 
   template<typename PointT> void
@@ -152,6 +187,25 @@ namespace pcl
     }
   }
 
+  /** \brief Get the conversion plan from a serialized field layout to PointT, i.e. the field map created by
+    * createMapping (). Plans are cached per point type and field layout, so converting a stream of messages
+    * that share a layout only creates (and warns about missing fields) once. The cache is thread safe.
+    * \param[in] msg_fields the fields of the serialized cloud
+    */
+  template<typename PointT> boost::shared_ptr<const MsgFieldMap>
+  getFieldMap (const std::vector<pcl::PCLPointField>& msg_fields)
+  {
+    boost::shared_ptr<const MsgFieldMap> field_map = detail::findFieldMap (typeid (PointT).name (), msg_fields);
+    if (!field_map)
+    {
+      boost::shared_ptr<MsgFieldMap> created (new MsgFieldMap);
+      createMapping<PointT> (msg_fields, *created);
+      detail::storeFieldMap (typeid (PointT).name (), msg_fields, created);
+      field_map = created;
+    }
+    return (field_map);
+  }
+
   /** \brief Convert a PCLPointCloud2 binary data blob into a pcl::PointCloud<T> object using a field_map.
     * \param[in] msg the PCLPointCloud2 binary blob
     * \param[out] cloud the resultant pcl::PointCloud<T>
@@ -178,48 +232,14 @@ namespace pcl
     // Copy point data
     uint32_t num_points = msg.width * msg.height;
     cloud.points.resize (num_points);
-    uint8_t* cloud_data = reinterpret_cast<uint8_t*>(&cloud.points[0]);
-
-    // Check if we can copy adjacent points in a single memcpy.  We can do so if there
-    // is exactly one field to copy and it is the same size as the source and destination
-    // point types.
-    if (field_map.size() == 1 &&
-        field_map[0].serialized_offset == 0 &&
-        field_map[0].struct_offset == 0 &&
-        field_map[0].size == msg.point_step &&
-        field_map[0].size == sizeof(PointT))
-    {
-      uint32_t cloud_row_step = static_cast<uint32_t> (sizeof (PointT) * cloud.width);
-      const uint8_t* msg_data = &msg.data[0];
-      // Should usually be able to copy all rows at once
-      if (msg.row_step == cloud_row_step)
-      {
-        memcpy (cloud_data, msg_data, msg.data.size ());
-      }
-      else
-      {
-        for (uint32_t i = 0; i < msg.height; ++i, cloud_data += cloud_row_step, msg_data += msg.row_step)
-          memcpy (cloud_data, msg_data, cloud_row_step);
-      }
+    if (num_points == 0)
+      return;
 
-    }
-    else
-    {
-      // If not, memcpy each group of contiguous fields separately
-      for (uint32_t row = 0; row < msg.height; ++row)
-      {
-        const uint8_t* row_data = &msg.data[row * msg.row_step];
-        for (uint32_t col = 0; col < msg.width; ++col)
-        {
-          const uint8_t* msg_data = row_data + col * msg.point_step;
-          BOOST_FOREACH (const detail::FieldMapping& mapping, field_map)
-          {
-            memcpy (cloud_data + mapping.struct_offset, msg_data + mapping.serialized_offset, mapping.size);
-          }
-          cloud_data += sizeof (PointT);
-        }
-      }
-    }
+    // A single mapping that covers the whole point is copied row by row (or all at once), any other map field
+    // by field over blocks of points
+    detail::copyFieldMap (&msg.data[0], msg.point_step, msg.row_step,
+                          reinterpret_cast<uint8_t*>(&cloud.points[0]), sizeof (PointT), msg.width, msg.height,
+                          field_map);
   }
 
   /** \brief Convert a PCLPointCloud2 binary data blob into a pcl::PointCloud<T> object.
@@ -229,9 +249,7 @@ namespace pcl
   template<typename PointT> void
   fromPCLPointCloud2 (const pcl::PCLPointCloud2& msg, pcl::PointCloud<PointT>& cloud)
   {
-    MsgFieldMap field_map;
-    createMapping<PointT> (msg.fields, field_map);
-    fromPCLPointCloud2 (msg, cloud, field_map);
+    fromPCLPointCloud2 (msg, cloud, *getFieldMap<PointT> (msg.fields));
   }
 
   /** \brief Convert a pcl::PointCloud<T> object to a PCLPointCloud2 binary data blob.
@@ -259,7 +277,11 @@ namespace pcl
     msg.data.resize (data_size);
     if (data_size)
     {
-      memcpy(&msg.data[0], &cloud.points[0], data_size);
+      MsgFieldMap field_map (1);
+      field_map[0].serialized_offset = field_map[0].struct_offset = 0;
+      field_map[0].size = sizeof (PointT);
+      detail::copyFieldMap (reinterpret_cast<const uint8_t*>(&cloud.points[0]), sizeof (PointT), data_size,
+                            &msg.data[0], sizeof (PointT), cloud.points.size (), 1, field_map);
     }
 
     // Fill fields metadata
@@ -0,0 +1,402 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef PCL_POINT_CLOUD_SOA_IMPL_HPP_
+#define PCL_POINT_CLOUD_SOA_IMPL_HPP_
+
+#include <pcl/point_cloud_soa.h>
+#include <pcl/console/print.h>
+#include <algorithm>
+#include <cstring>
+
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Collects the fields of \a PointT together with their size in bytes. */
+    template <typename PointT>
+    struct SoAFieldAdder
+    {
+      SoAFieldAdder (std::vector<pcl::PCLPointField> &fields, std::vector<size_t> &sizes)
+        : fields_ (fields), sizes_ (sizes) {}
+
+      template <typename Tag> void
+      operator () ()
+      {
+        pcl::PCLPointField f;
+        f.name = traits::name<PointT, Tag>::value;
+        f.offset = traits::offset<PointT, Tag>::value;
+        f.datatype = traits::datatype<PointT, Tag>::value;
+        f.count = traits::datatype<PointT, Tag>::size;
+        fields_.push_back (f);
+        sizes_.push_back (sizeof (typename traits::datatype<PointT, Tag>::type));
+      }
+
+      std::vector<pcl::PCLPointField> &fields_;
+      std::vector<size_t> &sizes_;
+    };
+
+    template <typename T> inline void
+    copyStridedT (const uint8_t *src, size_t src_stride, uint8_t *dst, size_t dst_stride, size_t n)
+    {
+      // memcpy with a constant size compiles down to a plain (unaligned-safe) move
+      for (size_t i = 0; i < n; ++i, src += src_stride, dst += dst_stride)
+        memcpy (dst, src, sizeof (T));
+    }
+
+    /** \brief Copy \a n elements of \a size bytes between two strided buffers. */
+    inline void
+    copyStrided (const uint8_t *src, size_t src_stride, uint8_t *dst, size_t dst_stride,
+                 size_t size, size_t n)
+    {
+      switch (size)
+      {
+        case 1: copyStridedT<uint8_t> (src, src_stride, dst, dst_stride, n); break;
+        case 2: copyStridedT<uint16_t> (src, src_stride, dst, dst_stride, n); break;
+        case 4: copyStridedT<uint32_t> (src, src_stride, dst, dst_stride, n); break;
+        case 8: copyStridedT<uint64_t> (src, src_stride, dst, dst_stride, n); break;
+        default:
+          for (size_t i = 0; i < n; ++i, src += src_stride, dst += dst_stride)
+            memcpy (dst, src, size);
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT>
+pcl::PointCloudSoA<PointT>::PointCloudSoA ()
+  : header ()
+  , width (0)
+  , height (0)
+  , is_dense (true)
+  , sensor_origin_ (Eigen::Vector4f::Zero ())
+  , sensor_orientation_ (Eigen::Quaternionf::Identity ())
+  , fields_ ()
+  , element_sizes_ ()
+  , columns_ ()
+  , x_idx_ (-1), y_idx_ (-1), z_idx_ (-1)
+  , size_ (0)
+{
+  initFields ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT>
+pcl::PointCloudSoA<PointT>::PointCloudSoA (const pcl::PointCloud<PointT> &cloud)
+  : header ()
+  , width (0)
+  , height (0)
+  , is_dense (true)
+  , sensor_origin_ (Eigen::Vector4f::Zero ())
+  , sensor_orientation_ (Eigen::Quaternionf::Identity ())
+  , fields_ ()
+  , element_sizes_ ()
+  , columns_ ()
+  , x_idx_ (-1), y_idx_ (-1), z_idx_ (-1)
+  , size_ (0)
+{
+  initFields ();
+  fromPointCloud (cloud);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::PointCloudSoA<PointT>::initFields ()
+{
+  typedef typename pcl::traits::fieldList<PointT>::type FieldList;
+  pcl::for_each_type<FieldList> (pcl::detail::SoAFieldAdder<PointT> (fields_, element_sizes_));
+  columns_.resize (fields_.size ());
+
+  // Only single float coordinates can be exposed through x (), y () and z ()
+  x_idx_ = getFieldIndex ("x");
+  y_idx_ = getFieldIndex ("y");
+  z_idx_ = getFieldIndex ("z");
+  if (x_idx_ >= 0 && fields_[x_idx_].datatype != pcl::PCLPointField::FLOAT32) x_idx_ = -1;
+  if (y_idx_ >= 0 && fields_[y_idx_].datatype != pcl::PCLPointField::FLOAT32) y_idx_ = -1;
+  if (z_idx_ >= 0 && fields_[z_idx_].datatype != pcl::PCLPointField::FLOAT32) z_idx_ = -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::PointCloudSoA<PointT>::fromPointCloud (const pcl::PointCloud<PointT> &cloud)
+{
+  header              = cloud.header;
+  width               = cloud.width;
+  height              = cloud.height;
+  is_dense            = cloud.is_dense;
+  sensor_origin_      = cloud.sensor_origin_;
+  sensor_orientation_ = cloud.sensor_orientation_;
+
+  size_ = cloud.points.size ();
+  for (size_t f = 0; f < fields_.size (); ++f)
+  {
+    columns_[f].resize (size_ * element_sizes_[f]);
+    if (size_ == 0)
+      continue;
+    const uint8_t *src = reinterpret_cast<const uint8_t*> (&cloud.points[0]) + fields_[f].offset;
+    detail::copyStrided (src, sizeof (PointT), &columns_[f][0], element_sizes_[f], element_sizes_[f], size_);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::PointCloudSoA<PointT>::toPointCloud (pcl::PointCloud<PointT> &cloud) const
+{
+  cloud.header              = header;
+  cloud.width               = width;
+  cloud.height              = height;
+  cloud.is_dense            = is_dense;
+  cloud.sensor_origin_      = sensor_origin_;
+  cloud.sensor_orientation_ = sensor_orientation_;
+
+  // Default construct the points so that padding members get their usual values
+  cloud.points.assign (size_, PointT ());
+  if (size_ == 0)
+    return;
+  for (size_t f = 0; f < fields_.size (); ++f)
+  {
+    uint8_t *dst = reinterpret_cast<uint8_t*> (&cloud.points[0]) + fields_[f].offset;
+    detail::copyStrided (&columns_[f][0], element_sizes_[f], dst, sizeof (PointT), element_sizes_[f], size_);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::PointCloudSoA<PointT>::resize (size_t n)
+{
+  for (size_t f = 0; f < fields_.size (); ++f)
+    columns_[f].resize (n * element_sizes_[f], 0);
+  size_ = n;
+  width = static_cast<uint32_t> (n);
+  height = 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::PointCloudSoA<PointT>::reserve (size_t n)
+{
+  for (size_t f = 0; f < fields_.size (); ++f)
+    columns_[f].reserve (n * element_sizes_[f]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::PointCloudSoA<PointT>::clear ()
+{
+  for (size_t f = 0; f < fields_.size (); ++f)
+    columns_[f].clear ();
+  size_ = 0;
+  width = height = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::PointCloudSoA<PointT>::push_back (const PointT &pt)
+{
+  const uint8_t *src = reinterpret_cast<const uint8_t*> (&pt);
+  for (size_t f = 0; f < fields_.size (); ++f)
+    columns_[f].insert (columns_[f].end (), src + fields_[f].offset, src + fields_[f].offset + element_sizes_[f]);
+  ++size_;
+  width = static_cast<uint32_t> (size_);
+  height = 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> PointT
+pcl::PointCloudSoA<PointT>::at (size_t n) const
+{
+  PointT pt;
+  uint8_t *dst = reinterpret_cast<uint8_t*> (&pt);
+  for (size_t f = 0; f < fields_.size (); ++f)
+    memcpy (dst + fields_[f].offset, &columns_[f][n * element_sizes_[f]], element_sizes_[f]);
+  return (pt);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::PointCloudSoA<PointT>::set (size_t n, const PointT &pt)
+{
+  const uint8_t *src = reinterpret_cast<const uint8_t*> (&pt);
+  for (size_t f = 0; f < fields_.size (); ++f)
+    memcpy (&columns_[f][n * element_sizes_[f]], src + fields_[f].offset, element_sizes_[f]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::PointCloudSoA<PointT>::getFieldIndex (const std::string &name) const
+{
+  for (size_t f = 0; f < fields_.size (); ++f)
+    if (fields_[f].name == name)
+      return (static_cast<int> (f));
+  return (-1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> template <typename T> T*
+pcl::PointCloudSoA<PointT>::getColumn (const std::string &name)
+{
+  int idx = getFieldIndex (name);
+  if (idx < 0 || fields_[idx].datatype != pcl::traits::asEnum<T>::value)
+    return (NULL);
+  return (columnAt<T> (idx));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> template <typename T> const T*
+pcl::PointCloudSoA<PointT>::getColumn (const std::string &name) const
+{
+  int idx = getFieldIndex (name);
+  if (idx < 0 || fields_[idx].datatype != pcl::traits::asEnum<T>::value)
+    return (NULL);
+  return (columnAt<T> (idx));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::fromPCLPointCloud2 (const pcl::PCLPointCloud2 &msg, pcl::PointCloudSoA<PointT> &cloud)
+{
+  cloud.resize (static_cast<size_t> (msg.width) * msg.height);
+  cloud.header   = msg.header;
+  cloud.width    = msg.width;
+  cloud.height   = msg.height;
+  cloud.is_dense = msg.is_dense == 1;
+
+  const std::vector<pcl::PCLPointField> &fields = cloud.getFields ();
+  for (size_t f = 0; f < fields.size (); ++f)
+  {
+    const pcl::PCLPointField *match = NULL;
+    for (size_t m = 0; m < msg.fields.size (); ++m)
+    {
+      const pcl::PCLPointField &field = msg.fields[m];
+      if (field.name == fields[f].name && field.datatype == fields[f].datatype &&
+          (field.count == fields[f].count || (field.count == 0 && fields[f].count == 1)))
+      {
+        match = &field;
+        break;
+      }
+    }
+    const size_t es = cloud.getElementSize (f);
+    uint8_t *dst = cloud.getColumnData (f);
+    if (!match)
+    {
+      // Do not leave the column with what it held before the conversion
+      PCL_WARN ("Failed to find match for field '%s'.\n", fields[f].name.c_str ());
+      std::fill (dst, dst + cloud.size () * es, 0);
+      continue;
+    }
+    if (cloud.empty ())
+      continue;
+
+    // Gather row by row, as each row of the blob may carry trailing padding
+    for (uint32_t row = 0; row < msg.height; ++row)
+    {
+      const uint8_t *src = &msg.data[row * msg.row_step + match->offset];
+      detail::copyStrided (src, msg.point_step, dst + row * msg.width * es, es, es, msg.width);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::toPCLPointCloud2 (const pcl::PointCloudSoA<PointT> &cloud, pcl::PCLPointCloud2 &msg)
+{
+  // Ease the user's burden on specifying width/height for unorganized datasets
+  if (cloud.width == 0 && cloud.height == 0)
+  {
+    msg.height = 1;
+    msg.width  = static_cast<uint32_t> (cloud.size ());
+  }
+  else
+  {
+    assert (cloud.size () == cloud.width * cloud.height);
+    msg.height = cloud.height;
+    msg.width  = cloud.width;
+  }
+
+  msg.fields = cloud.getFields ();
+  msg.header     = cloud.header;
+  msg.point_step = sizeof (PointT);
+  msg.row_step   = static_cast<uint32_t> (sizeof (PointT) * msg.width);
+  msg.is_dense   = cloud.is_dense;
+  /// @todo msg.is_bigendian = ?;
+
+  msg.data.assign (cloud.size () * sizeof (PointT), 0);
+  if (cloud.empty ())
+    return;
+  for (size_t f = 0; f < msg.fields.size (); ++f)
+  {
+    const size_t es = cloud.getElementSize (f);
+    detail::copyStrided (cloud.getColumnData (f), es, &msg.data[msg.fields[f].offset], sizeof (PointT), es, cloud.size ());
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::copyPointCloud (const pcl::PointCloudSoA<PointT> &cloud_in, const std::vector<int> &indices,
+                     pcl::PointCloudSoA<PointT> &cloud_out)
+{
+  cloud_out.resize (indices.size ());
+  cloud_out.header              = cloud_in.header;
+  cloud_out.is_dense            = cloud_in.is_dense;
+  cloud_out.sensor_origin_      = cloud_in.sensor_origin_;
+  cloud_out.sensor_orientation_ = cloud_in.sensor_orientation_;
+  if (indices.empty ())
+    return;
+
+  for (size_t f = 0; f < cloud_in.getFields ().size (); ++f)
+  {
+    const size_t es = cloud_in.getElementSize (f);
+    const uint8_t *src = cloud_in.getColumnData (f);
+    uint8_t *dst = cloud_out.getColumnData (f);
+    if (es == sizeof (float))
+    {
+      const uint32_t *s = reinterpret_cast<const uint32_t*> (src);
+      uint32_t *d = reinterpret_cast<uint32_t*> (dst);
+      for (size_t i = 0; i < indices.size (); ++i)
+        d[i] = s[indices[i]];
+    }
+    else
+    {
+      for (size_t i = 0; i < indices.size (); ++i)
+        memcpy (dst + i * es, src + indices[i] * es, es);
+    }
+  }
+}
+
+#endif  // PCL_POINT_CLOUD_SOA_IMPL_HPP_
@@ -0,0 +1,296 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef PCL_POINT_CLOUD_SOA_H_
+#define PCL_POINT_CLOUD_SOA_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_traits.h>
+#include <pcl/PCLPointField.h>
+#include <pcl/PCLPointCloud2.h>
+#include <pcl/conversions.h>
+#include <string>
+#include <vector>
+
+namespace pcl
+{
+  /** \brief Structure-of-arrays storage for a point cloud.
+    *
+    * PointCloudSoA keeps one contiguous, 16-byte aligned column per registered field
+    * of \a PointT (e.g. "x", "y", "z", "rgb", "normal_x", ...) instead of an array of
+    * interleaved, padded point structs. Kernels that only touch a few fields then read
+    * dense streams of values, which keeps the caches clean and lets the compiler
+    * vectorize the inner loops.
+    *
+    * The field list, the datatypes and the element counts are taken from the point type
+    * registration, so every type that works with pcl::PointCloud works here as well.
+    * Padding members are not stored.
+    *
+    * \code
+    * pcl::PointCloudSoA<pcl::PointXYZ> soa (cloud);
+    * const float *x = soa.x (), *y = soa.y (), *z = soa.z ();
+    * for (size_t i = 0; i < soa.size (); ++i)
+    *   ...
+    * \endcode
+    * \author Open Perception
+    * \ingroup common
+    */
+  template <typename PointT>
+  class PointCloudSoA
+  {
+    public:
+      typedef PointT PointType;
+      typedef boost::shared_ptr<PointCloudSoA<PointT> > Ptr;
+      typedef boost::shared_ptr<const PointCloudSoA<PointT> > ConstPtr;
+
+      /** \brief The storage used for a single field column. */
+      typedef std::vector<uint8_t, Eigen::aligned_allocator<uint8_t> > Column;
+
+      /** \brief Default constructor. Creates an empty cloud with the columns of \a PointT. */
+      PointCloudSoA ();
+
+      /** \brief Construct the columns from an array-of-structs point cloud.
+        * \param[in] cloud the input point cloud
+        */
+      explicit PointCloudSoA (const pcl::PointCloud<PointT> &cloud);
+
+      /** \brief Replace the contents with the points and the metadata of \a cloud.
+        * \param[in] cloud the input point cloud
+        */
+      void
+      fromPointCloud (const pcl::PointCloud<PointT> &cloud);
+
+      /** \brief Interleave the columns back into an array-of-structs point cloud.
+        * \param[out] cloud the resultant point cloud
+        */
+      void
+      toPointCloud (pcl::PointCloud<PointT> &cloud) const;
+
+      /** \brief Number of points in the cloud. */
+      inline size_t
+      size () const { return (size_); }
+
+      /** \brief Returns true if the cloud holds no points. */
+      inline bool
+      empty () const { return (size_ == 0); }
+
+      /** \brief Resize every column to \a n points and make the cloud unorganized.
+        * Newly added values are zero-initialized.
+        * \param[in] n the new number of points
+        */
+      void
+      resize (size_t n);
+
+      /** \brief Reserve memory for \a n points in every column.
+        * \param[in] n the number of points to reserve memory for
+        */
+      void
+      reserve (size_t n);
+
+      /** \brief Remove all points. */
+      void
+      clear ();
+
+      /** \brief Append a point at the end of the (unorganized) cloud.
+        * \param[in] pt the point to scatter into the columns
+        */
+      void
+      push_back (const PointT &pt);
+
+      /** \brief Gather the point at index \a n from the columns.
+        * \param[in] n the index of the point
+        */
+      PointT
+      at (size_t n) const;
+
+      /** \brief Scatter \a pt into the columns at index \a n.
+        * \param[in] n the index of the point
+        * \param[in] pt the new point value
+        */
+      void
+      set (size_t n, const PointT &pt);
+
+      /** \brief Get the fields stored in this cloud, one per column. The offsets are those of
+        * the fields inside \a PointT.
+        */
+      inline const std::vector<pcl::PCLPointField>&
+      getFields () const { return (fields_); }
+
+      /** \brief Get the index of the column holding the field called \a name, or -1 if there is none.
+        * \param[in] name the field name
+        */
+      int
+      getFieldIndex (const std::string &name) const;
+
+      /** \brief Get the number of bytes used by a single point in column \a field_idx.
+        * \param[in] field_idx the column index as returned by getFieldIndex ()
+        */
+      inline size_t
+      getElementSize (size_t field_idx) const { return (element_sizes_[field_idx]); }
+
+      /** \brief Raw access to the bytes of column \a field_idx. */
+      inline uint8_t*
+      getColumnData (size_t field_idx) { return (columns_[field_idx].empty () ? NULL : &columns_[field_idx][0]); }
+
+      /** \brief Raw access to the bytes of column \a field_idx. */
+      inline const uint8_t*
+      getColumnData (size_t field_idx) const { return (columns_[field_idx].empty () ? NULL : &columns_[field_idx][0]); }
+
+      /** \brief Typed access to the column holding the field called \a name.
+        * \return NULL if there is no such field, if its datatype is not \a T or if the cloud is empty
+        */
+      template <typename T> T*
+      getColumn (const std::string &name);
+
+      /** \brief Typed access to the column holding the field called \a name.
+        * \return NULL if there is no such field, if its datatype is not \a T or if the cloud is empty
+        */
+      template <typename T> const T*
+      getColumn (const std::string &name) const;
+
+      /** \brief The x coordinates, or NULL if \a PointT has no x field. */
+      inline float*
+      x () { return (columnAt<float> (x_idx_)); }
+      inline const float*
+      x () const { return (columnAt<float> (x_idx_)); }
+
+      /** \brief The y coordinates, or NULL if \a PointT has no y field. */
+      inline float*
+      y () { return (columnAt<float> (y_idx_)); }
+      inline const float*
+      y () const { return (columnAt<float> (y_idx_)); }
+
+      /** \brief The z coordinates, or NULL if \a PointT has no z field. */
+      inline float*
+      z () { return (columnAt<float> (z_idx_)); }
+      inline const float*
+      z () const { return (columnAt<float> (z_idx_)); }
+
+      /** \brief Returns true if the point at index \a n has finite x, y and z coordinates. */
+      inline bool
+      isFinite (size_t n) const
+      {
+        return (pcl_isfinite (x ()[n]) && pcl_isfinite (y ()[n]) && pcl_isfinite (z ()[n]));
+      }
+
+      /** \brief Returns true if the cloud is organized (height > 1). */
+      inline bool
+      isOrganized () const { return (height > 1); }
+
+      /** \brief The point cloud header. */
+      pcl::PCLHeader header;
+
+      /** \brief The point cloud width (if organized as an image-structure). */
+      uint32_t width;
+      /** \brief The point cloud height (if organized as an image-structure). */
+      uint32_t height;
+
+      /** \brief True if no points are invalid (e.g., have NaN or Inf values). */
+      bool is_dense;
+
+      /** \brief Sensor acquisition pose (origin/translation). */
+      Eigen::Vector4f sensor_origin_;
+      /** \brief Sensor acquisition pose (rotation). */
+      Eigen::Quaternionf sensor_orientation_;
+
+    protected:
+      /** \brief Set up fields_, element_sizes_ and the (empty) columns from the registration of \a PointT. */
+      void
+      initFields ();
+
+      template <typename T> inline T*
+      columnAt (int field_idx)
+      {
+        return (field_idx < 0 || size_ == 0 ? NULL : reinterpret_cast<T*> (&columns_[field_idx][0]));
+      }
+
+      template <typename T> inline const T*
+      columnAt (int field_idx) const
+      {
+        return (field_idx < 0 || size_ == 0 ? NULL : reinterpret_cast<const T*> (&columns_[field_idx][0]));
+      }
+
+      /** \brief The fields of \a PointT, one per column. */
+      std::vector<pcl::PCLPointField> fields_;
+      /** \brief The number of bytes per point in each column. */
+      std::vector<size_t> element_sizes_;
+      /** \brief The column storage. */
+      std::vector<Column> columns_;
+      /** \brief The column indices of the x, y and z fields (-1 if not present). */
+      int x_idx_, y_idx_, z_idx_;
+      /** \brief The number of points. */
+      size_t size_;
+
+    public:
+      EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+
+  /** \brief Convert a PCLPointCloud2 binary data blob into a structure-of-arrays cloud.
+    * Fields are matched by name, datatype and count; columns without a matching field
+    * are zero-filled.
+    * \param[in] msg the PCLPointCloud2 binary blob
+    * \param[out] cloud the resultant structure-of-arrays cloud
+    * \ingroup common
+    */
+  template <typename PointT> void
+  fromPCLPointCloud2 (const pcl::PCLPointCloud2 &msg, pcl::PointCloudSoA<PointT> &cloud);
+
+  /** \brief Convert a structure-of-arrays cloud into a PCLPointCloud2 binary data blob. The
+    * blob uses the memory layout of \a PointT, exactly as the pcl::PointCloud overload does.
+    * \param[in] cloud the input structure-of-arrays cloud
+    * \param[out] msg the resultant PCLPointCloud2 binary blob
+    * \ingroup common
+    */
+  template <typename PointT> void
+  toPCLPointCloud2 (const pcl::PointCloudSoA<PointT> &cloud, pcl::PCLPointCloud2 &msg);
+
+  /** \brief Extract the points at \a indices into a new structure-of-arrays cloud.
+    * \param[in] cloud_in the input cloud
+    * \param[in] indices the indices of the points to copy
+    * \param[out] cloud_out the resultant, unorganized cloud
+    * \note cloud_in and cloud_out must be different objects
+    * \ingroup common
+    */
+  template <typename PointT> void
+  copyPointCloud (const pcl::PointCloudSoA<PointT> &cloud_in, const std::vector<int> &indices,
+                  pcl::PointCloudSoA<PointT> &cloud_out);
+}
+
+#include <pcl/impl/point_cloud_soa.hpp>
+
+#endif  // PCL_POINT_CLOUD_SOA_H_
@@ -41,6 +41,8 @@
 
 #include <pcl/pcl_macros.h>
 #include <pcl/common/distances.h>
+#include <pcl/common/task_scheduler.h>
+#include <boost/bind.hpp>
 
 namespace pcl
 {
@@ -229,97 +231,40 @@ RangeImage::createFromPointCloudWithViewpoints (const PointCloudTypeWithViewpoin
 template <typename PointCloudType> void 
 RangeImage::doZBuffer (const PointCloudType& point_cloud, float noise_level, float min_range, int& top, int& right, int& bottom, int& left)
 {
-  typedef typename PointCloudType::PointType PointType2;
-  const typename pcl::PointCloud<PointType2>::VectorType &points2 = point_cloud.points;
-  
-  unsigned int size = width*height;
-  int* counters = new int[size];
-  ERASE_ARRAY (counters, size);
-  
-  top=height; right=-1; bottom=-1; left=width;
+  std::vector<ProjectedPoint> projected (point_cloud.points.size ());
+  parallel_for (0, static_cast<int> (projected.size ()),
+                boost::bind (&RangeImage::projectPoints<PointCloudType>, this, boost::cref (point_cloud), min_range,
+                             _1, _2, boost::ref (projected)),
+                4096, static_cast<unsigned int> ((std::max) (max_no_of_threads, 1)));
   
+  zBufferProjectedPoints (projected, noise_level, top, right, bottom, left);
+}
+
+/////////////////////////////////////////////////////////////////////////
+template <typename PointCloudType> void
+RangeImage::projectPoints (const PointCloudType& point_cloud, float min_range, int begin, int end,
+                           std::vector<ProjectedPoint>& projected) const
+{
   float x_real, y_real, range_of_current_point;
   int x, y;
-  for (typename pcl::PointCloud<PointType2>::VectorType::const_iterator it=points2.begin (); it!=points2.end (); ++it)
+  for (int i = begin; i < end; ++i)
   {
-    if (!isFinite (*it))  // Check for NAN etc
+    ProjectedPoint& projected_point = projected[i];
+    projected_point.range = std::numeric_limits<float>::quiet_NaN ();
+    if (!isFinite (point_cloud.points[i]))  // Check for NAN etc
       continue;
-    Vector3fMapConst current_point = it->getVector3fMap ();
     
-    this->getImagePoint (current_point, x_real, y_real, range_of_current_point);
+    this->getImagePoint (point_cloud.points[i].getVector3fMap (), x_real, y_real, range_of_current_point);
     this->real2DToInt2D (x_real, y_real, x, y);
     
     if (range_of_current_point < min_range|| !isInImage (x, y))
       continue;
-    //std::cout << " ("<<current_point[0]<<", "<<current_point[1]<<", "<<current_point[2]<<") falls into pixel "<<x<<","<<y<<".\n";
-    
-    // Do some minor interpolation by checking the three closest neighbors to the point, that are not filled yet.
-    int floor_x = pcl_lrint (floor (x_real)), floor_y = pcl_lrint (floor (y_real)),
-        ceil_x  = pcl_lrint (ceil (x_real)),  ceil_y  = pcl_lrint (ceil (y_real));
-    
-    int neighbor_x[4], neighbor_y[4];
-    neighbor_x[0]=floor_x; neighbor_y[0]=floor_y;
-    neighbor_x[1]=floor_x; neighbor_y[1]=ceil_y;
-    neighbor_x[2]=ceil_x;  neighbor_y[2]=floor_y;
-    neighbor_x[3]=ceil_x;  neighbor_y[3]=ceil_y;
-    //std::cout << x_real<<","<<y_real<<": ";
-    
-    for (int i=0; i<4; ++i)
-    {
-      int n_x=neighbor_x[i], n_y=neighbor_y[i];
-      //std::cout << n_x<<","<<n_y<<" ";
-      if (n_x==x && n_y==y)
-        continue;
-      if (isInImage (n_x, n_y))
-      {
-        int neighbor_array_pos = n_y*width + n_x;
-        if (counters[neighbor_array_pos]==0)
-        {
-          float& neighbor_range = points[neighbor_array_pos].range;
-          neighbor_range = (pcl_isinf (neighbor_range) ? range_of_current_point : (std::min) (neighbor_range, range_of_current_point));
-          top= (std::min) (top, n_y); right= (std::max) (right, n_x); bottom= (std::max) (bottom, n_y); left= (std::min) (left, n_x);
-        }
-      }
-    }
-    //std::cout <<std::endl;
-    
-    // The point itself
-    int arrayPos = y*width + x;
-    float& range_at_image_point = points[arrayPos].range;
-    int& counter = counters[arrayPos];
-    bool addCurrentPoint=false, replace_with_current_point=false;
-    
-    if (counter==0)
-    {
-      replace_with_current_point = true;
-    }
-    else
-    {
-      if (range_of_current_point < range_at_image_point-noise_level)
-      {
-        replace_with_current_point = true;
-      }
-      else if (fabs (range_of_current_point-range_at_image_point)<=noise_level)
-      {
-        addCurrentPoint = true;
-      }
-    }
-    
-    if (replace_with_current_point)
-    {
-      counter = 1;
-      range_at_image_point = range_of_current_point;
-      top= (std::min) (top, y); right= (std::max) (right, x); bottom= (std::max) (bottom, y); left= (std::min) (left, x);
-      //std::cout << "Adding point "<<x<<","<<y<<"\n";
-    }
-    else if (addCurrentPoint)
-    {
-      ++counter;
-      range_at_image_point += (range_of_current_point-range_at_image_point)/counter;
-    }
+    projected_point.x = x_real;
+    projected_point.y = y_real;
+    projected_point.range = range_of_current_point;
+    projected_point.image_x = x;
+    projected_point.image_y = y;
   }
-  
-  delete[] counters;
 }
 
 /////////////////////////////////////////////////////////////////////////
@@ -297,6 +297,8 @@ namespace pcl
                    float angle_height=pcl::deg2rad (180.0f));
       
       /** \brief Integrate the given point cloud into the current range image using a z-buffer
+        * Large clouds are projected and integrated in parallel on the shared pcl::TaskScheduler; the
+        * resulting image does not depend on the number of threads.
         * \param point_cloud the input point cloud
         * \param noise_level - The distance in meters inside of which the z-buffer will not use the minimum,
         *                      but the mean of the points. If 0.0 it is equivalent to a normal z-buffer and
@@ -781,6 +783,31 @@ namespace pcl
                                                 *   a reference to a non-existing point */
       
       // =====PROTECTED METHODS=====
+      /** Where doZBuffer () projected a point of the cloud into the image */
+      struct ProjectedPoint
+      {
+        float x, y;            /**< Image position */
+        float range;           /**< Range, NaN for points that are not finite, too close or outside of the image */
+        int image_x, image_y;  /**< The pixel, i.e. the rounded image position */
+      };
+
+      /** Applies the z-buffer to the points falling into bands of image rows, defined in range_image.cpp */
+      struct ZBufferBands;
+
+      /** Project the points [begin, end) of point_cloud into the image, for doZBuffer () */
+      template <typename PointCloudType> void
+      projectPoints (const PointCloudType& point_cloud, float min_range, int begin, int end,
+                     std::vector<ProjectedPoint>& projected) const;
+
+      /** Integrate the projected points into the image, like a serial z-buffer over the points in their
+        * order would, but updating disjoint bands of image rows in parallel. See doZBuffer () for the parameters */
+      PCL_EXPORTS void
+      zBufferProjectedPoints (const std::vector<ProjectedPoint>& projected, float noise_level,
+                              int& top, int& right, int& bottom, int& left);
+
+      /** Recalculate the 3D point positions of the rows [row_begin, row_end), for recalculate3DPointPositions () */
+      PCL_EXPORTS void
+      recalculate3DPointRows (int row_begin, int row_end);
 
 
       // =====STATIC PROTECTED=====
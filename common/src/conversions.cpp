@@ -0,0 +1,186 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <pcl/conversions.h>
+#include <boost/thread/mutex.hpp>
+#include <algorithm>
+#include <cstring>
+#include <list>
+
+namespace
+{
+  /** \brief Points per block when copying field by field; keeps a block of both buffers in cache. */
+  const size_t field_block_size = 512;
+
+  /** \brief Points per block when a single memcpy covers the whole point. */
+  const size_t contiguous_block_size = 16384;
+
+  /** \brief Clouds with fewer points are copied by the calling thread alone. */
+  const size_t parallel_threshold = 65536;
+
+  /** \brief Number of (point type, field layout) plans kept by the field map cache. */
+  const size_t field_map_cache_size = 64;
+
+  template <size_t N> inline void
+  copyStridedN (const uint8_t *src, size_t src_stride, uint8_t *dst, size_t dst_stride, size_t n)
+  {
+    // memcpy with a constant size compiles down to one or two (vector) moves
+    for (size_t i = 0; i < n; ++i, src += src_stride, dst += dst_stride)
+      memcpy (dst, src, N);
+  }
+
+  inline void
+  copyStrided (const uint8_t *src, size_t src_stride, uint8_t *dst, size_t dst_stride, size_t size, size_t n)
+  {
+    switch (size)
+    {
+      case 1: copyStridedN<1> (src, src_stride, dst, dst_stride, n); break;
+      case 2: copyStridedN<2> (src, src_stride, dst, dst_stride, n); break;
+      case 4: copyStridedN<4> (src, src_stride, dst, dst_stride, n); break;
+      case 8: copyStridedN<8> (src, src_stride, dst, dst_stride, n); break;
+      case 12: copyStridedN<12> (src, src_stride, dst, dst_stride, n); break;
+      case 16: copyStridedN<16> (src, src_stride, dst, dst_stride, n); break;
+      case 20: copyStridedN<20> (src, src_stride, dst, dst_stride, n); break;
+      case 24: copyStridedN<24> (src, src_stride, dst, dst_stride, n); break;
+      case 32: copyStridedN<32> (src, src_stride, dst, dst_stride, n); break;
+      default:
+        for (size_t i = 0; i < n; ++i, src += src_stride, dst += dst_stride)
+          memcpy (dst, src, size);
+    }
+  }
+
+  inline bool
+  sameLayout (const std::vector<pcl::PCLPointField> &a, const std::vector<pcl::PCLPointField> &b)
+  {
+    if (a.size () != b.size ())
+      return (false);
+    for (size_t i = 0; i < a.size (); ++i)
+      if (a[i].offset != b[i].offset || a[i].datatype != b[i].datatype ||
+          a[i].count != b[i].count || a[i].name != b[i].name)
+        return (false);
+    return (true);
+  }
+
+  struct FieldMapCacheEntry
+  {
+    std::string point_type;
+    std::vector<pcl::PCLPointField> fields;
+    boost::shared_ptr<const pcl::MsgFieldMap> field_map;
+  };
+
+  /** \brief Most recently used entries first. */
+  std::list<FieldMapCacheEntry> field_map_cache;
+  boost::mutex field_map_cache_mutex;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::detail::copyFieldMap (const uint8_t* msg_data, size_t point_step, size_t row_step,
+                           uint8_t* cloud_data, size_t point_size, size_t width, size_t height,
+                           const MsgFieldMap& field_map)
+{
+  if (width == 0 || height == 0 || field_map.empty ())
+    return;
+
+  // Rows without padding are copied as one long row
+  if (row_step == width * point_step)
+  {
+    width *= height;
+    height = 1;
+  }
+
+  const bool contiguous = field_map.size () == 1 &&
+                          field_map[0].serialized_offset == 0 &&
+                          field_map[0].struct_offset == 0 &&
+                          field_map[0].size == point_step &&
+                          field_map[0].size == point_size;
+  const size_t block_size = contiguous ? contiguous_block_size : field_block_size;
+  const size_t blocks_per_row = (width + block_size - 1) / block_size;
+  const int nr_blocks = static_cast<int> (blocks_per_row * height);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule (static) if (width * height >= parallel_threshold)
+#endif
+  for (int block = 0; block < nr_blocks; ++block)
+  {
+    const size_t row = block / blocks_per_row;
+    const size_t begin = (block % blocks_per_row) * block_size;
+    const size_t n = std::min (block_size, width - begin);
+    const uint8_t *src = msg_data + row * row_step + begin * point_step;
+    uint8_t *dst = cloud_data + (row * width + begin) * point_size;
+
+    if (contiguous)
+      memcpy (dst, src, n * point_size);
+    else
+      for (size_t m = 0; m < field_map.size (); ++m)
+        copyStrided (src + field_map[m].serialized_offset, point_step,
+                     dst + field_map[m].struct_offset, point_size, field_map[m].size, n);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+boost::shared_ptr<const pcl::MsgFieldMap>
+pcl::detail::findFieldMap (const char* point_type, const std::vector<pcl::PCLPointField>& msg_fields)
+{
+  boost::mutex::scoped_lock lock (field_map_cache_mutex);
+  for (std::list<FieldMapCacheEntry>::iterator it = field_map_cache.begin (); it != field_map_cache.end (); ++it)
+  {
+    if (it->point_type == point_type && sameLayout (it->fields, msg_fields))
+    {
+      field_map_cache.splice (field_map_cache.begin (), field_map_cache, it);
+      return (it->field_map);
+    }
+  }
+  return (boost::shared_ptr<const MsgFieldMap> ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::detail::storeFieldMap (const char* point_type, const std::vector<pcl::PCLPointField>& msg_fields,
+                            const boost::shared_ptr<const MsgFieldMap>& field_map)
+{
+  FieldMapCacheEntry entry;
+  entry.point_type = point_type;
+  entry.fields = msg_fields;
+  entry.field_map = field_map;
+
+  boost::mutex::scoped_lock lock (field_map_cache_mutex);
+  field_map_cache.push_front (entry);
+  if (field_map_cache.size () > field_map_cache_size)
+    field_map_cache.pop_back ();
+}
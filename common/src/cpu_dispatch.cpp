@@ -0,0 +1,149 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <pcl/common/cpu_dispatch.h>
+#include <pcl/console/print.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace
+{
+  const char* const isa_names[pcl::CPU_ISA_COUNT] = { "generic", "sse2", "sse4.2", "avx2", "avx512" };
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  pcl::CpuIsa
+  detectHostCpuIsa ()
+  {
+#ifdef PCL_CPU_DISPATCH_X86
+    __builtin_cpu_init ();
+    if (__builtin_cpu_supports ("avx512f") && __builtin_cpu_supports ("avx512vl") &&
+        __builtin_cpu_supports ("avx512bw") && __builtin_cpu_supports ("avx512dq") &&
+        __builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma"))
+      return (pcl::CPU_ISA_AVX512);
+    if (__builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma"))
+      return (pcl::CPU_ISA_AVX2);
+    if (__builtin_cpu_supports ("sse4.2"))
+      return (pcl::CPU_ISA_SSE4_2);
+    return (pcl::CPU_ISA_SSE2);
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    // No portable way to query the CPU here: stay at what the compiler already assumes
+    return (pcl::CPU_ISA_SSE2);
+#else
+    return (pcl::CPU_ISA_GENERIC);
+#endif
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  pcl::CpuIsa
+  initDispatchCpuIsa ()
+  {
+    const pcl::CpuIsa host = pcl::getHostCpuIsa ();
+    const char* pcl_cpu_isa = getenv ("PCL_CPU_ISA");
+    if (!pcl_cpu_isa)
+      return (host);
+
+    pcl::CpuIsa isa;
+    if (!pcl::parseCpuIsa (pcl_cpu_isa, isa))
+    {
+      PCL_WARN ("[pcl::getDispatchCpuIsa] Invalid PCL_CPU_ISA set (%s), using %s.\n", pcl_cpu_isa, isa_names[host]);
+      return (host);
+    }
+    return (std::min (isa, host));
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  pcl::CpuIsa&
+  dispatchCpuIsa ()
+  {
+    static pcl::CpuIsa isa = initDispatchCpuIsa ();
+    return (isa);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::CpuIsa
+pcl::getHostCpuIsa ()
+{
+  static const CpuIsa host = detectHostCpuIsa ();
+  return (host);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::CpuIsa
+pcl::getDispatchCpuIsa ()
+{
+  return (dispatchCpuIsa ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::setDispatchCpuIsa (CpuIsa isa)
+{
+  if (isa < CPU_ISA_GENERIC)
+    isa = CPU_ISA_GENERIC;
+  dispatchCpuIsa () = std::min (isa, getHostCpuIsa ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+const char*
+pcl::getCpuIsaName (CpuIsa isa)
+{
+  if (isa < CPU_ISA_GENERIC || isa >= CPU_ISA_COUNT)
+    return ("unknown");
+  return (isa_names[isa]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::parseCpuIsa (const std::string &name, CpuIsa &isa)
+{
+  std::string s (name);
+  std::transform (s.begin (), s.end (), s.begin (), tolower);
+  // Accept "sse42" and "avx-512" style spellings as well
+  s.erase (std::remove (s.begin (), s.end (), '.'), s.end ());
+  s.erase (std::remove (s.begin (), s.end (), '-'), s.end ());
+
+  if (s == "generic" || s == "none")  isa = CPU_ISA_GENERIC;
+  else if (s == "sse2")               isa = CPU_ISA_SSE2;
+  else if (s == "sse42")              isa = CPU_ISA_SSE4_2;
+  else if (s == "avx2")               isa = CPU_ISA_AVX2;
+  else if (s == "avx512")             isa = CPU_ISA_AVX512;
+  else return (false);
+  return (true);
+}
@@ -0,0 +1,225 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <pcl/common/eigen.h>
+#include <pcl/common/cpu_dispatch.h>
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#ifdef PCL_CPU_DISPATCH_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+  typedef void (*SmallestEigenPairsFn) (const Eigen::Matrix3f*, size_t, float*, Eigen::Vector3f*);
+  typedef void (*EigenDecompositionsFn) (const Eigen::Matrix3f*, size_t, Eigen::Matrix3f*, Eigen::Vector3f*);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void
+  smallestEigenPairsGeneric (const Eigen::Matrix3f *matrices, size_t n, float *eigenvalues, Eigen::Vector3f *eigenvectors)
+  {
+    for (size_t i = 0; i < n; ++i)
+      pcl::eigen33 (matrices[i], eigenvalues[i], eigenvectors[i]);
+  }
+
+  void
+  eigenDecompositionsGeneric (const Eigen::Matrix3f *matrices, size_t n, Eigen::Matrix3f *evecs, Eigen::Vector3f *evals)
+  {
+    for (size_t i = 0; i < n; ++i)
+      pcl::eigen33 (matrices[i], evecs[i], evals[i]);
+  }
+
+#if defined(__SSE2__)
+  namespace sse2
+  {
+    struct Pack
+    {
+      typedef __m128 V;
+      typedef __m128 M;
+      static const int lanes = 4;
+      static inline V load (const float *p) { return (_mm_loadu_ps (p)); }
+      static inline void store (float *p, V v) { _mm_storeu_ps (p, v); }
+      static inline V set1 (float f) { return (_mm_set1_ps (f)); }
+      static inline V add (V a, V b) { return (_mm_add_ps (a, b)); }
+      static inline V sub (V a, V b) { return (_mm_sub_ps (a, b)); }
+      static inline V mul (V a, V b) { return (_mm_mul_ps (a, b)); }
+      static inline V div (V a, V b) { return (_mm_div_ps (a, b)); }
+      static inline V sqrt (V a) { return (_mm_sqrt_ps (a)); }
+      static inline V abs (V a) { return (_mm_andnot_ps (_mm_set1_ps (-0.0f), a)); }
+      static inline V min (V a, V b) { return (_mm_min_ps (a, b)); }
+      static inline V max (V a, V b) { return (_mm_max_ps (a, b)); }
+      static inline M lt (V a, V b) { return (_mm_cmplt_ps (a, b)); }
+      static inline M le (V a, V b) { return (_mm_cmple_ps (a, b)); }
+      static inline M gt (V a, V b) { return (_mm_cmpgt_ps (a, b)); }
+      static inline M mand (M a, M b) { return (_mm_and_ps (a, b)); }
+      static inline M mor (M a, M b) { return (_mm_or_ps (a, b)); }
+      static inline M mnot (M a) { return (_mm_xor_ps (a, _mm_castsi128_ps (_mm_set1_epi32 (-1)))); }
+      static inline M mandnot (M a, M b) { return (_mm_andnot_ps (a, b)); }
+      static inline V select (M m, V a, V b) { return (_mm_or_ps (_mm_and_ps (m, a), _mm_andnot_ps (m, b))); }
+    };
+
+#include "eigen33_batch_kernel.hpp"
+  }
+#endif
+
+#ifdef PCL_CPU_DISPATCH_X86
+PCL_TARGET_AVX2_BEGIN
+  namespace avx2
+  {
+    struct Pack
+    {
+      typedef __m256 V;
+      typedef __m256 M;
+      static const int lanes = 8;
+      static inline V load (const float *p) { return (_mm256_loadu_ps (p)); }
+      static inline void store (float *p, V v) { _mm256_storeu_ps (p, v); }
+      static inline V set1 (float f) { return (_mm256_set1_ps (f)); }
+      static inline V add (V a, V b) { return (_mm256_add_ps (a, b)); }
+      static inline V sub (V a, V b) { return (_mm256_sub_ps (a, b)); }
+      static inline V mul (V a, V b) { return (_mm256_mul_ps (a, b)); }
+      static inline V div (V a, V b) { return (_mm256_div_ps (a, b)); }
+      static inline V sqrt (V a) { return (_mm256_sqrt_ps (a)); }
+      static inline V abs (V a) { return (_mm256_andnot_ps (_mm256_set1_ps (-0.0f), a)); }
+      static inline V min (V a, V b) { return (_mm256_min_ps (a, b)); }
+      static inline V max (V a, V b) { return (_mm256_max_ps (a, b)); }
+      static inline M lt (V a, V b) { return (_mm256_cmp_ps (a, b, _CMP_LT_OQ)); }
+      static inline M le (V a, V b) { return (_mm256_cmp_ps (a, b, _CMP_LE_OQ)); }
+      static inline M gt (V a, V b) { return (_mm256_cmp_ps (a, b, _CMP_GT_OQ)); }
+      static inline M mand (M a, M b) { return (_mm256_and_ps (a, b)); }
+      static inline M mor (M a, M b) { return (_mm256_or_ps (a, b)); }
+      static inline M mnot (M a) { return (_mm256_xor_ps (a, _mm256_castsi256_ps (_mm256_set1_epi32 (-1)))); }
+      static inline M mandnot (M a, M b) { return (_mm256_andnot_ps (a, b)); }
+      static inline V select (M m, V a, V b) { return (_mm256_blendv_ps (b, a, m)); }
+    };
+
+#include "eigen33_batch_kernel.hpp"
+  }
+PCL_TARGET_END
+
+// GCC's _mm512_undefined_ps () self-initializes and trips these warnings in the AVX-512 kernel
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+PCL_TARGET_AVX512_BEGIN
+  namespace avx512
+  {
+    struct Pack
+    {
+      typedef __m512 V;
+      typedef __mmask16 M;
+      static const int lanes = 16;
+      static inline V load (const float *p) { return (_mm512_loadu_ps (p)); }
+      static inline void store (float *p, V v) { _mm512_storeu_ps (p, v); }
+      static inline V set1 (float f) { return (_mm512_set1_ps (f)); }
+      static inline V add (V a, V b) { return (_mm512_add_ps (a, b)); }
+      static inline V sub (V a, V b) { return (_mm512_sub_ps (a, b)); }
+      static inline V mul (V a, V b) { return (_mm512_mul_ps (a, b)); }
+      static inline V div (V a, V b) { return (_mm512_div_ps (a, b)); }
+      static inline V sqrt (V a) { return (_mm512_sqrt_ps (a)); }
+      static inline V abs (V a) { return (_mm512_abs_ps (a)); }
+      static inline V min (V a, V b) { return (_mm512_min_ps (a, b)); }
+      static inline V max (V a, V b) { return (_mm512_max_ps (a, b)); }
+      static inline M lt (V a, V b) { return (_mm512_cmp_ps_mask (a, b, _CMP_LT_OQ)); }
+      static inline M le (V a, V b) { return (_mm512_cmp_ps_mask (a, b, _CMP_LE_OQ)); }
+      static inline M gt (V a, V b) { return (_mm512_cmp_ps_mask (a, b, _CMP_GT_OQ)); }
+      static inline M mand (M a, M b) { return (static_cast<M> (a & b)); }
+      static inline M mor (M a, M b) { return (static_cast<M> (a | b)); }
+      static inline M mnot (M a) { return (static_cast<M> (~a)); }
+      static inline M mandnot (M a, M b) { return (static_cast<M> (~a & b)); }
+      static inline V select (M m, V a, V b) { return (_mm512_mask_blend_ps (m, b, a)); }
+    };
+
+#include "eigen33_batch_kernel.hpp"
+  }
+PCL_TARGET_END
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  pcl::CpuDispatcher<SmallestEigenPairsFn>
+  makeSmallestEigenPairsDispatcher ()
+  {
+    pcl::CpuDispatcher<SmallestEigenPairsFn> dispatcher (&smallestEigenPairsGeneric);
+#if defined(__SSE2__)
+    dispatcher.add (pcl::CPU_ISA_SSE2, &sse2::smallestEigenPairs<sse2::Pack>);
+#endif
+#ifdef PCL_CPU_DISPATCH_X86
+    dispatcher.add (pcl::CPU_ISA_AVX2, &avx2::smallestEigenPairs<avx2::Pack>);
+    dispatcher.add (pcl::CPU_ISA_AVX512, &avx512::smallestEigenPairs<avx512::Pack>);
+#endif
+    return (dispatcher);
+  }
+
+  pcl::CpuDispatcher<EigenDecompositionsFn>
+  makeEigenDecompositionsDispatcher ()
+  {
+    pcl::CpuDispatcher<EigenDecompositionsFn> dispatcher (&eigenDecompositionsGeneric);
+#if defined(__SSE2__)
+    dispatcher.add (pcl::CPU_ISA_SSE2, &sse2::eigenDecompositions<sse2::Pack>);
+#endif
+#ifdef PCL_CPU_DISPATCH_X86
+    dispatcher.add (pcl::CPU_ISA_AVX2, &avx2::eigenDecompositions<avx2::Pack>);
+    dispatcher.add (pcl::CPU_ISA_AVX512, &avx512::eigenDecompositions<avx512::Pack>);
+#endif
+    return (dispatcher);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::eigen33 (const Eigen::Matrix3f *matrices, size_t n, float *eigenvalues, Eigen::Vector3f *eigenvectors)
+{
+  static const pcl::CpuDispatcher<SmallestEigenPairsFn> dispatcher = makeSmallestEigenPairsDispatcher ();
+  dispatcher.get () (matrices, n, eigenvalues, eigenvectors);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::eigen33 (const Eigen::Matrix3f *matrices, size_t n, Eigen::Matrix3f *evecs, Eigen::Vector3f *evals)
+{
+  static const pcl::CpuDispatcher<EigenDecompositionsFn> dispatcher = makeEigenDecompositionsDispatcher ();
+  dispatcher.get () (matrices, n, evecs, evals);
+}
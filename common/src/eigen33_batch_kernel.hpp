@@ -0,0 +1,382 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+// Lane-parallel versions of pcl::computeRoots and pcl::eigen33, written once against a SIMD
+// "pack" type P and included by eigen.cpp inside one namespace per target instruction set
+// (a template cannot carry a per-instantiation target attribute). No include guard on purpose.
+//
+// A pack provides the vector type V, the mask type M, the lane count 'lanes' and
+// load/store/set1, add/sub/mul/div/sqrt/abs/min/max, lt/le/gt comparisons, the mask operations
+// mand, mor, mnot and mandnot (~a & b), and select (mask, if_true, if_false). Branches of the scalar code become selects, and the
+// trigonometric functions of the cubic root formula become polynomial approximations.
+
+/** \brief Closed form roots of the characteristic polynomial of the symmetric matrices a (scaled
+  * to [-1, 1]), in ascending order. Mirrors pcl::computeRoots.
+  */
+template <typename P> inline void
+computeRootsLanes (const typename P::V *a, typename P::V *roots)
+{
+  typedef typename P::V V;
+  typedef typename P::M M;
+  const V a00 = a[0], a01 = a[1], a02 = a[2], a11 = a[3], a12 = a[4], a22 = a[5];
+  const V zero = P::set1 (0.0f), half = P::set1 (0.5f), one = P::set1 (1.0f), two = P::set1 (2.0f);
+  const V inv3 = P::set1 (1.0f / 3.0f);
+
+  const V c0 = P::sub (P::sub (P::sub (P::add (P::mul (P::mul (a00, a11), a22), P::mul (two, P::mul (P::mul (a01, a02), a12))),
+                                       P::mul (P::mul (a00, a12), a12)),
+                               P::mul (P::mul (a11, a02), a02)),
+                       P::mul (P::mul (a22, a01), a01));
+  const V c1 = P::add (P::add (P::sub (P::mul (a00, a11), P::mul (a01, a01)),
+                               P::sub (P::mul (a00, a22), P::mul (a02, a02))),
+                       P::sub (P::mul (a11, a22), P::mul (a12, a12)));
+  const V c2 = P::add (P::add (a00, a11), a22);
+
+  // One root is 0: quadratic equation (computeRoots2)
+  const V d = P::max (P::sub (P::mul (c2, c2), P::mul (P::set1 (4.0f), c1)), zero);
+  const V sd = P::sqrt (d);
+  const V quad1 = P::mul (half, P::sub (c2, sd));
+  const V quad2 = P::mul (half, P::add (c2, sd));
+
+  // Cubic in trigonometric form
+  const V c2_over_3 = P::mul (c2, inv3);
+  const V a_over_3 = P::min (P::mul (P::sub (c1, P::mul (c2, c2_over_3)), inv3), zero);
+  const V half_b = P::mul (half, P::add (c0, P::mul (c2_over_3, P::sub (P::mul (two, P::mul (c2_over_3, c2_over_3)), c1))));
+  const V q = P::min (P::add (P::mul (half_b, half_b), P::mul (P::mul (a_over_3, a_over_3), a_over_3)), zero);
+  const V rho = P::sqrt (P::sub (zero, a_over_3));
+
+  // theta = atan2 (sqrt (-q), half_b) / 3, with atan reduced to [0, tan (pi / 8)] as in Cephes atanf
+  const V y = P::sqrt (P::sub (zero, q));
+  const V x = P::abs (half_b);
+  const V big = P::max (x, y);
+  const V ratio = P::div (P::min (x, y), P::select (P::le (big, zero), one, big));
+  const M reduce = P::gt (ratio, P::set1 (0.41421356f));
+  const V u = P::select (reduce, P::div (P::sub (ratio, one), P::add (ratio, one)), ratio);
+  const V z = P::mul (u, u);
+  V atan = P::add (P::mul (P::set1 (8.05374449538e-2f), z), P::set1 (-1.38776856032e-1f));
+  atan = P::add (P::mul (atan, z), P::set1 (1.99777106478e-1f));
+  atan = P::add (P::mul (atan, z), P::set1 (-3.33329491539e-1f));
+  atan = P::add (u, P::mul (P::mul (u, z), atan));
+  atan = P::select (reduce, P::add (atan, P::set1 (0.78539816f)), atan);
+  atan = P::select (P::gt (y, x), P::sub (P::set1 (1.57079633f), atan), atan);
+  atan = P::select (P::lt (half_b, zero), P::sub (P::set1 (3.14159265f), atan), atan);
+  const V theta = P::mul (atan, inv3);
+
+  // sin and cos on [0, pi / 3], Taylor series to x^9 and x^10
+  const V theta2 = P::mul (theta, theta);
+  V sin_theta = P::add (P::mul (P::set1 (1.0f / 362880.0f), theta2), P::set1 (-1.0f / 5040.0f));
+  sin_theta = P::add (P::mul (sin_theta, theta2), P::set1 (1.0f / 120.0f));
+  sin_theta = P::add (P::mul (sin_theta, theta2), P::set1 (-1.0f / 6.0f));
+  sin_theta = P::add (P::mul (P::mul (sin_theta, theta2), theta), theta);
+  V cos_theta = P::add (P::mul (P::set1 (-1.0f / 3628800.0f), theta2), P::set1 (1.0f / 40320.0f));
+  cos_theta = P::add (P::mul (cos_theta, theta2), P::set1 (-1.0f / 720.0f));
+  cos_theta = P::add (P::mul (cos_theta, theta2), P::set1 (1.0f / 24.0f));
+  cos_theta = P::add (P::mul (cos_theta, theta2), P::set1 (-0.5f));
+  cos_theta = P::add (P::mul (cos_theta, theta2), one);
+
+  const V sqrt3_sin = P::mul (P::set1 (1.7320508f), sin_theta);
+  const V t0 = P::add (c2_over_3, P::mul (P::mul (two, rho), cos_theta));
+  const V t1 = P::sub (c2_over_3, P::mul (rho, P::add (cos_theta, sqrt3_sin)));
+  const V t2 = P::sub (c2_over_3, P::mul (rho, P::sub (cos_theta, sqrt3_sin)));
+
+  // Sort in increasing order
+  const V lo = P::min (t0, t1), hi = P::max (t0, t1);
+  const V mid = P::min (hi, t2);
+  const V r2 = P::max (hi, t2);
+  const V r0 = P::min (lo, mid);
+  const V r1 = P::max (lo, mid);
+
+  // Eigenvalues of a positive semi-definite matrix can not be negative: use the quadratic then
+  const M quadratic = P::mor (P::lt (P::abs (c0), P::set1 (std::numeric_limits<float>::epsilon ())), P::le (r0, zero));
+  roots[0] = P::select (quadratic, zero, r0);
+  roots[1] = P::select (quadratic, quad1, r1);
+  roots[2] = P::select (quadratic, quad2, r2);
+}
+
+/** \brief Cross product of two lane vectors. */
+template <typename P> inline void
+crossLanes (const typename P::V *a, const typename P::V *b, typename P::V *out)
+{
+  out[0] = P::sub (P::mul (a[1], b[2]), P::mul (a[2], b[1]));
+  out[1] = P::sub (P::mul (a[2], b[0]), P::mul (a[0], b[2]));
+  out[2] = P::sub (P::mul (a[0], b[1]), P::mul (a[1], b[0]));
+}
+
+/** \brief Squared norm of a lane vector. */
+template <typename P> inline typename P::V
+squaredNormLanes (const typename P::V *v)
+{
+  return (P::add (P::add (P::mul (v[0], v[0]), P::mul (v[1], v[1])), P::mul (v[2], v[2])));
+}
+
+/** \brief Scale a lane vector to unit length. */
+template <typename P> inline void
+normalizeLanes (typename P::V *v)
+{
+  const typename P::V inv = P::div (P::set1 (1.0f), P::sqrt (squaredNormLanes<P> (v)));
+  for (int d = 0; d < 3; ++d)
+    v[d] = P::mul (v[d], inv);
+}
+
+/** \brief Unit eigenvector of the scaled matrices a for the eigenvalue lambda: the longest of the
+  * cross products of the rows of (a - lambda I), as in pcl::eigen33. On ties the first of them wins.
+  * \param[out] last_len if not NULL, the squared length of the last cross product, (row 1) x (row 2)
+  * \return the squared length of the chosen cross product
+  */
+template <typename P> inline typename P::V
+eigenVectorLanes (const typename P::V *a, const typename P::V lambda, typename P::V *vec,
+                  typename P::V *last_len = NULL)
+{
+  typedef typename P::V V;
+  typedef typename P::M M;
+  const V row0[3] = { P::sub (a[0], lambda), a[1], a[2] };
+  const V row1[3] = { a[1], P::sub (a[3], lambda), a[4] };
+  const V row2[3] = { a[2], a[4], P::sub (a[5], lambda) };
+  V vec1[3], vec2[3], vec3[3];
+  crossLanes<P> (row0, row1, vec1);
+  crossLanes<P> (row0, row2, vec2);
+  crossLanes<P> (row1, row2, vec3);
+  const V len1 = squaredNormLanes<P> (vec1), len2 = squaredNormLanes<P> (vec2), len3 = squaredNormLanes<P> (vec3);
+
+  const M pick1 = P::mand (P::le (len2, len1), P::le (len3, len1));
+  const M pick2 = P::mandnot (pick1, P::mand (P::le (len1, len2), P::le (len3, len2)));
+  const V len = P::select (pick1, len1, P::select (pick2, len2, len3));
+  const V inv = P::div (P::set1 (1.0f), P::sqrt (len));
+  for (int d = 0; d < 3; ++d)
+    vec[d] = P::mul (P::select (pick1, vec1[d], P::select (pick2, vec2[d], vec3[d])), inv);
+  if (last_len)
+    *last_len = len3;
+  return (len);
+}
+
+/** \brief A unit vector orthogonal to v, as Eigen's unitOrthogonal () computes it. */
+template <typename P> inline void
+unitOrthogonalLanes (const typename P::V *v, typename P::V *out)
+{
+  typedef typename P::V V;
+  typedef typename P::M M;
+  const V zero = P::set1 (0.0f), one = P::set1 (1.0f);
+  const V precision = P::mul (P::abs (v[2]), P::set1 (Eigen::NumTraits<float>::dummy_precision ()));
+  // Use the xy plane unless x and y are both much smaller than z
+  const M use_xy = P::mor (P::gt (P::abs (v[0]), precision), P::gt (P::abs (v[1]), precision));
+  const V inv_xy = P::div (one, P::sqrt (P::add (P::mul (v[0], v[0]), P::mul (v[1], v[1]))));
+  const V inv_yz = P::div (one, P::sqrt (P::add (P::mul (v[1], v[1]), P::mul (v[2], v[2]))));
+  out[0] = P::select (use_xy, P::mul (P::sub (zero, v[1]), inv_xy), zero);
+  out[1] = P::select (use_xy, P::mul (v[0], inv_xy), P::mul (P::sub (zero, v[2]), inv_yz));
+  out[2] = P::select (use_xy, zero, P::mul (v[1], inv_yz));
+}
+
+/** \brief Scale the matrices a in place so that their entries are in [-1, 1].
+  * \return the scale factors
+  */
+template <typename P> inline typename P::V
+scaleLanes (typename P::V *a)
+{
+  typedef typename P::V V;
+  V scale = P::abs (a[0]);
+  for (int c = 1; c < 6; ++c)
+    scale = P::max (scale, P::abs (a[c]));
+  scale = P::select (P::le (scale, P::set1 (std::numeric_limits<float>::min ())), P::set1 (1.0f), scale);
+  const V inv = P::div (P::set1 (1.0f), scale);
+  for (int c = 0; c < 6; ++c)
+    a[c] = P::mul (a[c], inv);
+  return (scale);
+}
+
+/** \brief Smallest eigenvalue and eigenvector of P::lanes matrices.
+  * \param[in] in the xx, xy, xz, yy, yz, zz coefficients, P::lanes floats each
+  * \param[out] eigenvalue P::lanes eigenvalues
+  * \param[out] eigenvector the x, y, z components, P::lanes floats each
+  */
+template <typename P> void
+smallestEigenPairLanes (const float *in, float *eigenvalue, float *eigenvector)
+{
+  typedef typename P::V V;
+  V a[6];
+  for (int c = 0; c < 6; ++c)
+    a[c] = P::load (in + c * P::lanes);
+  const V scale = scaleLanes<P> (a);
+
+  V roots[3], vec[3];
+  computeRootsLanes<P> (a, roots);
+  eigenVectorLanes<P> (a, roots[0], vec);
+
+  P::store (eigenvalue, P::mul (roots[0], scale));
+  for (int d = 0; d < 3; ++d)
+    P::store (eigenvector + d * P::lanes, vec[d]);
+}
+
+/** \brief Eigenvalues and eigenvectors of P::lanes matrices.
+  * \param[in] in the xx, xy, xz, yy, yz, zz coefficients, P::lanes floats each
+  * \param[out] evals the three eigenvalues in ascending order, P::lanes floats each
+  * \param[out] evecs the column major eigenvector matrices, P::lanes floats per coefficient
+  */
+template <typename P> void
+eigenDecompositionLanes (const float *in, float *evals, float *evecs)
+{
+  typedef typename P::V V;
+  typedef typename P::M M;
+  const V eps = P::set1 (Eigen::NumTraits<float>::epsilon ());
+  const V zero = P::set1 (0.0f), one = P::set1 (1.0f);
+  V a[6];
+  for (int c = 0; c < 6; ++c)
+    a[c] = P::load (in + c * P::lanes);
+  const V scale = scaleLanes<P> (a);
+
+  V roots[3];
+  computeRootsLanes<P> (a, roots);
+
+  // Candidate eigenvectors of the three eigenvalues, and the lengths they were normalized from
+  V col[3][3], len[3];
+  V last_len;
+  len[0] = eigenVectorLanes<P> (a, roots[0], col[0], &last_len);
+  for (int k = 1; k < 3; ++k)
+    len[k] = eigenVectorLanes<P> (a, roots[k], col[k]);
+
+  // General case: rebuild the least reliable vector, then the middle one, from cross products.
+  // As in pcl::eigen33, vector 2 starts as both minimum and maximum and vectors 1 and 0 replace it:
+  // on the minimum if not longer (<=), on the maximum only if strictly longer (>). So among equal
+  // lengths the minimum goes to the lowest index and the maximum stays with the highest one.
+  // pcl::eigen33 weighs vector 0 by the last cross product it computed, not by the chosen one;
+  // last_len keeps that, so that both pick the same vectors to rebuild.
+  M is_min[3], is_max[3];
+  is_min[1] = P::le (len[1], len[2]);
+  is_max[1] = P::gt (len[1], len[2]);
+  const V len_min = P::select (is_min[1], len[1], len[2]);
+  const V len_max = P::select (is_max[1], len[1], len[2]);
+  is_min[0] = P::le (last_len, len_min);
+  is_max[0] = P::gt (last_len, len_max);
+  is_min[1] = P::mandnot (is_min[0], is_min[1]);
+  is_max[1] = P::mandnot (is_max[0], is_max[1]);
+  is_min[2] = P::mnot (P::mor (is_min[0], is_min[1]));
+  is_max[2] = P::mnot (P::mor (is_max[0], is_max[1]));
+
+  V rebuilt[3][3], general[3][3];
+  for (int k = 0; k < 3; ++k)
+  {
+    V c[3];
+    crossLanes<P> (col[(k + 1) % 3], col[(k + 2) % 3], c);
+    normalizeLanes<P> (c);
+    for (int d = 0; d < 3; ++d)
+      rebuilt[k][d] = P::select (is_min[k], c[d], col[k][d]);
+  }
+  for (int k = 0; k < 3; ++k)
+  {
+    const M is_mid = P::mnot (P::mor (is_min[k], is_max[k]));
+    V c[3];
+    crossLanes<P> (rebuilt[(k + 1) % 3], rebuilt[(k + 2) % 3], c);
+    normalizeLanes<P> (c);
+    for (int d = 0; d < 3; ++d)
+      general[k][d] = P::select (is_mid, c[d], rebuilt[k][d]);
+  }
+
+  // First and second eigenvalue equal: keep the third vector, complete an orthonormal frame
+  V first_eq[3][3];
+  for (int d = 0; d < 3; ++d)
+    first_eq[2][d] = col[2][d];
+  unitOrthogonalLanes<P> (first_eq[2], first_eq[1]);
+  crossLanes<P> (first_eq[1], first_eq[2], first_eq[0]);
+
+  // Second and third equal: keep the first vector
+  V second_eq[3][3];
+  for (int d = 0; d < 3; ++d)
+    second_eq[0][d] = col[0][d];
+  unitOrthogonalLanes<P> (second_eq[0], second_eq[1]);
+  crossLanes<P> (second_eq[0], second_eq[1], second_eq[2]);
+
+  const M all_equal = P::le (P::sub (roots[2], roots[0]), eps);
+  const M first_equal = P::le (P::sub (roots[1], roots[0]), eps);
+  const M second_equal = P::le (P::sub (roots[2], roots[1]), eps);
+  for (int k = 0; k < 3; ++k)
+  {
+    for (int d = 0; d < 3; ++d)
+    {
+      V v = P::select (second_equal, second_eq[k][d], general[k][d]);
+      v = P::select (first_equal, first_eq[k][d], v);
+      v = P::select (all_equal, k == d ? one : zero, v);
+      P::store (evecs + (k * 3 + d) * P::lanes, v);
+    }
+    P::store (evals + k * P::lanes, P::mul (roots[k], scale));
+  }
+}
+
+/** \brief Solve n matrices, P::lanes at a time, with smallestEigenPairLanes. */
+template <typename P> void
+smallestEigenPairs (const Eigen::Matrix3f *matrices, size_t n, float *eigenvalues, Eigen::Vector3f *eigenvectors)
+{
+  const int lanes = P::lanes;
+  const int coeffs[6] = { 0, 1, 2, 4, 5, 8 };
+  float in[6 * lanes], value[lanes], vector[3 * lanes];
+  for (size_t base = 0; base < n; base += lanes)
+  {
+    const int count = static_cast<int> (std::min (n - base, static_cast<size_t> (lanes)));
+    // Unused lanes of the last batch repeat its first matrix
+    for (int l = 0; l < lanes; ++l)
+      for (int c = 0; c < 6; ++c)
+        in[c * lanes + l] = matrices[base + (l < count ? l : 0)].coeff (coeffs[c]);
+    smallestEigenPairLanes<P> (in, value, vector);
+    for (int l = 0; l < count; ++l)
+    {
+      eigenvalues[base + l] = value[l];
+      eigenvectors[base + l] = Eigen::Vector3f (vector[l], vector[lanes + l], vector[2 * lanes + l]);
+    }
+  }
+}
+
+/** \brief Solve n matrices, P::lanes at a time, with eigenDecompositionLanes. */
+template <typename P> void
+eigenDecompositions (const Eigen::Matrix3f *matrices, size_t n, Eigen::Matrix3f *evecs, Eigen::Vector3f *evals)
+{
+  const int lanes = P::lanes;
+  const int coeffs[6] = { 0, 1, 2, 4, 5, 8 };
+  float in[6 * lanes], values[3 * lanes], vectors[9 * lanes];
+  for (size_t base = 0; base < n; base += lanes)
+  {
+    const int count = static_cast<int> (std::min (n - base, static_cast<size_t> (lanes)));
+    for (int l = 0; l < lanes; ++l)
+      for (int c = 0; c < 6; ++c)
+        in[c * lanes + l] = matrices[base + (l < count ? l : 0)].coeff (coeffs[c]);
+    eigenDecompositionLanes<P> (in, values, vectors);
+    for (int l = 0; l < count; ++l)
+    {
+      for (int k = 0; k < 3; ++k)
+        evals[base + l][k] = values[k * lanes + l];
+      for (int c = 0; c < 9; ++c)
+        evecs[base + l].coeffRef (c) = vectors[c * lanes + l];
+    }
+  }
+}
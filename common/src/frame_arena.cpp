@@ -0,0 +1,208 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include <pcl/common/frame_arena.h>
+#include <boost/thread/tss.hpp>
+
+namespace
+{
+  boost::thread_specific_ptr<pcl::FrameArena> thread_arena;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::FrameArena::FrameArena ()
+  : buffers_ ()
+  , statistics_ ()
+  , current_stage_ ()
+{
+  setStage ("default");
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::FrameArena&
+pcl::FrameArena::getThreadArena ()
+{
+  FrameArena *arena = thread_arena.get ();
+  if (!arena)
+  {
+    arena = new FrameArena;
+    thread_arena.reset (arena);
+  }
+  return (*arena);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::FrameArena::beginFrame ()
+{
+  accountGrowth ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::FrameArena::setStage (const std::string &name)
+{
+  // Growth up to here happened in the stage that was active until now
+  accountGrowth ();
+
+  // Only the first activation of a stage inserts into the map
+  StatisticsMap::iterator it = statistics_.find (name);
+  if (it == statistics_.end ())
+    it = statistics_.insert (std::make_pair (name, StageStatistics ())).first;
+  current_stage_ = it;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+const pcl::FrameArena::StatisticsMap&
+pcl::FrameArena::getStatistics ()
+{
+  accountGrowth ();
+  return (statistics_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+size_t
+pcl::FrameArena::getBytesAllocated ()
+{
+  accountGrowth ();
+  size_t bytes = 0;
+  for (StatisticsMap::const_iterator it = statistics_.begin (); it != statistics_.end (); ++it)
+    bytes += it->second.bytes_allocated;
+  return (bytes);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::FrameArena::resetStatistics ()
+{
+  // The active stage and the enclosing ScopedStage objects keep iterators to their entries,
+  // so these are zeroed rather than erased
+  accountGrowth ();
+  for (StatisticsMap::iterator it = statistics_.begin (); it != statistics_.end (); ++it)
+    it->second = StageStatistics ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+size_t
+pcl::FrameArena::getBytesReserved () const
+{
+  size_t bytes = 0;
+  for (size_t i = 0; i < buffers_.size (); ++i)
+    bytes += buffers_[i].bytes (buffers_[i].object.get ());
+  return (bytes);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+size_t
+pcl::FrameArena::getNumberOfBuffersInUse () const
+{
+  size_t in_use = 0;
+  for (size_t i = 0; i < buffers_.size (); ++i)
+    if (!buffers_[i].object.unique ())
+      ++in_use;
+  return (in_use);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::FrameArena::trim ()
+{
+  accountGrowth ();
+  size_t kept = 0;
+  for (size_t i = 0; i < buffers_.size (); ++i)
+    if (!buffers_[i].object.unique ())
+      buffers_[kept++] = buffers_[i];
+  buffers_.resize (kept);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::FrameArena::Buffer*
+pcl::FrameArena::findFreeBuffer (const std::type_info &type)
+{
+  for (size_t i = 0; i < buffers_.size (); ++i)
+  {
+    Buffer &buffer = buffers_[i];
+    if (*buffer.type != type || !buffer.object.unique ())
+      continue;
+
+    // Charge what the buffer grew since the last stage switch before handing it out
+    accountBuffer (buffer);
+    ++current_stage_->second.acquisitions;
+    return (&buffer);
+  }
+  return (NULL);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::FrameArena::Buffer*
+pcl::FrameArena::createBuffer (const boost::shared_ptr<void> &object, const std::type_info &type,
+                               size_t (*bytes) (const void*))
+{
+  Buffer buffer;
+  buffer.object = object;
+  buffer.type = &type;
+  buffer.bytes = bytes;
+  buffer.accounted_bytes = bytes (object.get ());
+  buffers_.push_back (buffer);
+
+  StageStatistics &stage = current_stage_->second;
+  ++stage.acquisitions;
+  ++stage.buffers_created;
+  stage.bytes_allocated += buffer.accounted_bytes;
+  return (&buffers_.back ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::FrameArena::accountGrowth ()
+{
+  for (size_t i = 0; i < buffers_.size (); ++i)
+    accountBuffer (buffers_[i]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::FrameArena::accountBuffer (Buffer &buffer) const
+{
+  // A buffer that shrank (e.g. swapped with a smaller one) is charged again once it regrows
+  const size_t bytes = buffer.bytes (buffer.object.get ());
+  if (bytes > buffer.accounted_bytes)
+    current_stage_->second.bytes_allocated += bytes - buffer.accounted_bytes;
+  buffer.accounted_bytes = bytes;
+}
@@ -41,6 +41,22 @@
 #include <pcl/common/eigen.h>
 #include <pcl/range_image/range_image.h>
 #include <pcl/common/transformation_from_correspondences.h>
+#include <pcl/common/task_scheduler.h>
+#include <boost/bind.hpp>
+
+namespace
+{
+  /** Size of the pixels and counters of a band of rows the z-buffer updates at once */
+  const size_t z_buffer_band_bytes = 256 * 1024;
+
+  /** The number of threads RangeImage may use, bounded by RangeImage::max_no_of_threads */
+  unsigned int
+  getNumberOfThreads ()
+  {
+    const unsigned int concurrency = pcl::TaskScheduler::getInstance ().getConcurrency ();
+    return ((std::min) (static_cast<unsigned int> ((std::max) (pcl::RangeImage::max_no_of_threads, 1)), concurrency));
+  }
+}
 
 namespace pcl 
 {
@@ -273,7 +289,15 @@ RangeImage::cropImage (int borderSize, int top, int right, int bottom, int left)
 void 
 RangeImage::recalculate3DPointPositions () 
 {
-  for (int y = 0; y < static_cast<int> (height); ++y) 
+  parallel_for (0, static_cast<int> (height), boost::bind (&RangeImage::recalculate3DPointRows, this, _1, _2),
+                16, getNumberOfThreads ());
+}
+
+/////////////////////////////////////////////////////////////////////////
+void 
+RangeImage::recalculate3DPointRows (int row_begin, int row_end) 
+{
+  for (int y = row_begin; y < row_end; ++y) 
   {
     for (int x = 0; x < static_cast<int> (width); ++x) 
     {
@@ -284,6 +308,330 @@ RangeImage::recalculate3DPointPositions ()
   }
 }
 
+/////////////////////////////////////////////////////////////////////////
+/** Every pixel of the image belongs to exactly one band of rows, and the points updating a band are visited
+  * in their order in the cloud, so that each pixel sees the same sequence of updates as in a serial z-buffer.
+  * The bands are chosen to hold similar numbers of points, the points are sorted into them in parallel chunks. */
+struct RangeImage::ZBufferBands
+{
+  ZBufferBands (RangeImage& image, const std::vector<ProjectedPoint>& projected, float noise_level,
+                int nr_bands, int nr_chunks) :
+    image_ (image), projected_ (projected), noise_level_ (noise_level),
+    nr_points_ (static_cast<int> (projected.size ())), nr_rows_ (static_cast<int> (image.height)),
+    nr_bands_ (nr_bands), nr_chunks_ (nr_chunks),
+    counters_ (image.width*image.height, 0), bounds_ (4*nr_bands),
+    row_counts_ (), row_band_ (), band_first_row_ (nr_bands+1, 0), band_counts_ (), band_begin_ (), sorted_ ()
+  {
+    for (int band = 0; band < nr_bands_; ++band)
+    {
+      bounds_[4*band]   = image.height;  // top
+      bounds_[4*band+1] = -1;            // right
+      bounds_[4*band+2] = -1;            // bottom
+      bounds_[4*band+3] = image.width;   // left
+    }
+    band_first_row_[nr_bands_] = nr_rows_;
+  }
+
+  /** Copy the points into the bands of the rows they update */
+  void
+  sortPoints ()
+  {
+    row_counts_.assign (nr_chunks_*nr_rows_, 0);
+    parallel_for (0, nr_chunks_, boost::bind (&ZBufferBands::countRows, this, _1, _2), 1, nr_chunks_);
+    splitRows ();
+
+    band_counts_.assign (nr_chunks_*nr_bands_, 0);
+    parallel_for (0, nr_chunks_, boost::bind (&ZBufferBands::countBands, this, _1, _2), 1, nr_chunks_);
+
+    // Offsets of every chunk in every band, keeping the points of a band in their order
+    band_begin_.resize (nr_bands_+1);
+    int offset = 0;
+    for (int band = 0; band < nr_bands_; ++band)
+    {
+      band_begin_[band] = offset;
+      for (int chunk = 0; chunk < nr_chunks_; ++chunk)
+      {
+        const int count = band_counts_[chunk*nr_bands_ + band];
+        band_counts_[chunk*nr_bands_ + band] = offset;
+        offset += count;
+      }
+    }
+    band_begin_[nr_bands_] = offset;
+    sorted_.resize (offset);
+    parallel_for (0, nr_chunks_, boost::bind (&ZBufferBands::scatter, this, _1, _2), 1, nr_chunks_);
+  }
+
+  /** Apply the z-buffer to the bands [first_band, last_band) */
+  void
+  apply (int first_band, int last_band)
+  {
+    for (int band = first_band; band < last_band; ++band)
+    {
+      int* bounds = &bounds_[4*band];
+      if (nr_bands_ == 1)
+      {
+        for (int index = 0; index < nr_points_; ++index)
+          applyPoint (projected_[index], 0, nr_rows_, bounds);
+        continue;
+      }
+      for (int i = band_begin_[band]; i < band_begin_[band+1]; ++i)
+        applyPoint (sorted_[i], band_first_row_[band], band_first_row_[band+1], bounds);
+    }
+  }
+
+  /** Merge the bounds of the pixels the bands updated */
+  void
+  getBounds (int& top, int& right, int& bottom, int& left) const
+  {
+    for (int band = 0; band < nr_bands_; ++band)
+    {
+      top    = (std::min) (top,    bounds_[4*band]);
+      right  = (std::max) (right,  bounds_[4*band+1]);
+      bottom = (std::max) (bottom, bounds_[4*band+2]);
+      left   = (std::min) (left,   bounds_[4*band+3]);
+    }
+  }
+
+  /** floor (value) and ceil (value), given the rounded value */
+  static void
+  getFloorAndCeil (float value, int rounded, int& floor_value, int& ceil_value)
+  {
+    floor_value = value < static_cast<float> (rounded) ? rounded-1 : rounded;
+    ceil_value  = value > static_cast<float> (rounded) ? rounded+1 : rounded;
+  }
+
+  void
+  getChunk (int chunk, int& begin, int& end) const
+  {
+    begin = static_cast<int> (static_cast<int64_t> (nr_points_) * chunk / nr_chunks_);
+    end   = static_cast<int> (static_cast<int64_t> (nr_points_) * (chunk+1) / nr_chunks_);
+  }
+
+  /** Histogram of the pixel rows of the points of the chunks [first_chunk, last_chunk) */
+  void
+  countRows (int first_chunk, int last_chunk)
+  {
+    for (int chunk = first_chunk; chunk < last_chunk; ++chunk)
+    {
+      int* counts = &row_counts_[chunk*nr_rows_];
+      int begin, end;
+      getChunk (chunk, begin, end);
+      for (int index = begin; index < end; ++index)
+        if (!pcl_isnan (projected_[index].range))
+          ++counts[projected_[index].image_y];
+    }
+  }
+
+  /** Split the rows into bands holding similar numbers of points */
+  void
+  splitRows ()
+  {
+    std::vector<int64_t> cumulative (nr_rows_+1, 0);
+    for (int row = 0; row < nr_rows_; ++row)
+    {
+      cumulative[row+1] = cumulative[row];
+      for (int chunk = 0; chunk < nr_chunks_; ++chunk)
+        cumulative[row+1] += row_counts_[chunk*nr_rows_ + row];
+    }
+
+    int row = 0;
+    for (int band = 1; band < nr_bands_; ++band)
+    {
+      const int64_t target = cumulative[nr_rows_] * band / nr_bands_;
+      while (row < nr_rows_ && cumulative[row+1] <= target)
+        ++row;
+      // Every band gets at least one row, as long as there are rows left
+      row = (std::max) (row, (std::min) (band_first_row_[band-1]+1, nr_rows_));
+      band_first_row_[band] = row;
+    }
+
+    row_band_.resize (nr_rows_);
+    for (int band = 0; band < nr_bands_; ++band)
+      for (int row = band_first_row_[band]; row < band_first_row_[band+1]; ++row)
+        row_band_[row] = band;
+  }
+
+  /** The bands of the rows of the pixel of point and of its neighbors, -1 for rows outside of the image or
+    * a repeated band */
+  void
+  getBands (const ProjectedPoint& point, int& first_band, int& second_band) const
+  {
+    int floor_y, ceil_y;
+    getFloorAndCeil (point.y, point.image_y, floor_y, ceil_y);
+    first_band  = (floor_y >= 0 && floor_y < nr_rows_) ? row_band_[floor_y] : -1;
+    second_band = (ceil_y  >= 0 && ceil_y  < nr_rows_) ? row_band_[ceil_y]  : -1;
+    if (second_band == first_band)
+      second_band = -1;
+  }
+
+  void
+  countBands (int first_chunk, int last_chunk)
+  {
+    for (int chunk = first_chunk; chunk < last_chunk; ++chunk)
+    {
+      int* counts = &band_counts_[chunk*nr_bands_];
+      int begin, end;
+      getChunk (chunk, begin, end);
+      for (int index = begin; index < end; ++index)
+      {
+        if (pcl_isnan (projected_[index].range))
+          continue;
+        int first_band, second_band;
+        getBands (projected_[index], first_band, second_band);
+        if (first_band >= 0)
+          ++counts[first_band];
+        if (second_band >= 0)
+          ++counts[second_band];
+      }
+    }
+  }
+
+  void
+  scatter (int first_chunk, int last_chunk)
+  {
+    for (int chunk = first_chunk; chunk < last_chunk; ++chunk)
+    {
+      int* offsets = &band_counts_[chunk*nr_bands_];
+      int begin, end;
+      getChunk (chunk, begin, end);
+      for (int index = begin; index < end; ++index)
+      {
+        if (pcl_isnan (projected_[index].range))
+          continue;
+        int first_band, second_band;
+        getBands (projected_[index], first_band, second_band);
+        if (first_band >= 0)
+          sorted_[offsets[first_band]++] = projected_[index];
+        if (second_band >= 0)
+          sorted_[offsets[second_band]++] = projected_[index];
+      }
+    }
+  }
+
+  /** The z-buffer update of one point, restricted to the pixels in rows [row_begin, row_end) */
+  void
+  applyPoint (const ProjectedPoint& projected_point, int row_begin, int row_end, int* bounds)
+  {
+    const float range_of_current_point = projected_point.range;
+    if (pcl_isnan (range_of_current_point))
+      return;
+    const int width = static_cast<int> (image_.width);
+    int& top = bounds[0];
+    int& right = bounds[1];
+    int& bottom = bounds[2];
+    int& left = bounds[3];
+
+    const int x = projected_point.image_x, y = projected_point.image_y;
+
+    // Do some minor interpolation by checking the three closest neighbors to the point, that are not filled yet.
+    int floor_x, floor_y, ceil_x, ceil_y;
+    getFloorAndCeil (projected_point.x, x, floor_x, ceil_x);
+    getFloorAndCeil (projected_point.y, y, floor_y, ceil_y);
+
+    int neighbor_x[4], neighbor_y[4];
+    neighbor_x[0]=floor_x; neighbor_y[0]=floor_y;
+    neighbor_x[1]=floor_x; neighbor_y[1]=ceil_y;
+    neighbor_x[2]=ceil_x;  neighbor_y[2]=floor_y;
+    neighbor_x[3]=ceil_x;  neighbor_y[3]=ceil_y;
+
+    for (int i=0; i<4; ++i)
+    {
+      int n_x=neighbor_x[i], n_y=neighbor_y[i];
+      if (n_x==x && n_y==y)
+        continue;
+      if (n_y >= row_begin && n_y < row_end && image_.isInImage (n_x, n_y))
+      {
+        int neighbor_array_pos = n_y*width + n_x;
+        if (counters_[neighbor_array_pos]==0)
+        {
+          float& neighbor_range = image_.points[neighbor_array_pos].range;
+          neighbor_range = (pcl_isinf (neighbor_range) ? range_of_current_point : (std::min) (neighbor_range, range_of_current_point));
+          top= (std::min) (top, n_y); right= (std::max) (right, n_x); bottom= (std::max) (bottom, n_y); left= (std::min) (left, n_x);
+        }
+      }
+    }
+
+    // The point itself
+    if (y < row_begin || y >= row_end)
+      return;
+    int arrayPos = y*width + x;
+    float& range_at_image_point = image_.points[arrayPos].range;
+    int& counter = counters_[arrayPos];
+    bool addCurrentPoint=false, replace_with_current_point=false;
+
+    if (counter==0)
+    {
+      replace_with_current_point = true;
+    }
+    else
+    {
+      if (range_of_current_point < range_at_image_point-noise_level_)
+      {
+        replace_with_current_point = true;
+      }
+      else if (fabs (range_of_current_point-range_at_image_point)<=noise_level_)
+      {
+        addCurrentPoint = true;
+      }
+    }
+
+    if (replace_with_current_point)
+    {
+      counter = 1;
+      range_at_image_point = range_of_current_point;
+      top= (std::min) (top, y); right= (std::max) (right, x); bottom= (std::max) (bottom, y); left= (std::min) (left, x);
+    }
+    else if (addCurrentPoint)
+    {
+      ++counter;
+      range_at_image_point += (range_of_current_point-range_at_image_point)/static_cast<float> (counter);
+    }
+  }
+
+  RangeImage& image_;
+  const std::vector<ProjectedPoint>& projected_;
+  float noise_level_;
+  int nr_points_, nr_rows_, nr_bands_, nr_chunks_;
+  /** Number of points averaged in every pixel */
+  std::vector<int> counters_;
+  /** top, right, bottom and left pixel updated by every band */
+  std::vector<int> bounds_;
+  /** Number of points per chunk and row */
+  std::vector<int> row_counts_;
+  std::vector<int> row_band_;
+  std::vector<int> band_first_row_;
+  /** Number of points per chunk and band, then the offsets of the chunks in sorted_ */
+  std::vector<int> band_counts_;
+  std::vector<int> band_begin_;
+  /** The points updating each band, band after band */
+  std::vector<ProjectedPoint> sorted_;
+};
+
+/////////////////////////////////////////////////////////////////////////
+void
+RangeImage::zBufferProjectedPoints (const std::vector<ProjectedPoint>& projected, float noise_level,
+                                    int& top, int& right, int& bottom, int& left)
+{
+  top=height; right=-1; bottom=-1; left=width;
+  if (width == 0 || height == 0)
+    return;
+
+  // Besides splitting the work between threads, small bands keep the pixels a point updates in cache, which
+  // pays for sorting the points when it is done in parallel. Small clouds are not worth sorting.
+  const int nr_threads = static_cast<int> (getNumberOfThreads ());
+  const size_t image_bytes = points.size () * (sizeof (PointWithRange) + sizeof (int));
+  int nr_bands = (std::max) (nr_threads, static_cast<int> (image_bytes / z_buffer_band_bytes));
+  nr_bands = (std::min) (nr_bands, static_cast<int> (height));
+  if (nr_threads == 1 || projected.size () < 65536)
+    nr_bands = 1;
+
+  ZBufferBands bands (*this, projected, noise_level, nr_bands, nr_threads);
+  if (nr_bands > 1)
+    bands.sortPoints ();
+  parallel_for (0, nr_bands, boost::bind (&ZBufferBands::apply, &bands, _1, _2), 1, nr_threads);
+  bands.getBounds (top, right, bottom, left);
+}
+
 /////////////////////////////////////////////////////////////////////////
 float* 
 RangeImage::getRangesArray () const 
@@ -39,6 +39,58 @@ using std::cout;
 using std::cerr;
 
 #include <pcl/range_image/range_image_planar.h>
+#include <pcl/common/task_scheduler.h>
+
+namespace
+{
+  /** Fills rows of a planar range image from every skip-th pixel of a depth image, see setDepthImage () */
+  template <typename DepthT>
+  struct DepthImageRows
+  {
+    DepthImageRows (const DepthT* depth_image, int di_width, int skip, float depth_scale,
+                    int width, float center_x, float center_y,
+                    float focal_length_x_reciprocal, float focal_length_y_reciprocal,
+                    const pcl::PointWithRange& unobserved_point, pcl::PointWithRange* points) :
+      depth_image_ (depth_image), di_width_ (di_width), skip_ (skip), depth_scale_ (depth_scale),
+      width_ (width), center_x_ (center_x), center_y_ (center_y),
+      focal_length_x_reciprocal_ (focal_length_x_reciprocal), focal_length_y_reciprocal_ (focal_length_y_reciprocal),
+      unobserved_point_ (unobserved_point), points_ (points)
+    {
+    }
+
+    void
+    operator () (int row_begin, int row_end) const
+    {
+      for (int y = row_begin; y < row_end; ++y)
+      {
+        const DepthT* depth_row = depth_image_ + (y*skip_)*di_width_;
+        pcl::PointWithRange* row = points_ + y*width_;
+        for (int x = 0; x < width_; ++x)
+        {
+          pcl::PointWithRange& point = row[x];
+          float depth = static_cast<float> (depth_row[x*skip_]) * depth_scale_;
+          if (depth <= 0.0f || !pcl_isfinite (depth))
+          {
+            point = unobserved_point_;
+            continue;
+          }
+          point.z = depth;
+          point.x = (static_cast<float> (x) - center_x_) * point.z * focal_length_x_reciprocal_;
+          point.y = (static_cast<float> (y) - center_y_) * point.z * focal_length_y_reciprocal_;
+          point.range = point.getVector3fMap ().norm ();
+        }
+      }
+    }
+
+    const DepthT* depth_image_;
+    int di_width_, skip_;
+    float depth_scale_;
+    int width_;
+    float center_x_, center_y_, focal_length_x_reciprocal_, focal_length_y_reciprocal_;
+    pcl::PointWithRange unobserved_point_;
+    pcl::PointWithRange* points_;
+  };
+}
 
 namespace pcl 
 {
@@ -137,23 +189,12 @@ namespace pcl
     center_y_ = static_cast<float> (di_center_y) / static_cast<float> (skip);
     points.resize (width * height);
     
-    for (int y=0; y < static_cast<int> (height); ++y)
-    {
-      for (int x=0; x < static_cast<int> (width); ++x)
-      {
-        PointWithRange& point = getPointNoCheck (x, y);
-        float depth = depth_image[ (y*skip)*di_width + x*skip];
-        if (depth <= 0.0f || !pcl_isfinite (depth))
-        {
-          point = unobserved_point;
-          continue;
-        }
-        point.z = depth;
-        point.x = (static_cast<float> (x) - center_x_) * point.z * focal_length_x_reciprocal_;
-        point.y = (static_cast<float> (y) - center_y_) * point.z * focal_length_y_reciprocal_;
-        point.range = point.getVector3fMap ().norm ();
-      }
-    }
+    // Rows are independent, so they are filled in parallel
+    parallel_for (0, static_cast<int> (height),
+                  DepthImageRows<float> (depth_image, di_width, skip, 1.0f, static_cast<int> (width),
+                                      center_x_, center_y_, focal_length_x_reciprocal_, focal_length_y_reciprocal_,
+                                      unobserved_point, points.empty () ? NULL : &points[0]),
+                  16, static_cast<unsigned int> ((std::max) (max_no_of_threads, 1)));
   }
 
 
@@ -183,23 +224,12 @@ namespace pcl
     center_y_ = static_cast<float> (di_center_y) / static_cast<float> (skip);
     points.resize (width * height);
     
-    for (int y = 0; y < static_cast<int> (height); ++y)
-    {
-      for (int x = 0; x < static_cast<int> (width); ++x)
-      {
-        PointWithRange& point = getPointNoCheck (x, y);
-        float depth = depth_image[ (y*skip)*di_width + x*skip] * 0.001f;
-        if (depth <= 0.0f || !pcl_isfinite (depth))
-        {
-          point = unobserved_point;
-          continue;
-        }
-        point.z = depth;
-        point.x = (static_cast<float> (x) - center_x_) * point.z * focal_length_x_reciprocal_;
-        point.y = (static_cast<float> (y) - center_y_) * point.z * focal_length_y_reciprocal_;
-        point.range = point.getVector3fMap ().norm ();
-      }
-    }
+    // Rows are independent, so they are filled in parallel
+    parallel_for (0, static_cast<int> (height),
+                  DepthImageRows<unsigned short> (depth_image, di_width, skip, 0.001f, static_cast<int> (width),
+                                      center_x_, center_y_, focal_length_x_reciprocal_, focal_length_y_reciprocal_,
+                                      unobserved_point, points.empty () ? NULL : &points[0]),
+                  16, static_cast<unsigned int> ((std::max) (max_no_of_threads, 1)));
   }
   
   /////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,366 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <pcl/common/task_scheduler.h>
+#include <pcl/console/print.h>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/tss.hpp>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <vector>
+
+namespace
+{
+  struct QueuedTask
+  {
+    pcl::TaskScheduler::Task task;
+    pcl::TaskGroup *group;
+  };
+
+  struct TaskQueue
+  {
+    boost::mutex mutex;
+    std::deque<QueuedTask> tasks;
+  };
+
+  /** \brief Identifies the queue of a worker thread. */
+  struct WorkerSlot
+  {
+    const void *scheduler;
+    size_t queue;
+  };
+
+  void
+  keepWorkerSlot (WorkerSlot*)
+  {
+    // Slots are owned by their scheduler
+  }
+
+  boost::thread_specific_ptr<WorkerSlot> current_worker (&keepWorkerSlot);
+
+  /** \brief Number of nested tasks the thread is running, see TaskScheduler::inTask (). */
+  boost::thread_specific_ptr<unsigned int> task_depth;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct pcl::TaskScheduler::Impl
+{
+  Impl () : concurrency (1), queued (0), stop (false) {}
+
+  /** \brief Queue of the calling thread: its own one for workers, the shared queue 0 for all other threads. */
+  size_t
+  ownQueue () const
+  {
+    const WorkerSlot *slot = current_worker.get ();
+    return (slot && slot->scheduler == this ? slot->queue : 0);
+  }
+
+  /** \brief Take the newest task of queue own, or else steal the oldest task of another queue. */
+  bool
+  take (size_t own, QueuedTask &task)
+  {
+    for (size_t i = 0; i < queues.size (); ++i)
+    {
+      TaskQueue &queue = *queues[(own + i) % queues.size ()];
+      boost::mutex::scoped_lock lock (queue.mutex);
+      if (queue.tasks.empty ())
+        continue;
+      if (i == 0)
+      {
+        task = queue.tasks.back ();
+        queue.tasks.pop_back ();
+      }
+      else
+      {
+        task = queue.tasks.front ();
+        queue.tasks.pop_front ();
+      }
+      lock.unlock ();
+
+      boost::mutex::scoped_lock sleep_lock (sleep_mutex);
+      --queued;
+      return (true);
+    }
+    return (false);
+  }
+
+  static void
+  execute (QueuedTask &task)
+  {
+    try
+    {
+      pcl::detail::TaskScope scope;
+      task.task ();
+    }
+    catch (const std::exception &e)
+    {
+      PCL_ERROR ("[pcl::TaskScheduler] Task threw an exception: %s\n", e.what ());
+    }
+    catch (...)
+    {
+      PCL_ERROR ("[pcl::TaskScheduler] Task threw an exception.\n");
+    }
+    task.group->finish ();
+  }
+
+  void
+  work (size_t index)
+  {
+    current_worker.reset (slots[index].get ());
+    QueuedTask task;
+    while (true)
+    {
+      if (take (index, task))
+      {
+        execute (task);
+        // Release the functor (and what it binds) before sleeping
+        task.task.clear ();
+        continue;
+      }
+
+      boost::mutex::scoped_lock lock (sleep_mutex);
+      while (!stop && queued == 0)
+        work_available.wait (lock);
+      if (stop)
+        return;
+    }
+  }
+
+  void
+  start (unsigned int nr_threads)
+  {
+    concurrency = nr_threads;
+    queues.resize (concurrency);
+    slots.resize (concurrency);
+    for (size_t i = 0; i < concurrency; ++i)
+    {
+      if (!queues[i])
+        queues[i].reset (new TaskQueue);
+      slots[i].reset (new WorkerSlot);
+      slots[i]->scheduler = this;
+      slots[i]->queue = i;
+    }
+    // Queue 0 belongs to the threads outside of the pool
+    for (size_t i = 1; i < concurrency; ++i)
+      workers.push_back (boost::shared_ptr<boost::thread> (
+            new boost::thread (boost::bind (&Impl::work, this, i))));
+  }
+
+  void
+  shutdown ()
+  {
+    {
+      boost::mutex::scoped_lock lock (sleep_mutex);
+      stop = true;
+    }
+    work_available.notify_all ();
+    for (size_t i = 0; i < workers.size (); ++i)
+      workers[i]->join ();
+    workers.clear ();
+    stop = false;
+  }
+
+  unsigned int concurrency;
+
+  /** \brief Queue 0 takes the tasks submitted from outside the pool, queue i those of worker i. */
+  std::vector<boost::shared_ptr<TaskQueue> > queues;
+  std::vector<boost::shared_ptr<WorkerSlot> > slots;
+  std::vector<boost::shared_ptr<boost::thread> > workers;
+
+  /** \brief Idle workers sleep on work_available until queued becomes positive. */
+  boost::mutex sleep_mutex;
+  boost::condition_variable work_available;
+  size_t queued;
+  bool stop;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::TaskScheduler::TaskScheduler (unsigned int concurrency)
+  : impl_ (new Impl)
+{
+  impl_->start (concurrency ? concurrency : getDefaultConcurrency ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::TaskScheduler::~TaskScheduler ()
+{
+  impl_->shutdown ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::TaskScheduler&
+pcl::TaskScheduler::getInstance ()
+{
+  static TaskScheduler scheduler;
+  return (scheduler);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int
+pcl::TaskScheduler::getDefaultConcurrency ()
+{
+  const char* pcl_num_threads = getenv ("PCL_NUM_THREADS");
+  if (pcl_num_threads && atoi (pcl_num_threads) > 0)
+    return (static_cast<unsigned int> (atoi (pcl_num_threads)));
+  return (std::max (boost::thread::hardware_concurrency (), 1u));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::TaskScheduler::setConcurrency (unsigned int concurrency)
+{
+  impl_->shutdown ();
+  impl_->start (concurrency ? concurrency : getDefaultConcurrency ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int
+pcl::TaskScheduler::getConcurrency () const
+{
+  return (impl_->concurrency);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::TaskScheduler::inTask ()
+{
+  const unsigned int *depth = task_depth.get ();
+  return (depth && *depth > 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::TaskScheduler::submit (const Task &task, TaskGroup *group)
+{
+  QueuedTask queued_task;
+  queued_task.task = task;
+  queued_task.group = group;
+
+  TaskQueue &queue = *impl_->queues[impl_->ownQueue ()];
+  {
+    boost::mutex::scoped_lock lock (queue.mutex);
+    queue.tasks.push_back (queued_task);
+  }
+  {
+    boost::mutex::scoped_lock lock (impl_->sleep_mutex);
+    ++impl_->queued;
+  }
+  impl_->work_available.notify_one ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::TaskScheduler::runQueuedTask ()
+{
+  QueuedTask task;
+  if (!impl_->take (impl_->ownQueue (), task))
+    return (false);
+  Impl::execute (task);
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::TaskGroup::TaskGroup (TaskScheduler &scheduler)
+  : scheduler_ (scheduler)
+  , pending_ (0)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::TaskGroup::~TaskGroup ()
+{
+  wait ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::TaskGroup::run (const TaskScheduler::Task &task)
+{
+  {
+    boost::mutex::scoped_lock lock (mutex_);
+    ++pending_;
+  }
+  scheduler_.submit (task, this);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::TaskGroup::wait ()
+{
+  while (true)
+  {
+    {
+      boost::mutex::scoped_lock lock (mutex_);
+      if (pending_ == 0)
+        return;
+    }
+
+    // Help with queued tasks instead of blocking a thread; only sleep once the
+    // remaining tasks of the group are all running elsewhere
+    if (scheduler_.runQueuedTask ())
+      continue;
+
+    boost::mutex::scoped_lock lock (mutex_);
+    if (pending_ != 0)
+      finished_.wait (lock);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::TaskGroup::finish ()
+{
+  boost::mutex::scoped_lock lock (mutex_);
+  if (--pending_ == 0)
+    finished_.notify_all ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::detail::TaskScope::TaskScope ()
+{
+  if (!task_depth.get ())
+    task_depth.reset (new unsigned int (0));
+  ++*task_depth;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::detail::TaskScope::~TaskScope ()
+{
+  --*task_depth;
+}
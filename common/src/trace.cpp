@@ -0,0 +1,328 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <pcl/common/trace.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace
+{
+  enum EventType
+  {
+    EVENT_ZONE,
+    EVENT_COUNTER
+  };
+
+  /** \brief A zone [time, time + value) or the addition of value to a counter at time. */
+  struct Event
+  {
+    const char *name;
+    pcl::uint64_t time;
+    pcl::int64_t value;
+    EventType type;
+  };
+
+  /** \brief Ring buffer of the events of one thread; count keeps growing past the capacity. */
+  struct ThreadBuffer
+  {
+    std::vector<Event> events;
+    size_t count;
+    unsigned int tid;
+  };
+
+  /** \brief An event together with the thread that recorded it. */
+  struct ThreadEvent
+  {
+    Event event;
+    unsigned int tid;
+  };
+
+  inline bool
+  earlier (const ThreadEvent &a, const ThreadEvent &b)
+  {
+    return (a.event.time < b.event.time);
+  }
+
+  void
+  keepThreadBuffer (ThreadBuffer*)
+  {
+    // Buffers are owned by the registry, so that they outlive their threads
+  }
+
+  volatile bool enabled = false;
+  size_t buffer_size = 65536;
+
+  /** \brief Guards buffers, buffer_size and interned. */
+  boost::mutex registry_mutex;
+  std::vector<boost::shared_ptr<ThreadBuffer> > buffers;
+  std::set<std::string> interned;
+  boost::thread_specific_ptr<ThreadBuffer> current_buffer (&keepThreadBuffer);
+
+  inline void
+  record (const char *name, pcl::uint64_t time, pcl::int64_t value, EventType type)
+  {
+    ThreadBuffer *buffer = current_buffer.get ();
+    if (!buffer)
+    {
+      boost::mutex::scoped_lock lock (registry_mutex);
+      boost::shared_ptr<ThreadBuffer> created (new ThreadBuffer);
+      created->events.resize (buffer_size);
+      created->count = 0;
+      created->tid = static_cast<unsigned int> (buffers.size () + 1);
+      buffers.push_back (created);
+      buffer = created.get ();
+      current_buffer.reset (buffer);
+    }
+
+    Event &event = buffer->events[buffer->count % buffer->events.size ()];
+    event.name = name;
+    event.time = time;
+    event.value = value;
+    event.type = type;
+    ++buffer->count;
+  }
+
+  /** \brief The events still held by all ring buffers, oldest first. */
+  std::vector<ThreadEvent>
+  collectEvents ()
+  {
+    std::vector<ThreadEvent> events;
+    boost::mutex::scoped_lock lock (registry_mutex);
+    for (size_t b = 0; b < buffers.size (); ++b)
+    {
+      const ThreadBuffer &buffer = *buffers[b];
+      const size_t size = buffer.events.size ();
+      for (size_t i = buffer.count > size ? buffer.count - size : 0; i < buffer.count; ++i)
+      {
+        ThreadEvent event;
+        event.event = buffer.events[i % size];
+        event.tid = buffer.tid;
+        events.push_back (event);
+      }
+    }
+    std::stable_sort (events.begin (), events.end (), earlier);
+    return (events);
+  }
+
+  void
+  writeJsonString (std::ostream &stream, const char *text)
+  {
+    stream << '"';
+    for (const char *c = text; *c; ++c)
+    {
+      if (*c == '"' || *c == '\\')
+        stream << '\\' << *c;
+      else if (static_cast<unsigned char> (*c) < 0x20)
+      {
+        char escaped[8];
+        sprintf (escaped, "\\u%04x", static_cast<unsigned int> (static_cast<unsigned char> (*c)));
+        stream << escaped;
+      }
+      else
+        stream << *c;
+    }
+    stream << '"';
+  }
+
+  /** \brief Nanoseconds as the microseconds of the trace format. */
+  void
+  writeMicroseconds (std::ostream &stream, pcl::uint64_t nanoseconds)
+  {
+    char text[32];
+    sprintf (text, "%.3f", static_cast<double> (nanoseconds) * 1e-3);
+    stream << text;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::trace::setEnabled (bool enable)
+{
+  enabled = enable;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::trace::isEnabled ()
+{
+  return (enabled);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::trace::setBufferSize (size_t events_per_thread)
+{
+  boost::mutex::scoped_lock lock (registry_mutex);
+  buffer_size = std::max<size_t> (events_per_thread, 1);
+  for (size_t b = 0; b < buffers.size (); ++b)
+  {
+    buffers[b]->events.assign (buffer_size, Event ());
+    buffers[b]->count = 0;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+size_t
+pcl::trace::getBufferSize ()
+{
+  boost::mutex::scoped_lock lock (registry_mutex);
+  return (buffer_size);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::trace::clear ()
+{
+  boost::mutex::scoped_lock lock (registry_mutex);
+  for (size_t b = 0; b < buffers.size (); ++b)
+    buffers[b]->count = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::uint64_t
+pcl::trace::now ()
+{
+#ifdef _WIN32
+  static LARGE_INTEGER frequency;
+  if (frequency.QuadPart == 0)
+    QueryPerformanceFrequency (&frequency);
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter (&counter);
+  return (static_cast<uint64_t> (static_cast<double> (counter.QuadPart) * 1e9 / static_cast<double> (frequency.QuadPart)));
+#else
+  timespec time;
+  clock_gettime (CLOCK_MONOTONIC, &time);
+  return (static_cast<uint64_t> (time.tv_sec) * static_cast<uint64_t> (1000000000) + static_cast<uint64_t> (time.tv_nsec));
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+const char*
+pcl::trace::intern (const std::string &name)
+{
+  boost::mutex::scoped_lock lock (registry_mutex);
+  return (interned.insert (name).first->c_str ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::trace::recordZone (const char *name, uint64_t begin, uint64_t end)
+{
+  record (name, begin, static_cast<int64_t> (end - begin), EVENT_ZONE);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::trace::addCounter (const char *name, int64_t value)
+{
+  record (name, now (), value, EVENT_COUNTER);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::int64_t
+pcl::trace::getCounter (const std::string &name)
+{
+  const std::vector<ThreadEvent> events = collectEvents ();
+  int64_t total = 0;
+  for (size_t i = 0; i < events.size (); ++i)
+    if (events[i].event.type == EVENT_COUNTER && name == events[i].event.name)
+      total += events[i].event.value;
+  return (total);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::trace::writeChromeTrace (std::ostream &stream)
+{
+  const std::vector<ThreadEvent> events = collectEvents ();
+  const uint64_t origin = events.empty () ? 0 : events.front ().event.time;
+  std::set<unsigned int> tids;
+  std::map<std::string, int64_t> totals;
+
+  stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  for (size_t i = 0; i < events.size (); ++i)
+  {
+    const Event &event = events[i].event;
+    tids.insert (events[i].tid);
+    stream << (i ? ",\n" : "\n") << "{\"name\":";
+    writeJsonString (stream, event.name);
+    stream << ",\"cat\":\"pcl\",\"pid\":1,\"tid\":" << events[i].tid << ",\"ts\":";
+    writeMicroseconds (stream, event.time - origin);
+    if (event.type == EVENT_ZONE)
+    {
+      stream << ",\"ph\":\"X\",\"dur\":";
+      writeMicroseconds (stream, static_cast<uint64_t> (event.value));
+      stream << "}";
+    }
+    else
+    {
+      // Counters show the running total over all threads
+      int64_t &total = totals[event.name];
+      total += event.value;
+      stream << ",\"ph\":\"C\",\"args\":{\"value\":" << total << "}}";
+    }
+  }
+  for (std::set<unsigned int>::const_iterator it = tids.begin (); it != tids.end (); ++it)
+    stream << (events.empty () ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << *it
+           << ",\"args\":{\"name\":\"thread " << *it << "\"}}";
+  stream << "\n]}\n";
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::trace::writeChromeTrace (const std::string &file_name)
+{
+  std::ofstream file (file_name.c_str ());
+  if (!file)
+    return (false);
+  writeChromeTrace (file);
+  return (static_cast<bool> (file));
+}
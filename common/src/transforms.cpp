@@ -0,0 +1,404 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <pcl/common/transforms.h>
+#include <pcl/common/cpu_dispatch.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// The AVX2 and AVX-512 kernels are built with function level target attributes, so that a
+// library compiled for a generic x86-64 baseline still uses them on CPUs that support them.
+#ifdef PCL_CPU_DISPATCH_X86
+#include <immintrin.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace
+{
+  /** \brief Loop-invariant state shared by all kernels. */
+  struct TransformJob
+  {
+    const char *in;
+    char *out;
+    size_t stride;
+    const int *indices;
+    bool with_normals;
+    ptrdiff_t normal_offset;
+    const float *matrix;
+    bool check_finite;
+
+    inline const float*
+    input (size_t i) const
+    {
+      return (reinterpret_cast<const float*> (in + (indices ? static_cast<size_t> (indices[i]) : i) * stride));
+    }
+
+    inline float*
+    output (size_t i) const
+    {
+      return (reinterpret_cast<float*> (out + i * stride));
+    }
+
+    inline const float*
+    normal (const float *p) const
+    {
+      return (reinterpret_cast<const float*> (reinterpret_cast<const char*> (p) + normal_offset));
+    }
+
+    inline float*
+    normal (float *p) const
+    {
+      return (reinterpret_cast<float*> (reinterpret_cast<char*> (p) + normal_offset));
+    }
+  };
+
+  typedef void (*TransformKernelFn) (const TransformJob &job, size_t begin, size_t end);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void
+  transformGeneric (const TransformJob &job, size_t begin, size_t end)
+  {
+    const float *m = job.matrix;
+    for (size_t i = begin; i < end; ++i)
+    {
+      const float *p = job.input (i);
+      float *q = job.output (i);
+      const float x = p[0], y = p[1], z = p[2];
+      if (job.check_finite && (!pcl_isfinite (x) || !pcl_isfinite (y) || !pcl_isfinite (z)))
+        continue;
+      if (job.with_normals)
+      {
+        const float *pn = job.normal (p);
+        float *qn = job.normal (q);
+        const float nx = pn[0], ny = pn[1], nz = pn[2];
+        qn[0] = m[0] * nx + m[1] * ny + m[2]  * nz;
+        qn[1] = m[4] * nx + m[5] * ny + m[6]  * nz;
+        qn[2] = m[8] * nx + m[9] * ny + m[10] * nz;
+      }
+      q[0] = m[0] * x + m[1] * y + m[2]  * z + m[3];
+      q[1] = m[4] * x + m[5] * y + m[6]  * z + m[7];
+      q[2] = m[8] * x + m[9] * y + m[10] * z + m[11];
+    }
+  }
+
+#if defined(__SSE2__)
+  /** \brief The columns of the 3x4 matrix, with a zero fourth lane. */
+  struct Columns128
+  {
+    explicit Columns128 (const float *m)
+      : c0 (_mm_setr_ps (m[0], m[4], m[8], 0.0f))
+      , c1 (_mm_setr_ps (m[1], m[5], m[9], 0.0f))
+      , c2 (_mm_setr_ps (m[2], m[6], m[10], 0.0f))
+      , c3 (_mm_setr_ps (m[3], m[7], m[11], 0.0f))
+      , xyz_lanes (_mm_castsi128_ps (_mm_setr_epi32 (-1, -1, -1, 0)))
+    {
+    }
+    __m128 c0, c1, c2, c3, xyz_lanes;
+  };
+
+  /** \brief Lanes 0-2 set where x, y and z of \a v are all finite. */
+  inline __m128
+  finiteMask128 (const __m128 v, const __m128 xyz_lanes)
+  {
+    // v - v is 0 for finite values and NaN for NaN and Inf
+    const __m128 f = _mm_cmpeq_ps (_mm_sub_ps (v, v), _mm_setzero_ps ());
+    const __m128 all = _mm_and_ps (_mm_and_ps (_mm_shuffle_ps (f, f, 0x00), _mm_shuffle_ps (f, f, 0x55)),
+                                   _mm_shuffle_ps (f, f, 0xAA));
+    return (_mm_and_ps (all, xyz_lanes));
+  }
+
+  inline __m128
+  select128 (const __m128 mask, const __m128 a, const __m128 b)
+  {
+    return (_mm_or_ps (_mm_and_ps (mask, a), _mm_andnot_ps (mask, b)));
+  }
+
+  /** \brief Transform a single point with 128 bit registers. Used by all x86 kernels. */
+  inline void
+  transformOne128 (const TransformJob &job, const Columns128 &c, size_t i)
+  {
+    const float *p = job.input (i);
+    float *q = job.output (i);
+    const __m128 v = _mm_loadu_ps (p);
+    const __m128 mask = job.check_finite ? finiteMask128 (v, c.xyz_lanes) : c.xyz_lanes;
+    if (job.with_normals)
+    {
+      const __m128 n = _mm_loadu_ps (job.normal (p));
+      __m128 r = _mm_add_ps (_mm_add_ps (_mm_mul_ps (c.c0, _mm_shuffle_ps (n, n, 0x00)),
+                                         _mm_mul_ps (c.c1, _mm_shuffle_ps (n, n, 0x55))),
+                             _mm_mul_ps (c.c2, _mm_shuffle_ps (n, n, 0xAA)));
+      float *qn = job.normal (q);
+      _mm_storeu_ps (qn, select128 (mask, r, _mm_loadu_ps (qn)));
+    }
+    __m128 r = _mm_add_ps (_mm_add_ps (_mm_mul_ps (c.c0, _mm_shuffle_ps (v, v, 0x00)),
+                                       _mm_mul_ps (c.c1, _mm_shuffle_ps (v, v, 0x55))),
+                           _mm_add_ps (_mm_mul_ps (c.c2, _mm_shuffle_ps (v, v, 0xAA)), c.c3));
+    _mm_storeu_ps (q, select128 (mask, r, _mm_loadu_ps (q)));
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void
+  transformSSE2 (const TransformJob &job, size_t begin, size_t end)
+  {
+    const Columns128 c (job.matrix);
+    for (size_t i = begin; i < end; ++i)
+      transformOne128 (job, c, i);
+  }
+#endif
+
+#ifdef PCL_CPU_DISPATCH_X86
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  PCL_TARGET_AVX2 inline __m256
+  loadPair256 (const float *a, const float *b)
+  {
+    return (_mm256_insertf128_ps (_mm256_castps128_ps256 (_mm_loadu_ps (a)), _mm_loadu_ps (b), 1));
+  }
+
+  PCL_TARGET_AVX2 inline void
+  storePair256 (float *a, float *b, const __m256 v)
+  {
+    _mm_storeu_ps (a, _mm256_castps256_ps128 (v));
+    _mm_storeu_ps (b, _mm256_extractf128_ps (v, 1));
+  }
+
+  PCL_TARGET_AVX2 inline __m256
+  broadcast256 (const __m128 v)
+  {
+    return (_mm256_insertf128_ps (_mm256_castps128_ps256 (v), v, 1));
+  }
+
+  /** \brief Transform points i and i + 1 with 256 bit registers. */
+  PCL_TARGET_AVX2 inline void
+  transformTwo256 (const TransformJob &job, const __m256 *c, const __m256 xyz_lanes, size_t i)
+  {
+    const float *p0 = job.input (i), *p1 = job.input (i + 1);
+    float *q0 = job.output (i), *q1 = job.output (i + 1);
+    const __m256 v = loadPair256 (p0, p1);
+
+    __m256 mask = xyz_lanes;
+    if (job.check_finite)
+    {
+      const __m256 f = _mm256_cmp_ps (_mm256_sub_ps (v, v), _mm256_setzero_ps (), _CMP_EQ_OQ);
+      const __m256 all = _mm256_and_ps (_mm256_and_ps (_mm256_permute_ps (f, 0x00), _mm256_permute_ps (f, 0x55)),
+                                        _mm256_permute_ps (f, 0xAA));
+      mask = _mm256_and_ps (all, xyz_lanes);
+    }
+
+    if (job.with_normals)
+    {
+      float *qn0 = job.normal (q0), *qn1 = job.normal (q1);
+      const __m256 n = loadPair256 (job.normal (p0), job.normal (p1));
+      __m256 r = _mm256_mul_ps (c[0], _mm256_permute_ps (n, 0x00));
+      r = _mm256_fmadd_ps (c[1], _mm256_permute_ps (n, 0x55), r);
+      r = _mm256_fmadd_ps (c[2], _mm256_permute_ps (n, 0xAA), r);
+      storePair256 (qn0, qn1, _mm256_blendv_ps (loadPair256 (qn0, qn1), r, mask));
+    }
+
+    __m256 r = _mm256_fmadd_ps (c[0], _mm256_permute_ps (v, 0x00), c[3]);
+    r = _mm256_fmadd_ps (c[1], _mm256_permute_ps (v, 0x55), r);
+    r = _mm256_fmadd_ps (c[2], _mm256_permute_ps (v, 0xAA), r);
+    storePair256 (q0, q1, _mm256_blendv_ps (loadPair256 (q0, q1), r, mask));
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  PCL_TARGET_AVX2 void
+  transformAVX2 (const TransformJob &job, size_t begin, size_t end)
+  {
+    const Columns128 c128 (job.matrix);
+    __m256 c[4];
+    c[0] = broadcast256 (c128.c0);
+    c[1] = broadcast256 (c128.c1);
+    c[2] = broadcast256 (c128.c2);
+    c[3] = broadcast256 (c128.c3);
+    const __m256 xyz_lanes = broadcast256 (c128.xyz_lanes);
+
+    size_t i = begin;
+    // Eight points per iteration
+    for (; i + 8 <= end; i += 8)
+    {
+      transformTwo256 (job, c, xyz_lanes, i);
+      transformTwo256 (job, c, xyz_lanes, i + 2);
+      transformTwo256 (job, c, xyz_lanes, i + 4);
+      transformTwo256 (job, c, xyz_lanes, i + 6);
+    }
+    for (; i + 2 <= end; i += 2)
+      transformTwo256 (job, c, xyz_lanes, i);
+    for (; i < end; ++i)
+      transformOne128 (job, c128, i);
+  }
+
+  // GCC's _mm512_undefined_ps () self-initializes and trips these warnings in the AVX-512 helpers
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  PCL_TARGET_AVX512 inline __m512
+  loadQuad512 (const float *a, const float *b, const float *c, const float *d)
+  {
+    __m512 v = _mm512_castps128_ps512 (_mm_loadu_ps (a));
+    v = _mm512_insertf32x4 (v, _mm_loadu_ps (b), 1);
+    v = _mm512_insertf32x4 (v, _mm_loadu_ps (c), 2);
+    return (_mm512_insertf32x4 (v, _mm_loadu_ps (d), 3));
+  }
+
+  PCL_TARGET_AVX512 inline void
+  storeQuad512 (float *a, float *b, float *c, float *d, const __m512 v)
+  {
+    _mm_storeu_ps (a, _mm512_castps512_ps128 (v));
+    _mm_storeu_ps (b, _mm512_extractf32x4_ps (v, 1));
+    _mm_storeu_ps (c, _mm512_extractf32x4_ps (v, 2));
+    _mm_storeu_ps (d, _mm512_extractf32x4_ps (v, 3));
+  }
+
+  /** \brief Transform points i to i + 3 with 512 bit registers. */
+  PCL_TARGET_AVX512 inline void
+  transformFour512 (const TransformJob &job, const __m512 *c, size_t i)
+  {
+    const float *p0 = job.input (i), *p1 = job.input (i + 1), *p2 = job.input (i + 2), *p3 = job.input (i + 3);
+    float *q0 = job.output (i), *q1 = job.output (i + 1), *q2 = job.output (i + 2), *q3 = job.output (i + 3);
+    const __m512 v = loadQuad512 (p0, p1, p2, p3);
+
+    // Four lanes per point; keep lanes 0-2 of the points whose x, y and z are finite
+    __mmask16 mask = 0x7777;
+    if (job.check_finite)
+    {
+      const unsigned f = _mm512_cmp_ps_mask (_mm512_sub_ps (v, v), _mm512_setzero_ps (), _CMP_EQ_OQ);
+      mask = static_cast<__mmask16> (((f & (f >> 1) & (f >> 2)) & 0x1111) * 7);
+    }
+
+    if (job.with_normals)
+    {
+      float *qn0 = job.normal (q0), *qn1 = job.normal (q1), *qn2 = job.normal (q2), *qn3 = job.normal (q3);
+      const __m512 n = loadQuad512 (job.normal (p0), job.normal (p1), job.normal (p2), job.normal (p3));
+      __m512 r = _mm512_mul_ps (c[0], _mm512_permute_ps (n, 0x00));
+      r = _mm512_fmadd_ps (c[1], _mm512_permute_ps (n, 0x55), r);
+      r = _mm512_fmadd_ps (c[2], _mm512_permute_ps (n, 0xAA), r);
+      storeQuad512 (qn0, qn1, qn2, qn3, _mm512_mask_blend_ps (mask, loadQuad512 (qn0, qn1, qn2, qn3), r));
+    }
+
+    __m512 r = _mm512_fmadd_ps (c[0], _mm512_permute_ps (v, 0x00), c[3]);
+    r = _mm512_fmadd_ps (c[1], _mm512_permute_ps (v, 0x55), r);
+    r = _mm512_fmadd_ps (c[2], _mm512_permute_ps (v, 0xAA), r);
+    storeQuad512 (q0, q1, q2, q3, _mm512_mask_blend_ps (mask, loadQuad512 (q0, q1, q2, q3), r));
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  PCL_TARGET_AVX512 void
+  transformAVX512 (const TransformJob &job, size_t begin, size_t end)
+  {
+    const Columns128 c128 (job.matrix);
+    __m512 c[4];
+    c[0] = _mm512_broadcast_f32x4 (c128.c0);
+    c[1] = _mm512_broadcast_f32x4 (c128.c1);
+    c[2] = _mm512_broadcast_f32x4 (c128.c2);
+    c[3] = _mm512_broadcast_f32x4 (c128.c3);
+
+    size_t i = begin;
+    // Sixteen points per iteration
+    for (; i + 16 <= end; i += 16)
+    {
+      transformFour512 (job, c, i);
+      transformFour512 (job, c, i + 4);
+      transformFour512 (job, c, i + 8);
+      transformFour512 (job, c, i + 12);
+    }
+    for (; i + 4 <= end; i += 4)
+      transformFour512 (job, c, i);
+    for (; i < end; ++i)
+      transformOne128 (job, c128, i);
+  }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  pcl::CpuDispatcher<TransformKernelFn>
+  makeTransformDispatcher ()
+  {
+    pcl::CpuDispatcher<TransformKernelFn> dispatcher (&transformGeneric);
+#if defined(__SSE2__)
+    dispatcher.add (pcl::CPU_ISA_SSE2, &transformSSE2);
+#endif
+#ifdef PCL_CPU_DISPATCH_X86
+    dispatcher.add (pcl::CPU_ISA_AVX2, &transformAVX2);
+    dispatcher.add (pcl::CPU_ISA_AVX512, &transformAVX512);
+#endif
+    return (dispatcher);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::detail::transformPoints (const float *in, float *out, size_t n, size_t stride, const int *indices,
+                              bool with_normals, ptrdiff_t normal_offset, const float *matrix, bool check_finite)
+{
+  static const pcl::CpuDispatcher<TransformKernelFn> dispatcher = makeTransformDispatcher ();
+  const TransformKernelFn fn = dispatcher.get ();
+
+  TransformJob job;
+  job.in = reinterpret_cast<const char*> (in);
+  job.out = reinterpret_cast<char*> (out);
+  job.stride = stride;
+  job.indices = indices;
+  job.with_normals = with_normals;
+  job.normal_offset = normal_offset;
+  job.matrix = matrix;
+  job.check_finite = check_finite;
+
+  // Small clouds are not worth waking up the thread pool for
+  const size_t block = 16384;
+  const int nr_blocks = static_cast<int> ((n + block - 1) / block);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (nr_blocks > 4)
+#endif
+  for (int b = 0; b < nr_blocks; ++b)
+  {
+    const size_t begin = static_cast<size_t> (b) * block;
+    fn (job, begin, std::min (begin + block, n));
+  }
+}
@@ -49,6 +49,7 @@
 #include <boost/bind.hpp>
 // PCL includes
 #include <pcl/pcl_base.h>
+#include <pcl/common/trace.h>
 #include <pcl/search/search.h>
 
 namespace pcl
@@ -85,6 +86,21 @@ namespace pcl
   solvePlaneParameters (const Eigen::Matrix3f &covariance_matrix,
                         float &nx, float &ny, float &nz, float &curvature);
 
+  /** \brief Solve n 3x3 covariance matrices at once with the batched pcl::eigen33 and estimate their least-squares
+    * plane normals and surface curvatures, as the single matrix version above does for each of them.
+    * \param covariance_matrices the n 3x3 covariance matrices
+    * \param n the number of covariance matrices
+    * \param normals the n resultant plane normals
+    * \param curvatures the n estimated surface curvatures as a measure of
+    * \f[
+    * \lambda_0 / (\lambda_0 + \lambda_1 + \lambda_2)
+    * \f]
+    * \ingroup features
+    */
+  inline void
+  solvePlaneParameters (const Eigen::Matrix3f *covariance_matrices, size_t n,
+                        Eigen::Vector3f *normals, float *curvatures);
+
   ////////////////////////////////////////////////////////////////////////////////////////////
   ////////////////////////////////////////////////////////////////////////////////////////////
   ////////////////////////////////////////////////////////////////////////////////////////////
@@ -86,6 +86,25 @@ pcl::solvePlaneParameters (const Eigen::Matrix3f &covariance_matrix,
     curvature = 0;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+inline void
+pcl::solvePlaneParameters (const Eigen::Matrix3f *covariance_matrices, size_t n,
+                           Eigen::Vector3f *normals, float *curvatures)
+{
+  // The smallest eigenvalues go to curvatures first and are turned into the surface change in place
+  pcl::eigen33 (covariance_matrices, n, curvatures, normals);
+
+  for (size_t i = 0; i < n; ++i)
+  {
+    const Eigen::Matrix3f &covariance_matrix = covariance_matrices[i];
+    float eig_sum = covariance_matrix.coeff (0) + covariance_matrix.coeff (4) + covariance_matrix.coeff (8);
+    if (eig_sum != 0)
+      curvatures[i] = fabsf (curvatures[i] / eig_sum);
+    else
+      curvatures[i] = 0;
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -188,12 +207,14 @@ pcl::Feature<PointInT, PointOutT>::deinitCompute ()
 template <typename PointInT, typename PointOutT> void
 pcl::Feature<PointInT, PointOutT>::compute (PointCloudOut &output)
 {
+  PCL_TRACE_ZONE (feature_name_);
   if (!initCompute ())
   {
     output.width = output.height = 0;
     output.points.clear ();
     return;
   }
+  PCL_TRACE_COUNTER ("feature points", indices_->size ());
 
   // Copy the header
   output.header = input_->header;
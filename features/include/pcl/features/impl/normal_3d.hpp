@@ -46,53 +46,72 @@
 ///////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointOutT> void
 pcl::NormalEstimation<PointInT, PointOutT>::computeFeature (PointCloudOut &output)
+{
+  output.is_dense = true;
+  const int size = static_cast<int> (indices_->size ());
+  for (int begin = 0; begin < size; begin += block_size_)
+  {
+    if (!computeFeatureBlock (begin, std::min (begin + block_size_, size), output))
+      output.is_dense = false;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> bool
+pcl::NormalEstimation<PointInT, PointOutT>::computeFeatureBlock (int begin, int end, PointCloudOut &output)
 {
   // Allocate enough space to hold the results
   // \note This resize is irrelevant for a radiusSearch ().
   std::vector<int> nn_indices (k_);
   std::vector<float> nn_dists (k_);
 
-  output.is_dense = true;
-  // Save a few cycles by not checking every point for NaN/Inf values if the cloud is set to dense
-  if (input_->is_dense)
+  // Covariance matrices of the points with enough neighbors, and their positions in output
+  std::vector<Eigen::Matrix3f, Eigen::aligned_allocator<Eigen::Matrix3f> > covariance_matrices;
+  std::vector<int> solved;
+  covariance_matrices.reserve (end - begin);
+  solved.reserve (end - begin);
+
+  EIGEN_ALIGN16 Eigen::Matrix3f covariance_matrix;
+  Eigen::Vector4f xyz_centroid;
+  bool is_dense = true;
+  for (int idx = begin; idx < end; ++idx)
   {
-    // Iterating over the entire index vector
-    for (size_t idx = 0; idx < indices_->size (); ++idx)
+    // Save a few cycles by not checking every point for NaN/Inf values if the cloud is set to dense
+    if ((!input_->is_dense && !isFinite ((*input_)[(*indices_)[idx]])) ||
+        this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0 ||
+        nn_indices.size () < 3 ||
+        computeMeanAndCovarianceMatrix (*surface_, nn_indices, covariance_matrix, xyz_centroid) == 0)
     {
-      if (this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0 ||
-          !computePointNormal (*surface_, nn_indices, output.points[idx].normal[0], output.points[idx].normal[1], output.points[idx].normal[2], output.points[idx].curvature))
-      {
-        output.points[idx].normal[0] = output.points[idx].normal[1] = output.points[idx].normal[2] = output.points[idx].curvature = std::numeric_limits<float>::quiet_NaN ();
-
-        output.is_dense = false;
-        continue;
-      }
-
-      flipNormalTowardsViewpoint (input_->points[(*indices_)[idx]], vpx_, vpy_, vpz_,
-                                  output.points[idx].normal[0], output.points[idx].normal[1], output.points[idx].normal[2]);
+      output.points[idx].normal[0] = output.points[idx].normal[1] = output.points[idx].normal[2] = output.points[idx].curvature = std::numeric_limits<float>::quiet_NaN ();
 
+      is_dense = false;
+      continue;
     }
+
+    covariance_matrices.push_back (covariance_matrix);
+    solved.push_back (idx);
   }
-  else
-  {
-    // Iterating over the entire index vector
-    for (size_t idx = 0; idx < indices_->size (); ++idx)
-    {
-      if (!isFinite ((*input_)[(*indices_)[idx]]) ||
-          this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0 ||
-          !computePointNormal (*surface_, nn_indices, output.points[idx].normal[0], output.points[idx].normal[1], output.points[idx].normal[2], output.points[idx].curvature))
-      {
-        output.points[idx].normal[0] = output.points[idx].normal[1] = output.points[idx].normal[2] = output.points[idx].curvature = std::numeric_limits<float>::quiet_NaN ();
 
-        output.is_dense = false;
-        continue;
-      }
+  if (solved.empty ())
+    return (is_dense);
 
-      flipNormalTowardsViewpoint (input_->points[(*indices_)[idx]], vpx_, vpy_, vpz_,
-                                  output.points[idx].normal[0], output.points[idx].normal[1], output.points[idx].normal[2]);
+  // Get the plane normals and surface curvatures of the whole block at once
+  std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f> > normals (solved.size ());
+  std::vector<float> curvatures (solved.size ());
+  solvePlaneParameters (&covariance_matrices[0], solved.size (), &normals[0], &curvatures[0]);
 
-    }
+  for (size_t i = 0; i < solved.size (); ++i)
+  {
+    PointOutT &point = output.points[solved[i]];
+    point.normal[0] = normals[i][0];
+    point.normal[1] = normals[i][1];
+    point.normal[2] = normals[i][2];
+    point.curvature = curvatures[i];
+
+    flipNormalTowardsViewpoint (input_->points[(*indices_)[solved[i]]], vpx_, vpy_, vpz_,
+                                point.normal[0], point.normal[1], point.normal[2]);
   }
+  return (is_dense);
 }
 
 #define PCL_INSTANTIATE_NormalEstimation(T,NT) template class PCL_EXPORTS pcl::NormalEstimation<T,NT>;
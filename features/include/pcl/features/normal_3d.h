@@ -402,6 +402,20 @@ namespace pcl
       void
       computeFeature (PointCloudOut &output);
 
+      /** \brief Estimate the normals of output points [begin, end): the covariance matrices of all neighborhoods are
+        * gathered first and then solved together through the batched solvePlaneParameters ().
+        * \note Thread safe for disjoint ranges, as long as the search method is.
+        * \param begin the first position in indices_ to estimate a normal for
+        * \param end one past the last position in indices_ to estimate a normal for
+        * \param output the resultant point cloud model dataset that contains surface normals and curvatures
+        * \return false if the normal of at least one point could not be estimated
+        */
+      bool
+      computeFeatureBlock (int begin, int end, PointCloudOut &output);
+
+      /** \brief Number of points whose covariance matrices computeFeature () solves in one batch. */
+      static const int block_size_ = 256;
+
       /** \brief Values describing the viewpoint ("pinhole" camera model assumed). For per point viewpoints, inherit
         * from NormalEstimation and provide your own computeFeature (). By default, the viewpoint is set to 0,0,0. */
       float vpx_, vpy_, vpz_;
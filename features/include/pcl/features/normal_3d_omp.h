@@ -46,7 +46,7 @@
 namespace pcl
 {
   /** \brief NormalEstimationOMP estimates local surface properties at each 3D point, such as surface normals and
-    * curvatures, in parallel, using the OpenMP standard.
+    * curvatures, in parallel, on the threads of the shared pcl::TaskScheduler.
     * \author Radu Bogdan Rusu
     * \ingroup features
     */
@@ -67,6 +67,8 @@ namespace pcl
       using NormalEstimation<PointInT, PointOutT>::search_parameter_;
       using NormalEstimation<PointInT, PointOutT>::surface_;
       using NormalEstimation<PointInT, PointOutT>::getViewPoint;
+      using NormalEstimation<PointInT, PointOutT>::computeFeatureBlock;
+      using NormalEstimation<PointInT, PointOutT>::block_size_;
 
       typedef typename NormalEstimation<PointInT, PointOutT>::PointCloudOut PointCloudOut;
 
@@ -81,6 +83,7 @@ namespace pcl
 
       /** \brief Initialize the scheduler and set the number of threads to use.
         * \param nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        * \note The threads come from pcl::TaskScheduler::getInstance (), whose concurrency caps nr_threads.
         */
       inline void 
       setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
@@ -96,6 +99,12 @@ namespace pcl
         */
       void 
       computeFeature (PointCloudOut &output);
+
+      /** \brief Estimate the normals of blocks [first_block, last_block) of computeFeatureBlock (), recording for
+        * each block whether all of its normals could be estimated.
+        */
+      void
+      computeFeatureBlocks (int first_block, int last_block, PointCloudOut &output, std::vector<char> &block_is_dense);
   };
 }
 
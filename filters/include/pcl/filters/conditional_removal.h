@@ -54,6 +54,8 @@ namespace pcl
     } CompareOp;
   }
 
+  template<typename PointT> class ConditionProgram;
+
   //////////////////////////////////////////////////////////////////////////////////////////
   /** \brief A datatype that enables type-correct comparisons. */
   template<typename PointT>
@@ -72,6 +74,20 @@ namespace pcl
         */
       int
       compare (const PointT& p, const double& val);
+
+      /** \brief Get the PCLPointField datatype of the compared field. */
+      inline uint8_t
+      getDatatype () const
+      {
+        return (datatype_);
+      }
+
+      /** \brief Get the byte offset of the compared field inside the point. */
+      inline uint32_t
+      getOffset () const
+      {
+        return (offset_);
+      }
     protected:
       /** \brief The type of data. */
       uint8_t datatype_;
@@ -108,6 +124,13 @@ namespace pcl
       virtual bool
       evaluate (const PointT &point) const = 0;
 
+      /** \brief Append this comparison to a compiled condition program.
+        * The default implementation adds an opaque step that calls evaluate () for every point.
+        * \param[in,out] program the program to append to
+        */
+      virtual void
+      compile (ConditionProgram<PointT> &program) const;
+
     protected:
       /** \brief True if capable. */
       bool capable_;
@@ -173,6 +196,12 @@ namespace pcl
       virtual bool
       evaluate (const PointT &point) const;
 
+      /** \brief Append a type-resolved field comparison to a compiled condition program.
+        * \param[in,out] program the program to append to
+        */
+      virtual void
+      compile (ConditionProgram<PointT> &program) const;
+
     protected:
       /** \brief All types (that we care about) can be represented as a double. */
       double compare_val_;
@@ -216,6 +245,12 @@ namespace pcl
       virtual bool
       evaluate (const PointT &point) const;
 
+      /** \brief Append a byte comparison on the color component to a compiled condition program.
+        * \param[in,out] program the program to append to
+        */
+      virtual void
+      compile (ConditionProgram<PointT> &program) const;
+
     protected:
       /** \brief The name of the component. */
       std::string component_name_;
@@ -492,6 +527,13 @@ namespace pcl
       virtual bool
       evaluate (const PointT &point) const = 0;
 
+      /** \brief Append this condition to a compiled condition program.
+        * The default implementation adds an opaque step that calls evaluate () for every point.
+        * \param[in,out] program the program to append to
+        */
+      virtual void
+      compile (ConditionProgram<PointT> &program) const;
+
     protected:
       /** \brief True if capable. */
       bool capable_;
@@ -529,6 +571,12 @@ namespace pcl
         */
       virtual bool
       evaluate (const PointT &point) const;
+
+      /** \brief Append a conjunction of all comparisons and nested conditions to a compiled program.
+        * \param[in,out] program the program to append to
+        */
+      virtual void
+      compile (ConditionProgram<PointT> &program) const;
   };
 
   //////////////////////////////////////////////////////////////////////////////////////////
@@ -557,6 +605,153 @@ namespace pcl
         */
       virtual bool
       evaluate (const PointT &point) const;
+
+      /** \brief Append a disjunction of all comparisons and nested conditions to a compiled program.
+        * \param[in,out] program the program to append to
+        */
+      virtual void
+      compile (ConditionProgram<PointT> &program) const;
+  };
+
+  //////////////////////////////////////////////////////////////////////////////////////////
+  /** \brief A condition tree flattened into a list of type-resolved instructions.
+    *
+    * Field and packed color comparisons are stored with their byte offset, datatype,
+    * operator and constant resolved once, so evaluating them is a tight loop over a
+    * block of points instead of a virtual call and a datatype switch per point and
+    * comparison. AND / OR nodes combine the per-block masks of their children and skip
+    * the remaining children as soon as the whole block is decided. Comparisons and
+    * conditions the program does not know about are kept as opaque steps that call
+    * their evaluate () method.
+    *
+    * The program only stores raw pointers to opaque steps, so the condition tree it
+    * was compiled from must outlive it. Evaluation is const and may run concurrently.
+    *
+    * \ingroup filters
+    */
+  template<typename PointT>
+  class ConditionProgram
+  {
+    public:
+      typedef pcl::PointCloud<PointT> PointCloud;
+
+      /** \brief Constructor. */
+      ConditionProgram () : instructions_ (), open_groups_ (), max_depth_ (0) {}
+
+      /** \brief Replace the program with the compiled form of a condition tree.
+        * \param[in] condition the root of the condition tree
+        */
+      void
+      compile (const ConditionBase<PointT> &condition);
+
+      /** \brief Remove all instructions. */
+      void
+      clear ();
+
+      /** \brief Get the number of instructions in the program. */
+      inline size_t
+      size () const
+      {
+        return (instructions_.size ());
+      }
+
+      /** \brief Open a group that is true when all of its members are true. */
+      void
+      beginConjunction ();
+
+      /** \brief Open a group that is true when any of its members is true (or when it is empty). */
+      void
+      beginDisjunction ();
+
+      /** \brief Close the most recently opened group. */
+      void
+      endGroup ();
+
+      /** \brief Add a comparison of a scalar point field against a constant.
+        * The constant is converted to the field type, as done by PointDataAtOffset::compare.
+        * \param[in] datatype the PCLPointField datatype of the field
+        * \param[in] offset the byte offset of the field inside the point
+        * \param[in] op the comparison operator
+        * \param[in] value the constant to compare against
+        */
+      void
+      addFieldComparison (uint8_t datatype, uint32_t offset, ComparisonOps::CompareOp op, double value);
+
+      /** \brief Add a comparison of an unsigned byte (e.g. a packed color component) against a constant.
+        * \param[in] offset the byte offset of the component inside the point
+        * \param[in] op the comparison operator
+        * \param[in] value the constant to compare against
+        */
+      void
+      addByteComparison (uint32_t offset, ComparisonOps::CompareOp op, double value);
+
+      /** \brief Add an opaque comparison, evaluated through its evaluate () method.
+        * \param[in] comparison the comparison (must outlive the program)
+        */
+      void
+      addComparison (const ComparisonBase<PointT> &comparison);
+
+      /** \brief Add an opaque condition, evaluated through its evaluate () method.
+        * \param[in] condition the condition (must outlive the program)
+        */
+      void
+      addCondition (const ConditionBase<PointT> &condition);
+
+      /** \brief Evaluate the program for a set of points.
+        * \param[in] cloud the point cloud the indices refer to
+        * \param[in] indices the indices of the points to evaluate
+        * \param[in] nr_points the number of indices
+        * \param[out] result receives 1 for every point that satisfies the condition and 0 otherwise
+        */
+      void
+      evaluate (const PointCloud &cloud, const int *indices, size_t nr_points, unsigned char *result) const;
+
+    protected:
+      /** \brief The kinds of instructions. */
+      enum InstructionType
+      {
+        CONJUNCTION, DISJUNCTION, FIELD_COMPARISON, BYTE_COMPARISON, OPAQUE_COMPARISON, OPAQUE_CONDITION
+      };
+
+      /** \brief A single step of the program. Groups are followed by their members. */
+      struct Instruction
+      {
+        InstructionType type;
+        ComparisonOps::CompareOp op;
+        uint8_t datatype;
+        uint32_t offset;
+        double value;
+        /** \brief One past the last instruction that belongs to this one. */
+        size_t end;
+        const ComparisonBase<PointT> *comparison;
+        const ConditionBase<PointT> *condition;
+      };
+
+      /** \brief Append an instruction and return its position. */
+      size_t
+      addInstruction (InstructionType type);
+
+      /** \brief Evaluate one instruction (and its members) for a block of points.
+        * \param[in] node the position of the instruction
+        * \param[in] cloud the point cloud the indices refer to
+        * \param[in] indices the indices of the points in the block
+        * \param[in] nr_points the number of points in the block
+        * \param[out] result the per point result
+        * \param[in] scratch scratch space of one block per remaining nesting level
+        * \param[in] block_size the stride between the scratch blocks
+        */
+      void
+      evaluateNode (size_t node, const PointCloud &cloud, const int *indices, size_t nr_points,
+                    unsigned char *result, unsigned char *scratch, size_t block_size) const;
+
+      /** \brief The instructions, in pre-order. */
+      std::vector<Instruction> instructions_;
+
+      /** \brief Positions of the groups that are currently open during compilation. */
+      std::vector<size_t> open_groups_;
+
+      /** \brief The deepest group nesting in the program. */
+      size_t max_depth_;
   };
 
   //////////////////////////////////////////////////////////////////////////////////////////
@@ -617,7 +812,7 @@ namespace pcl
         */
       ConditionalRemoval (int extract_removed_indices = false) :
         Filter<PointT>::Filter (extract_removed_indices), capable_ (false), keep_organized_ (false), condition_ (),
-        user_filter_value_ (std::numeric_limits<float>::quiet_NaN ())
+        user_filter_value_ (std::numeric_limits<float>::quiet_NaN ()), threads_ (0)
       {
         filter_name_ = "ConditionalRemoval";
       }
@@ -662,6 +857,17 @@ namespace pcl
       void
       setCondition (ConditionBasePtr condition);
 
+      /** \brief Set the number of threads to use for evaluating the condition.
+        * \note Comparisons and conditions that are not FieldComparison, PackedRGBComparison,
+        * ConditionAnd or ConditionOr are called concurrently and must have a thread-safe evaluate ().
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0)
+      {
+        threads_ = nr_threads;
+      }
+
     protected:
       /** \brief Filter a Point Cloud.
         * \param output the resultant point cloud message
@@ -669,6 +875,15 @@ namespace pcl
       void
       applyFilter (PointCloud &output);
 
+      /** \brief Evaluate the compiled condition for a list of points, in parallel.
+        * \param[in] program the compiled condition
+        * \param[in] indices the indices of the points to evaluate
+        * \param[out] passed 1 for every point that satisfies the condition, 0 otherwise
+        */
+      void
+      evaluateCondition (const ConditionProgram<PointT> &program, const std::vector<int> &indices,
+                         std::vector<unsigned char> &passed) const;
+
       /** \brief True if capable. */
       bool capable_;
 
@@ -684,6 +899,9 @@ namespace pcl
         * the correct field type. 
         */
       float user_filter_value_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
   };
 }
 
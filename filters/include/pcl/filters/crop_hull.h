@@ -70,7 +70,8 @@ namespace pcl
         hull_polygons_(),
         hull_cloud_(),
         dim_(3),
-        crop_outside_(true)
+        crop_outside_(true),
+        threads_ (0)
       {
         filter_name_ = "CropHull";
       }
@@ -131,6 +132,15 @@ namespace pcl
         crop_outside_ = crop_outside;
       }
 
+      /** \brief Set the number of threads to use for the inside/outside tests.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0)
+      {
+        threads_ = nr_threads;
+      }
+
     protected:
       /** \brief Filter the input points using the 2D or 3D polygon hull.
         * \param[out] output The set of points that passed the filter
@@ -145,6 +155,75 @@ namespace pcl
       applyFilter (std::vector<int> &indices);
 
     private:  
+      /** \brief An edge of a 2D hull polygon, with the terms of the crossing test of
+        * isPointIn2DPolyWithVertIndices precomputed.
+        */
+      struct Edge2D
+      {
+        double x_new, x_old;
+        double x1, y1;
+        double dx, dy;
+      };
+
+      /** \brief A 2D hull polygon whose edges are binned into slabs along the first
+        * plane dimension, so that a point is only tested against the edges that can
+        * straddle it.
+        */
+      struct Polygon2D
+      {
+        double min_x, max_x;
+        double slab_scale;
+        std::vector<unsigned int> slab_begin;
+        std::vector<Edge2D> slab_edges;
+      };
+
+      /** \brief A uniform 2D grid over axis aligned boxes, with the box indices of
+        * all cells stored in one flat array.
+        */
+      struct UniformGrid2D
+      {
+        UniformGrid2D () :
+          min_x (0), min_y (0), max_x (-1), max_y (-1), inv_cell_size (0),
+          nr_cells_x (0), nr_cells_y (0), cell_begin (), cell_items ()
+        {
+        }
+
+        /** \brief Bin a set of boxes.
+          * \param[in] boxes (min x, min y, max x, max y) of every box, in a flat array
+          * \param[in] padding the amount every box is grown by before binning
+          */
+        void
+        build (const std::vector<float> &boxes, float padding);
+
+        /** \brief Get the boxes that may contain a point.
+          * \param[in] x the first coordinate of the point
+          * \param[in] y the second coordinate of the point
+          * \param[out] begin the first box index of the cell containing the point
+          * \param[out] end one past the last box index of the cell containing the point
+          */
+        inline void
+        getBoxes (float x, float y, const unsigned int* &begin, const unsigned int* &end) const
+        {
+          // Also rejects NaN coordinates
+          if (!(x >= min_x && x <= max_x && y >= min_y && y <= max_y))
+          {
+            begin = end = NULL;
+            return;
+          }
+          const int cx = std::min (static_cast<int> ((x - min_x) * inv_cell_size), nr_cells_x - 1);
+          const int cy = std::min (static_cast<int> ((y - min_y) * inv_cell_size), nr_cells_y - 1);
+          const size_t cell = static_cast<size_t> (cy) * nr_cells_x + cx;
+          begin = &cell_items[0] + cell_begin[cell];
+          end = &cell_items[0] + cell_begin[cell + 1];
+        }
+
+        float min_x, min_y, max_x, max_y;
+        float inv_cell_size;
+        int nr_cells_x, nr_cells_y;
+        std::vector<unsigned int> cell_begin;
+        std::vector<unsigned int> cell_items;
+      };
+
       /** \brief Return the size of the hull point cloud in line with coordinate axes.
         * This is used to choose the 2D projection to use when cropping to a 2d
         * polygon.
@@ -171,6 +250,14 @@ namespace pcl
       template<unsigned PlaneDim1, unsigned PlaneDim2> void
       applyFilter2D (std::vector<int> &indices);
 
+      /** \brief Determine which of the input points lie inside the 2D hull.
+        * The polygons are binned into a uniform grid and their edges into slabs,
+        * and the points are tested in parallel.
+        * \param[out] inside 1 for every input index inside any of the polygons, 0 otherwise
+        */
+      template<unsigned PlaneDim1, unsigned PlaneDim2> void
+      computeInside2D (std::vector<unsigned char> &inside);
+
        /** \brief Apply the three-dimensional hull filter.
          * Polygon-ray crossings are used for three rays cast from each point
          * being tested, and a  majority vote of the resulting
@@ -193,6 +280,16 @@ namespace pcl
       void
       applyFilter3D (std::vector<int> &indices);
 
+      /** \brief Determine which of the input points lie inside the 3D hull.
+        * For every ray direction the hull triangles are projected onto the plane
+        * orthogonal to the ray and binned into a uniform grid, so that a ray is only
+        * intersected with the triangles whose projection covers its origin. The
+        * points are tested in parallel.
+        * \param[out] inside 1 for every input index inside the hull, 0 otherwise
+        */
+      void
+      computeInside3D (std::vector<unsigned char> &inside);
+
       /** \brief Test an individual point against a 2D polygon.
         * PlaneDim1 and PlaneDim2 specify the x/y/z coordinate axes to use.
         * \param[in] point Point to test against the polygon.
@@ -204,6 +301,15 @@ namespace pcl
                                       const Vertices& verts,
                                       const PointCloud& cloud);
 
+      /** \brief Test an individual point against a precomputed 2D polygon.
+        * Gives the same result as isPointIn2DPolyWithVertIndices.
+        * \param[in] x the first plane coordinate of the point
+        * \param[in] y the second plane coordinate of the point
+        * \param[in] polygon the polygon with its binned edges
+        */
+      inline static bool
+      isPointIn2DPolygon (double x, double y, const Polygon2D &polygon);
+
       /** \brief Does a ray cast from a point intersect with an arbitrary
         * triangle in 3D?
         * See: http://softsurfer.com/Archive/algorithm_0105/algorithm_0105.htm#intersect_RayTriangle()
@@ -232,6 +338,9 @@ namespace pcl
        * false, those inside will be removed.
        */
       bool crop_outside_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
   };
 
 } // namespace pcl
@@ -42,6 +42,8 @@
 
 #include <pcl/pcl_base.h>
 #include <pcl/common/io.h>
+#include <pcl/common/trace.h>
+#include <pcl/point_cloud_soa.h>
 #include <pcl/conversions.h>
 #include <pcl/filters/boost.h>
 #include <cfloat>
@@ -62,6 +64,19 @@ namespace pcl
                            pcl::PointCloud<PointT> &cloud_out, 
                            std::vector<int> &index);
 
+  /** \brief Removes points with x, y, or z equal to NaN from a structure-of-arrays cloud
+    * \param[in] cloud_in the input point cloud
+    * \param[out] cloud_out the input point cloud
+    * \param[out] index the mapping (ordered): cloud_out.at (i) = cloud_in.at (index[i])
+    * \note The density of the point cloud is lost.
+    * \note Can be called with cloud_in == cloud_out
+    * \ingroup filters
+    */
+  template<typename PointT> void
+  removeNaNFromPointCloud (const pcl::PointCloudSoA<PointT> &cloud_in, 
+                           pcl::PointCloudSoA<PointT> &cloud_out, 
+                           std::vector<int> &index);
+
   /** \brief Removes points that have their normals invalid (i.e., equal to NaN)
     * \param[in] cloud_in the input point cloud
     * \param[out] cloud_out the input point cloud
@@ -131,8 +146,10 @@ namespace pcl
       inline void
       filter (PointCloud &output)
       {
+        PCL_TRACE_ZONE (filter_name_);
         if (!initCompute ())
           return;
+        PCL_TRACE_COUNTER ("filter points", indices_->size ());
 
         if (input_.get () == &output)  // cloud_in = cloud_out
         {
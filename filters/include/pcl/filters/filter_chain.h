@@ -0,0 +1,236 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef PCL_FILTERS_FILTER_CHAIN_H_
+#define PCL_FILTERS_FILTER_CHAIN_H_
+
+#include <pcl/filters/filter_indices.h>
+#include <pcl/common/eigen.h>
+
+namespace pcl
+{
+  /** \brief FilterChain applies a sequence of index filters to the same input cloud, without copying
+    * the cloud between the stages.
+    *
+    * PassThrough, CropBox, FrustumCulling and ExtractIndices stages are compiled into predicates:
+    * consecutive predicates are evaluated together in a single sweep over the input. The sweep gathers
+    * the coordinates of a block of points into contiguous arrays, and each predicate clears the mask
+    * entries of the points of the block that fail it, in a loop without branches that the compiler can
+    * vectorize. The remaining predicates are skipped once all points of a block have failed. Any other
+    * FilterIndices is run on the indices that survived the preceding stages, after which fusing
+    * continues. A PassThrough without a field name only removes non-finite points.
+    *
+    * The settings of the stages (limits, negative, ...) are read when \ref filter is called. All stages
+    * refer to the input cloud of the chain; in particular, the indices of an ExtractIndices stage are
+    * indices into that cloud. A stage that can not be fused is temporarily given the input cloud of the
+    * chain and the surviving indices; its own input cloud and indices are restored afterwards. The keep
+    * organized and removed indices settings of the stages are ignored, the ones of the chain apply to
+    * the combined result, which keeps the input order.
+    *
+    * Code example:
+    *
+    * \code
+    * pcl::PassThrough<pcl::PointXYZ>::Ptr pass (new pcl::PassThrough<pcl::PointXYZ>);
+    * pass->setFilterFieldName ("z");
+    * pass->setFilterLimits (0.0, 3.0);
+    * pcl::CropBox<pcl::PointXYZ>::Ptr box (new pcl::CropBox<pcl::PointXYZ>);
+    * box->setMin (Eigen::Vector4f (-1, -1, 0, 1));
+    * box->setMax (Eigen::Vector4f (1, 1, 2, 1));
+    *
+    * pcl::FilterChain<pcl::PointXYZ> chain;
+    * chain.addFilter (pass);
+    * chain.addFilter (box);
+    * chain.setInputCloud (cloud);
+    * chain.filter (output);
+    * \endcode
+    *
+    * \ingroup filters
+    */
+  template <typename PointT>
+  class FilterChain : public FilterIndices<PointT>
+  {
+    protected:
+      typedef typename FilterIndices<PointT>::PointCloud PointCloud;
+      typedef typename PointCloud::Ptr PointCloudPtr;
+      typedef typename PointCloud::ConstPtr PointCloudConstPtr;
+
+    public:
+      typedef boost::shared_ptr< FilterChain<PointT> > Ptr;
+      typedef boost::shared_ptr< const FilterChain<PointT> > ConstPtr;
+
+      typedef typename FilterIndices<PointT>::Ptr FilterIndicesPtr;
+
+      /** \brief Constructor.
+        * \param[in] extract_removed_indices Set to true if you want to be able to extract the indices of points being removed (default = false).
+        */
+      FilterChain (bool extract_removed_indices = false) :
+        FilterIndices<PointT>::FilterIndices (extract_removed_indices),
+        filters_ ()
+      {
+        filter_name_ = "FilterChain";
+      }
+
+      /** \brief Append a stage to the chain.
+        * \param[in] filter the (configured) filter to apply after the stages added so far
+        */
+      inline void
+      addFilter (const FilterIndicesPtr &filter)
+      {
+        filters_.push_back (filter);
+      }
+
+      /** \brief Remove all stages from the chain. */
+      inline void
+      clearFilters ()
+      {
+        filters_.clear ();
+      }
+
+      /** \brief Get the number of stages in the chain. */
+      inline size_t
+      getNumberOfFilters () const
+      {
+        return (filters_.size ());
+      }
+
+    protected:
+      using PCLBase<PointT>::input_;
+      using PCLBase<PointT>::indices_;
+      using Filter<PointT>::filter_name_;
+      using Filter<PointT>::getClassName;
+      using FilterIndices<PointT>::negative_;
+      using FilterIndices<PointT>::keep_organized_;
+      using FilterIndices<PointT>::user_filter_value_;
+      using FilterIndices<PointT>::extract_removed_indices_;
+      using FilterIndices<PointT>::removed_indices_;
+
+      /** \brief Filtered results are stored in a separate point cloud.
+        * \param[out] output The resultant point cloud.
+        */
+      void
+      applyFilter (PointCloud &output);
+
+      /** \brief Filtered results are indexed by an indices array.
+        * \param[out] indices The resultant indices.
+        */
+      void
+      applyFilter (std::vector<int> &indices)
+      {
+        applyFilterIndices (indices);
+      }
+
+      /** \brief Filtered results are indexed by an indices array.
+        * \param[out] indices The resultant indices.
+        */
+      void
+      applyFilterIndices (std::vector<int> &indices);
+
+      /** \brief The coordinates of a block of points of the input cloud, stored as structure of arrays. */
+      struct PointBlock
+      {
+        /** \brief Maximum number of points in a block. */
+        static const int capacity = 256;
+
+        /** \brief The indices of the points in the input cloud. */
+        const int *indices;
+        /** \brief The number of points in the block. */
+        int size;
+        float x[capacity];
+        float y[capacity];
+        float z[capacity];
+      };
+
+      /** \brief A test that the points have to pass to stay in the output of a fused stage. */
+      class PointPredicate
+      {
+        public:
+          virtual
+          ~PointPredicate () {}
+
+          /** \brief Clear the mask entries of the points of the block that fail the test.
+            * \param[in] cloud the input cloud the block was gathered from
+            * \param[in] block the points to test
+            * \param[in,out] mask one entry per point of the block, 1 while the point passed all tests so far
+            */
+          virtual void
+          apply (const PointCloud &cloud, const PointBlock &block, unsigned char *mask) const = 0;
+      };
+      typedef boost::shared_ptr<PointPredicate> PointPredicatePtr;
+
+      class FieldRangePredicate;
+      class BoxPredicate;
+      class PlanesPredicate;
+      class IndexSetPredicate;
+
+      /** \brief Compile a stage into a predicate.
+        * \param[in] filter the stage
+        * \return the predicate, or an empty pointer if the stage can not be fused
+        */
+      PointPredicatePtr
+      makePredicate (const FilterIndicesPtr &filter) const;
+
+      /** \brief Keep the points that pass all predicates, in a single sweep over blocks of points.
+        * \param[in] predicates the predicates to evaluate for every point
+        * \param[in,out] indices the indices to test, reduced to the ones that passed
+        */
+      void
+      applyPredicates (const std::vector<PointPredicatePtr> &predicates, std::vector<int> &indices) const;
+
+      /** \brief Check whether the indices of a stage were given by the user, rather than generated
+        * by the stage for the whole of its last input.
+        * \param[in] filter the stage
+        */
+      static bool
+      hasUserIndices (const FilterIndices<PointT> &filter)
+      {
+        // fake_indices_ is protected, but may be reached through a member pointer formed here
+        bool PCLBase<PointT>::*fake_indices = &FilterChain<PointT>::fake_indices_;
+        return (filter.getIndices () && !(filter.*fake_indices));
+      }
+
+    private:
+      /** \brief The stages, in the order they are applied. */
+      std::vector<FilterIndicesPtr> filters_;
+  };
+}
+
+#ifdef PCL_NO_PRECOMPILE
+#include <pcl/filters/impl/filter_chain.hpp>
+#endif
+
+#endif  // PCL_FILTERS_FILTER_CHAIN_H_
@@ -111,8 +111,10 @@ namespace pcl
       inline void
       filter (std::vector<int> &indices)
       {
+        PCL_TRACE_ZONE (this->filter_name_);
         if (!initCompute ())
           return;
+        PCL_TRACE_COUNTER ("filter points", this->indices_->size ());
 
         // Apply the actual filter
         applyFilter (indices);
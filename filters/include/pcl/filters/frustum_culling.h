@@ -195,6 +195,14 @@ namespace pcl
         return (fp_dist_);
       }
 
+      /** \brief Compute the six planes bounding the frustum (left, right, top, bottom, far, near).
+        * \details Each column holds the coefficients (a, b, c, d) of one plane, oriented so that a
+        * point p lies inside the frustum iff (p.x, p.y, p.z, 1) . column <= 0 for all columns.
+        * \param[out] planes the plane equations, one per column
+        */
+      void
+      getFrustumPlanes (Eigen::Matrix<float, 4, 6> &planes) const;
+
     protected:
       using PCLBase<PointT>::input_;
       using PCLBase<PointT>::indices_;
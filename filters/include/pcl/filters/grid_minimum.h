@@ -56,6 +56,9 @@ namespace pcl
     * can be useful in a number of topographic processing tasks such as crudely
     * estimating ground returns, especially under foliage.
     *
+    * The points are binned in parallel with \ref selectVoxelRepresentatives and the
+    * output is ordered by cell.
+    *
     * \author Bradley J Chambers
     * \ingroup filters
     */
@@ -72,7 +75,8 @@ namespace pcl
 
     public:
       /** \brief Empty constructor. */
-      GridMinimum (const float resolution)
+      GridMinimum (const float resolution) :
+        threads_ (0)
       {
         setResolution (resolution);
         filter_name_ = "GridMinimum";
@@ -98,6 +102,15 @@ namespace pcl
       inline float
       getResolution () { return (resolution_); }
 
+      /** \brief Set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0)
+      {
+        threads_ = nr_threads;
+      }
+
     protected:
       /** \brief The resolution. */
       float resolution_;
@@ -105,6 +118,9 @@ namespace pcl
       /** \brief Internal resolution stored as 1/resolution_ for efficiency reasons. */
       float inverse_resolution_;
 
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
       /** \brief Downsample a Point Cloud using a 2D grid approach
         * \param[out] output the resultant point cloud message
         */
@@ -41,6 +41,53 @@
 #include <pcl/common/io.h>
 #include <pcl/common/copy_point.h>
 #include <pcl/filters/conditional_removal.h>
+#include <algorithm>
+#include <cstring>
+
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Compare a field of every point in a block against a constant.
+      * With \a ThreeWay set, GE, LE and EQ follow PointDataAtOffset::compare, i.e. they are
+      * derived from the sign of (a > b) - (a < b), so that NaN values compare equal.
+      */
+    template <typename FieldT, typename ValueT, bool ThreeWay, typename PointT> void
+    compareBlock (const pcl::PointCloud<PointT> &cloud, const int *indices, size_t nr_points,
+                  uint32_t offset, pcl::ComparisonOps::CompareOp op, ValueT value, unsigned char *result)
+    {
+      FieldT field;
+#define PCL_COMPARE_BLOCK(expr)                                                                   \
+      for (size_t i = 0; i < nr_points; ++i)                                                      \
+      {                                                                                           \
+        memcpy (&field, reinterpret_cast<const uint8_t*> (&cloud.points[indices[i]]) + offset,    \
+                sizeof (FieldT));                                                                 \
+        result[i] = static_cast<unsigned char> (expr);                                            \
+      }
+      switch (op)
+      {
+        case pcl::ComparisonOps::GT:
+          PCL_COMPARE_BLOCK (field > value);
+          break;
+        case pcl::ComparisonOps::GE:
+          PCL_COMPARE_BLOCK (ThreeWay ? !(field < value) : field >= value);
+          break;
+        case pcl::ComparisonOps::LT:
+          PCL_COMPARE_BLOCK (field < value);
+          break;
+        case pcl::ComparisonOps::LE:
+          PCL_COMPARE_BLOCK (ThreeWay ? !(field > value) : field <= value);
+          break;
+        case pcl::ComparisonOps::EQ:
+          PCL_COMPARE_BLOCK (ThreeWay ? !(field < value) && !(field > value) : field == value);
+          break;
+        default:
+          std::fill (result, result + nr_points, static_cast<unsigned char> (0));
+      }
+#undef PCL_COMPARE_BLOCK
+    }
+  }
+}
 
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
@@ -133,6 +180,17 @@ pcl::FieldComparison<PointT>::evaluate (const PointT &point) const
   }
 }
 
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::FieldComparison<PointT>::compile (ConditionProgram<PointT> &program) const
+{
+  // Invalid comparisons keep their warning path
+  if (!this->capable_ || point_data_ == NULL)
+    program.addComparison (*this);
+  else
+    program.addFieldComparison (point_data_->getDatatype (), point_data_->getOffset (), op_, compare_val_);
+}
+
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
@@ -225,6 +283,16 @@ pcl::PackedRGBComparison<PointT>::evaluate (const PointT &point) const
   }
 }
 
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::PackedRGBComparison<PointT>::compile (ConditionProgram<PointT> &program) const
+{
+  if (!capable_)
+    program.addComparison (*this);
+  else
+    program.addByteComparison (component_offset_, op_, compare_val_);
+}
+
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
@@ -301,55 +369,41 @@ pcl::PackedHSIComparison<PointT>::PackedHSIComparison (
 template <typename PointT> bool
 pcl::PackedHSIComparison<PointT>::evaluate (const PointT &point) const
 {
-  // Since this is a const function, we can't make these data members because we change them here
-  static uint32_t rgb_val_ = 0;
-  static uint8_t r_ = 0;
-  static uint8_t g_ = 0;
-  static uint8_t b_ = 0;
-  static int8_t h_ = 0;
-  static uint8_t s_ = 0;
-  static uint8_t i_ = 0;
+  // No caching across calls (e.g. in static variables): evaluate () may run concurrently
 
   // We know that rgb data is 32 bit aligned (verified in the ctor) so...
   const uint8_t* pt_data = reinterpret_cast<const uint8_t*> (&point);
   const uint32_t* rgb_data = reinterpret_cast<const uint32_t*> (pt_data + rgb_offset_);
-  uint32_t new_rgb_val = *rgb_data;
-
-  if (rgb_val_ != new_rgb_val) 
-  { // avoid having to redo this calc, if possible
-    rgb_val_ = new_rgb_val;
-    // extract r,g,b
-    r_ = static_cast <uint8_t> (rgb_val_ >> 16); 
-    g_ = static_cast <uint8_t> (rgb_val_ >> 8);
-    b_ = static_cast <uint8_t> (rgb_val_);
-
-    // definitions taken from http://en.wikipedia.org/wiki/HSL_and_HSI
-    float hx = (2.0f * r_ - g_ - b_) / 4.0f;  // hue x component -127 to 127
-    float hy = static_cast<float> (g_ - b_) * 111.0f / 255.0f; // hue y component -111 to 111
-    h_ = static_cast<int8_t> (atan2(hy, hx) * 128.0f / M_PI);
-
-    int32_t i = (r_+g_+b_)/3; // 0 to 255
-    i_ = static_cast<uint8_t> (i);
+  uint32_t rgb_val = *rgb_data;
 
-    int32_t m;  // min(r,g,b)
-    m = (r_ < g_) ? r_ : g_;
-    m = (m < b_) ? m : b_;
-
-    s_ = static_cast<uint8_t> ((i == 0) ? 0 : 255 - (m * 255) / i); // saturation 0 to 255
-  }
+  // extract r,g,b
+  uint8_t r = static_cast <uint8_t> (rgb_val >> 16);
+  uint8_t g = static_cast <uint8_t> (rgb_val >> 8);
+  uint8_t b = static_cast <uint8_t> (rgb_val);
 
   float my_val = 0;
 
+  // definitions taken from http://en.wikipedia.org/wiki/HSL_and_HSI
   switch (component_id_) 
   {
     case H:
-      my_val = static_cast <float> (h_);
+    {
+      float hx = (2.0f * r - g - b) / 4.0f;  // hue x component -127 to 127
+      float hy = static_cast<float> (g - b) * 111.0f / 255.0f; // hue y component -111 to 111
+      my_val = static_cast <float> (static_cast<int8_t> (atan2(hy, hx) * 128.0f / M_PI));
       break;
+    }
     case S:
-      my_val = static_cast <float> (s_);
+    {
+      int32_t i = (r+g+b)/3; // 0 to 255
+      int32_t m;  // min(r,g,b)
+      m = (r < g) ? r : g;
+      m = (m < b) ? m : b;
+      my_val = static_cast <float> (static_cast<uint8_t> ((i == 0) ? 0 : 255 - (m * 255) / i)); // saturation 0 to 255
       break;
+    }
     case I:
-      my_val = static_cast <float> (i_);
+      my_val = static_cast <float> (static_cast<uint8_t> ((r+g+b)/3)); // 0 to 255
       break;
     default:
       assert (false);
@@ -620,6 +674,13 @@ pcl::ConditionBase<PointT>::addCondition (Ptr condition)
   conditions_.push_back (condition);
 }
 
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ConditionBase<PointT>::compile (ConditionProgram<PointT> &program) const
+{
+  program.addCondition (*this);
+}
+
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
@@ -637,6 +698,18 @@ pcl::ConditionAnd<PointT>::evaluate (const PointT &point) const
   return (true);
 }
 
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ConditionAnd<PointT>::compile (ConditionProgram<PointT> &program) const
+{
+  program.beginConjunction ();
+  for (size_t i = 0; i < comparisons_.size (); ++i)
+    comparisons_[i]->compile (program);
+  for (size_t i = 0; i < conditions_.size (); ++i)
+    conditions_[i]->compile (program);
+  program.endGroup ();
+}
+
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
@@ -656,6 +729,239 @@ pcl::ConditionOr<PointT>::evaluate (const PointT &point) const
   return (false);
 }
 
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ConditionOr<PointT>::compile (ConditionProgram<PointT> &program) const
+{
+  program.beginDisjunction ();
+  for (size_t i = 0; i < comparisons_.size (); ++i)
+    comparisons_[i]->compile (program);
+  for (size_t i = 0; i < conditions_.size (); ++i)
+    conditions_[i]->compile (program);
+  program.endGroup ();
+}
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ComparisonBase<PointT>::compile (ConditionProgram<PointT> &program) const
+{
+  program.addComparison (*this);
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ConditionProgram<PointT>::compile (const ConditionBase<PointT> &condition)
+{
+  clear ();
+  condition.compile (*this);
+  if (!open_groups_.empty ())
+  {
+    PCL_WARN ("[pcl::ConditionProgram::compile] %lu groups were not closed!\n", open_groups_.size ());
+    while (!open_groups_.empty ())
+      endGroup ();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ConditionProgram<PointT>::clear ()
+{
+  instructions_.clear ();
+  open_groups_.clear ();
+  max_depth_ = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> size_t
+pcl::ConditionProgram<PointT>::addInstruction (InstructionType type)
+{
+  Instruction instruction;
+  instruction.type = type;
+  instruction.op = pcl::ComparisonOps::EQ;
+  instruction.datatype = 0;
+  instruction.offset = 0;
+  instruction.value = 0.0;
+  instruction.end = instructions_.size () + 1;
+  instruction.comparison = NULL;
+  instruction.condition = NULL;
+  instructions_.push_back (instruction);
+  return (instructions_.size () - 1);
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ConditionProgram<PointT>::beginConjunction ()
+{
+  open_groups_.push_back (addInstruction (CONJUNCTION));
+  max_depth_ = std::max (max_depth_, open_groups_.size ());
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ConditionProgram<PointT>::beginDisjunction ()
+{
+  open_groups_.push_back (addInstruction (DISJUNCTION));
+  max_depth_ = std::max (max_depth_, open_groups_.size ());
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ConditionProgram<PointT>::endGroup ()
+{
+  if (open_groups_.empty ())
+  {
+    PCL_WARN ("[pcl::ConditionProgram::endGroup] no open group!\n");
+    return;
+  }
+  instructions_[open_groups_.back ()].end = instructions_.size ();
+  open_groups_.pop_back ();
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ConditionProgram<PointT>::addFieldComparison (
+    uint8_t datatype, uint32_t offset, ComparisonOps::CompareOp op, double value)
+{
+  Instruction &instruction = instructions_[addInstruction (FIELD_COMPARISON)];
+  instruction.datatype = datatype;
+  instruction.offset = offset;
+  instruction.op = op;
+  instruction.value = value;
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ConditionProgram<PointT>::addByteComparison (uint32_t offset, ComparisonOps::CompareOp op, double value)
+{
+  Instruction &instruction = instructions_[addInstruction (BYTE_COMPARISON)];
+  instruction.offset = offset;
+  instruction.op = op;
+  instruction.value = value;
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ConditionProgram<PointT>::addComparison (const ComparisonBase<PointT> &comparison)
+{
+  instructions_[addInstruction (OPAQUE_COMPARISON)].comparison = &comparison;
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ConditionProgram<PointT>::addCondition (const ConditionBase<PointT> &condition)
+{
+  instructions_[addInstruction (OPAQUE_CONDITION)].condition = &condition;
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ConditionProgram<PointT>::evaluate (
+    const PointCloud &cloud, const int *indices, size_t nr_points, unsigned char *result) const
+{
+  // An empty program accepts everything, like an empty ConditionAnd
+  if (instructions_.empty ())
+  {
+    std::fill (result, result + nr_points, static_cast<unsigned char> (1));
+    return;
+  }
+
+  // Every nesting level needs one block to hold the result of the member being evaluated
+  const size_t block_size = 256;
+  std::vector<unsigned char> scratch (std::max<size_t> (max_depth_, 1) * block_size);
+
+  for (size_t begin = 0; begin < nr_points; begin += block_size)
+  {
+    size_t nr_block = std::min (block_size, nr_points - begin);
+    evaluateNode (0, cloud, indices + begin, nr_block, result + begin, &scratch[0], block_size);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ConditionProgram<PointT>::evaluateNode (
+    size_t node, const PointCloud &cloud, const int *indices, size_t nr_points,
+    unsigned char *result, unsigned char *scratch, size_t block_size) const
+{
+  const Instruction &instruction = instructions_[node];
+  switch (instruction.type)
+  {
+    case CONJUNCTION:
+    case DISJUNCTION:
+    {
+      const bool conjunction = (instruction.type == CONJUNCTION);
+      // An empty group is true; otherwise start from the neutral element of the group
+      std::fill (result, result + nr_points, static_cast<unsigned char> (conjunction || instruction.end == node + 1));
+      for (size_t member = node + 1; member < instruction.end; member = instructions_[member].end)
+      {
+        evaluateNode (member, cloud, indices, nr_points, scratch, scratch + block_size, block_size);
+        size_t nr_true = 0;
+        if (conjunction)
+          for (size_t i = 0; i < nr_points; ++i)
+            nr_true += (result[i] &= scratch[i]);
+        else
+          for (size_t i = 0; i < nr_points; ++i)
+            nr_true += (result[i] |= scratch[i]);
+        // The remaining members cannot change the outcome for this block
+        if (nr_true == (conjunction ? 0 : nr_points))
+          break;
+      }
+      break;
+    }
+    case FIELD_COMPARISON:
+    {
+      // Same conversions as PointDataAtOffset::compare
+      const uint32_t offset = instruction.offset;
+      const ComparisonOps::CompareOp op = instruction.op;
+      const double value = instruction.value;
+      switch (instruction.datatype)
+      {
+        case pcl::PCLPointField::INT8:
+          detail::compareBlock<int8_t, int8_t, true> (cloud, indices, nr_points, offset, op, static_cast<int8_t> (value), result);
+          break;
+        case pcl::PCLPointField::UINT8:
+          detail::compareBlock<uint8_t, uint8_t, true> (cloud, indices, nr_points, offset, op, static_cast<uint8_t> (value), result);
+          break;
+        case pcl::PCLPointField::INT16:
+          detail::compareBlock<int16_t, int16_t, true> (cloud, indices, nr_points, offset, op, static_cast<int16_t> (value), result);
+          break;
+        case pcl::PCLPointField::UINT16:
+          detail::compareBlock<uint16_t, uint16_t, true> (cloud, indices, nr_points, offset, op, static_cast<uint16_t> (value), result);
+          break;
+        case pcl::PCLPointField::INT32:
+          detail::compareBlock<int32_t, int32_t, true> (cloud, indices, nr_points, offset, op, static_cast<int32_t> (value), result);
+          break;
+        case pcl::PCLPointField::UINT32:
+          detail::compareBlock<uint32_t, uint32_t, true> (cloud, indices, nr_points, offset, op, static_cast<uint32_t> (value), result);
+          break;
+        case pcl::PCLPointField::FLOAT32:
+          detail::compareBlock<float, float, true> (cloud, indices, nr_points, offset, op, static_cast<float> (value), result);
+          break;
+        case pcl::PCLPointField::FLOAT64:
+          detail::compareBlock<double, double, true> (cloud, indices, nr_points, offset, op, value, result);
+          break;
+        default:
+          // PointDataAtOffset::compare reports unknown types as equal
+          std::fill (result, result + nr_points,
+                     static_cast<unsigned char> (op == pcl::ComparisonOps::GE || op == pcl::ComparisonOps::LE || op == pcl::ComparisonOps::EQ));
+      }
+      break;
+    }
+    case BYTE_COMPARISON:
+      detail::compareBlock<uint8_t, double, false> (cloud, indices, nr_points, instruction.offset, instruction.op, instruction.value, result);
+      break;
+    case OPAQUE_COMPARISON:
+      for (size_t i = 0; i < nr_points; ++i)
+        result[i] = instruction.comparison->evaluate (cloud.points[indices[i]]);
+      break;
+    case OPAQUE_CONDITION:
+      for (size_t i = 0; i < nr_points; ++i)
+        result[i] = instruction.condition->evaluate (cloud.points[indices[i]]);
+      break;
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
@@ -707,8 +1013,15 @@ pcl::ConditionalRemoval<PointT>::applyFilter (PointCloud &output)
   int nr_p = 0;
   int nr_removed_p = 0;
 
+  // Resolve the condition tree once, then evaluate it for all points in blocks
+  ConditionProgram<PointT> program;
+  program.compile (*condition_);
+  std::vector<unsigned char> passed;
+
   if (!keep_organized_)
   {
+    evaluateCondition (program, *Filter<PointT>::indices_, passed);
+
     for (size_t cp = 0; cp < Filter<PointT>::indices_->size (); ++cp)
     {
       // Check if the point is invalid
@@ -724,7 +1037,7 @@ pcl::ConditionalRemoval<PointT>::applyFilter (PointCloud &output)
         continue;
       }
 
-      if (condition_->evaluate (input_->points[(*Filter < PointT > ::indices_)[cp]]))
+      if (passed[cp])
       {
         copyPoint (input_->points[(*Filter < PointT > ::indices_)[cp]], output.points[nr_p]);
         nr_p++;
@@ -746,12 +1059,14 @@ pcl::ConditionalRemoval<PointT>::applyFilter (PointCloud &output)
   {
     std::vector<int> indices = *Filter<PointT>::indices_;
     std::sort (indices.begin (), indices.end ());   //TODO: is this necessary or can we assume the indices to be sorted?
+    evaluateCondition (program, indices, passed);
     bool removed_p = false;
     size_t ci = 0;
     for (size_t cp = 0; cp < input_->points.size (); ++cp)
     {
       if (cp == static_cast<size_t> (indices[ci]))
       {
+        const bool point_passed = (passed[ci] != 0);
         if (ci < indices.size () - 1)
         {
           ci++;
@@ -762,7 +1077,7 @@ pcl::ConditionalRemoval<PointT>::applyFilter (PointCloud &output)
         // copy all the fields
         copyPoint (input_->points[cp], output.points[cp]);
 
-        if (!condition_->evaluate (input_->points[cp]))
+        if (!point_passed)
         {
           output.points[cp].getVector4fMap ().setConstant (user_filter_value_);
           removed_p = true;
@@ -788,6 +1103,30 @@ pcl::ConditionalRemoval<PointT>::applyFilter (PointCloud &output)
   removed_indices_->resize (nr_removed_p);
 }
 
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ConditionalRemoval<PointT>::evaluateCondition (
+    const ConditionProgram<PointT> &program, const std::vector<int> &indices, std::vector<unsigned char> &passed) const
+{
+  passed.resize (indices.size ());
+  if (indices.empty ())
+    return;
+
+  // Chunks are large enough to amortize the per call scratch allocation
+  const int chunk_size = 4096;
+  const int nr_chunks = static_cast<int> ((indices.size () + chunk_size - 1) / chunk_size);
+
+#ifdef _OPENMP
+#pragma omp parallel for shared (program, indices, passed) schedule (dynamic, 1) num_threads(threads_)
+#endif
+  for (int c = 0; c < nr_chunks; ++c)
+  {
+    size_t begin = static_cast<size_t> (c) * chunk_size;
+    size_t nr_points = std::min (static_cast<size_t> (chunk_size), indices.size () - begin);
+    program.evaluate (*input_, &indices[begin], nr_points, &passed[begin]);
+  }
+}
+
 #define PCL_INSTANTIATE_PointDataAtOffset(T) template class PCL_EXPORTS pcl::PointDataAtOffset<T>;
 #define PCL_INSTANTIATE_ComparisonBase(T) template class PCL_EXPORTS pcl::ComparisonBase<T>;
 #define PCL_INSTANTIATE_FieldComparison(T) template class PCL_EXPORTS pcl::FieldComparison<T>;
@@ -797,6 +1136,7 @@ pcl::ConditionalRemoval<PointT>::applyFilter (PointCloud &output)
 #define PCL_INSTANTIATE_ConditionBase(T) template class PCL_EXPORTS pcl::ConditionBase<T>;
 #define PCL_INSTANTIATE_ConditionAnd(T) template class PCL_EXPORTS pcl::ConditionAnd<T>;
 #define PCL_INSTANTIATE_ConditionOr(T) template class PCL_EXPORTS pcl::ConditionOr<T>;
+#define PCL_INSTANTIATE_ConditionProgram(T) template class PCL_EXPORTS pcl::ConditionProgram<T>;
 #define PCL_INSTANTIATE_ConditionalRemoval(T) template class PCL_EXPORTS pcl::ConditionalRemoval<T>;
 
 #endif 
@@ -98,7 +98,7 @@ pcl::CropBox<PointT>::applyFilter (std::vector<int> &indices)
   {
     if (!input_->is_dense)
       // Check if the point is invalid
-      if (!isFinite (input_->points[index]))
+      if (!isFinite (input_->points[(*indices_)[index]]))
         continue;
 
     // Get local point
@@ -39,6 +39,7 @@
 #define PCL_FILTERS_IMPL_CROP_HULL_H_
 
 #include <pcl/filters/crop_hull.h>
+#include <pcl/common/common.h>
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointT> void
@@ -121,29 +122,14 @@ pcl::CropHull<PointT>::getHullCloudRange ()
 template<typename PointT> template<unsigned PlaneDim1, unsigned PlaneDim2> void 
 pcl::CropHull<PointT>::applyFilter2D (PointCloud &output)
 {
+  std::vector<unsigned char> inside;
+  computeInside2D<PlaneDim1, PlaneDim2> (inside);
+
+  // If we're removing points *inside* the hull, only keep points that
+  // haven't been found inside any polygons
   for (size_t index = 0; index < indices_->size (); index++)
-  {
-    // iterate over polygons faster than points because we expect this data
-    // to be, in general, more cache-local - the point cloud might be huge
-    size_t poly;
-    for (poly = 0; poly < hull_polygons_.size (); poly++)
-    {
-      if (isPointIn2DPolyWithVertIndices<PlaneDim1,PlaneDim2> (
-              input_->points[(*indices_)[index]], hull_polygons_[poly], *hull_cloud_
-         ))
-      {
-        if (crop_outside_)
-          output.push_back (input_->points[(*indices_)[index]]);
-        // once a point has tested +ve for being inside one polygon, we can
-        // stop checking the others:
-        break;
-      }
-    }
-    // If we're removing points *inside* the hull, only remove points that
-    // haven't been found inside any polygons
-    if (poly == hull_polygons_.size () && !crop_outside_)
+    if ((inside[index] != 0) == crop_outside_)
       output.push_back (input_->points[(*indices_)[index]]);
-  }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -151,22 +137,109 @@ template<typename PointT> template<unsigned PlaneDim1, unsigned PlaneDim2> void
 pcl::CropHull<PointT>::applyFilter2D (std::vector<int> &indices)
 {
   // see comments in (PointCloud& output) overload
+  std::vector<unsigned char> inside;
+  computeInside2D<PlaneDim1, PlaneDim2> (inside);
+
   for (size_t index = 0; index < indices_->size (); index++)
+    if ((inside[index] != 0) == crop_outside_)
+      indices.push_back ((*indices_)[index]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> template<unsigned PlaneDim1, unsigned PlaneDim2> void
+pcl::CropHull<PointT>::computeInside2D (std::vector<unsigned char> &inside)
+{
+  inside.assign (indices_->size (), 0);
+
+  // Precompute the edge tables of all polygons, see isPointIn2DPolyWithVertIndices
+  std::vector<Polygon2D> polygons (hull_polygons_.size ());
+  std::vector<float> boxes (4 * hull_polygons_.size ());
+  std::vector<Edge2D> edges;
+  std::vector<unsigned int> slab_counts;
+  for (size_t poly = 0; poly < hull_polygons_.size (); poly++)
+  {
+    const std::vector<uint32_t> &verts = hull_polygons_[poly].vertices;
+    Polygon2D &polygon = polygons[poly];
+    edges.resize (verts.size ());
+    float min_x = std::numeric_limits<float>::max (), max_x = -std::numeric_limits<float>::max ();
+    float min_y = std::numeric_limits<float>::max (), max_y = -std::numeric_limits<float>::max ();
+    for (size_t i = 0; i < verts.size (); i++)
+    {
+      const Eigen::Vector3f vnew = (*hull_cloud_)[verts[i]].getVector3fMap ();
+      const Eigen::Vector3f vold = (*hull_cloud_)[verts[(i + verts.size () - 1) % verts.size ()]].getVector3fMap ();
+      const double xnew = vnew[PlaneDim1], ynew = vnew[PlaneDim2];
+      const double xold = vold[PlaneDim1], yold = vold[PlaneDim2];
+      Edge2D &edge = edges[i];
+      edge.x_new = xnew;
+      edge.x_old = xold;
+      // Same orientation rule as isPointIn2DPolyWithVertIndices
+      const bool forward = (xnew > xold);
+      edge.x1 = forward ? xold : xnew;
+      edge.y1 = forward ? yold : ynew;
+      edge.dx = (forward ? xnew : xold) - edge.x1;
+      edge.dy = (forward ? ynew : yold) - edge.y1;
+
+      min_x = std::min (min_x, vnew[PlaneDim1]);
+      max_x = std::max (max_x, vnew[PlaneDim1]);
+      min_y = std::min (min_y, vnew[PlaneDim2]);
+      max_y = std::max (max_y, vnew[PlaneDim2]);
+    }
+    boxes[4 * poly + 0] = min_x;
+    boxes[4 * poly + 1] = min_y;
+    boxes[4 * poly + 2] = max_x;
+    boxes[4 * poly + 3] = max_y;
+
+    // Points outside [min_x, max_x] never straddle an edge, so only the edges
+    // overlapping the slab of a point need to be tested
+    const unsigned int nr_slabs = static_cast<unsigned int> (std::min<size_t> (std::max<size_t> (verts.size () / 8, 1), 1024));
+    polygon.min_x = min_x;
+    polygon.max_x = max_x;
+    polygon.slab_scale = (max_x > min_x) ? nr_slabs / (static_cast<double> (max_x) - min_x) : 0.0;
+    slab_counts.assign (nr_slabs + 1, 0);
+    for (size_t i = 0; i < edges.size (); i++)
+    {
+      const double lo = std::min (edges[i].x_new, edges[i].x_old), hi = std::max (edges[i].x_new, edges[i].x_old);
+      const unsigned int first = std::min (static_cast<unsigned int> ((lo - polygon.min_x) * polygon.slab_scale), nr_slabs - 1);
+      const unsigned int last = std::min (static_cast<unsigned int> ((hi - polygon.min_x) * polygon.slab_scale), nr_slabs - 1);
+      for (unsigned int slab = first; slab <= last; slab++)
+        slab_counts[slab + 1]++;
+    }
+    for (unsigned int slab = 0; slab < nr_slabs; slab++)
+      slab_counts[slab + 1] += slab_counts[slab];
+    polygon.slab_begin = slab_counts;
+    polygon.slab_edges.resize (slab_counts[nr_slabs]);
+    for (size_t i = 0; i < edges.size (); i++)
+    {
+      const double lo = std::min (edges[i].x_new, edges[i].x_old), hi = std::max (edges[i].x_new, edges[i].x_old);
+      const unsigned int first = std::min (static_cast<unsigned int> ((lo - polygon.min_x) * polygon.slab_scale), nr_slabs - 1);
+      const unsigned int last = std::min (static_cast<unsigned int> ((hi - polygon.min_x) * polygon.slab_scale), nr_slabs - 1);
+      for (unsigned int slab = first; slab <= last; slab++)
+        polygon.slab_edges[slab_counts[slab]++] = edges[i];
+    }
+  }
+
+  UniformGrid2D grid;
+  grid.build (boxes, 0.0f);
+
+  const int nr_points = static_cast<int> (indices_->size ());
+#ifdef _OPENMP
+#pragma omp parallel for shared (inside, polygons, grid) schedule (dynamic, 1024) num_threads(threads_)
+#endif
+  for (int index = 0; index < nr_points; index++)
   {
-    size_t poly;
-    for (poly = 0; poly < hull_polygons_.size (); poly++)
+    const Eigen::Vector3f p = input_->points[(*indices_)[index]].getVector3fMap ();
+    const unsigned int *begin, *end;
+    grid.getBoxes (p[PlaneDim1], p[PlaneDim2], begin, end);
+    // once a point has tested +ve for being inside one polygon, we can
+    // stop checking the others
+    for (const unsigned int *poly = begin; poly != end; ++poly)
     {
-      if (isPointIn2DPolyWithVertIndices<PlaneDim1,PlaneDim2> (
-              input_->points[(*indices_)[index]], hull_polygons_[poly], *hull_cloud_
-         ))
+      if (isPointIn2DPolygon (p[PlaneDim1], p[PlaneDim2], polygons[*poly]))
       {
-        if (crop_outside_)      
-          indices.push_back ((*indices_)[index]);
+        inside[index] = 1;
         break;
       }
     }
-    if (poly == hull_polygons_.size () && !crop_outside_)
-      indices.push_back ((*indices_)[index]);
   }
 }
 
@@ -174,36 +247,12 @@ pcl::CropHull<PointT>::applyFilter2D (std::vector<int> &indices)
 template<typename PointT> void 
 pcl::CropHull<PointT>::applyFilter3D (PointCloud &output)
 {
-  // This algorithm could definitely be sped up using kdtree/octree
-  // information, if that is available!
+  std::vector<unsigned char> inside;
+  computeInside3D (inside);
 
   for (size_t index = 0; index < indices_->size (); index++)
-  {
-    // test ray-crossings for three random rays, and take vote of crossings
-    // counts to determine if each point is inside the hull: the vote avoids
-    // tricky edge and corner cases when rays might fluke through the edge
-    // between two polygons
-    // 'random' rays are arbitrary - basically anything that is less likely to
-    // hit the edge between polygons than coordinate-axis aligned rays would
-    // be.
-    size_t crossings[3] = {0,0,0};
-    Eigen::Vector3f rays[3] = 
-    {
-      Eigen::Vector3f (0.264882f,  0.688399f, 0.675237f),
-      Eigen::Vector3f (0.0145419f, 0.732901f, 0.68018f),
-      Eigen::Vector3f (0.856514f,  0.508771f, 0.0868081f)
-    };
-
-    for (size_t poly = 0; poly < hull_polygons_.size (); poly++)
-      for (size_t ray = 0; ray < 3; ray++)
-        crossings[ray] += rayTriangleIntersect
-          (input_->points[(*indices_)[index]], rays[ray], hull_polygons_[poly], *hull_cloud_);
-
-    if (crop_outside_ && (crossings[0]&1) + (crossings[1]&1) + (crossings[2]&1) > 1)
-      output.push_back (input_->points[(*indices_)[index]]);
-    else if (!crop_outside_)
+    if ((inside[index] != 0) == crop_outside_)
       output.push_back (input_->points[(*indices_)[index]]);
-  }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -211,26 +260,180 @@ template<typename PointT> void
 pcl::CropHull<PointT>::applyFilter3D (std::vector<int> &indices)
 {
   // see comments in applyFilter3D (PointCloud& output)
+  std::vector<unsigned char> inside;
+  computeInside3D (inside);
+
   for (size_t index = 0; index < indices_->size (); index++)
+    if ((inside[index] != 0) == crop_outside_)
+      indices.push_back ((*indices_)[index]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::CropHull<PointT>::computeInside3D (std::vector<unsigned char> &inside)
+{
+  inside.assign (indices_->size (), 0);
+
+  // test ray-crossings for three random rays, and take vote of crossings
+  // counts to determine if each point is inside the hull: the vote avoids
+  // tricky edge and corner cases when rays might fluke through the edge
+  // between two polygons
+  // 'random' rays are arbitrary - basically anything that is less likely to
+  // hit the edge between polygons than coordinate-axis aligned rays would
+  // be.
+  const Eigen::Vector3f rays[3] = 
   {
+    Eigen::Vector3f (0.264882f,  0.688399f, 0.675237f),
+    Eigen::Vector3f (0.0145419f, 0.732901f, 0.68018f),
+    Eigen::Vector3f (0.856514f,  0.508771f, 0.0868081f)
+  };
+
+  // A ray can only cross the triangles whose projection along the ray covers
+  // the ray origin: bin the projected triangles of every ray direction
+  Eigen::Vector3f axes[3][2];
+  UniformGrid2D grids[3];
+  Eigen::Vector4f hull_min, hull_max;
+  pcl::getMinMax3D (*hull_cloud_, hull_min, hull_max);
+  // Covers the rounding of the projection and of the intersection test
+  const float padding = 1e-4f * ((hull_max - hull_min).head<3> ().norm () + hull_max.head<3> ().cwiseAbs ().maxCoeff () +
+                                 hull_min.head<3> ().cwiseAbs ().maxCoeff ()) + std::numeric_limits<float>::min ();
+  std::vector<float> boxes (4 * hull_polygons_.size ());
+  for (int ray = 0; ray < 3; ray++)
+  {
+    axes[ray][0] = rays[ray].unitOrthogonal ();
+    axes[ray][1] = rays[ray].cross (axes[ray][0]).normalized ();
+    for (size_t poly = 0; poly < hull_polygons_.size (); poly++)
+    {
+      float *box = &boxes[4 * poly];
+      box[0] = box[1] = std::numeric_limits<float>::max ();
+      box[2] = box[3] = -std::numeric_limits<float>::max ();
+      // rayTriangleIntersect only looks at the first three vertices
+      for (size_t i = 0; i < 3 && i < hull_polygons_[poly].vertices.size (); i++)
+      {
+        const Eigen::Vector3f v = (*hull_cloud_)[hull_polygons_[poly].vertices[i]].getVector3fMap ();
+        const float x = axes[ray][0].dot (v), y = axes[ray][1].dot (v);
+        box[0] = std::min (box[0], x);
+        box[1] = std::min (box[1], y);
+        box[2] = std::max (box[2], x);
+        box[3] = std::max (box[3], y);
+      }
+    }
+    grids[ray].build (boxes, padding);
+  }
+
+  const int nr_points = static_cast<int> (indices_->size ());
+#ifdef _OPENMP
+#pragma omp parallel for shared (inside, axes, grids) schedule (dynamic, 256) num_threads(threads_)
+#endif
+  for (int index = 0; index < nr_points; index++)
+  {
+    const PointT &point = input_->points[(*indices_)[index]];
+    const Eigen::Vector3f p = point.getVector3fMap ();
     size_t crossings[3] = {0,0,0};
-    Eigen::Vector3f rays[3] = 
+    for (int ray = 0; ray < 3; ray++)
     {
-      Eigen::Vector3f(0.264882f,  0.688399f, 0.675237f),
-      Eigen::Vector3f(0.0145419f, 0.732901f, 0.68018f),
-      Eigen::Vector3f(0.856514f,  0.508771f, 0.0868081f)
-    };
+      const unsigned int *begin, *end;
+      grids[ray].getBoxes (axes[ray][0].dot (p), axes[ray][1].dot (p), begin, end);
+      for (const unsigned int *poly = begin; poly != end; ++poly)
+        crossings[ray] += rayTriangleIntersect (point, rays[ray], hull_polygons_[*poly], *hull_cloud_);
+    }
+    inside[index] = ((crossings[0]&1) + (crossings[1]&1) + (crossings[2]&1) > 1);
+  }
+}
 
-    for (size_t poly = 0; poly < hull_polygons_.size (); poly++)
-      for (size_t ray = 0; ray < 3; ray++)
-        crossings[ray] += rayTriangleIntersect
-          (input_->points[(*indices_)[index]], rays[ray], hull_polygons_[poly], *hull_cloud_);
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::CropHull<PointT>::UniformGrid2D::build (const std::vector<float> &boxes, float padding)
+{
+  const size_t nr_boxes = boxes.size () / 4;
+  min_x = min_y = std::numeric_limits<float>::max ();
+  max_x = max_y = -std::numeric_limits<float>::max ();
+  for (size_t i = 0; i < nr_boxes; i++)
+  {
+    // The box of a polygon without vertices is inverted, and is left out
+    if (!(boxes[4 * i + 0] <= boxes[4 * i + 2] && boxes[4 * i + 1] <= boxes[4 * i + 3]))
+      continue;
+    min_x = std::min (min_x, boxes[4 * i + 0] - padding);
+    min_y = std::min (min_y, boxes[4 * i + 1] - padding);
+    max_x = std::max (max_x, boxes[4 * i + 2] + padding);
+    max_y = std::max (max_y, boxes[4 * i + 3] + padding);
+  }
+  cell_begin.assign (2, 0);
+  cell_items.clear ();
+  // No boxes: the bounds reject every point
+  if (!(min_x <= max_x && min_y <= max_y))
+  {
+    nr_cells_x = nr_cells_y = 1;
+    inv_cell_size = 0;
+    return;
+  }
 
-    if (crop_outside_ && (crossings[0]&1) + (crossings[1]&1) + (crossings[2]&1) > 1)
-      indices.push_back ((*indices_)[index]);
-    else if (!crop_outside_)
-      indices.push_back ((*indices_)[index]);
+  // Aim for about one box per cell, with at most 512 cells per side
+  const float extent = std::max (std::max (max_x - min_x, max_y - min_y), std::numeric_limits<float>::min ());
+  const float cell_size = std::max (std::sqrt ((max_x - min_x) * (max_y - min_y) / static_cast<float> (nr_boxes)),
+                                    extent / 512.0f);
+  inv_cell_size = 1.0f / cell_size;
+  nr_cells_x = std::min (static_cast<int> ((max_x - min_x) * inv_cell_size) + 1, 512);
+  nr_cells_y = std::min (static_cast<int> ((max_y - min_y) * inv_cell_size) + 1, 512);
+
+  // Count, then fill: the boxes of cell c are cell_items[cell_begin[c] .. cell_begin[c+1])
+  const size_t nr_cells = static_cast<size_t> (nr_cells_x) * nr_cells_y;
+  cell_begin.assign (nr_cells + 1, 0);
+  for (int pass = 0; pass < 2; pass++)
+  {
+    for (size_t i = 0; i < nr_boxes; i++)
+    {
+      if (!(boxes[4 * i + 0] <= boxes[4 * i + 2] && boxes[4 * i + 1] <= boxes[4 * i + 3]))
+        continue;
+      const int x0 = std::min (static_cast<int> ((boxes[4 * i + 0] - padding - min_x) * inv_cell_size), nr_cells_x - 1);
+      const int y0 = std::min (static_cast<int> ((boxes[4 * i + 1] - padding - min_y) * inv_cell_size), nr_cells_y - 1);
+      const int x1 = std::min (static_cast<int> ((boxes[4 * i + 2] + padding - min_x) * inv_cell_size), nr_cells_x - 1);
+      const int y1 = std::min (static_cast<int> ((boxes[4 * i + 3] + padding - min_y) * inv_cell_size), nr_cells_y - 1);
+      for (int y = std::max (y0, 0); y <= y1; y++)
+        for (int x = std::max (x0, 0); x <= x1; x++)
+        {
+          const size_t cell = static_cast<size_t> (y) * nr_cells_x + x;
+          if (pass == 0)
+            cell_begin[cell + 1]++;
+          else
+            cell_items[cell_begin[cell]++] = static_cast<unsigned int> (i);
+        }
+    }
+    if (pass == 0)
+    {
+      for (size_t cell = 0; cell < nr_cells; cell++)
+        cell_begin[cell + 1] += cell_begin[cell];
+      cell_items.resize (cell_begin[nr_cells]);
+    }
+    else
+    {
+      // The fill advanced every cell start to the start of the next cell
+      for (size_t cell = nr_cells; cell > 0; cell--)
+        cell_begin[cell] = cell_begin[cell - 1];
+      cell_begin[0] = 0;
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> bool
+pcl::CropHull<PointT>::isPointIn2DPolygon (double x, double y, const Polygon2D &polygon)
+{
+  // Outside [min_x, max_x] no edge passes the first condition below
+  if (!(x >= polygon.min_x && x <= polygon.max_x))
+    return (false);
+
+  const size_t nr_slabs = polygon.slab_begin.size () - 1;
+  const size_t slab = std::min (static_cast<size_t> ((x - polygon.min_x) * polygon.slab_scale), nr_slabs - 1);
+  bool in_poly = false;
+  for (unsigned int i = polygon.slab_begin[slab]; i < polygon.slab_begin[slab + 1]; i++)
+  {
+    const Edge2D &edge = polygon.slab_edges[i];
+    if ((edge.x_new < x) == (x <= edge.x_old) &&
+        (y - edge.y1) * edge.dx < edge.dy * (x - edge.x1))
+      in_poly = !in_poly;
   }
+  return (in_poly);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
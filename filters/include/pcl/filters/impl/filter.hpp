@@ -92,6 +92,49 @@ pcl::removeNaNFromPointCloud (const pcl::PointCloud<PointT> &cloud_in,
   }
 }
 
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::removeNaNFromPointCloud (const pcl::PointCloudSoA<PointT> &cloud_in, 
+                              pcl::PointCloudSoA<PointT> &cloud_out,
+                              std::vector<int> &index)
+{
+  index.resize (cloud_in.size ());
+
+  // If the data is dense, we don't need to check for NaN
+  if (cloud_in.is_dense)
+  {
+    // Simply copy the data
+    if (&cloud_in != &cloud_out)
+      cloud_out = cloud_in;
+    for (size_t j = 0; j < index.size (); ++j)
+      index[j] = static_cast<int>(j);
+    return;
+  }
+
+  // Only the coordinate columns are scanned, the other columns are gathered afterwards
+  const float *x = cloud_in.x (), *y = cloud_in.y (), *z = cloud_in.z ();
+  size_t j = 0;
+  for (size_t i = 0; i < cloud_in.size (); ++i)
+  {
+    if (!pcl_isfinite (x[i]) || !pcl_isfinite (y[i]) || !pcl_isfinite (z[i]))
+      continue;
+    index[j++] = static_cast<int>(i);
+  }
+  index.resize (j);
+
+  if (&cloud_in != &cloud_out)
+    pcl::copyPointCloud (cloud_in, index, cloud_out);
+  else
+  {
+    pcl::PointCloudSoA<PointT> cloud_tmp;
+    pcl::copyPointCloud (cloud_in, index, cloud_tmp);
+    cloud_out = cloud_tmp;
+  }
+
+  // Removing bad points => dense (note: 'dense' doesn't mean 'organized')
+  cloud_out.is_dense = true;
+}
+
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::removeNaNNormalsFromPointCloud (const pcl::PointCloud<PointT> &cloud_in, 
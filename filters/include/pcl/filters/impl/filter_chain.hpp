@@ -0,0 +1,454 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef PCL_FILTERS_IMPL_FILTER_CHAIN_HPP_
+#define PCL_FILTERS_IMPL_FILTER_CHAIN_HPP_
+
+#include <pcl/filters/filter_chain.h>
+#include <pcl/filters/passthrough.h>
+#include <pcl/filters/crop_box.h>
+#include <pcl/filters/frustum_culling.h>
+#include <pcl/filters/extract_indices.h>
+#include <pcl/common/transforms.h>
+#include <pcl/common/io.h>
+
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Apply an affine transformation to the coordinates of a block of points, in place. */
+    inline void
+    transformBlock (const Eigen::Affine3f &transform, float *x, float *y, float *z, int size)
+    {
+      const Eigen::Matrix4f &m = transform.matrix ();
+      const float m00 = m (0, 0), m01 = m (0, 1), m02 = m (0, 2), m03 = m (0, 3);
+      const float m10 = m (1, 0), m11 = m (1, 1), m12 = m (1, 2), m13 = m (1, 3);
+      const float m20 = m (2, 0), m21 = m (2, 1), m22 = m (2, 2), m23 = m (2, 3);
+      for (int i = 0; i < size; ++i)
+      {
+        const float px = x[i], py = y[i], pz = z[i];
+        x[i] = m00 * px + m01 * py + m02 * pz + m03;
+        y[i] = m10 * px + m11 * py + m12 * pz + m13;
+        z[i] = m20 * px + m21 * py + m22 * pz + m23;
+      }
+    }
+
+    /** \brief Clear the mask entries of the points with a non-finite coordinate. */
+    inline void
+    maskFinite (const float *x, const float *y, const float *z, int size, unsigned char *mask)
+    {
+      for (int i = 0; i < size; ++i)
+        mask[i] &= (pcl_isfinite (x[i]) & pcl_isfinite (y[i]) & pcl_isfinite (z[i]));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/** \brief PassThrough test: the point is finite and its field value lies within [min; max]
+  * (outside of it if negative). Without a field (offset < 0) only the finiteness is tested.
+  */
+template <typename PointT>
+class pcl::FilterChain<PointT>::FieldRangePredicate : public pcl::FilterChain<PointT>::PointPredicate
+{
+  public:
+    /** \param[in] component 0, 1 or 2 if the field is x, y or z, -1 otherwise */
+    FieldRangePredicate (int component, int offset, float limit_min, float limit_max, bool negative) :
+      component_ (component), offset_ (offset), limit_min_ (limit_min), limit_max_ (limit_max), negative_ (negative)
+    {
+    }
+
+    void
+    apply (const PointCloud &cloud, const PointBlock &block, unsigned char *mask) const
+    {
+      // Non-finite entries are always removed
+      pcl::detail::maskFinite (block.x, block.y, block.z, block.size, mask);
+      if (offset_ < 0)
+        return;
+
+      const float *values = block.x;
+      float field_values[PointBlock::capacity];
+      if (component_ == 1)
+        values = block.y;
+      else if (component_ == 2)
+        values = block.z;
+      else if (component_ < 0)
+      {
+        for (int i = 0; i < block.size; ++i)
+          memcpy (&field_values[i], reinterpret_cast<const uint8_t*> (&cloud.points[block.indices[i]]) + offset_, sizeof (float));
+        values = field_values;
+      }
+
+      for (int i = 0; i < block.size; ++i)
+      {
+        const float field_value = values[i];
+        const bool inside = (field_value >= limit_min_) & (field_value <= limit_max_);
+        mask[i] &= (pcl_isfinite (field_value) & (inside != negative_));
+      }
+    }
+
+  private:
+    int component_;
+    int offset_;
+    float limit_min_;
+    float limit_max_;
+    bool negative_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/** \brief CropBox test: the point, brought into the local frame of the box, lies inside the box
+  * (outside of it if negative). Non-finite points of non-dense clouds never pass.
+  */
+template <typename PointT>
+class pcl::FilterChain<PointT>::BoxPredicate : public pcl::FilterChain<PointT>::PointPredicate
+{
+  public:
+    BoxPredicate (pcl::CropBox<PointT> &crop_box, bool check_finite) :
+      transform_ (crop_box.getTransform ()),
+      inverse_transform_ (Eigen::Affine3f::Identity ()),
+      translation_ (crop_box.getTranslation ()),
+      min_pt_ (crop_box.getMin ()),
+      max_pt_ (crop_box.getMax ()),
+      negative_ (crop_box.getNegative ()),
+      check_finite_ (check_finite)
+    {
+      const Eigen::Vector3f rotation = crop_box.getRotation ();
+      if (rotation != Eigen::Vector3f::Zero ())
+      {
+        Eigen::Affine3f rotation_transform;
+        pcl::getTransformation (0, 0, 0, rotation (0), rotation (1), rotation (2), rotation_transform);
+        inverse_transform_ = rotation_transform.inverse ();
+      }
+      transform_is_identity_ = transform_.matrix ().isIdentity ();
+      translation_is_zero_ = (translation_ == Eigen::Vector3f::Zero ());
+      inverse_transform_is_identity_ = inverse_transform_.matrix ().isIdentity ();
+    }
+
+    void
+    apply (const PointCloud &, const PointBlock &block, unsigned char *mask) const
+    {
+      if (check_finite_)
+        pcl::detail::maskFinite (block.x, block.y, block.z, block.size, mask);
+
+      // Same sequence of operations as CropBox: transform, translate, then undo the rotation
+      float x[PointBlock::capacity], y[PointBlock::capacity], z[PointBlock::capacity];
+      std::copy (block.x, block.x + block.size, x);
+      std::copy (block.y, block.y + block.size, y);
+      std::copy (block.z, block.z + block.size, z);
+      if (!transform_is_identity_)
+        pcl::detail::transformBlock (transform_, x, y, z, block.size);
+      if (!translation_is_zero_)
+      {
+        const float tx = translation_ (0), ty = translation_ (1), tz = translation_ (2);
+        for (int i = 0; i < block.size; ++i)
+        {
+          x[i] -= tx;
+          y[i] -= ty;
+          z[i] -= tz;
+        }
+      }
+      if (!inverse_transform_is_identity_)
+        pcl::detail::transformBlock (inverse_transform_, x, y, z, block.size);
+
+      const float min_x = min_pt_[0], min_y = min_pt_[1], min_z = min_pt_[2];
+      const float max_x = max_pt_[0], max_y = max_pt_[1], max_z = max_pt_[2];
+      for (int i = 0; i < block.size; ++i)
+      {
+        const bool inside = (x[i] >= min_x) & (y[i] >= min_y) & (z[i] >= min_z) &
+                            (x[i] <= max_x) & (y[i] <= max_y) & (z[i] <= max_z);
+        mask[i] &= (inside != negative_);
+      }
+    }
+
+  private:
+    Eigen::Affine3f transform_;
+    Eigen::Affine3f inverse_transform_;
+    Eigen::Vector3f translation_;
+    Eigen::Vector4f min_pt_;
+    Eigen::Vector4f max_pt_;
+    bool transform_is_identity_;
+    bool translation_is_zero_;
+    bool inverse_transform_is_identity_;
+    bool negative_;
+    bool check_finite_;
+
+  public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/** \brief FrustumCulling test: the point lies on the inner side of all planes (not if negative). */
+template <typename PointT>
+class pcl::FilterChain<PointT>::PlanesPredicate : public pcl::FilterChain<PointT>::PointPredicate
+{
+  public:
+    PlanesPredicate (const pcl::FrustumCulling<PointT> &frustum, bool negative) :
+      planes_ (), negative_ (negative)
+    {
+      frustum.getFrustumPlanes (planes_);
+    }
+
+    void
+    apply (const PointCloud &, const PointBlock &block, unsigned char *mask) const
+    {
+      unsigned char is_in_fov[PointBlock::capacity];
+      std::fill (is_in_fov, is_in_fov + block.size, 1);
+      for (int pi = 0; pi < 6; ++pi)
+      {
+        const float a = planes_ (0, pi), b = planes_ (1, pi), c = planes_ (2, pi), d = planes_ (3, pi);
+        for (int i = 0; i < block.size; ++i)
+          is_in_fov[i] &= (block.x[i] * a + block.y[i] * b + block.z[i] * c + d <= 0);
+      }
+      for (int i = 0; i < block.size; ++i)
+        mask[i] &= (is_in_fov[i] != negative_);
+    }
+
+  private:
+    Eigen::Matrix<float, 4, 6> planes_;
+    bool negative_;
+
+  public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/** \brief ExtractIndices test: the point is part of the given index set (not part of it if negative). */
+template <typename PointT>
+class pcl::FilterChain<PointT>::IndexSetPredicate : public pcl::FilterChain<PointT>::PointPredicate
+{
+  public:
+    IndexSetPredicate (const std::vector<int> *indices, size_t nr_points, bool negative) :
+      is_in_set_ (nr_points, indices == NULL), negative_ (negative)
+    {
+      // Indices outside of the input can not select a point
+      if (indices)
+        for (size_t i = 0; i < indices->size (); ++i)
+          if ((*indices)[i] >= 0 && static_cast<size_t> ((*indices)[i]) < nr_points)
+            is_in_set_[(*indices)[i]] = 1;
+    }
+
+    void
+    apply (const PointCloud &, const PointBlock &block, unsigned char *mask) const
+    {
+      for (int i = 0; i < block.size; ++i)
+      {
+        const int index = block.indices[i];
+        const bool is_in_set = index >= 0 && static_cast<size_t> (index) < is_in_set_.size () && is_in_set_[index];
+        mask[i] &= (is_in_set != negative_);
+      }
+    }
+
+  private:
+    std::vector<unsigned char> is_in_set_;
+    bool negative_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::FilterChain<PointT>::applyFilter (PointCloud &output)
+{
+  std::vector<int> indices;
+  if (keep_organized_)
+  {
+    bool temp = extract_removed_indices_;
+    extract_removed_indices_ = true;
+    applyFilterIndices (indices);
+    extract_removed_indices_ = temp;
+
+    output = *input_;
+    for (int rii = 0; rii < static_cast<int> (removed_indices_->size ()); ++rii)  // rii = removed indices iterator
+      output.points[(*removed_indices_)[rii]].x = output.points[(*removed_indices_)[rii]].y = output.points[(*removed_indices_)[rii]].z = user_filter_value_;
+    if (!pcl_isfinite (user_filter_value_))
+      output.is_dense = false;
+  }
+  else
+  {
+    applyFilterIndices (indices);
+    copyPointCloud (*input_, indices, output);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> typename pcl::FilterChain<PointT>::PointPredicatePtr
+pcl::FilterChain<PointT>::makePredicate (const FilterIndicesPtr &filter) const
+{
+  if (pcl::PassThrough<PointT> *pass = dynamic_cast<pcl::PassThrough<PointT>*> (filter.get ()))
+  {
+    const std::string &field_name = pass->getFilterFieldName ();
+    int component = -1, offset = -1;
+    if (!field_name.empty ())
+    {
+      std::vector<pcl::PCLPointField> fields;
+      int distance_idx = pcl::getFieldIndex (*input_, field_name, fields);
+      // Let the stage itself report the unknown field
+      if (distance_idx == -1)
+        return (PointPredicatePtr ());
+      offset = fields[distance_idx].offset;
+      // The coordinates are already gathered into the blocks
+      if (field_name == "x")
+        component = 0;
+      else if (field_name == "y")
+        component = 1;
+      else if (field_name == "z")
+        component = 2;
+    }
+    float limit_min, limit_max;
+    pass->getFilterLimits (limit_min, limit_max);
+    return (PointPredicatePtr (new FieldRangePredicate (component, offset, limit_min, limit_max, pass->getNegative ())));
+  }
+
+  if (pcl::CropBox<PointT> *crop_box = dynamic_cast<pcl::CropBox<PointT>*> (filter.get ()))
+    return (PointPredicatePtr (new BoxPredicate (*crop_box, !input_->is_dense)));
+
+  if (pcl::FrustumCulling<PointT> *frustum = dynamic_cast<pcl::FrustumCulling<PointT>*> (filter.get ()))
+    return (PointPredicatePtr (new PlanesPredicate (*frustum, frustum->getNegative ())));
+
+  if (pcl::ExtractIndices<PointT> *extract = dynamic_cast<pcl::ExtractIndices<PointT>*> (filter.get ()))
+    return (PointPredicatePtr (new IndexSetPredicate (hasUserIndices (*extract) ? extract->getIndices ().get () : NULL,
+                                                      input_->points.size (), extract->getNegative ())));
+
+  return (PointPredicatePtr ());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::FilterChain<PointT>::applyPredicates (const std::vector<PointPredicatePtr> &predicates, std::vector<int> &indices) const
+{
+  if (predicates.empty ())
+    return;
+
+  const PointCloud &cloud = *input_;
+  PointBlock block;
+  unsigned char mask[PointBlock::capacity];
+  int oii = 0;  // oii = output indices iterator
+  for (size_t start = 0; start < indices.size (); start += PointBlock::capacity)
+  {
+    block.indices = &indices[start];
+    block.size = static_cast<int> (std::min (indices.size () - start, static_cast<size_t> (PointBlock::capacity)));
+    for (int i = 0; i < block.size; ++i)
+    {
+      const PointT &point = cloud.points[block.indices[i]];
+      block.x[i] = point.x;
+      block.y[i] = point.y;
+      block.z[i] = point.z;
+    }
+    std::fill (mask, mask + block.size, 1);
+
+    // Stop once no point of the block is left
+    for (size_t pi = 0; pi < predicates.size (); ++pi)
+    {
+      predicates[pi]->apply (cloud, block, mask);
+      if (std::find (mask, mask + block.size, 1) == mask + block.size)
+        break;
+    }
+
+    // The output never overtakes the block, so the indices can be compacted in place
+    for (int i = 0; i < block.size; ++i)
+      if (mask[i])
+        indices[oii++] = block.indices[i];
+  }
+  indices.resize (oii);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::FilterChain<PointT>::applyFilterIndices (std::vector<int> &indices)
+{
+  std::vector<int> passed (*indices_);
+  std::vector<PointPredicatePtr> predicates;
+  for (size_t fi = 0; fi < filters_.size (); ++fi)
+  {
+    PointPredicatePtr predicate = makePredicate (filters_[fi]);
+    if (predicate)
+    {
+      predicates.push_back (predicate);
+      continue;
+    }
+
+    // The stage needs the indices that survived so far
+    applyPredicates (predicates, passed);
+    predicates.clear ();
+
+    // Run the stage on the chain's input, then hand its own settings back. Indices the stage
+    // generated for itself are dropped, so that it generates them again for its next input.
+    const PointCloudConstPtr stage_input = filters_[fi]->getInputCloud ();
+    const IndicesPtr stage_user_indices = hasUserIndices (*filters_[fi]) ? filters_[fi]->getIndices () : IndicesPtr ();
+    IndicesPtr stage_indices (new std::vector<int>);
+    stage_indices->swap (passed);
+    filters_[fi]->setInputCloud (input_);
+    filters_[fi]->setIndices (stage_indices);
+    filters_[fi]->filter (passed);
+    filters_[fi]->setInputCloud (stage_input);
+    filters_[fi]->setIndices (stage_user_indices);
+  }
+  applyPredicates (predicates, passed);
+
+  indices.clear ();
+  removed_indices_->clear ();
+  if (!negative_ && !extract_removed_indices_)
+  {
+    indices.swap (passed);
+    return;
+  }
+
+  std::vector<bool> is_passed (input_->points.size (), false);
+  for (size_t i = 0; i < passed.size (); ++i)
+    is_passed[passed[i]] = true;
+
+  if (!negative_)
+    indices.swap (passed);
+  for (size_t iii = 0; iii < indices_->size (); ++iii)  // iii = input indices iterator
+  {
+    const int index = (*indices_)[iii];
+    if (is_passed[index])
+    {
+      if (negative_ && extract_removed_indices_)
+        removed_indices_->push_back (index);
+    }
+    else if (negative_)
+      indices.push_back (index);
+    else
+      removed_indices_->push_back (index);
+  }
+}
+
+#define PCL_INSTANTIATE_FilterChain(T) template class PCL_EXPORTS pcl::FilterChain<T>;
+
+#endif  // PCL_FILTERS_IMPL_FILTER_CHAIN_HPP_
@@ -73,7 +73,7 @@ pcl::FrustumCulling<PointT>::applyFilter (PointCloud& output)
 
 ///////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
-pcl::FrustumCulling<PointT>::applyFilter (std::vector<int> &indices)
+pcl::FrustumCulling<PointT>::getFrustumPlanes (Eigen::Matrix<float, 4, 6> &planes) const
 {
   Eigen::Vector4f pl_n; // near plane 
   Eigen::Vector4f pl_f; // far plane
@@ -143,6 +143,21 @@ pcl::FrustumCulling<PointT>::applyFilter (std::vector<int> &indices)
   pl_t (3) = -T.dot (pl_t.block (0, 0, 3, 1));
   pl_b (3) = -T.dot (pl_b.block (0, 0, 3, 1));
 
+  planes.col (0) = pl_l;
+  planes.col (1) = pl_r;
+  planes.col (2) = pl_t;
+  planes.col (3) = pl_b;
+  planes.col (4) = pl_f;
+  planes.col (5) = pl_n;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::FrustumCulling<PointT>::applyFilter (std::vector<int> &indices)
+{
+  Eigen::Matrix<float, 4, 6> planes;
+  getFrustumPlanes (planes);
+
   if (extract_removed_indices_)
   {
     removed_indices_->resize (indices_->size ());
@@ -157,12 +172,12 @@ pcl::FrustumCulling<PointT>::applyFilter (std::vector<int> &indices)
                         input_->points[idx].y,
                         input_->points[idx].z,
                         1.0f);
-    bool is_in_fov = (pt.dot (pl_l) <= 0) && 
-                     (pt.dot (pl_r) <= 0) &&
-                     (pt.dot (pl_t) <= 0) && 
-                     (pt.dot (pl_b) <= 0) && 
-                     (pt.dot (pl_f) <= 0) &&
-                     (pt.dot (pl_n) <= 0);
+    bool is_in_fov = (pt.dot (planes.col (0)) <= 0) && 
+                     (pt.dot (planes.col (1)) <= 0) &&
+                     (pt.dot (planes.col (2)) <= 0) && 
+                     (pt.dot (planes.col (3)) <= 0) && 
+                     (pt.dot (planes.col (4)) <= 0) &&
+                     (pt.dot (planes.col (5)) <= 0);
     if (is_in_fov ^ negative_)
     {
       indices[indices_ctr++] = idx;
@@ -45,15 +45,40 @@
 #include <pcl/common/common.h>
 #include <pcl/common/io.h>
 #include <pcl/filters/grid_minimum.h>
+#include <pcl/filters/voxel_binning.h>
 
-struct point_index_idx
+namespace pcl
 {
-  unsigned int idx;
-  unsigned int cloud_point_index;
+  namespace detail
+  {
+    /** \brief Bins points into the 2D cells of GridMinimum and scores them by their height. */
+    template <typename PointT>
+    struct GridMinimumBinner
+    {
+      GridMinimumBinner (float inverse_resolution, const Eigen::Vector4i &min_b, const Eigen::Vector4i &div_b) :
+        inverse_resolution_ (inverse_resolution), min_b_ (min_b), div_b_ (div_b)
+      {
+      }
 
-  point_index_idx (unsigned int idx_, unsigned int cloud_point_index_) : idx (idx_), cloud_point_index (cloud_point_index_) {}
-  bool operator < (const point_index_idx &p) const { return (idx < p.idx); }
-};
+      inline uint64_t
+      getKey (const PointT &p) const
+      {
+        int ijk0 = static_cast<int> (floor (p.x * inverse_resolution_) - static_cast<float> (min_b_[0]));
+        int ijk1 = static_cast<int> (floor (p.y * inverse_resolution_) - static_cast<float> (min_b_[1]));
+        return (static_cast<uint64_t> (ijk0) + static_cast<uint64_t> (ijk1) * static_cast<uint64_t> (div_b_[0]));
+      }
+
+      inline float
+      getScore (const PointT &p) const
+      {
+        return (p.z);
+      }
+
+      const float inverse_resolution_;
+      const Eigen::Vector4i min_b_, div_b_;
+    };
+  }
+}
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
@@ -79,9 +104,6 @@ pcl::GridMinimum<PointT>::applyFilter (PointCloud &output)
 template <typename PointT> void
 pcl::GridMinimum<PointT>::applyFilterIndices (std::vector<int> &indices)
 {
-  indices.resize (indices_->size ());
-  int oii = 0;
-
   // Get the minimum and maximum dimensions
   Eigen::Vector4f min_p, max_p;
   getMinMax3D<PointT> (*input_, *indices_, min_p, max_p);
@@ -93,10 +115,11 @@ pcl::GridMinimum<PointT>::applyFilterIndices (std::vector<int> &indices)
   if ((dx*dy) > static_cast<int64_t> (std::numeric_limits<int32_t>::max ()))
   {
     PCL_WARN ("[pcl::%s::applyFilter] Leaf size is too small for the input dataset. Integer indices would overflow.", getClassName ().c_str ());
+    indices.clear ();
     return;
   }
 
-  Eigen::Vector4i min_b, max_b, div_b, divb_mul;
+  Eigen::Vector4i min_b, max_b, div_b;
 
   // Compute the minimum and maximum bounding box values
   min_b[0] = static_cast<int> (floor (min_p[0] * inverse_resolution_));
@@ -108,88 +131,14 @@ pcl::GridMinimum<PointT>::applyFilterIndices (std::vector<int> &indices)
   div_b = max_b - min_b + Eigen::Vector4i::Ones ();
   div_b[3] = 0;
 
-  // Set up the division multiplier
-  divb_mul = Eigen::Vector4i (1, div_b[0], 0, 0);
-
-  std::vector<point_index_idx> index_vector;
-  index_vector.reserve (indices_->size ());
-
-  // First pass: go over all points and insert them into the index_vector vector
-  // with calculated idx. Points with the same idx value will contribute to the
-  // same point of resulting CloudPoint
-  for (std::vector<int>::const_iterator it = indices_->begin (); it != indices_->end (); ++it)
-  {
-    if (!input_->is_dense)
-      // Check if the point is invalid
-      if (!pcl_isfinite (input_->points[*it].x) ||
-          !pcl_isfinite (input_->points[*it].y) ||
-          !pcl_isfinite (input_->points[*it].z))
-        continue;
-
-    int ijk0 = static_cast<int> (floor (input_->points[*it].x * inverse_resolution_) - static_cast<float> (min_b[0]));
-    int ijk1 = static_cast<int> (floor (input_->points[*it].y * inverse_resolution_) - static_cast<float> (min_b[1]));
-
-    // Compute the grid cell index
-    int idx = ijk0 * divb_mul[0] + ijk1 * divb_mul[1];
-    index_vector.push_back (point_index_idx (static_cast<unsigned int> (idx), *it));
-  }
-  
-  // Second pass: sort the index_vector vector using value representing target cell as index
-  // in effect all points belonging to the same output cell will be next to each other
-  std::sort (index_vector.begin (), index_vector.end (), std::less<point_index_idx> ());
-
-  // Third pass: count output cells
-  // we need to skip all the same, adjacenent idx values
-  unsigned int total = 0;
-  unsigned int index = 0;
-
-  // first_and_last_indices_vector[i] represents the index in index_vector of the first point in
-  // index_vector belonging to the voxel which corresponds to the i-th output point,
-  // and of the first point not belonging to.
-  std::vector<std::pair<unsigned int, unsigned int> > first_and_last_indices_vector;
-  
-  // Worst case size
-  first_and_last_indices_vector.reserve (index_vector.size ());
-  while (index < index_vector.size ())
-  {
-    unsigned int i = index + 1;
-    while (i < index_vector.size () && index_vector[i].idx == index_vector[index].idx)
-      ++i;
-    ++total;
-    first_and_last_indices_vector.push_back (std::pair<unsigned int, unsigned int> (index, i));
-    index = i;
-  }
-
-  // Fourth pass: locate grid minimums
-  indices.resize (total);
-
-  index = 0;
-
-  for (unsigned int cp = 0; cp < first_and_last_indices_vector.size (); ++cp)
-  {
-    unsigned int first_index = first_and_last_indices_vector[cp].first;
-    unsigned int last_index = first_and_last_indices_vector[cp].second;
-    unsigned int min_index = index_vector[first_index].cloud_point_index;
-    float min_z = input_->points[index_vector[first_index].cloud_point_index].z;
-
-    for (unsigned int i = first_index + 1; i < last_index; ++i)
-    {
-      if (input_->points[index_vector[i].cloud_point_index].z < min_z)
-      {
-        min_z = input_->points[index_vector[i].cloud_point_index].z;
-        min_index = index_vector[i].cloud_point_index;
-      }
-    }
-
-    indices[index] = min_index;
-    
-    ++index;
-  }
-
-  oii = indices.size ();
+  // Bin the points in parallel and keep the lowest point of every cell
+  std::vector<std::pair<uint64_t, int> > representatives;
+  selectVoxelRepresentatives (*input_, *indices_, detail::GridMinimumBinner<PointT> (inverse_resolution_, min_b, div_b),
+                              representatives, threads_);
 
-  // Resize the output arrays
-  indices.resize (oii);
+  indices.resize (representatives.size ());
+  for (size_t cp = 0; cp < representatives.size (); ++cp)
+    indices[cp] = (*indices_)[representatives[cp].second];
 }
 
 #define PCL_INSTANTIATE_GridMinimum(T) template class PCL_EXPORTS pcl::GridMinimum<T>;
@@ -0,0 +1,181 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef PCL_FILTERS_IMPL_MULTI_FRUSTUM_CULLING_HPP_
+#define PCL_FILTERS_IMPL_MULTI_FRUSTUM_CULLING_HPP_
+
+#include <pcl/filters/multi_frustum_culling.h>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> size_t
+pcl::MultiFrustumCulling<PointT>::addCamera (
+    const Eigen::Matrix4f &camera_pose, float hfov, float vfov, float np_dist, float fp_dist)
+{
+  FrustumCulling<PointT> frustum_culling;
+  frustum_culling.setCameraPose (camera_pose);
+  frustum_culling.setHorizontalFOV (hfov);
+  frustum_culling.setVerticalFOV (vfov);
+  frustum_culling.setNearPlaneDistance (np_dist);
+  frustum_culling.setFarPlaneDistance (fp_dist);
+  return (addCamera (frustum_culling));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> size_t
+pcl::MultiFrustumCulling<PointT>::addCamera (const FrustumCulling<PointT> &frustum_culling)
+{
+  Eigen::Matrix<float, 4, 6> planes;
+  frustum_culling.getFrustumPlanes (planes);
+
+  // Grow the tables by one block of cameras when needed
+  const size_t old_padded = getPaddedNumberOfCameras ();
+  const size_t camera = nr_cameras_++;
+  const size_t padded = getPaddedNumberOfCameras ();
+  if (padded != old_padded)
+  {
+    std::vector<float> new_planes (24 * padded, 0.0f);
+    for (size_t row = 0; row < 24; ++row)
+    {
+      std::copy (planes_.begin () + row * old_padded, planes_.begin () + (row + 1) * old_padded,
+                 new_planes.begin () + row * padded);
+      // The d coefficients of the padding cameras
+      if (row % 4 == 3)
+        std::fill (new_planes.begin () + row * padded + old_padded, new_planes.begin () + (row + 1) * padded, 1.0f);
+    }
+    planes_.swap (new_planes);
+  }
+
+  for (size_t k = 0; k < 6; ++k)
+    for (size_t j = 0; j < 4; ++j)
+      planes_[(k * 4 + j) * padded + camera] = planes (j, k);
+  return (camera);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::MultiFrustumCulling<PointT>::clearCameras ()
+{
+  nr_cameras_ = 0;
+  planes_.clear ();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::MultiFrustumCulling<PointT>::computeVisibilityMasks (std::vector<uint64_t> &masks)
+{
+  masks.clear ();
+  if (!initCompute ())
+    return;
+
+  computeMasks (masks);
+  deinitCompute ();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::MultiFrustumCulling<PointT>::computeVisibleIndices (std::vector<std::vector<int> > &indices)
+{
+  indices.assign (nr_cameras_, std::vector<int> ());
+  if (!initCompute ())
+    return;
+
+  std::vector<uint64_t> masks;
+  computeMasks (masks);
+
+  // One camera per iteration keeps every list in input order
+  const size_t words = getWordsPerPoint ();
+  const int nr_cameras = static_cast<int> (nr_cameras_);
+#ifdef _OPENMP
+#pragma omp parallel for shared (indices, masks) schedule (dynamic, 1) num_threads(threads_)
+#endif
+  for (int c = 0; c < nr_cameras; ++c)
+  {
+    const uint64_t bit = static_cast<uint64_t> (1) << (c % 64);
+    const uint64_t *mask = &masks[c / 64];
+    std::vector<int> &camera_indices = indices[c];
+    for (size_t i = 0; i < indices_->size (); ++i, mask += words)
+      if (*mask & bit)
+        camera_indices.push_back ((*indices_)[i]);
+  }
+
+  deinitCompute ();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::MultiFrustumCulling<PointT>::computeMasks (std::vector<uint64_t> &masks) const
+{
+  const size_t words = getWordsPerPoint ();
+  const size_t padded = getPaddedNumberOfCameras ();
+  masks.assign (indices_->size () * words, 0);
+  if (nr_cameras_ == 0)
+    return;
+
+  const int nr_points = static_cast<int> (indices_->size ());
+  std::vector<int> inside (padded);
+#ifdef _OPENMP
+#pragma omp parallel for shared (masks) firstprivate (inside) schedule (static, 1024) num_threads(threads_)
+#endif
+  for (int i = 0; i < nr_points; ++i)
+  {
+    const PointT &point = input_->points[(*indices_)[i]];
+    const float x = point.x, y = point.y, z = point.z;
+
+    // Same test as FrustumCulling: inside iff (x, y, z, 1) . plane <= 0 for all six planes.
+    // The loops over the cameras run over contiguous coefficients and vectorize.
+    std::fill (inside.begin (), inside.end (), 1);
+    for (size_t k = 0; k < 6; ++k)
+    {
+      const float *a = &planes_[(k * 4 + 0) * padded];
+      const float *b = &planes_[(k * 4 + 1) * padded];
+      const float *c = &planes_[(k * 4 + 2) * padded];
+      const float *d = &planes_[(k * 4 + 3) * padded];
+      for (size_t cam = 0; cam < padded; ++cam)
+        inside[cam] &= (a[cam] * x + b[cam] * y + c[cam] * z + d[cam] <= 0.0f);
+    }
+
+    uint64_t *mask = &masks[i * words];
+    for (size_t cam = 0; cam < nr_cameras_; ++cam)
+      mask[cam / 64] |= static_cast<uint64_t> (inside[cam]) << (cam % 64);
+  }
+}
+
+#define PCL_INSTANTIATE_MultiFrustumCulling(T) template class PCL_EXPORTS pcl::MultiFrustumCulling<T>;
+
+#endif  // PCL_FILTERS_IMPL_MULTI_FRUSTUM_CULLING_HPP_
@@ -42,6 +42,7 @@
 
 #include <pcl/filters/radius_outlier_removal.h>
 #include <pcl/common/io.h>
+#include <algorithm>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
@@ -90,89 +91,42 @@ pcl::RadiusOutlierRemoval<PointT>::applyFilterIndices (std::vector<int> &indices
   }
   searcher_->setInputCloud (input_);
 
-  // The arrays to be used
-  std::vector<int> nn_indices (indices_->size ());
-  std::vector<float> nn_dists (indices_->size ());
+  const int nr_queries = static_cast<int> (indices_->size ());
   indices.resize (indices_->size ());
   removed_indices_->resize (indices_->size ());
   int oii = 0, rii = 0;  // oii = output indices iterator, rii = removed indices iterator
 
-  // If the data is dense => use nearest-k search
-  if (input_->is_dense)
-  {
-    // Note: k includes the query point, so is always at least 1
-    int mean_k = min_pts_radius_ + 1;
-    double nn_dists_max = search_radius_ * search_radius_;
+  // Only the existence of min_pts_radius_ neighbors matters, so the count search may stop early
+  // Note: the count includes the query point, so is always at least 1
+  const unsigned int max_count = static_cast<unsigned int> (std::max (min_pts_radius_ + 1, 1));
+  std::vector<unsigned char> is_inlier (nr_queries);
 
-    for (std::vector<int>::const_iterator it = indices_->begin (); it != indices_->end (); ++it)
-    {
-      // Perform the nearest-k search
-      int k = searcher_->nearestKSearch (*it, mean_k, nn_indices, nn_dists);
-
-      // Check the number of neighbors
-      // Note: nn_dists is sorted, so check the last item
-      bool chk_neighbors = true;
-      if (k == mean_k)
-      {
-        if (negative_)
-        {
-          chk_neighbors = false;
-          if (nn_dists_max < nn_dists[k-1])
-          {
-            chk_neighbors = true;
-          }
-        }
-        else
-        {
-          chk_neighbors = true;
-          if (nn_dists_max < nn_dists[k-1])
-          {
-            chk_neighbors = false;
-          }
-        }
-      }
-      else
-      {
-        if (negative_)
-          chk_neighbors = true;
-        else
-          chk_neighbors = false;
-      }
-
-      // Points having too few neighbors are outliers and are passed to removed indices
-      // Unless negative was set, then it's the opposite condition
-      if (!chk_neighbors)
-      {
-        if (extract_removed_indices_)
-          (*removed_indices_)[rii++] = *it;
-        continue;
-      }
-
-      // Otherwise it was a normal point for output (inlier)
-      indices[oii++] = *it;
-    }
+#ifdef _OPENMP
+#pragma omp parallel for shared (is_inlier) schedule (dynamic, 256) num_threads(threads_)
+#endif
+  for (int iii = 0; iii < nr_queries; ++iii)  // iii = input indices iterator
+  {
+    const PointT &point = input_->points[(*indices_)[iii]];
+    int k = 0;
+    if (input_->is_dense || (pcl_isfinite (point.x) && pcl_isfinite (point.y) && pcl_isfinite (point.z)))
+      k = searcher_->radiusSearchCount (point, search_radius_, max_count);
+
+    // Points having too few neighbors are outliers and are passed to removed indices
+    // Unless negative was set, then it's the opposite condition
+    is_inlier[iii] = (!negative_ && k > min_pts_radius_) || (negative_ && k <= min_pts_radius_);
   }
-  // NaN or Inf values could exist => use radius search
-  else
+
+  for (int iii = 0; iii < nr_queries; ++iii)  // iii = input indices iterator
   {
-    for (std::vector<int>::const_iterator it = indices_->begin (); it != indices_->end (); ++it)
+    if (!is_inlier[iii])
     {
-      // Perform the radius search
-      // Note: k includes the query point, so is always at least 1
-      int k = searcher_->radiusSearch (*it, search_radius_, nn_indices, nn_dists);
-
-      // Points having too few neighbors are outliers and are passed to removed indices
-      // Unless negative was set, then it's the opposite condition
-      if ((!negative_ && k <= min_pts_radius_) || (negative_ && k > min_pts_radius_))
-      {
-        if (extract_removed_indices_)
-          (*removed_indices_)[rii++] = *it;
-        continue;
-      }
-
-      // Otherwise it was a normal point for output (inlier)
-      indices[oii++] = *it;
+      if (extract_removed_indices_)
+        (*removed_indices_)[rii++] = (*indices_)[iii];
+      continue;
     }
+
+    // Otherwise it was a normal point for output (inlier)
+    indices[oii++] = (*indices_)[iii];
   }
 
   // Resize the output arrays
@@ -68,62 +68,104 @@ pcl::StatisticalOutlierRemoval<PointT>::applyFilter (PointCloud &output)
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::StatisticalOutlierRemoval<PointT>::computeMeanDistance (int index, std::vector<int> &nn_indices, std::vector<float> &nn_dists, float &distance) const
+{
+  distance = 0.0f;
+  if (!pcl_isfinite (input_->points[index].x) ||
+      !pcl_isfinite (input_->points[index].y) ||
+      !pcl_isfinite (input_->points[index].z))
+    return (false);
+
+  const std::vector<int> *row_indices = &nn_indices;
+  const std::vector<float> *row_dists = &nn_dists;
+  if (graph_sqr_distances_)
+  {
+    // Reuse the neighbors provided by another stage
+    row_indices = &(*graph_indices_)[index];
+    row_dists = &(*graph_sqr_distances_)[index];
+  }
+  else if (searcher_->nearestKSearch (index, mean_k_ + 1, nn_indices, nn_dists) == 0)
+  {
+    PCL_WARN ("[pcl::%s::applyFilter] Searching for the closest %d neighbors failed.\n", getClassName ().c_str (), mean_k_);
+    return (false);
+  }
+
+  // Skip the query point, which comes first in its own neighborhood. A searcher may return an exact duplicate
+  // of the query before the query itself, so its first result is always skipped; rows of a neighbor graph
+  // may or may not contain the query
+  int first = 1;
+  if (graph_sqr_distances_)
+    first = (!row_indices->empty () && (*row_indices)[0] == index) ? 1 : 0;
+  if (static_cast<int> (row_dists->size ()) < first + mean_k_)
+    return (false);
+
+  // Calculate the mean distance to its neighbors
+  double dist_sum = 0.0;
+  for (int k = first; k < first + mean_k_; ++k)
+    dist_sum += sqrt ((*row_dists)[k]);
+  distance = static_cast<float> (dist_sum / mean_k_);
+  return (true);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::StatisticalOutlierRemoval<PointT>::applyFilterIndices (std::vector<int> &indices)
 {
-  // Initialize the search class
-  if (!searcher_)
+  if (graph_sqr_distances_)
   {
-    if (input_->isOrganized ())
-      searcher_.reset (new pcl::search::OrganizedNeighbor<PointT> ());
-    else
-      searcher_.reset (new pcl::search::KdTree<PointT> (false));
+    if (!graph_indices_ || graph_indices_->size () != input_->points.size () || graph_sqr_distances_->size () != input_->points.size ())
+    {
+      PCL_ERROR ("[pcl::%s::applyFilter] The neighbor graph does not have one row per input point!\n", getClassName ().c_str ());
+      indices.clear ();
+      removed_indices_->clear ();
+      return;
+    }
+  }
+  else
+  {
+    // Initialize the search class
+    if (!searcher_)
+    {
+      if (input_->isOrganized ())
+        searcher_.reset (new pcl::search::OrganizedNeighbor<PointT> ());
+      else
+        searcher_.reset (new pcl::search::KdTree<PointT> (false));
+    }
+    searcher_->setInputCloud (input_);
   }
-  searcher_->setInputCloud (input_);
+
+  const int nr_queries = static_cast<int> (indices_->size ());
 
   // The arrays to be used
   std::vector<int> nn_indices (mean_k_);
   std::vector<float> nn_dists (mean_k_);
-  std::vector<float> distances (indices_->size ());
+  std::vector<float> distances;
   indices.resize (indices_->size ());
   removed_indices_->resize (indices_->size ());
   int oii = 0, rii = 0;  // oii = output indices iterator, rii = removed indices iterator
 
-  // First pass: Compute the mean distances for all points with respect to their k nearest neighbors
-  int valid_distances = 0;
-  for (int iii = 0; iii < static_cast<int> (indices_->size ()); ++iii)  // iii = input indices iterator
-  {
-    if (!pcl_isfinite (input_->points[(*indices_)[iii]].x) ||
-        !pcl_isfinite (input_->points[(*indices_)[iii]].y) ||
-        !pcl_isfinite (input_->points[(*indices_)[iii]].z))
-    {
-      distances[iii] = 0.0;
-      continue;
-    }
-
-    // Perform the nearest k search
-    if (searcher_->nearestKSearch ((*indices_)[iii], mean_k_ + 1, nn_indices, nn_dists) == 0)
-    {
-      distances[iii] = 0.0;
-      PCL_WARN ("[pcl::%s::applyFilter] Searching for the closest %d neighbors failed.\n", getClassName ().c_str (), mean_k_);
-      continue;
-    }
+  // First pass: Compute the mean distances of all points (or of a sample) with respect to their k nearest neighbors
+  const int stride = (sample_size_ > 0 && static_cast<int> (sample_size_) < nr_queries) ? nr_queries / static_cast<int> (sample_size_) : 1;
+  const int nr_samples = (nr_queries + stride - 1) / stride;
+  distances.resize (nr_samples);
+  std::vector<unsigned char> valid (nr_samples);
 
-    // Calculate the mean distance to its neighbors
-    double dist_sum = 0.0;
-    for (int k = 1; k < mean_k_ + 1; ++k)  // k = 0 is the query point
-      dist_sum += sqrt (nn_dists[k]);
-    distances[iii] = static_cast<float> (dist_sum / mean_k_);
-    valid_distances++;
-  }
+#ifdef _OPENMP
+#pragma omp parallel for shared (distances, valid) firstprivate (nn_indices, nn_dists) schedule (dynamic, 256) num_threads(threads_)
+#endif
+  for (int sii = 0; sii < nr_samples; ++sii)  // sii = sample indices iterator
+    valid[sii] = computeMeanDistance ((*indices_)[sii * stride], nn_indices, nn_dists, distances[sii]);
 
   // Estimate the mean and the standard deviation of the distance vector
   double sum = 0, sq_sum = 0;
+  int valid_distances = 0;
   for (size_t i = 0; i < distances.size (); ++i)
   {
     sum += distances[i];
     sq_sum += distances[i] * distances[i];
+    valid_distances += valid[i];
   }
   double mean = sum / static_cast<double>(valid_distances);
   double variance = (sq_sum - sum * sum / static_cast<double>(valid_distances)) / (static_cast<double>(valid_distances) - 1);
@@ -132,12 +174,35 @@ pcl::StatisticalOutlierRemoval<PointT>::applyFilterIndices (std::vector<int> &in
 
   double distance_threshold = mean + std_mul_ * stddev;
 
-  // Second pass: Classify the points on the computed distance threshold
-  for (int iii = 0; iii < static_cast<int> (indices_->size ()); ++iii)  // iii = input indices iterator
+  // Points having a too high average distance are outliers and are passed to removed indices
+  // Unless negative was set, then it's the opposite condition
+  std::vector<unsigned char> removed (nr_queries);
+  if (stride > 1)
+  {
+    // With a subsample-estimated threshold the remaining points are searched and classified in one pass
+#ifdef _OPENMP
+#pragma omp parallel for shared (distances, removed) firstprivate (nn_indices, nn_dists) schedule (dynamic, 256) num_threads(threads_)
+#endif
+    for (int iii = 0; iii < nr_queries; ++iii)  // iii = input indices iterator
+    {
+      float distance;
+      if (iii % stride == 0)
+        distance = distances[iii / stride];
+      else
+        computeMeanDistance ((*indices_)[iii], nn_indices, nn_dists, distance);
+      removed[iii] = (!negative_ && distance > distance_threshold) || (negative_ && distance <= distance_threshold);
+    }
+  }
+  else
+  {
+    for (int iii = 0; iii < nr_queries; ++iii)  // iii = input indices iterator
+      removed[iii] = (!negative_ && distances[iii] > distance_threshold) || (negative_ && distances[iii] <= distance_threshold);
+  }
+
+  // Second pass: Split the points on their classification
+  for (int iii = 0; iii < nr_queries; ++iii)  // iii = input indices iterator
   {
-    // Points having a too high average distance are outliers and are passed to removed indices
-    // Unless negative was set, then it's the opposite condition
-    if ((!negative_ && distances[iii] > distance_threshold) || (negative_ && distances[iii] <= distance_threshold))
+    if (removed[iii])
     {
       if (extract_removed_indices_)
         (*removed_indices_)[rii++] = (*indices_)[iii];
@@ -40,6 +40,50 @@
 
 #include <pcl/common/common.h>
 #include <pcl/filters/uniform_sampling.h>
+#include <pcl/filters/voxel_binning.h>
+
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Bins points into the leaves of UniformSampling and scores them by their
+      * distance to the grid coordinates of their leaf.
+      */
+    template <typename PointT>
+    struct UniformSamplingBinner
+    {
+      UniformSamplingBinner (const Eigen::Array4f &inverse_leaf_size, const Eigen::Vector4i &min_b, const Eigen::Vector4i &div_b) :
+        inverse_leaf_size_ (inverse_leaf_size), min_b_ (min_b), div_b_ (div_b)
+      {
+      }
+
+      inline Eigen::Vector4i
+      getGridCoordinates (const PointT &p) const
+      {
+        return (Eigen::Vector4i (static_cast<int> (floor (p.x * inverse_leaf_size_[0])),
+                                 static_cast<int> (floor (p.y * inverse_leaf_size_[1])),
+                                 static_cast<int> (floor (p.z * inverse_leaf_size_[2])), 0));
+      }
+
+      inline uint64_t
+      getKey (const PointT &p) const
+      {
+        const Eigen::Vector4i ijk = getGridCoordinates (p) - min_b_;
+        return (static_cast<uint64_t> (ijk[0]) +
+                static_cast<uint64_t> (div_b_[0]) * (static_cast<uint64_t> (ijk[1]) + static_cast<uint64_t> (div_b_[1]) * static_cast<uint64_t> (ijk[2])));
+      }
+
+      inline float
+      getScore (const PointT &p) const
+      {
+        return ((p.getVector4fMap () - getGridCoordinates (p).template cast<float> ()).squaredNorm ());
+      }
+
+      const Eigen::Array4f inverse_leaf_size_;
+      const Eigen::Vector4i min_b_, div_b_;
+    };
+  }
+}
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
@@ -73,69 +117,33 @@ pcl::UniformSampling<PointT>::applyFilter (PointCloud &output)
   div_b_ = max_b_ - min_b_ + Eigen::Vector4i::Ones ();
   div_b_[3] = 0;
 
-  // Clear the leaves
-  leaves_.clear ();
-
   // Set up the division multiplier
   divb_mul_ = Eigen::Vector4i (1, div_b_[0], div_b_[0] * div_b_[1], 0);
 
-  Filter<PointT>::removed_indices_->clear();
-  // First pass: build a set of leaves with the point index closest to the leaf center
-  for (size_t cp = 0; cp < indices_->size (); ++cp)
-  {
-    if (!input_->is_dense)
-    {
-      // Check if the point is invalid
-      if (!pcl_isfinite (input_->points[(*indices_)[cp]].x) || 
-          !pcl_isfinite (input_->points[(*indices_)[cp]].y) || 
-          !pcl_isfinite (input_->points[(*indices_)[cp]].z))
-      {
-        if (Filter<PointT>::extract_removed_indices_)
-        {
-          Filter<PointT>::removed_indices_->push_back ((*indices_)[cp]);
-        }
-        continue;
-      }
-    }
-
-    Eigen::Vector4i ijk = Eigen::Vector4i::Zero ();
-    ijk[0] = static_cast<int> (floor (input_->points[(*indices_)[cp]].x * inverse_leaf_size_[0]));
-    ijk[1] = static_cast<int> (floor (input_->points[(*indices_)[cp]].y * inverse_leaf_size_[1]));
-    ijk[2] = static_cast<int> (floor (input_->points[(*indices_)[cp]].z * inverse_leaf_size_[2]));
-
-    // Compute the leaf index
-    int idx = (ijk - min_b_).dot (divb_mul_);
-    Leaf& leaf = leaves_[idx];
-    // First time we initialize the index
-    if (leaf.idx == -1)
-    {
-      leaf.idx = (*indices_)[cp];
-      continue;
-    }
-
-    // Check to see if this point is closer to the leaf center than the previous one we saved
-    float diff_cur   = (input_->points[(*indices_)[cp]].getVector4fMap () - ijk.cast<float> ()).squaredNorm ();
-    float diff_prev  = (input_->points[leaf.idx].getVector4fMap ()        - ijk.cast<float> ()).squaredNorm ();
-
-    // If current point is closer, copy its index instead
-    if (diff_cur < diff_prev)
-    {
-      if (Filter<PointT>::extract_removed_indices_)
-      {
-        Filter<PointT>::removed_indices_->push_back (leaf.idx);
-      }
-
-      leaf.idx = (*indices_)[cp];
-    }
-  }
+  // First pass: bin the points in parallel and keep the one closest to the leaf in every leaf
+  std::vector<std::pair<uint64_t, int> > representatives;
+  selectVoxelRepresentatives (*input_, *indices_, detail::UniformSamplingBinner<PointT> (inverse_leaf_size_, min_b_, div_b_),
+                              representatives, threads_);
 
   // Second pass: go over all leaves and copy data
-  output.points.resize (leaves_.size ());
-  int cp = 0;
-
-  for (typename boost::unordered_map<size_t, Leaf>::const_iterator it = leaves_.begin (); it != leaves_.end (); ++it)
-    output.points[cp++] = input_->points[it->second.idx];
+  output.points.resize (representatives.size ());
+  for (size_t cp = 0; cp < representatives.size (); ++cp)
+    output.points[cp] = input_->points[(*indices_)[representatives[cp].second]];
   output.width = static_cast<uint32_t> (output.points.size ());
+
+  // Every point that was not kept is removed, invalid points included
+  Filter<PointT>::removed_indices_->clear();
+  if (Filter<PointT>::extract_removed_indices_)
+  {
+    std::vector<bool> kept (indices_->size (), false);
+    for (size_t cp = 0; cp < representatives.size (); ++cp)
+      kept[representatives[cp].second] = true;
+
+    Filter<PointT>::removed_indices_->reserve (indices_->size () - representatives.size ());
+    for (size_t cp = 0; cp < indices_->size (); ++cp)
+      if (!kept[cp])
+        Filter<PointT>::removed_indices_->push_back ((*indices_)[cp]);
+  }
 }
 
 #define PCL_INSTANTIATE_UniformSampling(T) template class PCL_EXPORTS pcl::UniformSampling<T>;
@@ -0,0 +1,116 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef PCL_FILTERS_IMPL_VOXEL_BINNING_H_
+#define PCL_FILTERS_IMPL_VOXEL_BINNING_H_
+
+#include <pcl/filters/voxel_binning.h>
+#include <boost/unordered_map.hpp>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename BinnerT> void
+pcl::selectVoxelRepresentatives (const pcl::PointCloud<PointT> &cloud, const std::vector<int> &indices,
+                                 const BinnerT &binner,
+                                 std::vector<std::pair<uint64_t, int> > &representatives,
+                                 unsigned int nr_threads)
+{
+  // Best (score, position in indices) found so far for every cell
+  typedef boost::unordered_map<uint64_t, std::pair<float, int> > CellMap;
+
+  int nr_partitions = 1;
+#ifdef _OPENMP
+  nr_partitions = nr_threads > 0 ? static_cast<int> (nr_threads) : omp_get_max_threads ();
+#endif
+  const int nr_indices = static_cast<int> (indices.size ());
+  nr_partitions = std::max (1, std::min (nr_partitions, nr_indices / 4096 + 1));
+
+  std::vector<CellMap> partial_cells (nr_partitions);
+
+  // First pass: every thread bins its own contiguous slice of the indices
+#ifdef _OPENMP
+#pragma omp parallel for shared(cloud, indices, binner, partial_cells) schedule(static, 1) num_threads(nr_partitions)
+#endif
+  for (int part = 0; part < nr_partitions; ++part)
+  {
+    CellMap &cells = partial_cells[part];
+    const int begin = static_cast<int> (static_cast<int64_t> (nr_indices) * part / nr_partitions);
+    const int end = static_cast<int> (static_cast<int64_t> (nr_indices) * (part + 1) / nr_partitions);
+    cells.rehash (static_cast<size_t> (end - begin) / 4);
+
+    for (int i = begin; i < end; ++i)
+    {
+      const PointT &pt = cloud.points[indices[i]];
+      if (!cloud.is_dense)
+        // Check if the point is invalid
+        if (!pcl_isfinite (pt.x) || !pcl_isfinite (pt.y) || !pcl_isfinite (pt.z))
+          continue;
+
+      const float score = binner.getScore (pt);
+      std::pair<typename CellMap::iterator, bool> cell = cells.insert (std::make_pair (binner.getKey (pt), std::make_pair (score, i)));
+      // Positions grow inside a slice, so only a strictly better score replaces the current point
+      if (!cell.second && score < cell.first->second.first)
+        cell.first->second = std::make_pair (score, i);
+    }
+  }
+
+  // Second pass: merge the partial maps into the first one, slices are merged in order
+  CellMap &cells = partial_cells[0];
+  for (int part = 1; part < nr_partitions; ++part)
+  {
+    for (typename CellMap::const_iterator it = partial_cells[part].begin (); it != partial_cells[part].end (); ++it)
+    {
+      std::pair<typename CellMap::iterator, bool> cell = cells.insert (*it);
+      if (!cell.second && it->second.first < cell.first->second.first)
+        cell.first->second = it->second;
+    }
+    CellMap ().swap (partial_cells[part]);
+  }
+
+  // Third pass: output the representatives ordered by cell
+  representatives.clear ();
+  representatives.reserve (cells.size ());
+  for (typename CellMap::const_iterator it = cells.begin (); it != cells.end (); ++it)
+    representatives.push_back (std::make_pair (it->first, it->second.second));
+  std::sort (representatives.begin (), representatives.end ());
+}
+
+#endif    // PCL_FILTERS_IMPL_VOXEL_BINNING_H_
@@ -0,0 +1,209 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef PCL_FILTERS_IMPL_VOXEL_GRID_ACCUMULATOR_HPP_
+#define PCL_FILTERS_IMPL_VOXEL_GRID_ACCUMULATOR_HPP_
+
+#include <pcl/filters/voxel_grid_accumulator.h>
+
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Voxel coordinates are packed into 21 bits each. */
+    const int64_t voxel_key_offset = static_cast<int64_t> (1) << 20;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::VoxelGridAccumulator<PointT>::setLeafSize (float lx, float ly, float lz)
+{
+  leaf_size_ = Eigen::Vector3f (lx, ly, lz);
+  inverse_leaf_size_ = leaf_size_.cwiseInverse ();
+  voxels_.clear ();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::VoxelGridAccumulator<PointT>::setDownsampleAllData (bool downsample)
+{
+  downsample_all_data_ = downsample;
+  voxels_.clear ();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::VoxelGridAccumulator<PointT>::addPoint (const PointT &point)
+{
+  if (!pcl_isfinite (point.x) || !pcl_isfinite (point.y) || !pcl_isfinite (point.z))
+    return;
+
+  // Same binning as VoxelGrid
+  const int64_t i = static_cast<int64_t> (floor (point.x * inverse_leaf_size_[0])) + detail::voxel_key_offset;
+  const int64_t j = static_cast<int64_t> (floor (point.y * inverse_leaf_size_[1])) + detail::voxel_key_offset;
+  const int64_t k = static_cast<int64_t> (floor (point.z * inverse_leaf_size_[2])) + detail::voxel_key_offset;
+  const int64_t range = 2 * detail::voxel_key_offset;
+  if (i < 0 || i >= range || j < 0 || j >= range || k < 0 || k >= range)
+    return;
+
+  Voxel &voxel = voxels_[(static_cast<uint64_t> (i) << 42) | (static_cast<uint64_t> (j) << 21) | static_cast<uint64_t> (k)];
+  voxel.sum += point.getVector3fMap ().template cast<double> ();
+  ++voxel.nr_points;
+  if (downsample_all_data_)
+    voxel.centroid.add (point);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::VoxelGridAccumulator<PointT>::addCloud (const PointCloud &cloud)
+{
+  for (size_t i = 0; i < cloud.points.size (); ++i)
+    addPoint (cloud.points[i]);
+  evict (cloud.sensor_origin_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::VoxelGridAccumulator<PointT>::addCloud (const PointCloud &cloud, const std::vector<int> &indices)
+{
+  for (size_t i = 0; i < indices.size (); ++i)
+    addPoint (cloud.points[indices[i]]);
+  evict (cloud.sensor_origin_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::VoxelGridAccumulator<PointT>::evict (const Eigen::Vector4f &sensor_origin)
+{
+  if (eviction_radius_ > 0)
+    removeVoxelsOutside (sensor_origin.head<3> (), eviction_radius_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> size_t
+pcl::VoxelGridAccumulator<PointT>::removeVoxelsOutside (const Eigen::Vector3f &center, float radius)
+{
+  const Eigen::Vector3d c = center.cast<double> ();
+  const double squared_radius = static_cast<double> (radius) * radius;
+  size_t nr_removed = 0;
+  typename VoxelMap::iterator it = voxels_.begin ();
+  while (it != voxels_.end ())
+  {
+    const Voxel &voxel = it->second;
+    if ((voxel.sum / voxel.nr_points - c).squaredNorm () > squared_radius)
+    {
+      it = voxels_.erase (it);
+      ++nr_removed;
+    }
+    else
+      ++it;
+  }
+  return (nr_removed);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> size_t
+pcl::VoxelGridAccumulator<PointT>::removeVoxelsOutside (const Eigen::Vector3f &min_pt, const Eigen::Vector3f &max_pt)
+{
+  const Eigen::Vector3d min_d = min_pt.cast<double> (), max_d = max_pt.cast<double> ();
+  size_t nr_removed = 0;
+  typename VoxelMap::iterator it = voxels_.begin ();
+  while (it != voxels_.end ())
+  {
+    const Eigen::Vector3d centroid = it->second.sum / it->second.nr_points;
+    if ((centroid.array () < min_d.array ()).any () || (centroid.array () > max_d.array ()).any ())
+    {
+      it = voxels_.erase (it);
+      ++nr_removed;
+    }
+    else
+      ++it;
+  }
+  return (nr_removed);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::VoxelGridAccumulator<PointT>::getCentroid (const Voxel &voxel, PointT &point) const
+{
+  if (downsample_all_data_)
+  {
+    voxel.centroid.get (point);
+  }
+  else
+  {
+    const Eigen::Vector3d centroid = voxel.sum / voxel.nr_points;
+    point.x = static_cast<float> (centroid[0]);
+    point.y = static_cast<float> (centroid[1]);
+    point.z = static_cast<float> (centroid[2]);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::VoxelGridAccumulator<PointT>::getCentroids (PointCloud &output) const
+{
+  std::vector<unsigned int> counts;
+  getCentroids (output, counts);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::VoxelGridAccumulator<PointT>::getCentroids (PointCloud &output, std::vector<unsigned int> &counts) const
+{
+  output.points.clear ();
+  output.points.reserve (voxels_.size ());
+  counts.clear ();
+  counts.reserve (voxels_.size ());
+  for (typename VoxelMap::const_iterator it = voxels_.begin (); it != voxels_.end (); ++it)
+  {
+    if (it->second.nr_points < min_points_per_voxel_)
+      continue;
+    output.points.push_back (PointT ());
+    getCentroid (it->second, output.points.back ());
+    counts.push_back (it->second.nr_points);
+  }
+  output.width = static_cast<uint32_t> (output.points.size ());
+  output.height = 1;
+  output.is_dense = true;
+}
+
+#define PCL_INSTANTIATE_VoxelGridAccumulator(T) template class PCL_EXPORTS pcl::VoxelGridAccumulator<T>;
+
+#endif  // PCL_FILTERS_IMPL_VOXEL_GRID_ACCUMULATOR_HPP_
@@ -43,6 +43,7 @@
 #include <pcl/filters/voxel_grid_covariance.h>
 #include <Eigen/Dense>
 #include <Eigen/Cholesky>
+#include <algorithm>
 
 //////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointT> void
@@ -101,46 +102,123 @@ pcl::VoxelGridCovariance<PointT>::applyFilter (PointCloud &output)
   // Set up the division multiplier
   divb_mul_ = Eigen::Vector4i (1, div_b_[0], div_b_[0] * div_b_[1], 0);
 
-  int centroid_size = 4;
+  // First pass: bin all points, second pass: accumulate them and compute centroids and covariance matrices
+  std::vector<std::pair<size_t, int> > leaf_point_indices;
+  computeLeafIndices (*input_, leaf_point_indices);
+  accumulateLeaves (*input_, leaf_point_indices);
 
-  if (downsample_all_data_)
-    centroid_size = boost::mpl::size<FieldList>::value;
+  computeCentroidCloud (output);
+}
 
-  // ---[ RGB special case
-  std::vector<pcl::PCLPointField> fields;
-  int rgba_index = -1;
-  rgba_index = pcl::getFieldIndex (*input_, "rgb", fields);
-  if (rgba_index == -1)
-    rgba_index = pcl::getFieldIndex (*input_, "rgba", fields);
-  if (rgba_index >= 0)
+//////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::VoxelGridCovariance<PointT>::addCloud (const PointCloudConstPtr &cloud)
+{
+  if (!cloud || cloud->points.empty ())
+    return;
+
+  // Nothing to update yet, build the structure from scratch
+  if (leaves_.empty () || !voxel_centroids_)
   {
-    rgba_index = fields[rgba_index].offset;
-    centroid_size += 4;
+    this->setInputCloud (cloud);
+    filter (searchable_);
+    return;
+  }
+
+  Eigen::Vector4f min_p, max_p;
+  if (!filter_field_name_.empty ())
+    getMinMax3D<PointT> (cloud, filter_field_name_, static_cast<float> (filter_limit_min_), static_cast<float> (filter_limit_max_), min_p, max_p, filter_limit_negative_);
+  else
+    getMinMax3D<PointT> (*cloud, min_p, max_p);
+
+  // No valid point in the new cloud
+  if (min_p[0] > max_p[0])
+    return;
+
+  // Grow the grid bounds so that they cover the new points
+  Eigen::Vector4i min_b = min_b_, max_b = max_b_;
+  for (int d = 0; d < 3; ++d)
+  {
+    min_b[d] = std::min (min_b[d], static_cast<int> (floor (min_p[d] * inverse_leaf_size_[d])));
+    max_b[d] = std::max (max_b[d], static_cast<int> (floor (max_p[d] * inverse_leaf_size_[d])));
+  }
+
+  if (min_b != min_b_ || max_b != max_b_)
+  {
+    Eigen::Vector4i div_b = max_b - min_b + Eigen::Vector4i::Ones ();
+    div_b[3] = 0;
+    if (static_cast<int64_t> (div_b[0]) * div_b[1] * div_b[2] > std::numeric_limits<int32_t>::max ())
+    {
+      PCL_WARN ("[pcl::%s::addCloud] Leaf size is too small for the extended dataset. Integer indices would overflow.\n", getClassName ().c_str ());
+      return;
+    }
+    Eigen::Vector4i divb_mul (1, div_b[0], div_b[0] * div_b[1], 0);
+
+    // Re-index the existing leaves in the extended grid
+    LeafMap leaves;
+    leaves.rehash (leaves_.size ());
+    for (typename LeafMap::const_iterator it = leaves_.begin (); it != leaves_.end (); ++it)
+    {
+      int idx = static_cast<int> (it->first);
+      Eigen::Vector4i ijk (idx % div_b_[0], (idx / divb_mul_[1]) % div_b_[1], idx / divb_mul_[2], 0);
+      ijk += min_b_ - min_b;
+      leaves.insert (std::make_pair (static_cast<size_t> (ijk.dot (divb_mul)), it->second));
+    }
+    leaves_.swap (leaves);
+
+    min_b_ = min_b;
+    max_b_ = max_b;
+    div_b_ = div_b;
+    divb_mul_ = divb_mul;
   }
 
-  // If we don't want to process the entire cloud, but rather filter points far away from the viewpoint first...
+  std::vector<std::pair<size_t, int> > leaf_point_indices;
+  computeLeafIndices (*cloud, leaf_point_indices);
+  accumulateLeaves (*cloud, leaf_point_indices);
+
+  voxel_centroids_ = PointCloudPtr (new PointCloud);
+  computeCentroidCloud (*voxel_centroids_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::VoxelGridCovariance<PointT>::computeLeafIndices (const PointCloud &cloud,
+                                                      std::vector<std::pair<size_t, int> > &leaf_point_indices)
+{
+  // Get the distance field index
+  int distance_offset = -1;
   if (!filter_field_name_.empty ())
   {
-    // Get the distance field index
     std::vector<pcl::PCLPointField> fields;
-    int distance_idx = pcl::getFieldIndex (*input_, filter_field_name_, fields);
+    int distance_idx = pcl::getFieldIndex<PointT> (filter_field_name_, fields);
     if (distance_idx == -1)
-      PCL_WARN ("[pcl::%s::applyFilter] Invalid filter field name. Index is %d.\n", getClassName ().c_str (), distance_idx);
+      PCL_WARN ("[pcl::%s::computeLeafIndices] Invalid filter field name. Index is %d.\n", getClassName ().c_str (), distance_idx);
+    else
+      distance_offset = fields[distance_idx].offset;
+  }
 
-    // First pass: go over all points and insert them into the right leaf
-    for (size_t cp = 0; cp < input_->points.size (); ++cp)
-    {
-      if (!input_->is_dense)
-        // Check if the point is invalid
-        if (!pcl_isfinite (input_->points[cp].x) ||
-            !pcl_isfinite (input_->points[cp].y) ||
-            !pcl_isfinite (input_->points[cp].z))
-          continue;
+  // Invalid and filtered out points are marked with a negative point index
+  const int nr_points = static_cast<int> (cloud.points.size ());
+  leaf_point_indices.resize (nr_points);
+
+#ifdef _OPENMP
+#pragma omp parallel for shared(cloud, leaf_point_indices) firstprivate(distance_offset) schedule(static) num_threads(threads_)
+#endif
+  for (int cp = 0; cp < nr_points; ++cp)
+  {
+    const PointT &pt = cloud.points[cp];
+    leaf_point_indices[cp].second = -1;
+
+    if (!cloud.is_dense)
+      // Check if the point is invalid
+      if (!pcl_isfinite (pt.x) || !pcl_isfinite (pt.y) || !pcl_isfinite (pt.z))
+        continue;
 
+    if (distance_offset >= 0)
+    {
       // Get the distance value
-      const uint8_t* pt_data = reinterpret_cast<const uint8_t*> (&input_->points[cp]);
       float distance_value = 0;
-      memcpy (&distance_value, pt_data + fields[distance_idx].offset, sizeof (float));
+      memcpy (&distance_value, reinterpret_cast<const uint8_t*> (&pt) + distance_offset, sizeof (float));
 
       if (filter_limit_negative_)
       {
@@ -154,219 +232,324 @@ pcl::VoxelGridCovariance<PointT>::applyFilter (PointCloud &output)
         if ((distance_value > filter_limit_max_) || (distance_value < filter_limit_min_))
           continue;
       }
+    }
 
-      int ijk0 = static_cast<int> (floor (input_->points[cp].x * inverse_leaf_size_[0]) - static_cast<float> (min_b_[0]));
-      int ijk1 = static_cast<int> (floor (input_->points[cp].y * inverse_leaf_size_[1]) - static_cast<float> (min_b_[1]));
-      int ijk2 = static_cast<int> (floor (input_->points[cp].z * inverse_leaf_size_[2]) - static_cast<float> (min_b_[2]));
+    int ijk0 = static_cast<int> (floor (pt.x * inverse_leaf_size_[0]) - static_cast<float> (min_b_[0]));
+    int ijk1 = static_cast<int> (floor (pt.y * inverse_leaf_size_[1]) - static_cast<float> (min_b_[1]));
+    int ijk2 = static_cast<int> (floor (pt.z * inverse_leaf_size_[2]) - static_cast<float> (min_b_[2]));
 
-      // Compute the centroid leaf index
-      int idx = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
+    // Compute the centroid leaf index
+    leaf_point_indices[cp].first = static_cast<size_t> (ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2]);
+    leaf_point_indices[cp].second = cp;
+  }
 
-      Leaf& leaf = leaves_[idx];
-      if (leaf.nr_points == 0)
-      {
-        leaf.centroid.resize (centroid_size);
-        leaf.centroid.setZero ();
-      }
+  // Compact the valid entries and group them by leaf, keeping the point order inside each leaf
+  size_t nr_valid = 0;
+  for (size_t i = 0; i < leaf_point_indices.size (); ++i)
+    if (leaf_point_indices[i].second >= 0)
+      leaf_point_indices[nr_valid++] = leaf_point_indices[i];
+  leaf_point_indices.resize (nr_valid);
+  std::sort (leaf_point_indices.begin (), leaf_point_indices.end ());
+}
 
-      Eigen::Vector3d pt3d (input_->points[cp].x, input_->points[cp].y, input_->points[cp].z);
-      // Accumulate point sum for centroid calculation
-      leaf.mean_ += pt3d;
-      // Accumulate x*xT for single pass covariance calculation
-      leaf.cov_ += pt3d * pt3d.transpose ();
+//////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::VoxelGridCovariance<PointT>::accumulateLeaves (const PointCloud &cloud,
+                                                    const std::vector<std::pair<size_t, int> > &leaf_point_indices)
+{
+  int centroid_size, rgba_index;
+  getCentroidLayout (centroid_size, rgba_index);
 
-      // Do we need to process all the fields?
-      if (!downsample_all_data_)
-      {
-        Eigen::Vector4f pt (input_->points[cp].x, input_->points[cp].y, input_->points[cp].z, 0);
-        leaf.centroid.template head<4> () += pt;
-      }
-      else
-      {
-        // Copy all the fields
-        Eigen::VectorXf centroid = Eigen::VectorXf::Zero (centroid_size);
-        pcl::for_each_type<FieldList> (NdCopyPointEigenFunctor<PointT> (input_->points[cp], centroid));
-        // ---[ RGB special case
-        if (rgba_index >= 0)
-        {
-          // Fill r/g/b data, assuming that the order is BGRA
-          const pcl::RGB& rgb = *reinterpret_cast<const RGB*> (reinterpret_cast<const char*> (&input_->points[cp]) + rgba_index);
-          centroid[centroid_size - 4] = rgb.a;
-          centroid[centroid_size - 3] = rgb.r;
-          centroid[centroid_size - 2] = rgb.g;
-          centroid[centroid_size - 1] = rgb.b;
-        }
-        leaf.centroid += centroid;
-      }
-      ++leaf.nr_points;
-    }
-  }
-  // No distance filtering, process all data
-  else
+  // Look up (or create) the leaf of every run of points sharing a leaf index; the map is not touched afterwards
+  std::vector<Leaf*> run_leaves;
+  std::vector<size_t> run_begin;
+  for (size_t i = 0; i < leaf_point_indices.size (); )
   {
-    // First pass: go over all points and insert them into the right leaf
-    for (size_t cp = 0; cp < input_->points.size (); ++cp)
-    {
-      if (!input_->is_dense)
-        // Check if the point is invalid
-        if (!pcl_isfinite (input_->points[cp].x) ||
-            !pcl_isfinite (input_->points[cp].y) ||
-            !pcl_isfinite (input_->points[cp].z))
-          continue;
-
-      int ijk0 = static_cast<int> (floor (input_->points[cp].x * inverse_leaf_size_[0]) - static_cast<float> (min_b_[0]));
-      int ijk1 = static_cast<int> (floor (input_->points[cp].y * inverse_leaf_size_[1]) - static_cast<float> (min_b_[1]));
-      int ijk2 = static_cast<int> (floor (input_->points[cp].z * inverse_leaf_size_[2]) - static_cast<float> (min_b_[2]));
+    size_t j = i + 1;
+    while (j < leaf_point_indices.size () && leaf_point_indices[j].first == leaf_point_indices[i].first)
+      ++j;
+    run_leaves.push_back (&leaves_[leaf_point_indices[i].first]);
+    run_begin.push_back (i);
+    i = j;
+  }
+  run_begin.push_back (leaf_point_indices.size ());
 
-      // Compute the centroid leaf index
-      int idx = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
+  const int nr_runs = static_cast<int> (run_leaves.size ());
+#ifdef _OPENMP
+#pragma omp parallel for shared(cloud, leaf_point_indices, run_leaves, run_begin) firstprivate(centroid_size, rgba_index) schedule(dynamic, 64) num_threads(threads_)
+#endif
+  for (int ri = 0; ri < nr_runs; ++ri)
+  {
+    Leaf &leaf = *run_leaves[ri];
+    Eigen::VectorXf centroid_sum = Eigen::VectorXf::Zero (centroid_size);
 
-      //int idx = (((input_->points[cp].getArray4fmap () * inverse_leaf_size_).template cast<int> ()).matrix () - min_b_).dot (divb_mul_);
-      Leaf& leaf = leaves_[idx];
-      if (leaf.nr_points == 0)
-      {
-        leaf.centroid.resize (centroid_size);
-        leaf.centroid.setZero ();
-      }
+    for (size_t i = run_begin[ri]; i < run_begin[ri + 1]; ++i)
+    {
+      const PointT &point = cloud.points[leaf_point_indices[i].second];
 
-      Eigen::Vector3d pt3d (input_->points[cp].x, input_->points[cp].y, input_->points[cp].z);
+      Eigen::Vector3d pt3d (point.x, point.y, point.z);
       // Accumulate point sum for centroid calculation
-      leaf.mean_ += pt3d;
+      leaf.pt_sum_ += pt3d;
       // Accumulate x*xT for single pass covariance calculation
-      leaf.cov_ += pt3d * pt3d.transpose ();
+      leaf.pt_sq_sum_ += pt3d * pt3d.transpose ();
 
       // Do we need to process all the fields?
       if (!downsample_all_data_)
       {
-        Eigen::Vector4f pt (input_->points[cp].x, input_->points[cp].y, input_->points[cp].z, 0);
-        leaf.centroid.template head<4> () += pt;
+        centroid_sum.template head<4> () += Eigen::Vector4f (point.x, point.y, point.z, 0);
       }
       else
       {
         // Copy all the fields
         Eigen::VectorXf centroid = Eigen::VectorXf::Zero (centroid_size);
-        pcl::for_each_type<FieldList> (NdCopyPointEigenFunctor<PointT> (input_->points[cp], centroid));
+        pcl::for_each_type<FieldList> (NdCopyPointEigenFunctor<PointT> (point, centroid));
         // ---[ RGB special case
         if (rgba_index >= 0)
         {
           // Fill r/g/b data, assuming that the order is BGRA
-          const pcl::RGB& rgb = *reinterpret_cast<const RGB*> (reinterpret_cast<const char*> (&input_->points[cp]) + rgba_index);
+          const pcl::RGB& rgb = *reinterpret_cast<const RGB*> (reinterpret_cast<const char*> (&point) + rgba_index);
           centroid[centroid_size - 4] = rgb.a;
           centroid[centroid_size - 3] = rgb.r;
           centroid[centroid_size - 2] = rgb.g;
           centroid[centroid_size - 1] = rgb.b;
         }
-        leaf.centroid += centroid;
+        centroid_sum += centroid;
       }
-      ++leaf.nr_points;
     }
+
+    // Merge the new points into the normalized centroid
+    const int nr_new = static_cast<int> (run_begin[ri + 1] - run_begin[ri]);
+    if (leaf.nr_accumulated_ == 0 || leaf.centroid.size () != centroid_size)
+      leaf.centroid = centroid_sum / static_cast<float> (nr_new);
+    else
+      leaf.centroid = (leaf.centroid * static_cast<float> (leaf.nr_accumulated_) + centroid_sum) /
+                      static_cast<float> (leaf.nr_accumulated_ + nr_new);
+    leaf.nr_accumulated_ += nr_new;
+
+    computeLeafStatistics (leaf);
   }
+}
 
-  // Second pass: go over all leaves and compute centroids and covariance matrices
-  output.points.reserve (leaves_.size ());
-  if (searchable_)
-    voxel_centroids_leaf_indices_.reserve (leaves_.size ());
-  int cp = 0;
-  if (save_leaf_layout_)
-    leaf_layout_.resize (div_b_[0] * div_b_[1] * div_b_[2], -1);
+//////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::VoxelGridCovariance<PointT>::computeLeafStatistics (Leaf &leaf) const
+{
+  leaf.nr_points = leaf.nr_accumulated_;
+  leaf.icov_.setZero ();
+  leaf.evecs_.setIdentity ();
+  leaf.evals_.setZero ();
+
+  // Normalize mean
+  leaf.mean_ = leaf.pt_sum_ / leaf.nr_points;
+  leaf.cov_ = leaf.pt_sq_sum_;
+
+  // If the voxel contains sufficient points, its covariance is calculated.
+  // Points with less than the minimum points will have a can not be accuratly approximated using a normal distribution.
+  if (leaf.nr_points < min_points_per_voxel_)
+    return;
 
-  // Eigen values and vectors calculated to prevent near singluar matrices
-  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eigensolver;
-  Eigen::Matrix3d eigen_val;
-  Eigen::Vector3d pt_sum;
+  // Single pass covariance calculation
+  leaf.cov_ = (leaf.pt_sq_sum_ - 2 * (leaf.pt_sum_ * leaf.mean_.transpose ())) / leaf.nr_points + leaf.mean_ * leaf.mean_.transpose ();
+  leaf.cov_ *= (leaf.nr_points - 1.0) / leaf.nr_points;
 
-  // Eigen values less than a threshold of max eigen value are inflated to a set fraction of the max eigen value.
-  double min_covar_eigvalue;
+  //Normalize Eigen Val such that max no more than 100x min.
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eigensolver (leaf.cov_);
+  Eigen::Matrix3d eigen_val = eigensolver.eigenvalues ().asDiagonal ();
+  leaf.evecs_ = eigensolver.eigenvectors ();
 
-  for (typename std::map<size_t, Leaf>::iterator it = leaves_.begin (); it != leaves_.end (); ++it)
+  if (eigen_val (0, 0) < 0 || eigen_val (1, 1) < 0 || eigen_val (2, 2) <= 0)
   {
+    leaf.nr_points = -1;
+    return;
+  }
 
-    // Normalize the centroid
-    Leaf& leaf = it->second;
-
-    // Normalize the centroid
-    leaf.centroid /= static_cast<float> (leaf.nr_points);
-    // Point sum used for single pass covariance calculation
-    pt_sum = leaf.mean_;
-    // Normalize mean
-    leaf.mean_ /= leaf.nr_points;
+  // Avoids matrices near singularities (eq 6.11)[Magnusson 2009]
+  // Eigen values less than a threshold of max eigen value are inflated to a set fraction of the max eigen value.
+  double min_covar_eigvalue = min_covar_eigvalue_mult_ * eigen_val (2, 2);
+  if (eigen_val (0, 0) < min_covar_eigvalue)
+  {
+    eigen_val (0, 0) = min_covar_eigvalue;
 
-    // If the voxel contains sufficient points, its covariance is calculated and is added to the voxel centroids and output clouds.
-    // Points with less than the minimum points will have a can not be accuratly approximated using a normal distribution.
-    if (leaf.nr_points >= min_points_per_voxel_)
+    if (eigen_val (1, 1) < min_covar_eigvalue)
     {
-      if (save_leaf_layout_)
-        leaf_layout_[it->first] = cp++;
+      eigen_val (1, 1) = min_covar_eigvalue;
+    }
 
-      output.push_back (PointT ());
+    leaf.cov_ = leaf.evecs_ * eigen_val * leaf.evecs_.inverse ();
+  }
+  leaf.evals_ = eigen_val.diagonal ();
 
-      // Do we need to process all the fields?
-      if (!downsample_all_data_)
-      {
-        output.points.back ().x = leaf.centroid[0];
-        output.points.back ().y = leaf.centroid[1];
-        output.points.back ().z = leaf.centroid[2];
-      }
-      else
-      {
-        pcl::for_each_type<FieldList> (pcl::NdCopyEigenPointFunctor<PointT> (leaf.centroid, output.back ()));
-        // ---[ RGB special case
-        if (rgba_index >= 0)
-        {
-          pcl::RGB& rgb = *reinterpret_cast<RGB*> (reinterpret_cast<char*> (&output.points.back ()) + rgba_index);
-          rgb.a = leaf.centroid[centroid_size - 4];
-          rgb.r = leaf.centroid[centroid_size - 3];
-          rgb.g = leaf.centroid[centroid_size - 2];
-          rgb.b = leaf.centroid[centroid_size - 1];
-        }
-      }
+  leaf.icov_ = leaf.cov_.inverse ();
+  if (leaf.icov_.maxCoeff () == std::numeric_limits<float>::infinity ( )
+      || leaf.icov_.minCoeff () == -std::numeric_limits<float>::infinity ( ) )
+  {
+    leaf.nr_points = -1;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::VoxelGridCovariance<PointT>::computeCentroidCloud (PointCloud &output)
+{
+  int centroid_size, rgba_index;
+  getCentroidLayout (centroid_size, rgba_index);
 
-      // Stores the voxel indice for fast access searching
-      if (searchable_)
-        voxel_centroids_leaf_indices_.push_back (static_cast<int> (it->first));
+  // Voxels with sufficient points are output in leaf index order
+  voxel_centroids_leaf_indices_.clear ();
+  voxel_centroids_leaf_indices_.reserve (leaves_.size ());
+  for (typename LeafMap::const_iterator it = leaves_.begin (); it != leaves_.end (); ++it)
+    if (it->second.nr_accumulated_ >= min_points_per_voxel_)
+      voxel_centroids_leaf_indices_.push_back (static_cast<int> (it->first));
+  std::sort (voxel_centroids_leaf_indices_.begin (), voxel_centroids_leaf_indices_.end ());
 
-      // Single pass covariance calculation
-      leaf.cov_ = (leaf.cov_ - 2 * (pt_sum * leaf.mean_.transpose ())) / leaf.nr_points + leaf.mean_ * leaf.mean_.transpose ();
-      leaf.cov_ *= (leaf.nr_points - 1.0) / leaf.nr_points;
+  if (save_leaf_layout_)
+  {
+    leaf_layout_.clear ();
+    leaf_layout_.resize (div_b_[0] * div_b_[1] * div_b_[2], -1);
+    for (size_t cp = 0; cp < voxel_centroids_leaf_indices_.size (); ++cp)
+      leaf_layout_[voxel_centroids_leaf_indices_[cp]] = static_cast<int> (cp);
+  }
 
-      //Normalize Eigen Val such that max no more than 100x min.
-      eigensolver.compute (leaf.cov_);
-      eigen_val = eigensolver.eigenvalues ().asDiagonal ();
-      leaf.evecs_ = eigensolver.eigenvectors ();
+  const int nr_centroids = static_cast<int> (voxel_centroids_leaf_indices_.size ());
+  output.points.resize (nr_centroids);
+  output.width = static_cast<uint32_t> (nr_centroids);
+  output.height = 1;
+  output.is_dense = true;
 
-      if (eigen_val (0, 0) < 0 || eigen_val (1, 1) < 0 || eigen_val (2, 2) <= 0)
+#ifdef _OPENMP
+#pragma omp parallel for shared(output) firstprivate(centroid_size, rgba_index) schedule(static) num_threads(threads_)
+#endif
+  for (int cp = 0; cp < nr_centroids; ++cp)
+  {
+    const Leaf &leaf = leaves_.find (voxel_centroids_leaf_indices_[cp])->second;
+    PointT &point = output.points[cp];
+
+    // Do we need to process all the fields?
+    if (!downsample_all_data_)
+    {
+      point.x = leaf.centroid[0];
+      point.y = leaf.centroid[1];
+      point.z = leaf.centroid[2];
+    }
+    else
+    {
+      pcl::for_each_type<FieldList> (pcl::NdCopyEigenPointFunctor<PointT> (leaf.centroid, point));
+      // ---[ RGB special case
+      if (rgba_index >= 0)
       {
-        leaf.nr_points = -1;
-        continue;
+        pcl::RGB& rgb = *reinterpret_cast<RGB*> (reinterpret_cast<char*> (&point) + rgba_index);
+        rgb.a = leaf.centroid[centroid_size - 4];
+        rgb.r = leaf.centroid[centroid_size - 3];
+        rgb.g = leaf.centroid[centroid_size - 2];
+        rgb.b = leaf.centroid[centroid_size - 1];
       }
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::VoxelGridCovariance<PointT>::getCentroidLayout (int &centroid_size, int &rgba_index) const
+{
+  centroid_size = 4;
 
-      // Avoids matrices near singularities (eq 6.11)[Magnusson 2009]
+  if (downsample_all_data_)
+    centroid_size = boost::mpl::size<FieldList>::value;
 
-      min_covar_eigvalue = min_covar_eigvalue_mult_ * eigen_val (2, 2);
-      if (eigen_val (0, 0) < min_covar_eigvalue)
-      {
-        eigen_val (0, 0) = min_covar_eigvalue;
+  // ---[ RGB special case
+  std::vector<pcl::PCLPointField> fields;
+  rgba_index = pcl::getFieldIndex<PointT> ("rgb", fields);
+  if (rgba_index == -1)
+    rgba_index = pcl::getFieldIndex<PointT> ("rgba", fields);
+  if (rgba_index >= 0)
+  {
+    rgba_index = fields[rgba_index].offset;
+    centroid_size += 4;
+  }
+}
 
-        if (eigen_val (1, 1) < min_covar_eigvalue)
-        {
-          eigen_val (1, 1) = min_covar_eigvalue;
-        }
+//////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> int
+pcl::VoxelGridCovariance<PointT>::radiusSearch (const PointT &point, double radius, std::vector<LeafConstPtr> &k_leaves,
+                                                std::vector<float> &k_sqr_distances, unsigned int max_nn)
+{
+  k_leaves.clear ();
+  k_sqr_distances.clear ();
 
-        leaf.cov_ = leaf.evecs_ * eigen_val * leaf.evecs_.inverse ();
-      }
-      leaf.evals_ = eigen_val.diagonal ();
+  // Check if the voxel structure has been built
+  if (!searchable_)
+  {
+    PCL_WARN ("%s: Not Searchable", this->getClassName ().c_str ());
+    return 0;
+  }
 
-      leaf.icov_ = leaf.cov_.inverse ();
-      if (leaf.icov_.maxCoeff () == std::numeric_limits<float>::infinity ( )
-          || leaf.icov_.minCoeff () == -std::numeric_limits<float>::infinity ( ) )
-      {
-        leaf.nr_points = -1;
-      }
+  if (leaves_.empty () || !pcl_isfinite (point.x) || !pcl_isfinite (point.y) || !pcl_isfinite (point.z))
+    return 0;
+
+  // Range of voxels overlapping the bounding box of the search sphere, clamped to the grid
+  const float p[3] = { point.x, point.y, point.z };
+  Eigen::Vector3i min_ijk, max_ijk;
+  double nr_cells = 1.0;
+  for (int d = 0; d < 3; ++d)
+  {
+    double lo = std::max (floor ((p[d] - radius) * inverse_leaf_size_[d]), static_cast<double> (min_b_[d]));
+    double hi = std::min (floor ((p[d] + radius) * inverse_leaf_size_[d]), static_cast<double> (max_b_[d]));
+    if (lo > hi)
+      return 0;
+    min_ijk[d] = static_cast<int> (lo) - min_b_[d];
+    max_ijk[d] = static_cast<int> (hi) - min_b_[d];
+    nr_cells *= hi - lo + 1.0;
+  }
 
+  // A voxel centroid lies inside its voxel, so only the overlapping voxels can hold neighbors
+  const float sqr_radius = static_cast<float> (radius * radius);
+  std::vector<std::pair<float, LeafConstPtr> > neighbors;
+  if (nr_cells <= static_cast<double> (leaves_.size ()))
+  {
+    for (int k = min_ijk[2]; k <= max_ijk[2]; ++k)
+      for (int j = min_ijk[1]; j <= max_ijk[1]; ++j)
+        for (int i = min_ijk[0]; i <= max_ijk[0]; ++i)
+        {
+          typename LeafMap::const_iterator leaf_iter = leaves_.find (i * divb_mul_[0] + j * divb_mul_[1] + k * divb_mul_[2]);
+          if (leaf_iter == leaves_.end () || leaf_iter->second.nr_accumulated_ < min_points_per_voxel_)
+            continue;
+          const Eigen::VectorXf &centroid = leaf_iter->second.centroid;
+          float sqr_distance = (centroid[0] - p[0]) * (centroid[0] - p[0]) +
+                               (centroid[1] - p[1]) * (centroid[1] - p[1]) +
+                               (centroid[2] - p[2]) * (centroid[2] - p[2]);
+          if (sqr_distance < sqr_radius)
+            neighbors.push_back (std::make_pair (sqr_distance, &leaf_iter->second));
+        }
+  }
+  else
+  {
+    // The sphere covers more voxels than there are leaves, scan the leaves instead
+    for (typename LeafMap::const_iterator leaf_iter = leaves_.begin (); leaf_iter != leaves_.end (); ++leaf_iter)
+    {
+      if (leaf_iter->second.nr_accumulated_ < min_points_per_voxel_)
+        continue;
+      const Eigen::VectorXf &centroid = leaf_iter->second.centroid;
+      float sqr_distance = (centroid[0] - p[0]) * (centroid[0] - p[0]) +
+                           (centroid[1] - p[1]) * (centroid[1] - p[1]) +
+                           (centroid[2] - p[2]) * (centroid[2] - p[2]);
+      if (sqr_distance < sqr_radius)
+        neighbors.push_back (std::make_pair (sqr_distance, &leaf_iter->second));
     }
   }
 
-  output.width = static_cast<uint32_t> (output.points.size ());
+  // Sort the neighbors by distance
+  std::sort (neighbors.begin (), neighbors.end ());
+  if (max_nn > 0 && neighbors.size () > max_nn)
+    neighbors.resize (max_nn);
+
+  k_leaves.resize (neighbors.size ());
+  k_sqr_distances.resize (neighbors.size ());
+  for (size_t i = 0; i < neighbors.size (); ++i)
+  {
+    k_sqr_distances[i] = neighbors[i].first;
+    k_leaves[i] = neighbors[i].second;
+  }
+  return (static_cast<int> (neighbors.size ()));
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -374,32 +557,24 @@ template<typename PointT> int
 pcl::VoxelGridCovariance<PointT>::getNeighborhoodAtPoint (const PointT& reference_point, std::vector<LeafConstPtr> &neighbors)
 {
   neighbors.clear ();
+  neighbors.reserve (26);
 
-  // Find displacement coordinates
-  Eigen::MatrixXi relative_coordinates = pcl::getAllNeighborCellIndices ();
-  Eigen::Vector4i ijk (static_cast<int> (floor (reference_point.x / leaf_size_[0])), 
-                       static_cast<int> (floor (reference_point.y / leaf_size_[1])), 
-                       static_cast<int> (floor (reference_point.z / leaf_size_[2])), 0);
-  Eigen::Array4i diff2min = min_b_ - ijk;
-  Eigen::Array4i diff2max = max_b_ - ijk;
-  neighbors.reserve (relative_coordinates.cols ());
-
-  // Check each neighbor to see if it is occupied and contains sufficient points
-  // Slower than radius search because needs to check 26 indices
-  for (int ni = 0; ni < relative_coordinates.cols (); ni++)
-  {
-    Eigen::Vector4i displacement = (Eigen::Vector4i () << relative_coordinates.col (ni), 0).finished ();
-    // Checking if the specified cell is in the grid
-    if ((diff2min <= displacement.array ()).all () && (diff2max >= displacement.array ()).all ())
-    {
-      typename std::map<size_t, Leaf>::iterator leaf_iter = leaves_.find (((ijk + displacement - min_b_).dot (divb_mul_)));
-      if (leaf_iter != leaves_.end () && leaf_iter->second.nr_points >= min_points_per_voxel_)
+  Eigen::Vector3i ijk (static_cast<int> (floor (reference_point.x * inverse_leaf_size_[0])) - min_b_[0],
+                       static_cast<int> (floor (reference_point.y * inverse_leaf_size_[1])) - min_b_[1],
+                       static_cast<int> (floor (reference_point.z * inverse_leaf_size_[2])) - min_b_[2]);
+
+  // Check each of the 26 neighbor cells inside the grid to see if it is occupied and contains sufficient points
+  for (int k = std::max (ijk[2] - 1, 0); k <= std::min (ijk[2] + 1, div_b_[2] - 1); ++k)
+    for (int j = std::max (ijk[1] - 1, 0); j <= std::min (ijk[1] + 1, div_b_[1] - 1); ++j)
+      for (int i = std::max (ijk[0] - 1, 0); i <= std::min (ijk[0] + 1, div_b_[0] - 1); ++i)
       {
-        LeafConstPtr leaf = &(leaf_iter->second);
-        neighbors.push_back (leaf);
+        if (i == ijk[0] && j == ijk[1] && k == ijk[2])
+          continue;
+
+        typename LeafMap::const_iterator leaf_iter = leaves_.find (i * divb_mul_[0] + j * divb_mul_[1] + k * divb_mul_[2]);
+        if (leaf_iter != leaves_.end () && leaf_iter->second.nr_points >= min_points_per_voxel_)
+          neighbors.push_back (&(leaf_iter->second));
       }
-    }
-  }
 
   return (static_cast<int> (neighbors.size ()));
 }
@@ -421,10 +596,10 @@ pcl::VoxelGridCovariance<PointT>::getDisplayCloud (pcl::PointCloud<PointXYZ>& ce
   Eigen::Vector3d rand_point;
   Eigen::Vector3d dist_point;
 
-  // Generate points for each occupied voxel with sufficient points.
-  for (typename std::map<size_t, Leaf>::iterator it = leaves_.begin (); it != leaves_.end (); ++it)
+  // Generate points for each occupied voxel with sufficient points, in leaf index order.
+  for (size_t li = 0; li < voxel_centroids_leaf_indices_.size (); ++li)
   {
-    Leaf& leaf = it->second;
+    const Leaf& leaf = leaves_.find (voxel_centroids_leaf_indices_[li])->second;
 
     if (leaf.nr_points >= min_points_per_voxel_)
     {
@@ -63,6 +63,13 @@ pcl::VoxelGridOcclusionEstimation<PointT>::initializeVoxelGrid ()
   // set the sensor origin and sensor orientation
   sensor_origin_ = filtered_cloud_.sensor_origin_;
   sensor_orientation_ = filtered_cloud_.sensor_orientation_;
+
+  // pack the occupied voxels into a bitset, which is much denser than the leaf layout
+  occupancy_.clear ();
+  occupancy_.resize (static_cast<size_t> (div_b_[0]) * div_b_[1] * div_b_[2]);
+  for (size_t i = 0; i < leaf_layout_.size () && i < occupancy_.size (); ++i)
+    if (leaf_layout_[i] != -1)
+      occupancy_.set (i);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -138,36 +145,51 @@ pcl::VoxelGridOcclusionEstimation<PointT>::occlusionEstimationAll (std::vector<E
     return -1;
   }
 
-  // reserve space for the ray vector
-  int reserve_size = div_b_[0] * div_b_[1] * div_b_[2];
-  occluded_voxels.reserve (reserve_size);
+  // one flag per voxel, written by the thread owning its row of voxels
+  std::vector<unsigned char> occluded (occupancy_.size (), 0);
+  const int nr_rows = div_b_[1] * div_b_[2];
+
+  // iterate over the entire voxel grid, one row of voxels along x at a time
+#ifdef _OPENMP
+#pragma omp parallel for shared(occluded) schedule(dynamic, 16) num_threads(threads_)
+#endif
+  for (int row = 0; row < nr_rows; ++row)
+  {
+    const int jj = min_b_.y () + row % div_b_[1];
+    const int kk = min_b_.z () + row / div_b_[1];
+    int index = row * div_b_[0];
+    for (int ii = min_b_.x (); ii <= max_b_.x (); ++ii, ++index)
+    {
+      // process all free voxels
+      if (occupancy_[index])
+        continue;
+
+      Eigen::Vector3i ijk (ii, jj, kk);
+
+      // estimate direction to target voxel
+      Eigen::Vector4f p = getCentroidCoordinate (ijk);
+      Eigen::Vector4f direction = p - sensor_origin_;
+      direction.normalize ();
+
+      // estimate entry point into the voxel grid
+      float tmin = rayBoxIntersection (sensor_origin_, direction);
+
+      // ray traversal, the voxel is occluded if an occupied voxel is hit first
+      occluded[index] = static_cast<unsigned char> (rayTraversal (ijk, sensor_origin_, direction, tmin) == 1);
+    }
+  }
+
+  // collect the occluded voxels in grid order
+  size_t nr_occluded = 0;
+  for (size_t i = 0; i < occluded.size (); ++i)
+    nr_occluded += occluded[i];
+  occluded_voxels.reserve (occluded_voxels.size () + nr_occluded);
 
-  // iterate over the entire voxel grid
-  for (int kk = min_b_.z (); kk <= max_b_.z (); ++kk)
+  for (int kk = min_b_.z (), index = 0; kk <= max_b_.z (); ++kk)
     for (int jj = min_b_.y (); jj <= max_b_.y (); ++jj)
-      for (int ii = min_b_.x (); ii <= max_b_.x (); ++ii)
-      {
-        Eigen::Vector3i ijk (ii, jj, kk);
-        // process all free voxels
-        int index = this->getCentroidIndexAt (ijk);
-        if (index == -1)
-        {
-          // estimate direction to target voxel
-          Eigen::Vector4f p = getCentroidCoordinate (ijk);
-          Eigen::Vector4f direction = p - sensor_origin_;
-          direction.normalize ();
-          
-          // estimate entry point into the voxel grid
-          float tmin = rayBoxIntersection (sensor_origin_, direction);
-
-          // ray traversal
-          int state = rayTraversal (ijk, sensor_origin_, direction, tmin);
-          
-          // if voxel is occluded
-          if (state == 1)
-            occluded_voxels.push_back (ijk);
-        }
-      }
+      for (int ii = min_b_.x (); ii <= max_b_.x (); ++ii, ++index)
+        if (occluded[index])
+          occluded_voxels.push_back (Eigen::Vector3i (ii, jj, kk));
   return 0;
 }
 
@@ -296,20 +318,23 @@ pcl::VoxelGridOcclusionEstimation<PointT>::rayTraversal (const Eigen::Vector3i&
   float t_delta_y = leaf_size_[1] / static_cast<float> (fabs (direction[1]));
   float t_delta_z = leaf_size_[2] / static_cast<float> (fabs (direction[2]));
 
-  // index of the point in the point cloud
-  int index;
+  // leaf layout indices of the current and the target voxel, the current one is updated incrementally
+  int index = (ijk - min_b_.template head<3> ()).dot (divb_mul_.template head<3> ());
+  const int target_index = getVoxelIndex (target_voxel);
+  const int index_step_x = step_x * divb_mul_[0];
+  const int index_step_y = step_y * divb_mul_[1];
+  const int index_step_z = step_z * divb_mul_[2];
 
   while ( (ijk[0] < max_b_[0]+1) && (ijk[0] >= min_b_[0]) && 
           (ijk[1] < max_b_[1]+1) && (ijk[1] >= min_b_[1]) && 
           (ijk[2] < max_b_[2]+1) && (ijk[2] >= min_b_[2]) )
   {
     // check if we reached target voxel
-    if (ijk[0] == target_voxel[0] && ijk[1] == target_voxel[1] && ijk[2] == target_voxel[2])
+    if (index == target_index)
       return 0;
 
     // check if voxel is occupied, if yes return 1 for occluded
-    index = this->getCentroidIndexAt (ijk);
-    if (index != -1)
+    if (occupancy_[index])
       return 1;
 
     // estimate next voxel
@@ -317,16 +342,19 @@ pcl::VoxelGridOcclusionEstimation<PointT>::rayTraversal (const Eigen::Vector3i&
     {
       t_max_x += t_delta_x;
       ijk[0] += step_x;
+      index += index_step_x;
     }
     else if(t_max_y <= t_max_z && t_max_y <= t_max_x)
     {
       t_max_y += t_delta_y;
       ijk[1] += step_y;
+      index += index_step_y;
     }
     else
     {
       t_max_z += t_delta_z;
       ijk[2] += step_z;
+      index += index_step_z;
     }
   }
   return 0;
@@ -340,8 +368,8 @@ pcl::VoxelGridOcclusionEstimation<PointT>::rayTraversal (std::vector<Eigen::Vect
                                                          const Eigen::Vector4f& direction,
                                                          const float t_min)
 {
-  // reserve space for the ray vector
-  int reserve_size = div_b_.maxCoeff () * div_b_.maxCoeff ();
+  // reserve space for the ray vector, a traversal steps through at most one voxel per grid division
+  int reserve_size = div_b_[0] + div_b_[1] + div_b_[2];
   out_ray.reserve (reserve_size);
 
   // coordinate of the boundary of the voxel grid
@@ -396,8 +424,12 @@ pcl::VoxelGridOcclusionEstimation<PointT>::rayTraversal (std::vector<Eigen::Vect
   float t_delta_y = leaf_size_[1] / static_cast<float> (fabs (direction[1]));
   float t_delta_z = leaf_size_[2] / static_cast<float> (fabs (direction[2]));
 
-  // the index of the cloud (-1 if empty)
-  int index = -1;
+  // leaf layout indices of the current and the target voxel, the current one is updated incrementally
+  int index = (ijk - min_b_.template head<3> ()).dot (divb_mul_.template head<3> ());
+  const int target_index = getVoxelIndex (target_voxel);
+  const int index_step_x = step_x * divb_mul_[0];
+  const int index_step_y = step_y * divb_mul_[1];
+  const int index_step_z = step_z * divb_mul_[2];
   int result = 0;
 
   while ( (ijk[0] < max_b_[0]+1) && (ijk[0] >= min_b_[0]) && 
@@ -408,12 +440,11 @@ pcl::VoxelGridOcclusionEstimation<PointT>::rayTraversal (std::vector<Eigen::Vect
     out_ray.push_back (ijk);
 
     // check if we reached target voxel
-    if (ijk[0] == target_voxel[0] && ijk[1] == target_voxel[1] && ijk[2] == target_voxel[2])
+    if (index == target_index)
       break;
 
     // check if voxel is occupied
-    index = this->getCentroidIndexAt (ijk);
-    if (index != -1)
+    if (occupancy_[index])
       result = 1;
 
     // estimate next voxel
@@ -421,16 +452,19 @@ pcl::VoxelGridOcclusionEstimation<PointT>::rayTraversal (std::vector<Eigen::Vect
     {
       t_max_x += t_delta_x;
       ijk[0] += step_x;
+      index += index_step_x;
     }
     else if(t_max_y <= t_max_z && t_max_y <= t_max_x)
     {
       t_max_y += t_delta_y;
       ijk[1] += step_y;
+      index += index_step_y;
     }
     else
     {
       t_max_z += t_delta_z;
       ijk[2] += step_z;
+      index += index_step_z;
     }
   }
   return result;
@@ -0,0 +1,190 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef PCL_FILTERS_MULTI_FRUSTUM_CULLING_H_
+#define PCL_FILTERS_MULTI_FRUSTUM_CULLING_H_
+
+#include <pcl/pcl_base.h>
+#include <pcl/filters/frustum_culling.h>
+
+namespace pcl
+{
+  /** \brief MultiFrustumCulling tests every point against the frustums of many cameras in a
+    * single pass over the input, e.g. for selecting the views that see a point when colorizing
+    * a cloud from several images.
+    *
+    * Each camera has its own pose, field of view and near/far distances, with the same conventions
+    * (and the same plane equations) as FrustumCulling. The planes of all cameras are stored
+    * structure-of-arrays, so the test of one point against all cameras is a tight loop the compiler
+    * can vectorize. Points are processed in parallel.
+    *
+    * Code example:
+    *
+    * \code
+    * pcl::MultiFrustumCulling<pcl::PointXYZ> mfc;
+    * mfc.setInputCloud (cloud);
+    * for (size_t i = 0; i < poses.size (); ++i)
+    *   mfc.addCamera (poses[i], 60.0f, 45.0f, 0.1f, 10.0f);
+    *
+    * std::vector<std::vector<int> > visible;   // one list of point indices per camera
+    * mfc.computeVisibleIndices (visible);
+    * \endcode
+    *
+    * \ingroup filters
+    */
+  template <typename PointT>
+  class MultiFrustumCulling : public PCLBase<PointT>
+  {
+    public:
+      typedef boost::shared_ptr< MultiFrustumCulling<PointT> > Ptr;
+      typedef boost::shared_ptr< const MultiFrustumCulling<PointT> > ConstPtr;
+
+      /** \brief Empty constructor. */
+      MultiFrustumCulling ()
+        : nr_cameras_ (0)
+        , planes_ ()
+        , threads_ (0)
+      {
+      }
+
+      /** \brief Add a camera.
+        * \param[in] camera_pose the camera pose, see FrustumCulling::setCameraPose for the conventions
+        * \param[in] hfov the horizontal field of view in degrees
+        * \param[in] vfov the vertical field of view in degrees
+        * \param[in] np_dist the near plane distance
+        * \param[in] fp_dist the far plane distance
+        * \return the index of the camera
+        */
+      size_t
+      addCamera (const Eigen::Matrix4f &camera_pose, float hfov, float vfov, float np_dist, float fp_dist);
+
+      /** \brief Add a camera with the parameters of a FrustumCulling object.
+        * \param[in] frustum_culling the frustum to copy the camera pose, fields of view and distances from
+        * \return the index of the camera
+        */
+      size_t
+      addCamera (const FrustumCulling<PointT> &frustum_culling);
+
+      /** \brief Remove all cameras. */
+      void
+      clearCameras ();
+
+      /** \brief Get the number of cameras. */
+      inline size_t
+      getNumberOfCameras () const
+      {
+        return (nr_cameras_);
+      }
+
+      /** \brief Get the number of 64 bit words used per point in the visibility masks. */
+      inline size_t
+      getWordsPerPoint () const
+      {
+        return ((nr_cameras_ + 63) / 64);
+      }
+
+      /** \brief Set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0)
+      {
+        threads_ = nr_threads;
+      }
+
+      /** \brief Compute which cameras see which points.
+        * \param[out] masks getWordsPerPoint () words per entry of the input indices, in the same order;
+        * bit (c % 64) of word (i * getWordsPerPoint () + c / 64) is set if point i lies inside the frustum
+        * of camera c
+        */
+      void
+      computeVisibilityMasks (std::vector<uint64_t> &masks);
+
+      /** \brief Compute the points inside the frustum of every camera.
+        * \param[out] indices one list per camera with the indices (into the input cloud) of the points
+        * inside its frustum, in the order of the input indices
+        */
+      void
+      computeVisibleIndices (std::vector<std::vector<int> > &indices);
+
+    protected:
+      /** \brief Compute the visibility masks of the input indices, see computeVisibilityMasks.
+        * Assumes initCompute () succeeded.
+        * \param[out] masks the visibility masks
+        */
+      void
+      computeMasks (std::vector<uint64_t> &masks) const;
+
+      using PCLBase<PointT>::input_;
+      using PCLBase<PointT>::indices_;
+      using PCLBase<PointT>::initCompute;
+      using PCLBase<PointT>::deinitCompute;
+
+      /** \brief Get the class name. */
+      inline const std::string
+      getClassName () const
+      {
+        return ("MultiFrustumCulling");
+      }
+
+      /** \brief Get the number of cameras rounded up to the block size of the plane tables. */
+      inline size_t
+      getPaddedNumberOfCameras () const
+      {
+        return ((nr_cameras_ + 7) / 8 * 8);
+      }
+
+      /** \brief The number of cameras. */
+      size_t nr_cameras_;
+
+      /** \brief The frustum planes of all cameras: coefficient j (a, b, c, d) of plane k (left, right,
+        * top, bottom, far, near) of camera c is stored at ((k * 4 + j) * getPaddedNumberOfCameras () + c).
+        * Padding cameras have the plane 0x + 0y + 0z + 1 <= 0, which no point satisfies.
+        */
+      std::vector<float> planes_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+  };
+}
+
+#ifdef PCL_NO_PRECOMPILE
+#include <pcl/filters/impl/multi_frustum_culling.hpp>
+#endif
+
+#endif  // PCL_FILTERS_MULTI_FRUSTUM_CULLING_H_
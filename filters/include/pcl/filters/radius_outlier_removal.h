@@ -90,7 +90,8 @@ namespace pcl
         FilterIndices<PointT>::FilterIndices (extract_removed_indices),
         searcher_ (),
         search_radius_ (0.0),
-        min_pts_radius_ (1)
+        min_pts_radius_ (1),
+        threads_ (0)
       {
         filter_name_ = "RadiusOutlierRemoval";
       }
@@ -139,6 +140,25 @@ namespace pcl
         return (min_pts_radius_);
       }
 
+      /** \brief Provide a pointer to the search object.
+        * \details If none is given, a KdTree (or an OrganizedNeighbor for organized clouds) is created.
+        * \param[in] searcher a pointer to the spatial search object.
+        */
+      inline void
+      setSearchMethod (const SearcherPtr &searcher)
+      {
+        searcher_ = searcher;
+      }
+
+      /** \brief Set the number of threads to use for the neighbor counting.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0)
+      {
+        threads_ = nr_threads;
+      }
+
     protected:
       using PCLBase<PointT>::input_;
       using PCLBase<PointT>::indices_;
@@ -180,6 +200,9 @@ namespace pcl
 
       /** \brief The minimum number of neighbors that a point needs to have in the given search radius to be considered an inlier. */
       int min_pts_radius_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
   };
 
   //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -99,7 +99,11 @@ namespace pcl
         FilterIndices<PointT>::FilterIndices (extract_removed_indices),
         searcher_ (),
         mean_k_ (1),
-        std_mul_ (0.0)
+        std_mul_ (0.0),
+        threads_ (0),
+        sample_size_ (0),
+        graph_indices_ (),
+        graph_sqr_distances_ ()
       {
         filter_name_ = "StatisticalOutlierRemoval";
       }
@@ -143,6 +147,50 @@ namespace pcl
         return (std_mul_);
       }
 
+      /** \brief Set the number of threads to use for the nearest neighbor searches.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0)
+      {
+        threads_ = nr_threads;
+      }
+
+      /** \brief Estimate the mean and standard deviation of the neighbor distances on a subsample of
+        * the query points instead of on all of them. All points are still classified.
+        * \details The sample takes every n-th query point, so the result does not depend on the number of threads.
+        * With a sample the threshold is known before the remaining points are searched, so each of them is
+        * classified right after its nearest neighbor search and only a per-point flag is kept, no distance array.
+        * \param[in] nr_samples the number of query points to sample (0 uses all points, the default)
+        */
+      inline void
+      setStatisticsSampleSize (unsigned int nr_samples)
+      {
+        sample_size_ = nr_samples;
+      }
+
+      /** \brief Get the number of query points the distance statistics are estimated on (0 means all). */
+      inline unsigned int
+      getStatisticsSampleSize () const
+      {
+        return (sample_size_);
+      }
+
+      /** \brief Provide nearest neighbors computed by another processing stage instead of searching them again.
+        * \details Row i holds the neighbors of point i of the input cloud, sorted by increasing distance, as returned
+        * by pcl::search::Search::nearestKSearch (the query point itself may come first, it is skipped). A row needs
+        * at least getMeanK () neighbors besides the query point. Pass empty pointers to search neighbors again.
+        * \param[in] nn_indices the neighbor indices of every point of the input cloud
+        * \param[in] nn_sqr_distances the squared distances to these neighbors
+        */
+      inline void
+      setNeighborGraph (const boost::shared_ptr<const std::vector<std::vector<int> > > &nn_indices,
+                        const boost::shared_ptr<const std::vector<std::vector<float> > > &nn_sqr_distances)
+      {
+        graph_indices_ = nn_indices;
+        graph_sqr_distances_ = nn_sqr_distances;
+      }
+
     protected:
       using PCLBase<PointT>::input_;
       using PCLBase<PointT>::indices_;
@@ -175,6 +223,16 @@ namespace pcl
       void
       applyFilterIndices (std::vector<int> &indices);
 
+      /** \brief Compute the mean distance of an input point to its mean_k_ nearest neighbors.
+        * \param[in] index the index of the query point in the input cloud
+        * \param[out] nn_indices buffer for the neighbor indices
+        * \param[out] nn_dists buffer for the squared neighbor distances
+        * \param[out] distance the mean neighbor distance
+        * \return false if the point is not finite or not enough neighbors were found
+        */
+      bool
+      computeMeanDistance (int index, std::vector<int> &nn_indices, std::vector<float> &nn_dists, float &distance) const;
+
     private:
       /** \brief A pointer to the spatial search object. */
       SearcherPtr searcher_;
@@ -185,6 +243,18 @@ namespace pcl
       /** \brief Standard deviations threshold (i.e., points outside of 
         * \f$ \mu \pm \sigma \cdot std\_mul \f$ will be marked as outliers). */
       double std_mul_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
+      /** \brief The number of query points the distance statistics are estimated on (0 means all). */
+      unsigned int sample_size_;
+
+      /** \brief Neighbor indices provided by another stage, one row per input point. */
+      boost::shared_ptr<const std::vector<std::vector<int> > > graph_indices_;
+
+      /** \brief Squared neighbor distances provided by another stage, one row per input point. */
+      boost::shared_ptr<const std::vector<std::vector<float> > > graph_sqr_distances_;
   };
 
   /** \brief @b StatisticalOutlierRemoval uses point neighborhood statistics to filter outlier data. For more
@@ -41,7 +41,6 @@
 #define PCL_FILTERS_UNIFORM_SAMPLING_H_
 
 #include <pcl/filters/filter.h>
-#include <boost/unordered_map.hpp>
 
 namespace pcl
 {
@@ -54,6 +53,9 @@ namespace pcl
     * a bit slower than approximating them with the center of the voxel, but it
     * represents the underlying surface more accurately.
     *
+    * The points are binned in parallel with \ref selectVoxelRepresentatives and the
+    * output is ordered by voxel.
+    *
     * \author Radu Bogdan Rusu
     * \ingroup keypoints
     */
@@ -74,14 +76,14 @@ namespace pcl
       /** \brief Empty constructor. */
       UniformSampling (bool extract_removed_indices = false) :
         Filter<PointT>(extract_removed_indices),
-        leaves_ (),
         leaf_size_ (Eigen::Vector4f::Zero ()),
         inverse_leaf_size_ (Eigen::Vector4f::Zero ()),
         min_b_ (Eigen::Vector4i::Zero ()),
         max_b_ (Eigen::Vector4i::Zero ()),
         div_b_ (Eigen::Vector4i::Zero ()),
         divb_mul_ (Eigen::Vector4i::Zero ()),
-        search_radius_ (0)
+        search_radius_ (0),
+        threads_ (0)
       {
         filter_name_ = "UniformSampling";
       }
@@ -89,7 +91,6 @@ namespace pcl
       /** \brief Destructor. */
       virtual ~UniformSampling ()
       {
-        leaves_.clear();
       }
 
       /** \brief Set the 3D grid leaf size.
@@ -107,17 +108,16 @@ namespace pcl
         search_radius_ = radius;
       }
 
-    protected:
-      /** \brief Simple structure to hold an nD centroid and the number of points in a leaf. */
-      struct Leaf
+      /** \brief Set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0)
       {
-        Leaf () : idx (-1) { }
-        int idx;
-      };
-
-      /** \brief The 3D grid leaves. */
-      boost::unordered_map<size_t, Leaf> leaves_;
+        threads_ = nr_threads;
+      }
 
+    protected:
       /** \brief The size of a leaf. */
       Eigen::Vector4f leaf_size_;
 
@@ -130,6 +130,9 @@ namespace pcl
       /** \brief The nearest neighbors search radius for each point. */
       double search_radius_;
 
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
       /** \brief Downsample a Point Cloud using a voxelized grid approach
         * \param[out] output the resultant point cloud message
         */
@@ -0,0 +1,75 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef PCL_FILTERS_VOXEL_BINNING_H_
+#define PCL_FILTERS_VOXEL_BINNING_H_
+
+#include <pcl/point_cloud.h>
+#include <vector>
+#include <utility>
+
+namespace pcl
+{
+  /** \brief Bin points into grid cells in parallel and keep one representative point per cell.
+    *
+    * Each thread bins a contiguous slice of \a indices into its own hash map and the partial maps are
+    * merged at the end. For every cell the point with the lowest score is kept; ties go to the point that
+    * comes first in \a indices, so the result does not depend on the number of threads.
+    *
+    * The binner defines the grid and the selection criterion through two const member functions:
+    * <tt>uint64_t getKey (const PointT &p)</tt> returns the cell of a point and
+    * <tt>float getScore (const PointT &p)</tt> returns the value minimized inside each cell.
+    *
+    * \param[in] cloud the input point cloud
+    * \param[in] indices the indices of the points to bin
+    * \param[in] binner the functor providing the cell keys and the scores
+    * \param[out] representatives pairs of (cell key, position in \a indices) of the kept points, sorted by key
+    * \param[in] nr_threads the number of hardware threads to use (0 for automatic)
+    * \note Points with non-finite coordinates are skipped when the cloud is not dense.
+    * \ingroup filters
+    */
+  template <typename PointT, typename BinnerT> void
+  selectVoxelRepresentatives (const pcl::PointCloud<PointT> &cloud, const std::vector<int> &indices,
+                              const BinnerT &binner,
+                              std::vector<std::pair<uint64_t, int> > &representatives,
+                              unsigned int nr_threads = 0);
+}
+
+#include <pcl/filters/impl/voxel_binning.hpp>
+
+#endif  //#ifndef PCL_FILTERS_VOXEL_BINNING_H_
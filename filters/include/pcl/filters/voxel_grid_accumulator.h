@@ -0,0 +1,270 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef PCL_FILTERS_VOXEL_GRID_ACCUMULATOR_H_
+#define PCL_FILTERS_VOXEL_GRID_ACCUMULATOR_H_
+
+#include <pcl/pcl_base.h>
+#include <pcl/common/centroid.h>
+#include <boost/unordered_map.hpp>
+
+namespace pcl
+{
+  /** \brief VoxelGridAccumulator downsamples a stream of point clouds into a persistent voxel map.
+    *
+    * Where VoxelGrid voxelizes one cloud per call, the accumulator keeps a hashed map of voxels with
+    * the running centroid of every voxel across \ref addCloud calls, so building a downsampled map from
+    * a sequence of registered scans costs O(new points) per scan instead of refiltering the whole map.
+    * The voxels are the same as the ones of a VoxelGrid with the same leaf size.
+    *
+    * By default only the XYZ coordinates are averaged. With \ref setDownsampleAllData all fields are
+    * averaged the way CentroidPoint does it (e.g. colors are averaged per channel).
+    *
+    * Memory can be bounded with spatial eviction: either explicitly through \ref removeVoxelsOutside,
+    * or automatically after every \ref addCloud by removing the voxels farther than an eviction radius
+    * from the sensor origin of the cloud that was just added.
+    *
+    * Code example:
+    *
+    * \code
+    * pcl::VoxelGridAccumulator<pcl::PointXYZRGB> accumulator;
+    * accumulator.setLeafSize (0.05f, 0.05f, 0.05f);
+    * accumulator.setDownsampleAllData (true);
+    * accumulator.setEvictionRadius (30.0f);
+    * for (size_t i = 0; i < scans.size (); ++i)
+    *   accumulator.addCloud (*scans[i]);   // registered scans, with the sensor pose in sensor_origin_
+    * pcl::PointCloud<pcl::PointXYZRGB> map;
+    * accumulator.getCentroids (map);
+    * \endcode
+    *
+    * \ingroup filters
+    */
+  template <typename PointT>
+  class VoxelGridAccumulator
+  {
+    public:
+      typedef pcl::PointCloud<PointT> PointCloud;
+
+      typedef boost::shared_ptr< VoxelGridAccumulator<PointT> > Ptr;
+      typedef boost::shared_ptr< const VoxelGridAccumulator<PointT> > ConstPtr;
+
+      /** \brief Empty constructor. */
+      VoxelGridAccumulator () :
+        leaf_size_ (Eigen::Vector3f::Ones ()),
+        inverse_leaf_size_ (Eigen::Vector3f::Ones ()),
+        downsample_all_data_ (false),
+        min_points_per_voxel_ (0),
+        eviction_radius_ (0),
+        voxels_ ()
+      {
+      }
+
+      /** \brief Set the voxel grid leaf size. Clears the voxel map.
+        * \param[in] lx the leaf size for X
+        * \param[in] ly the leaf size for Y
+        * \param[in] lz the leaf size for Z
+        */
+      void
+      setLeafSize (float lx, float ly, float lz);
+
+      /** \brief Get the voxel grid leaf size. */
+      inline Eigen::Vector3f
+      getLeafSize () const
+      {
+        return (leaf_size_);
+      }
+
+      /** \brief Set to true if all fields need to be averaged, and false if only XYZ. Clears the voxel map.
+        * \param[in] downsample the new value (true/false)
+        */
+      void
+      setDownsampleAllData (bool downsample);
+
+      /** \brief Get the state of the internal downsampling parameter (true if all fields need to be
+        * averaged, false if only XYZ).
+        */
+      inline bool
+      getDownsampleAllData () const
+      {
+        return (downsample_all_data_);
+      }
+
+      /** \brief Set the minimum number of points a voxel needs to be returned by \ref getCentroids.
+        * \param[in] min_points_per_voxel the minimum number of points for a voxel to be used
+        */
+      inline void
+      setMinimumPointsNumberPerVoxel (unsigned int min_points_per_voxel)
+      {
+        min_points_per_voxel_ = min_points_per_voxel;
+      }
+
+      /** \brief Return the minimum number of points a voxel needs to be returned by \ref getCentroids. */
+      inline unsigned int
+      getMinimumPointsNumberPerVoxel () const
+      {
+        return (min_points_per_voxel_);
+      }
+
+      /** \brief Set the radius around the sensor origin of the last added cloud outside of which
+        * voxels are removed after every \ref addCloud. Each eviction visits all voxels.
+        * \param[in] radius the eviction radius (0 disables the automatic eviction)
+        */
+      inline void
+      setEvictionRadius (float radius)
+      {
+        eviction_radius_ = radius;
+      }
+
+      /** \brief Get the automatic eviction radius (0 if disabled). */
+      inline float
+      getEvictionRadius () const
+      {
+        return (eviction_radius_);
+      }
+
+      /** \brief Add the finite points of a cloud to the voxel map.
+        * \param[in] cloud the cloud to add, in the frame of the map
+        */
+      void
+      addCloud (const PointCloud &cloud);
+
+      /** \brief Add the finite points of a subset of a cloud to the voxel map.
+        * \param[in] cloud the cloud to add, in the frame of the map
+        * \param[in] indices the indices of the points to add
+        */
+      void
+      addCloud (const PointCloud &cloud, const std::vector<int> &indices);
+
+      /** \brief Remove the voxels whose centroid lies farther than a radius from a point.
+        * \param[in] center the center of the region to keep
+        * \param[in] radius the radius of the region to keep
+        * \return the number of removed voxels
+        */
+      size_t
+      removeVoxelsOutside (const Eigen::Vector3f &center, float radius);
+
+      /** \brief Remove the voxels whose centroid lies outside an axis aligned box.
+        * \param[in] min_pt the minimum corner of the box to keep
+        * \param[in] max_pt the maximum corner of the box to keep
+        * \return the number of removed voxels
+        */
+      size_t
+      removeVoxelsOutside (const Eigen::Vector3f &min_pt, const Eigen::Vector3f &max_pt);
+
+      /** \brief Get the centroids of all voxels with at least getMinimumPointsNumberPerVoxel () points.
+        * \param[out] output the centroids, one point per voxel, in no particular order
+        */
+      void
+      getCentroids (PointCloud &output) const;
+
+      /** \brief Get the centroids and point counts of all voxels with at least
+        * getMinimumPointsNumberPerVoxel () points.
+        * \param[out] output the centroids, one point per voxel, in no particular order
+        * \param[out] counts the number of points accumulated in every voxel, in the order of output
+        */
+      void
+      getCentroids (PointCloud &output, std::vector<unsigned int> &counts) const;
+
+      /** \brief Get the number of voxels in the map. */
+      inline size_t
+      getNumberOfVoxels () const
+      {
+        return (voxels_.size ());
+      }
+
+      /** \brief Remove all voxels. */
+      inline void
+      clear ()
+      {
+        voxels_.clear ();
+      }
+
+    protected:
+      /** \brief The accumulated data of one voxel. */
+      struct Voxel
+      {
+        Voxel () : sum (Eigen::Vector3d::Zero ()), nr_points (0), centroid () {}
+
+        /** \brief The sum of the XYZ coordinates, in double precision to stay exact over many scans. */
+        Eigen::Vector3d sum;
+        /** \brief The number of accumulated points. */
+        unsigned int nr_points;
+        /** \brief The accumulator of all fields, only used when downsampling all data. */
+        CentroidPoint<PointT> centroid;
+      };
+
+      typedef boost::unordered_map<uint64_t, Voxel, boost::hash<uint64_t>, std::equal_to<uint64_t>,
+                                   Eigen::aligned_allocator<std::pair<const uint64_t, Voxel> > > VoxelMap;
+
+      /** \brief Add one point to its voxel, if it is finite and within the range of the voxel keys. */
+      inline void
+      addPoint (const PointT &point);
+
+      /** \brief Get the centroid of a voxel. */
+      inline void
+      getCentroid (const Voxel &voxel, PointT &point) const;
+
+      /** \brief Remove the voxels outside the eviction radius around a sensor origin, if enabled. */
+      void
+      evict (const Eigen::Vector4f &sensor_origin);
+
+      /** \brief The size of a leaf. */
+      Eigen::Vector3f leaf_size_;
+
+      /** \brief Internal leaf sizes stored as 1/leaf_size_ for efficiency reasons. */
+      Eigen::Vector3f inverse_leaf_size_;
+
+      /** \brief Set to true if all fields need to be averaged, and false if only XYZ. */
+      bool downsample_all_data_;
+
+      /** \brief Minimum number of points per voxel for the centroid to be returned. */
+      unsigned int min_points_per_voxel_;
+
+      /** \brief The automatic eviction radius (0 if disabled). */
+      float eviction_radius_;
+
+      /** \brief The voxels, keyed by their packed integer grid coordinates. */
+      VoxelMap voxels_;
+  };
+}
+
+#ifdef PCL_NO_PRECOMPILE
+#include <pcl/filters/impl/voxel_grid_accumulator.hpp>
+#endif
+
+#endif  // PCL_FILTERS_VOXEL_GRID_ACCUMULATOR_H_
@@ -40,7 +40,6 @@
 
 #include <pcl/filters/boost.h>
 #include <pcl/filters/voxel_grid.h>
-#include <map>
 #include <pcl/point_types.h>
 #include <pcl/kdtree/kdtree_flann.h>
 
@@ -102,7 +101,10 @@ namespace pcl
           cov_ (Eigen::Matrix3d::Identity ()),
           icov_ (Eigen::Matrix3d::Zero ()),
           evecs_ (Eigen::Matrix3d::Identity ()),
-          evals_ (Eigen::Vector3d::Zero ())
+          evals_ (Eigen::Vector3d::Zero ()),
+          nr_accumulated_ (0),
+          pt_sum_ (Eigen::Vector3d::Zero ()),
+          pt_sq_sum_ (Eigen::Matrix3d::Zero ())
         {
         }
 
@@ -185,6 +187,17 @@ namespace pcl
         /** \brief Eigen values of voxel covariance matrix */
         Eigen::Vector3d evals_;
 
+        /** \brief Number of points accumulated in the voxel
+         * \note Unlike \ref nr_points it is not invalidated for degenerate voxels
+         */
+        int nr_accumulated_;
+
+        /** \brief Sum of the accumulated points (kept for incremental updates) */
+        Eigen::Vector3d pt_sum_;
+
+        /** \brief Sum of the outer products of the accumulated points (kept for incremental updates) */
+        Eigen::Matrix3d pt_sq_sum_;
+
       };
 
       /** \brief Pointer to VoxelGridCovariance leaf structure */
@@ -193,6 +206,9 @@ namespace pcl
       /** \brief Const pointer to VoxelGridCovariance leaf structure */
       typedef const Leaf* LeafConstPtr;
 
+      /** \brief Hash map from voxel index to leaf structure */
+      typedef boost::unordered_map<size_t, Leaf> LeafMap;
+
     public:
 
       /** \brief Constructor.
@@ -205,7 +221,8 @@ namespace pcl
         leaves_ (),
         voxel_centroids_ (),
         voxel_centroids_leaf_indices_ (),
-        kdtree_ ()
+        kdtree_ (),
+        threads_ (0)
       {
         downsample_all_data_ = false;
         save_leaf_layout_ = false;
@@ -259,9 +276,19 @@ namespace pcl
         return min_covar_eigvalue_mult_;
       }
 
+      /** \brief Set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0)
+      {
+        threads_ = nr_threads;
+      }
+
       /** \brief Filter cloud and initializes voxel structure.
        * \param[out] output cloud containing centroids of voxels containing a sufficient number of points
-       * \param[in] searchable flag if voxel structure is searchable, if true then kdtree is built
+       * \param[in] searchable flag if voxel structure is searchable, if true then the kdtree used by
+       * \ref nearestKSearch is built on first use
        */
       inline void
       filter (PointCloud &output, bool searchable = false)
@@ -270,16 +297,11 @@ namespace pcl
         applyFilter (output);
 
         voxel_centroids_ = PointCloudPtr (new PointCloud (output));
-
-        if (searchable_ && voxel_centroids_->size() > 0)
-        {
-          // Initiates kdtree of the centroids of voxels containing a sufficient number of points
-          kdtree_.setInputCloud (voxel_centroids_);
-        }
       }
 
       /** \brief Initializes voxel structure.
-       * \param[in] searchable flag if voxel structure is searchable, if true then kdtree is built
+       * \param[in] searchable flag if voxel structure is searchable, if true then the kdtree used by
+       * \ref nearestKSearch is built on first use
        */
       inline void
       filter (bool searchable = false)
@@ -287,14 +309,18 @@ namespace pcl
         searchable_ = searchable;
         voxel_centroids_ = PointCloudPtr (new PointCloud);
         applyFilter (*voxel_centroids_);
-
-        if (searchable_ && voxel_centroids_->size() > 0)
-        {
-          // Initiates kdtree of the centroids of voxels containing a sufficient number of points
-          kdtree_.setInputCloud (voxel_centroids_);
-        }
       }
 
+      /** \brief Add the points of a new scan to the voxel structure without rebuilding it.
+       * Only the leaves receiving new points are recomputed; the grid bounds grow as needed.
+       * If the structure has not been initialized yet, the cloud becomes the input and \ref filter is called.
+       * \note The leaf size must not change between \ref filter and subsequent calls, and leaf pointers
+       * obtained before the call are invalidated.
+       * \param[in] cloud the new points to add to the voxel structure
+       */
+      void
+      addCloud (const PointCloudConstPtr &cloud);
+
       /** \brief Get the voxel containing point p.
        * \param[in] index the index of the leaf structure node
        * \return const pointer to leaf structure
@@ -302,7 +328,7 @@ namespace pcl
       inline LeafConstPtr
       getLeaf (int index)
       {
-        typename std::map<size_t, Leaf>::iterator leaf_iter = leaves_.find (index);
+        typename LeafMap::iterator leaf_iter = leaves_.find (index);
         if (leaf_iter != leaves_.end ())
         {
           LeafConstPtr ret (&(leaf_iter->second));
@@ -328,7 +354,7 @@ namespace pcl
         int idx = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
 
         // Find leaf associated with index
-        typename std::map<size_t, Leaf>::iterator leaf_iter = leaves_.find (idx);
+        typename LeafMap::iterator leaf_iter = leaves_.find (idx);
         if (leaf_iter != leaves_.end ())
         {
           // If such a leaf exists return the pointer to the leaf structure
@@ -355,7 +381,7 @@ namespace pcl
         int idx = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
 
         // Find leaf associated with index
-        typename std::map<size_t, Leaf>::iterator leaf_iter = leaves_.find (idx);
+        typename LeafMap::iterator leaf_iter = leaves_.find (idx);
         if (leaf_iter != leaves_.end ())
         {
           // If such a leaf exists return the pointer to the leaf structure
@@ -368,7 +394,7 @@ namespace pcl
       }
 
       /** \brief Get the voxels surrounding point p, not including the voxel contating point p.
-       * \note Only voxels containing a sufficient number of points are used (slower than radius search in practice).
+       * \note Only voxels containing a sufficient number of points are used.
        * \param[in] reference_point the point to get the leaf structure at
        * \param[out] neighbors
        * \return number of neighbors found
@@ -379,7 +405,7 @@ namespace pcl
       /** \brief Get the leaf structure map
        * \return a map contataining all leaves
        */
-      inline const std::map<size_t, Leaf>&
+      inline const LeafMap&
       getLeaves ()
       {
         return leaves_;
@@ -423,6 +449,13 @@ namespace pcl
           return 0;
         }
 
+        if (voxel_centroids_->empty ())
+          return 0;
+
+        // Initiates kdtree of the centroids of voxels containing a sufficient number of points
+        if (kdtree_.getInputCloud () != voxel_centroids_)
+          kdtree_.setInputCloud (voxel_centroids_);
+
         // Find k-nearest neighbors in the occupied voxel centroid cloud
         std::vector<int> k_indices;
         k = kdtree_.nearestKSearch (point, k, k_indices, k_sqr_distances);
@@ -456,39 +489,18 @@ namespace pcl
 
 
       /** \brief Search for all the nearest occupied voxels of the query point in a given radius.
-       * \note Only voxels containing a sufficient number of points are used.
+       * \note Only voxels containing a sufficient number of points are used. The voxels overlapping the
+       * search sphere are looked up directly, so this is fastest for radii close to the leaf size.
        * \param[in] point the given query point
        * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
-       * \param[out] k_leaves the resultant leaves of the neighboring points
+       * \param[out] k_leaves the resultant leaves of the neighboring points, sorted by distance
        * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
-       * \param[in] max_nn
+       * \param[in] max_nn if greater than 0, only the max_nn nearest leaves are returned
        * \return number of neighbors found
        */
       int
       radiusSearch (const PointT &point, double radius, std::vector<LeafConstPtr> &k_leaves,
-                    std::vector<float> &k_sqr_distances, unsigned int max_nn = 0)
-      {
-        k_leaves.clear ();
-
-        // Check if kdtree has been built
-        if (!searchable_)
-        {
-          PCL_WARN ("%s: Not Searchable", this->getClassName ().c_str ());
-          return 0;
-        }
-
-        // Find neighbors within radius in the occupied voxel centroid cloud
-        std::vector<int> k_indices;
-        int k = kdtree_.radiusSearch (point, radius, k_indices, k_sqr_distances, max_nn);
-
-        // Find leaves corresponding to neighbors
-        k_leaves.reserve (k);
-        for (std::vector<int>::iterator iter = k_indices.begin (); iter != k_indices.end (); iter++)
-        {
-          k_leaves.push_back (&leaves_[voxel_centroids_leaf_indices_[*iter]]);
-        }
-        return k;
-      }
+                    std::vector<float> &k_sqr_distances, unsigned int max_nn = 0);
 
       /** \brief Search for all the nearest occupied voxels of the query point in a given radius.
        * \note Only voxels containing a sufficient number of points are used.
@@ -517,6 +529,36 @@ namespace pcl
        */
       void applyFilter (PointCloud &output);
 
+      /** \brief Compute the leaf index of every valid point of a cloud.
+       * \param[in] cloud the point cloud to bin
+       * \param[out] leaf_point_indices pairs of (leaf index, point index), sorted by leaf index and then by point index
+       */
+      void
+      computeLeafIndices (const PointCloud &cloud, std::vector<std::pair<size_t, int> > &leaf_point_indices);
+
+      /** \brief Accumulate binned points into their leaves and recompute the statistics of every touched leaf.
+       * \param[in] cloud the point cloud the indices refer to
+       * \param[in] leaf_point_indices the sorted output of \ref computeLeafIndices
+       */
+      void
+      accumulateLeaves (const PointCloud &cloud, const std::vector<std::pair<size_t, int> > &leaf_point_indices);
+
+      /** \brief Compute the mean, covariance and its decomposition from the sums accumulated in a leaf.
+       * \param[in,out] leaf the leaf to update
+       */
+      void
+      computeLeafStatistics (Leaf &leaf) const;
+
+      /** \brief Write the centroids of all voxels with a sufficient number of points, ordered by leaf index.
+       * \param[out] output the resultant centroid cloud
+       */
+      void
+      computeCentroidCloud (PointCloud &output);
+
+      /** \brief Get the size of the centroid vectors and the byte offset of the color field (-1 if absent). */
+      void
+      getCentroidLayout (int &centroid_size, int &rgba_index) const;
+
       /** \brief Flag to determine if voxel structure is searchable. */
       bool searchable_;
 
@@ -527,7 +569,7 @@ namespace pcl
       double min_covar_eigvalue_mult_;
 
       /** \brief Voxel structure containing all leaf nodes (includes voxels with less than a sufficient number of points). */
-      std::map<size_t, Leaf> leaves_;
+      LeafMap leaves_;
 
       /** \brief Point cloud containing centroids of voxels containing atleast minimum number of points. */
       PointCloudPtr voxel_centroids_;
@@ -537,6 +579,9 @@ namespace pcl
 
       /** \brief KdTree generated using \ref voxel_centroids_ (used for searching). */
       KdTreeFLANN<PointT> kdtree_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
   };
 }
 
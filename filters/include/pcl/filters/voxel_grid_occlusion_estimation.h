@@ -41,6 +41,7 @@
 #ifndef PCL_FILTERS_VOXEL_GRID_OCCLUSION_ESTIMATION_H_
 #define PCL_FILTERS_VOXEL_GRID_OCCLUSION_ESTIMATION_H_
 
+#include <pcl/filters/boost.h>
 #include <pcl/filters/voxel_grid.h>
 
 namespace pcl
@@ -59,6 +60,8 @@ namespace pcl
       using VoxelGrid<PointT>::min_b_;
       using VoxelGrid<PointT>::max_b_;
       using VoxelGrid<PointT>::div_b_;
+      using VoxelGrid<PointT>::divb_mul_;
+      using VoxelGrid<PointT>::leaf_layout_;
       using VoxelGrid<PointT>::leaf_size_;
       using VoxelGrid<PointT>::inverse_leaf_size_;
 
@@ -71,6 +74,7 @@ namespace pcl
       VoxelGridOcclusionEstimation ()
       {
         initialized_ = false;
+        threads_ = 0;
         this->setSaveLeafLayout (true);
       }
 
@@ -79,6 +83,15 @@ namespace pcl
       {
       }
 
+      /** \brief Set the number of threads to use in \ref occlusionEstimationAll.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0)
+      {
+        threads_ = nr_threads;
+      }
+
       /** \brief Initialize the voxel grid, needs to be called first
         * Builts the voxel grid and computes additional values for
         * the ray traversal algorithm.
@@ -114,6 +127,8 @@ namespace pcl
 
       /** \brief Computes the voxel coordinates (i, j, k) of all occluded
         * voxels in the voxel gird.
+        * The rays to all free voxels are traversed in parallel; the voxels are
+        * appended in (k, j, i) order.
         * \param[out] occluded_voxels the coordinates (i, j, k) of all occluded voxels
         * \return 0 upon success and -1 if an error occurs
         */
@@ -232,6 +247,17 @@ namespace pcl
                                 static_cast<int> (round (z * inverse_leaf_size_[2])));
       }
 
+      /** \brief Returns the index of voxel (i, j, k) in the leaf layout, or -1 if it is outside the grid.
+        * \param[in] ijk the coordinate (i, j, k) of the voxel
+        */
+      inline int
+      getVoxelIndex (const Eigen::Vector3i& ijk) const
+      {
+        if ((ijk.array () < min_b_.template head<3> ().array ()).any () || (ijk.array () > max_b_.template head<3> ().array ()).any ())
+          return (-1);
+        return ((ijk - min_b_.template head<3> ()).dot (divb_mul_.template head<3> ()));
+      }
+
       // initialization flag
       bool initialized_;
 
@@ -243,6 +269,12 @@ namespace pcl
 
       // voxel grid filtered cloud
       PointCloud filtered_cloud_;
+
+      // occupancy of the voxel grid, one bit per voxel in leaf layout order
+      boost::dynamic_bitset<> occupancy_;
+
+      // number of threads used by occlusionEstimationAll
+      unsigned int threads_;
   };
 }
 
@@ -54,6 +54,7 @@ PCL_INSTANTIATE(TfQuadraticXYZComparison, PCL_XYZ_POINT_TYPES)
 PCL_INSTANTIATE(ConditionBase, PCL_XYZ_POINT_TYPES)
 PCL_INSTANTIATE(ConditionAnd, PCL_XYZ_POINT_TYPES)
 PCL_INSTANTIATE(ConditionOr, PCL_XYZ_POINT_TYPES)
+PCL_INSTANTIATE(ConditionProgram, PCL_XYZ_POINT_TYPES)
 PCL_INSTANTIATE(ConditionalRemoval, PCL_XYZ_POINT_TYPES)
 
 #endif    // PCL_NO_PRECOMPILE
@@ -49,8 +49,10 @@
 void
 pcl::Filter<pcl::PCLPointCloud2>::filter (PCLPointCloud2 &output)
 {
+  PCL_TRACE_ZONE (filter_name_);
   if (!initCompute ())
     return;
+  PCL_TRACE_COUNTER ("filter points", indices_->size ());
 
   if (input_.get () == &output)  // cloud_in = cloud_out
   {
@@ -47,8 +47,10 @@
 void
 pcl::FilterIndices<pcl::PCLPointCloud2>::filter (std::vector<int> &indices)
 {
+  PCL_TRACE_ZONE (filter_name_);
   if (!initCompute ())
     return;
+  PCL_TRACE_COUNTER ("filter points", indices_->size ());
 
   // Apply the actual filter
   applyFilter (indices);
@@ -40,6 +40,7 @@
 
 #include <pcl/filters/impl/radius_outlier_removal.hpp>
 #include <pcl/conversions.h>
+#include <algorithm>
 
 ///////////////////////////////////////////////////////////////////////////////////////////
 void
@@ -76,10 +77,6 @@ pcl::RadiusOutlierRemoval<pcl::PCLPointCloud2>::applyFilter (PCLPointCloud2 &out
   }
   tree_->setInputCloud (cloud);
 
-  // Allocate enough space to hold the results
-  std::vector<int> nn_indices (indices_->size ());
-  std::vector<float> nn_dists (indices_->size ());
-
   // Copy the common fields
   output.is_bigendian = input_->is_bigendian;
   output.point_step = input_->point_step;
@@ -93,7 +90,8 @@ pcl::RadiusOutlierRemoval<pcl::PCLPointCloud2>::applyFilter (PCLPointCloud2 &out
   // Go over all the points and check which doesn't have enough neighbors
   for (int cp = 0; cp < static_cast<int> (indices_->size ()); ++cp)
   {
-    int k = tree_->radiusSearch ((*indices_)[cp], search_radius_, nn_indices, nn_dists);
+    // Only count up to the user imposed limit, the neighbors themselves are not needed
+    int k = tree_->radiusSearchCount ((*indices_)[cp], search_radius_, static_cast<unsigned int> (std::max (min_pts_radius_, 0)));
     // Check if the number of neighbors is larger than the user imposed limit
     if (k < min_pts_radius_)
     {
@@ -40,10 +40,165 @@
 
 #include <iostream>
 #include <pcl/common/io.h>
+#include <pcl/common/cpu_dispatch.h>
 #include <pcl/filters/impl/voxel_grid.hpp>
 
 typedef Eigen::Array<size_t, 4, 1> Array4size_t;
 
+#ifdef PCL_CPU_DISPATCH_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+  typedef void (*MinMaxFn) (const uint8_t*, size_t, size_t, const size_t*, float*, float*);
+
+  /** \brief Grow the bounding box min_p, max_p by the finite points of a strided float xyz layout. */
+  void
+  minMaxGeneric (const uint8_t *data, size_t nr_points, size_t point_step, const size_t *offsets,
+                 float *min_p, float *max_p)
+  {
+    float pt[3];
+    for (size_t cp = 0; cp < nr_points; ++cp, data += point_step)
+    {
+      memcpy (&pt[0], data + offsets[0], sizeof (float));
+      memcpy (&pt[1], data + offsets[1], sizeof (float));
+      memcpy (&pt[2], data + offsets[2], sizeof (float));
+      // Check if the point is invalid
+      if (!pcl_isfinite (pt[0]) || !pcl_isfinite (pt[1]) || !pcl_isfinite (pt[2]))
+        continue;
+      for (int d = 0; d < 3; ++d)
+      {
+        min_p[d] = (std::min) (min_p[d], pt[d]);
+        max_p[d] = (std::max) (max_p[d], pt[d]);
+      }
+    }
+  }
+
+#ifdef PCL_CPU_DISPATCH_X86
+  // The gathers below address a block of points with 32 bit byte offsets
+  const size_t max_gather_point_step = 1 << 26;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  PCL_TARGET_AVX2 void
+  minMaxAVX2 (const uint8_t *data, size_t nr_points, size_t point_step, const size_t *offsets,
+              float *min_p, float *max_p)
+  {
+    if (point_step > max_gather_point_step)
+      return (minMaxGeneric (data, nr_points, point_step, offsets, min_p, max_p));
+
+    const __m256i lanes = _mm256_mullo_epi32 (_mm256_setr_epi32 (0, 1, 2, 3, 4, 5, 6, 7),
+                                              _mm256_set1_epi32 (static_cast<int> (point_step)));
+    __m256i idx[3];
+    __m256 vmin[3], vmax[3];
+    for (int d = 0; d < 3; ++d)
+    {
+      idx[d] = _mm256_add_epi32 (lanes, _mm256_set1_epi32 (static_cast<int> (offsets[d])));
+      vmin[d] = _mm256_set1_ps (min_p[d]);
+      vmax[d] = _mm256_set1_ps (max_p[d]);
+    }
+
+    size_t cp = 0;
+    for (; cp + 8 <= nr_points; cp += 8, data += 8 * point_step)
+    {
+      const float *base = reinterpret_cast<const float*> (data);
+      __m256 v[3];
+      for (int d = 0; d < 3; ++d)
+        v[d] = _mm256_i32gather_ps (base, idx[d], 1);
+      // x - x is 0 for finite x only
+      const __m256 zero = _mm256_setzero_ps ();
+      const __m256 valid = _mm256_and_ps (_mm256_and_ps (_mm256_cmp_ps (_mm256_sub_ps (v[0], v[0]), zero, _CMP_EQ_OQ),
+                                                         _mm256_cmp_ps (_mm256_sub_ps (v[1], v[1]), zero, _CMP_EQ_OQ)),
+                                          _mm256_cmp_ps (_mm256_sub_ps (v[2], v[2]), zero, _CMP_EQ_OQ));
+      for (int d = 0; d < 3; ++d)
+      {
+        vmin[d] = _mm256_blendv_ps (vmin[d], _mm256_min_ps (vmin[d], v[d]), valid);
+        vmax[d] = _mm256_blendv_ps (vmax[d], _mm256_max_ps (vmax[d], v[d]), valid);
+      }
+    }
+
+    float lmin[8], lmax[8];
+    for (int d = 0; d < 3; ++d)
+    {
+      _mm256_storeu_ps (lmin, vmin[d]);
+      _mm256_storeu_ps (lmax, vmax[d]);
+      for (int l = 0; l < 8; ++l)
+      {
+        min_p[d] = (std::min) (min_p[d], lmin[l]);
+        max_p[d] = (std::max) (max_p[d], lmax[l]);
+      }
+    }
+    minMaxGeneric (data, nr_points - cp, point_step, offsets, min_p, max_p);
+  }
+
+  // GCC's _mm512_undefined_ps () self-initializes and trips these warnings in the AVX-512 helper
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  PCL_TARGET_AVX512 void
+  minMaxAVX512 (const uint8_t *data, size_t nr_points, size_t point_step, const size_t *offsets,
+                float *min_p, float *max_p)
+  {
+    if (point_step > max_gather_point_step)
+      return (minMaxGeneric (data, nr_points, point_step, offsets, min_p, max_p));
+
+    const __m512i lanes = _mm512_mullo_epi32 (_mm512_setr_epi32 (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+                                              _mm512_set1_epi32 (static_cast<int> (point_step)));
+    __m512i idx[3];
+    __m512 vmin[3], vmax[3];
+    for (int d = 0; d < 3; ++d)
+    {
+      idx[d] = _mm512_add_epi32 (lanes, _mm512_set1_epi32 (static_cast<int> (offsets[d])));
+      vmin[d] = _mm512_set1_ps (min_p[d]);
+      vmax[d] = _mm512_set1_ps (max_p[d]);
+    }
+
+    size_t cp = 0;
+    for (; cp + 16 <= nr_points; cp += 16, data += 16 * point_step)
+    {
+      __m512 v[3];
+      for (int d = 0; d < 3; ++d)
+        v[d] = _mm512_i32gather_ps (idx[d], data, 1);
+      const __m512 zero = _mm512_setzero_ps ();
+      const __mmask16 valid = _mm512_cmp_ps_mask (_mm512_sub_ps (v[0], v[0]), zero, _CMP_EQ_OQ) &
+                              _mm512_cmp_ps_mask (_mm512_sub_ps (v[1], v[1]), zero, _CMP_EQ_OQ) &
+                              _mm512_cmp_ps_mask (_mm512_sub_ps (v[2], v[2]), zero, _CMP_EQ_OQ);
+      for (int d = 0; d < 3; ++d)
+      {
+        vmin[d] = _mm512_mask_min_ps (vmin[d], valid, vmin[d], v[d]);
+        vmax[d] = _mm512_mask_max_ps (vmax[d], valid, vmax[d], v[d]);
+      }
+    }
+
+    for (int d = 0; d < 3; ++d)
+    {
+      min_p[d] = (std::min) (min_p[d], _mm512_reduce_min_ps (vmin[d]));
+      max_p[d] = (std::max) (max_p[d], _mm512_reduce_max_ps (vmax[d]));
+    }
+    minMaxGeneric (data, nr_points - cp, point_step, offsets, min_p, max_p);
+  }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+  pcl::CpuDispatcher<MinMaxFn>
+  makeMinMaxDispatcher ()
+  {
+    pcl::CpuDispatcher<MinMaxFn> dispatcher (&minMaxGeneric);
+#ifdef PCL_CPU_DISPATCH_X86
+    dispatcher.add (pcl::CPU_ISA_AVX2, &minMaxAVX2);
+    dispatcher.add (pcl::CPU_ISA_AVX512, &minMaxAVX512);
+#endif
+    return (dispatcher);
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 void
 pcl::getMinMax3D (const pcl::PCLPointCloud2ConstPtr &cloud, int x_idx, int y_idx, int z_idx,
@@ -63,28 +218,16 @@ pcl::getMinMax3D (const pcl::PCLPointCloud2ConstPtr &cloud, int x_idx, int y_idx
   max_p.setConstant (-FLT_MAX);
 
   size_t nr_points = cloud->width * cloud->height;
-
-  Eigen::Array4f pt = Eigen::Array4f::Zero ();
-  Array4size_t xyz_offset (cloud->fields[x_idx].offset, cloud->fields[y_idx].offset, cloud->fields[z_idx].offset, 0);
-
-  for (size_t cp = 0; cp < nr_points; ++cp)
+  if (nr_points > 0)
   {
-    // Unoptimized memcpys: assume fields x, y, z are in random order
-    memcpy (&pt[0], &cloud->data[xyz_offset[0]], sizeof (float));
-    memcpy (&pt[1], &cloud->data[xyz_offset[1]], sizeof (float));
-    memcpy (&pt[2], &cloud->data[xyz_offset[2]], sizeof (float));
-    // Check if the point is invalid
-    if (!pcl_isfinite (pt[0]) || 
-        !pcl_isfinite (pt[1]) || 
-        !pcl_isfinite (pt[2]))
-    {
-      xyz_offset += cloud->point_step;
-      continue;
-    }
-    xyz_offset += cloud->point_step;
-    min_p = (min_p.min) (pt);
-    max_p = (max_p.max) (pt);
+    // The fields x, y, z may be in any order
+    const size_t xyz_offset[3] = { cloud->fields[x_idx].offset, cloud->fields[y_idx].offset, cloud->fields[z_idx].offset };
+    static const pcl::CpuDispatcher<MinMaxFn> dispatcher = makeMinMaxDispatcher ();
+    dispatcher.get () (&cloud->data[0], nr_points, cloud->point_step, xyz_offset, min_p.data (), max_p.data ());
   }
+  // As before, the fourth coordinate is 0 as soon as one finite point was seen
+  if (min_p[0] <= max_p[0])
+    min_p[3] = max_p[3] = 0.0f;
   min_pt = min_p;
   max_pt = max_p;
 }
@@ -209,6 +209,36 @@ pcl::KdTreeFLANN<PointT, Dist>::radiusSearch (const PointT &point, double radius
   return (neighbors_in_radius);
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename Dist> int 
+pcl::KdTreeFLANN<PointT, Dist>::radiusSearchCount (const PointT &point, double radius, unsigned int max_count) const
+{
+  assert (point_representation_->isValid (point) && "Invalid (NaN, Inf) point coordinates given to radiusSearchCount!");
+
+  std::vector<float> query (dim_);
+  point_representation_->vectorize (static_cast<PointT> (point), query);
+
+  std::vector<std::vector<int> > indices(1);
+  std::vector<std::vector<float> > dists(1);
+
+  ::flann::SearchParams params (param_radius_);
+  params.sorted = false;
+  if (max_count == 0 || max_count >= static_cast<unsigned int> (total_nr_points_))
+    params.max_neighbors = 0;  // only count the neighbors in radius
+  else
+    params.max_neighbors = max_count;
+
+  int neighbors_in_radius = flann_index_->radiusSearch (::flann::Matrix<float> (&query[0], 1, dim_),
+      indices,
+      dists,
+      static_cast<float> (radius * radius), 
+      params);
+
+  if (max_count > 0 && neighbors_in_radius > static_cast<int> (max_count))
+    neighbors_in_radius = static_cast<int> (max_count);
+  return (neighbors_in_radius);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT, typename Dist> void 
 pcl::KdTreeFLANN<PointT, Dist>::cleanup ()
@@ -307,6 +307,24 @@ namespace pcl
         }
       }
 
+      /** \brief Count the neighbors of the query point in a given radius, without collecting them.
+        * \param[in] p_q the given query point
+        * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+        * \param[in] max_count if given, the search stops after this many neighbors and returns \a max_count.
+        * If \a max_count is set to 0, all neighbors in \a radius are counted.
+        * \return number of neighbors found in radius, at most \a max_count
+        */
+      virtual int
+      radiusSearchCount (const PointT &p_q, double radius, unsigned int max_count = 0) const
+      {
+        std::vector<int> k_indices;
+        std::vector<float> k_sqr_distances;
+        int k = radiusSearch (p_q, radius, k_indices, k_sqr_distances, max_count);
+        if (max_count > 0 && k > static_cast<int> (max_count))
+          k = static_cast<int> (max_count);
+        return (k);
+      }
+
       /** \brief Set the search epsilon precision (error bound) for nearest neighbors searches.
         * \param[in] eps precision (error bound) for nearest neighbors searches
         */
@@ -76,6 +76,7 @@ namespace pcl
       using KdTree<PointT>::point_representation_;
       using KdTree<PointT>::nearestKSearch;
       using KdTree<PointT>::radiusSearch;
+      using KdTree<PointT>::radiusSearchCount;
 
       typedef typename KdTree<PointT>::PointCloud PointCloud;
       typedef typename KdTree<PointT>::PointCloudConstPtr PointCloudConstPtr;
@@ -183,6 +184,21 @@ namespace pcl
       radiusSearch (const PointT &point, double radius, std::vector<int> &k_indices,
                     std::vector<float> &k_sqr_distances, unsigned int max_nn = 0) const;
 
+      /** \brief Count the neighbors of the query point in a given radius, without collecting them.
+        *
+        * Without \a max_count, FLANN only counts the points in the sphere. With \a max_count, the search
+        * keeps an unsorted set of the \a max_count closest points and prunes every branch farther
+        * away than the worst of them, so dense neighborhoods are not traversed completely.
+        *
+        * \param[in] point a given \a valid (i.e., finite) query point
+        * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+        * \param[in] max_count if given, the search stops after this many neighbors and returns \a max_count.
+        * If \a max_count is set to 0, all neighbors in \a radius are counted.
+        * \return number of neighbors found in radius, at most \a max_count
+        */
+      int
+      radiusSearchCount (const PointT &point, double radius, unsigned int max_count = 0) const;
+
     private:
       /** \brief Internal cleanup method. */
       void 
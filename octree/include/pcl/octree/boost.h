@@ -47,4 +47,5 @@
 // Marking all Boost headers as system headers to remove warnings
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/function.hpp>
+#include <boost/unordered_map.hpp>
 #endif    // PCL_OCTREE_BOOST_H_
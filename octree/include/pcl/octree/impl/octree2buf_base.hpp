@@ -317,6 +317,20 @@ namespace pcl
       tree_dirty_flag_ = false;
     }
 
+    //////////////////////////////////////////////////////////////////////////////////////////////
+    template<typename LeafContainerT, typename BranchContainerT> void
+    Octree2BufBase<LeafContainerT, BranchContainerT>::serializeChangedLeafKeys (std::vector<OctreeKey>& new_leaf_keys_arg,
+                                                                                std::vector<OctreeKey>& removed_leaf_keys_arg) const
+    {
+      OctreeKey new_key;
+
+      // clear output vectors, keep their capacity for the next frame
+      new_leaf_keys_arg.clear ();
+      removed_leaf_keys_arg.clear ();
+
+      serializeChangedLeafKeysRecursive (root_node_, new_key, new_leaf_keys_arg, removed_leaf_keys_arg);
+    }
+
     //////////////////////////////////////////////////////////////////////////////////////////////
     template<typename LeafContainerT, typename BranchContainerT>
       unsigned int
@@ -624,6 +638,86 @@ namespace pcl
     }
 
 
+    //////////////////////////////////////////////////////////////////////////////////////////////
+    template<typename LeafContainerT, typename BranchContainerT> void
+    Octree2BufBase<LeafContainerT, BranchContainerT>::serializeChangedLeafKeysRecursive (const BranchNode* branch_arg,
+                                                                                         OctreeKey& key_arg,
+                                                                                         std::vector<OctreeKey>& new_leaf_keys_arg,
+                                                                                         std::vector<OctreeKey>& removed_leaf_keys_arg) const
+    {
+      // iterate over all children
+      for (unsigned char child_idx = 0; child_idx < 8; child_idx++)
+      {
+        const bool in_current_buffer = branch_arg->hasChild (buffer_selector_, child_idx);
+        const bool in_previous_buffer = branch_arg->hasChild (!buffer_selector_, child_idx);
+
+        if (!in_current_buffer && !in_previous_buffer)
+          continue;
+
+        // add current branch voxel to key
+        key_arg.pushBranch (child_idx);
+
+        if (in_current_buffer)
+        {
+          const OctreeNode *child_node = branch_arg->getChildPtr (buffer_selector_, child_idx);
+
+          if (child_node->getNodeType () == BRANCH_NODE)
+          {
+            // branches taken from the previous buffer still reference their previous children,
+            // newly created branches do not reference any
+            serializeChangedLeafKeysRecursive (static_cast<const BranchNode*> (child_node), key_arg,
+                                               new_leaf_keys_arg, removed_leaf_keys_arg);
+          }
+          else if (!in_previous_buffer)
+          {
+            new_leaf_keys_arg.push_back (key_arg);
+          }
+        }
+        else
+        {
+          // node only exists in previous buffer - all of its leaves vanished
+          const OctreeNode *child_node = branch_arg->getChildPtr (!buffer_selector_, child_idx);
+
+          if (child_node->getNodeType () == BRANCH_NODE)
+            serializeLeafKeysRecursive (static_cast<const BranchNode*> (child_node), !buffer_selector_, key_arg,
+                                        removed_leaf_keys_arg);
+          else
+            removed_leaf_keys_arg.push_back (key_arg);
+        }
+
+        // pop current branch voxel from key
+        key_arg.popBranch ();
+      }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////
+    template<typename LeafContainerT, typename BranchContainerT> void
+    Octree2BufBase<LeafContainerT, BranchContainerT>::serializeLeafKeysRecursive (const BranchNode* branch_arg,
+                                                                                  unsigned char buffer_selector_arg,
+                                                                                  OctreeKey& key_arg,
+                                                                                  std::vector<OctreeKey>& leaf_keys_arg) const
+    {
+      // iterate over all children
+      for (unsigned char child_idx = 0; child_idx < 8; child_idx++)
+      {
+        if (!branch_arg->hasChild (buffer_selector_arg, child_idx))
+          continue;
+
+        // add current branch voxel to key
+        key_arg.pushBranch (child_idx);
+
+        const OctreeNode *child_node = branch_arg->getChildPtr (buffer_selector_arg, child_idx);
+        if (child_node->getNodeType () == BRANCH_NODE)
+          serializeLeafKeysRecursive (static_cast<const BranchNode*> (child_node), buffer_selector_arg, key_arg,
+                                      leaf_keys_arg);
+        else
+          leaf_keys_arg.push_back (key_arg);
+
+        // pop current branch voxel from key
+        key_arg.popBranch ();
+      }
+    }
+
     //////////////////////////////////////////////////////////////////////////////////////////////
     template<typename LeafContainerT, typename BranchContainerT> void
     Octree2BufBase<LeafContainerT, BranchContainerT>::deserializeTreeRecursive (BranchNode* branch_arg,
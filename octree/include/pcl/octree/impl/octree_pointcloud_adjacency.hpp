@@ -51,9 +51,13 @@
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointT, typename LeafContainerT, typename BranchContainerT> 
-pcl::octree::OctreePointCloudAdjacency<PointT, LeafContainerT, BranchContainerT>::OctreePointCloudAdjacency (const double resolution_arg) 
+pcl::octree::OctreePointCloudAdjacency<PointT, LeafContainerT, BranchContainerT>::OctreePointCloudAdjacency (const double resolution_arg,
+                                                                                                   unsigned int nr_threads) 
 : OctreePointCloud<PointT, LeafContainerT, BranchContainerT
 , OctreeBase<LeafContainerT, BranchContainerT> > (resolution_arg)
+, leaf_vector_ ()
+, transform_func_ ()
+, threads_ (nr_threads)
 {
 
 }
@@ -90,22 +94,104 @@ pcl::octree::OctreePointCloudAdjacency<PointT, LeafContainerT, BranchContainerT>
 
   OctreePointCloud<PointT, LeafContainerT, BranchContainerT>::addPointsFromInputCloud ();
   
-  LeafContainerT *leaf_container;
-  typename OctreeAdjacencyT::LeafNodeIterator leaf_itr;
+  // Gather the leaves first, the tree is not modified anymore afterwards so the
+  // per leaf work below can run concurrently
+  std::vector<OctreeKey> leaf_keys;
+  leaf_keys.reserve (this->getLeafCount ());
   leaf_vector_.reserve (this->getLeafCount ());
-  for ( leaf_itr = this->leaf_begin () ; leaf_itr != this->leaf_end (); ++leaf_itr)
+  for (typename OctreeAdjacencyT::LeafNodeIterator leaf_itr = this->leaf_begin () ; leaf_itr != this->leaf_end (); ++leaf_itr)
   {
-    OctreeKey leaf_key = leaf_itr.getCurrentOctreeKey ();
-    leaf_container = &(leaf_itr.getLeafContainer ());
-    
+    leaf_keys.push_back (leaf_itr.getCurrentOctreeKey ());
+    leaf_vector_.push_back (&(leaf_itr.getLeafContainer ()));
+  }
+  //Make sure our leaf vector is correctly sized
+  assert (leaf_vector_.size () == this->getLeafCount ());
+
+  // Each iteration only writes to its own leaf, neighbors are looked up read-only
+  const int nr_leaves = static_cast<int> (leaf_keys.size ());
+  const size_t first_leaf = leaf_vector_.size () - leaf_keys.size ();
+#ifdef _OPENMP
+#pragma omp parallel for shared (leaf_keys) num_threads(threads_) schedule(dynamic, 256)
+#endif
+  for (int i = 0; i < nr_leaves; ++i)
+  {
+    LeafContainerT *leaf_container = leaf_vector_[first_leaf + i];
+
     //Run the leaf's compute function
     leaf_container->computeData ();
 
-    computeNeighbors (leaf_key, leaf_container);
-    
-    leaf_vector_.push_back (leaf_container);
+    computeNeighbors (leaf_keys[i], leaf_container);
   }
-  //Make sure our leaf vector is correctly sized
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafContainerT, typename BranchContainerT> void
+pcl::octree::OctreePointCloudAdjacency<PointT, LeafContainerT, BranchContainerT>::addNewPointsFromInputCloud ()
+{
+  if (leaf_vector_.empty ())
+  {
+    addPointsFromInputCloud ();
+    return;
+  }
+
+  // Insert the new points, remembering the leaves which did not exist before together with
+  // one of their points. Keys are only generated once all points are in, as growing the
+  // bounding box shifts the keys of all existing voxels.
+  LeafVectorT new_leaves;
+  std::vector<PointT, Eigen::aligned_allocator<PointT> > new_leaf_points;
+  const size_t nr_points = indices_ ? indices_->size () : input_->size ();
+  for (size_t i = 0; i < nr_points; ++i)
+  {
+    const PointT& point = indices_ ? input_->points[(*indices_)[i]] : input_->points[i];
+    if (!pcl::isFinite (point))
+      continue;
+
+    PointT temp (point);
+    if (transform_func_)
+      transform_func_ (temp);
+    if (!pcl::isFinite (temp)) //Check to make sure transform didn't make point not finite
+      continue;
+    this->adoptBoundingBoxToPoint (temp);
+
+    OctreeKey key;
+    this->genOctreeKeyforPoint (point, key);
+    LeafContainerT* container = this->findLeaf (key);
+    if (!container)
+    {
+      container = this->createLeaf (key);
+      new_leaves.push_back (container);
+      new_leaf_points.push_back (point);
+    }
+    container->addPoint (point);
+  }
+
+  const int nr_new_leaves = static_cast<int> (new_leaves.size ());
+#ifdef _OPENMP
+#pragma omp parallel for shared (new_leaves, new_leaf_points) num_threads(threads_) schedule(dynamic, 256)
+#endif
+  for (int i = 0; i < nr_new_leaves; ++i)
+  {
+    OctreeKey key;
+    this->genOctreeKeyforPoint (new_leaf_points[i], key);
+    new_leaves[i]->computeData ();
+    computeNeighbors (key, new_leaves[i]);
+  }
+
+  // Link the existing neighbors back to the new leaves. Pairs of new leaves already found
+  // each other above.
+  LeafVectorT sorted_new_leaves (new_leaves);
+  std::sort (sorted_new_leaves.begin (), sorted_new_leaves.end ());
+  for (typename LeafVectorT::iterator leaf_itr = new_leaves.begin (); leaf_itr != new_leaves.end (); ++leaf_itr)
+  {
+    for (typename LeafContainerT::iterator neighbor_itr = (*leaf_itr)->begin (); neighbor_itr != (*leaf_itr)->end (); ++neighbor_itr)
+    {
+      LeafContainerT* neighbor = static_cast<LeafContainerT*> (*neighbor_itr);
+      if (!std::binary_search (sorted_new_leaves.begin (), sorted_new_leaves.end (), neighbor))
+        neighbor->addNeighbor (*leaf_itr);
+    }
+  }
+
+  leaf_vector_.insert (leaf_vector_.end (), new_leaves.begin (), new_leaves.end ());
   assert (leaf_vector_.size () == this->getLeafCount ());
 }
 
@@ -316,6 +402,35 @@ pcl::octree::OctreePointCloudAdjacency<PointT, LeafContainerT, BranchContainerT>
   
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafContainerT, typename BranchContainerT> void
+pcl::octree::OctreePointCloudAdjacency<PointT, LeafContainerT, BranchContainerT>::getAdjacencyCSR (
+  std::vector<int> &row_offsets, std::vector<int> &neighbor_indices) const
+{
+  const int nr_leaves = static_cast<int> (leaf_vector_.size ());
+
+  boost::unordered_map<const LeafContainerT*, int> leaf_index_map;
+  leaf_index_map.rehash (leaf_vector_.size ());
+  row_offsets.resize (leaf_vector_.size () + 1);
+  row_offsets[0] = 0;
+  for (int i = 0; i < nr_leaves; ++i)
+  {
+    leaf_index_map[leaf_vector_[i]] = i;
+    row_offsets[i + 1] = row_offsets[i] + static_cast<int> (leaf_vector_[i]->size ());
+  }
+
+  neighbor_indices.resize (row_offsets.back ());
+#ifdef _OPENMP
+#pragma omp parallel for shared (row_offsets, neighbor_indices, leaf_index_map) num_threads(threads_) schedule(dynamic, 256)
+#endif
+  for (int i = 0; i < nr_leaves; ++i)
+  {
+    int out_idx = row_offsets[i];
+    for (typename LeafContainerT::const_iterator neighbor_itr = leaf_vector_[i]->cbegin (); neighbor_itr != leaf_vector_[i]->cend (); ++neighbor_itr, ++out_idx)
+      neighbor_indices[out_idx] = leaf_index_map.find (static_cast<const LeafContainerT*> (*neighbor_itr))->second;
+  }
+}
+
 #define PCL_INSTANTIATE_OctreePointCloudAdjacency(T) template class PCL_EXPORTS pcl::octree::OctreePointCloudAdjacency<T>;
 
 #endif
@@ -428,6 +428,15 @@ namespace pcl
         void
         serializeNewLeafs (std::vector<LeafContainerT*>& leaf_container_vector_arg);
 
+        /** \brief Outputs the keys of all leaf nodes that were added to or removed from the current octree buffer with respect to the previous buffer.
+         *  \note In contrast to serializeNewLeafs(..), the previous buffer is left untouched. Call this method before serializeNewLeafs(..) or serializeTree(..), as those delete unused nodes of the previous buffer.
+         *  \param new_leaf_keys_arg: keys of leaf nodes that exist in the current buffer only
+         *  \param removed_leaf_keys_arg: keys of leaf nodes that exist in the previous buffer only
+         * */
+        void
+        serializeChangedLeafKeys (std::vector<OctreeKey>& new_leaf_keys_arg,
+                                  std::vector<OctreeKey>& removed_leaf_keys_arg) const;
+
         /** \brief Deserialize a binary octree description vector and create a corresponding octree structure. Leaf nodes are initialized with getDataTByKey(..).
          *  \param binary_tree_in_arg: reference to input vector for reading binary tree structure.
          *  \param do_XOR_decoding_arg: select if binary tree structure is based on current octree (false) of based on a XOR comparison between current and previous octree
@@ -798,6 +807,30 @@ namespace pcl
                                 bool do_XOR_encoding_arg = false,
                                 bool new_leafs_filter_arg = false);
 
+        /** \brief Recursively explore both octree buffers and output the keys of leaf nodes that exist in only one of them.
+         *  \param branch_arg: current branch node
+         *  \param key_arg: reference to an octree key
+         *  \param new_leaf_keys_arg: keys of leaf nodes that exist in the current buffer only
+         *  \param removed_leaf_keys_arg: keys of leaf nodes that exist in the previous buffer only
+         **/
+        void
+        serializeChangedLeafKeysRecursive (const BranchNode* branch_arg,
+                                           OctreeKey& key_arg,
+                                           std::vector<OctreeKey>& new_leaf_keys_arg,
+                                           std::vector<OctreeKey>& removed_leaf_keys_arg) const;
+
+        /** \brief Recursively output the keys of all leaf nodes below a branch node in a given buffer.
+         *  \param branch_arg: current branch node
+         *  \param buffer_selector_arg: buffer selector
+         *  \param key_arg: reference to an octree key
+         *  \param leaf_keys_arg: output vector of leaf node keys
+         **/
+        void
+        serializeLeafKeysRecursive (const BranchNode* branch_arg,
+                                    unsigned char buffer_selector_arg,
+                                    OctreeKey& key_arg,
+                                    std::vector<OctreeKey>& leaf_keys_arg) const;
+
         /** \brief Rebuild an octree based on binary XOR octree description and DataT objects for leaf node initialization.
          *  \param branch_arg: current branch node
          *  \param depth_mask_arg: depth mask used for octree key analysis and branch depth indicator
@@ -44,8 +44,10 @@
 #include <pcl/octree/octree_pointcloud.h>
 #include <pcl/octree/octree_pointcloud_adjacency_container.h>
 
+#include <algorithm>
 #include <set>
 #include <list>
+#include <vector>
 
 namespace pcl
 {
@@ -136,8 +138,10 @@ namespace pcl
 
         /** \brief Constructor.
           *
-          * \param[in] resolution_arg Octree resolution at lowest octree level (voxel size) */
-        OctreePointCloudAdjacency (const double resolution_arg);
+          * \param[in] resolution_arg Octree resolution at lowest octree level (voxel size)
+          * \param[in] nr_threads the number of hardware threads to use for the adjacency computation
+          * (0 sets the value back to automatic) */
+        OctreePointCloudAdjacency (const double resolution_arg, unsigned int nr_threads = 0);
 
         /** \brief Empty class destructor. */
         virtual ~OctreePointCloudAdjacency ()
@@ -150,6 +154,26 @@ namespace pcl
         void
         addPointsFromInputCloud ();
 
+        /** \brief Adds the points of the current input cloud to an already populated octree.
+          *
+          * Only the voxels touched by the new points are visited: newly created leaves get their data computed and
+          * their neighbors filled in, and existing leaves adjacent to them are linked back to them. Leaves which
+          * already existed only receive the new points through addPoint (), their computeData () is not called
+          * again. New leaves are appended to the leaf vector, so leaves [old size (), size ()) are the new ones.
+          *
+          * The bounding box is grown as needed to fit the new points. If the octree is empty this is equivalent to
+          * addPointsFromInputCloud ().
+          *
+          * \note Call setInputCloud () with the new points (and optionally indices) before calling this. */
+        void
+        addNewPointsFromInputCloud ();
+
+        /** \brief Set the number of threads used to compute the leaf data and the voxel adjacency.
+          *
+          * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic) */
+        inline void
+        setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
+
         /** \brief Gets the leaf container for a given point.
           *
           * \param[in] point_arg Point to search for
@@ -167,6 +191,17 @@ namespace pcl
         void
         computeVoxelAdjacencyGraph (VoxelAdjacencyList &voxel_adjacency_graph);
 
+        /** \brief Exports the voxel adjacency in compressed sparse row (CSR) form.
+          *
+          * Voxels are numbered by their position in the leaf vector (see begin (), at ()). The neighbors of voxel i
+          * are neighbor_indices[row_offsets[i]] ... neighbor_indices[row_offsets[i + 1] - 1]. As for the neighbor
+          * lists stored in the leaf containers, every voxel is reported as its own neighbor.
+          *
+          * \param[out] row_offsets offsets into neighbor_indices, of size size () + 1
+          * \param[out] neighbor_indices concatenated neighbor indices of all voxels */
+        void
+        getAdjacencyCSR (std::vector<int> &row_offsets, std::vector<int> &neighbor_indices) const;
+
         /** \brief Sets a point transform (and inverse) used to transform the space of the input cloud.
           *
           * This is useful for changing how adjacency is calculated - such as relaxing the adjacency criterion for
@@ -226,6 +261,7 @@ namespace pcl
         using OctreePointCloudT::addPointToCloud;
 
         using OctreePointCloudT::input_;
+        using OctreePointCloudT::indices_;
         using OctreePointCloudT::resolution_;
         using OctreePointCloudT::min_x_;
         using OctreePointCloudT::min_y_;
@@ -239,6 +275,9 @@ namespace pcl
 
         boost::function<void (PointT &p)> transform_func_;
 
+        /** \brief The number of threads the scheduler should use. */
+        unsigned int threads_;
+
     };
 
   }
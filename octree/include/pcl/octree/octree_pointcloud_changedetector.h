@@ -41,6 +41,7 @@
 
 #include <pcl/octree/octree_pointcloud.h>
 #include <pcl/octree/octree2buf_base.h>
+#include <pcl/common/common.h>
 
 namespace pcl
 {
@@ -51,6 +52,9 @@ namespace pcl
     /** \brief @b Octree pointcloud change detector class
      *  \note This pointcloud octree class generate an octrees from a point cloud (zero-copy). It allows to detect new leaf nodes and serialize their point indices
      *  \note The octree pointcloud is initialized with its voxel resolution. Its bounding box is automatically adjusted or can be predefined.
+     *  \note For streaming use, call switchBuffers(), setInputCloud(..) and addPointsFromInputCloud() once per frame and
+     *  \note query the changes with getChangedVoxelCenters(..) / getPointIndicesFromNewVoxels(..). Both octree buffers
+     *  \note as well as the internal work vectors are reused from frame to frame.
      *  \note
      *  \note typename: PointT: type of point used in pointcloud
      *  \ingroup octree
@@ -68,12 +72,23 @@ namespace pcl
 
       public:
 
+        typedef OctreePointCloud<PointT, LeafContainerT, BranchContainerT,
+            Octree2BufBase<LeafContainerT, BranchContainerT> > OctreePointCloudT;
+        typedef typename OctreePointCloudT::AlignedPointTVector AlignedPointTVector;
+
         /** \brief Constructor.
          *  \param resolution_arg:  octree resolution at lowest octree level
+         *  \param nr_threads: the number of hardware threads used to compute point keys (0 sets the value back to automatic)
          * */
-        OctreePointCloudChangeDetector (const double resolution_arg) :
+        OctreePointCloudChangeDetector (const double resolution_arg, unsigned int nr_threads = 0) :
             OctreePointCloud<PointT, LeafContainerT, BranchContainerT,
-                Octree2BufBase<LeafContainerT, BranchContainerT> > (resolution_arg)
+                Octree2BufBase<LeafContainerT, BranchContainerT> > (resolution_arg),
+            threads_ (nr_threads),
+            point_indices_ (),
+            point_keys_ (),
+            leaf_containers_ (),
+            new_leaf_keys_ (),
+            removed_leaf_keys_ ()
         {
         }
 
@@ -82,6 +97,77 @@ namespace pcl
         {
         }
 
+        /** \brief Set the number of threads used to compute the octree keys of the input points.
+         *  \param nr_threads: the number of hardware threads to use (0 sets the value back to automatic)
+         */
+        inline void
+        setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
+
+        /** \brief Add points from input point cloud to the current octree buffer.
+         *  \note The bounding box is adjusted to the whole cloud at once, which allows the octree keys to be computed
+         *  \note in parallel before the points are inserted. This hides OctreePointCloud::addPointsFromInputCloud().
+         */
+        void
+        addPointsFromInputCloud ()
+        {
+          // leaf expansion depends on the insertion order - use the sequential implementation
+          if (this->dynamic_depth_enabled_)
+          {
+            OctreePointCloudT::addPointsFromInputCloud ();
+            return;
+          }
+
+          point_indices_.clear ();
+          if (this->indices_)
+          {
+            point_indices_.reserve (this->indices_->size ());
+            for (std::vector<int>::const_iterator current = this->indices_->begin (); current != this->indices_->end (); ++current)
+            {
+              assert( (*current>=0) && (*current < static_cast<int> (this->input_->points.size ())));
+              if (isFinite (this->input_->points[*current]))
+                point_indices_.push_back (*current);
+            }
+          }
+          else
+          {
+            point_indices_.reserve (this->input_->points.size ());
+            for (size_t i = 0; i < this->input_->points.size (); ++i)
+            {
+              if (isFinite (this->input_->points[i]))
+                point_indices_.push_back (static_cast<int> (i));
+            }
+          }
+
+          const int nr_points = static_cast<int> (point_indices_.size ());
+          if (nr_points == 0)
+            return;
+
+          // grow the bounding box to the extent of the cloud, afterwards the octree keys do not change anymore
+          Eigen::Vector4f min_pt, max_pt;
+          pcl::getMinMax3D (*this->input_, point_indices_, min_pt, max_pt);
+          PointT corner;
+          corner.x = min_pt[0]; corner.y = min_pt[1]; corner.z = min_pt[2];
+          this->adoptBoundingBoxToPoint (corner);
+          corner.x = max_pt[0]; corner.y = max_pt[1]; corner.z = max_pt[2];
+          this->adoptBoundingBoxToPoint (corner);
+
+          point_keys_.resize (nr_points);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(threads_)
+#endif
+          for (int i = 0; i < nr_points; ++i)
+            this->genOctreeKeyforPoint (this->input_->points[point_indices_[i]], point_keys_[i]);
+
+          LeafContainerT* leaf_container = 0;
+          for (int i = 0; i < nr_points; ++i)
+          {
+            // consecutive points of a scan often fall into the same voxel
+            if (!leaf_container || !(point_keys_[i] == point_keys_[i - 1]))
+              leaf_container = this->createLeaf (point_keys_[i]);
+            leaf_container->addPointIndex (point_indices_[i]);
+          }
+        }
+
         /** \brief Get a indices from all leaf nodes that did not exist in previous buffer.
          * \param indicesVector_arg: results are written to this vector of int indices
          * \param minPointsPerLeaf_arg: minimum amount of points required within leaf node to become serialized.
@@ -91,13 +177,17 @@ namespace pcl
             const int minPointsPerLeaf_arg = 0)
         {
 
-          std::vector<OctreeContainerPointIndices*> leaf_containers;
-          this->serializeNewLeafs (leaf_containers);
+          this->serializeNewLeafs (leaf_containers_);
+
+          typename std::vector<LeafContainerT*>::const_iterator it;
+          typename std::vector<LeafContainerT*>::const_iterator it_end = leaf_containers_.end();
 
-          std::vector<OctreeContainerPointIndices*>::iterator it;
-          std::vector<OctreeContainerPointIndices*>::const_iterator it_end = leaf_containers.end();
+          size_t nr_indices = indicesVector_arg.size ();
+          for (it=leaf_containers_.begin(); it!=it_end; ++it)
+            nr_indices += (*it)->getSize ();
+          indicesVector_arg.reserve (nr_indices);
 
-          for (it=leaf_containers.begin(); it!=it_end; ++it)
+          for (it=leaf_containers_.begin(); it!=it_end; ++it)
           {
             if (static_cast<int> ((*it)->getSize ()) >= minPointsPerLeaf_arg)
               (*it)->getPointIndices(indicesVector_arg);
@@ -105,6 +195,47 @@ namespace pcl
 
           return (indicesVector_arg.size ());
         }
+
+        /** \brief Get the centers of all voxels that were added or removed with respect to the previous buffer.
+         * \note Must be called before getPointIndicesFromNewVoxels(..), which deletes the unused nodes of the previous buffer.
+         * \param new_voxel_centers_arg: centers of voxels that did not exist in the previous buffer
+         * \param removed_voxel_centers_arg: centers of voxels of the previous buffer that do not exist anymore
+         * \return number of changed voxels
+         */
+        std::size_t
+        getChangedVoxelCenters (AlignedPointTVector &new_voxel_centers_arg,
+                                AlignedPointTVector &removed_voxel_centers_arg)
+        {
+          this->serializeChangedLeafKeys (new_leaf_keys_, removed_leaf_keys_);
+
+          new_voxel_centers_arg.resize (new_leaf_keys_.size ());
+          for (size_t i = 0; i < new_leaf_keys_.size (); ++i)
+            this->genLeafNodeCenterFromOctreeKey (new_leaf_keys_[i], new_voxel_centers_arg[i]);
+
+          removed_voxel_centers_arg.resize (removed_leaf_keys_.size ());
+          for (size_t i = 0; i < removed_leaf_keys_.size (); ++i)
+            this->genLeafNodeCenterFromOctreeKey (removed_leaf_keys_[i], removed_voxel_centers_arg[i]);
+
+          return (new_leaf_keys_.size () + removed_leaf_keys_.size ());
+        }
+
+      protected:
+        /** \brief The number of threads the scheduler should use. */
+        unsigned int threads_;
+
+      private:
+        /** \brief Finite input point indices of the current frame. */
+        std::vector<int> point_indices_;
+
+        /** \brief Octree keys of the finite input points of the current frame. */
+        std::vector<OctreeKey> point_keys_;
+
+        /** \brief New leaf containers of the current frame. */
+        std::vector<LeafContainerT*> leaf_containers_;
+
+        /** \brief Keys of the new and removed leaf nodes of the current frame. */
+        std::vector<OctreeKey> new_leaf_keys_;
+        std::vector<OctreeKey> removed_leaf_keys_;
     };
   }
 }
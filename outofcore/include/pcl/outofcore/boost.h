@@ -52,6 +52,7 @@
 #include <boost/random/mersenne_twister.hpp>
 #include <boost/random/uniform_int.hpp>
 #include <boost/random/bernoulli_distribution.hpp>
+#include <boost/random/uniform_01.hpp>
 #include <boost/foreach.hpp>
 #include <boost/lexical_cast.hpp>
 
@@ -4,6 +4,10 @@
 
 #include <cassert>
 #include <list>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
 
 template<typename T>
 class LRUCacheItem
@@ -23,6 +27,17 @@ public:
   size_t timestamp;
 };
 
+/** \brief Least-recently-used cache with a byte budget.
+  *
+  * Lookups are hashed (O(1) on average) and every public method is guarded by
+  * an internal mutex, so a single cache can be shared between query threads and
+  * a loader thread. The capacity is expressed in the units returned by
+  * CacheItemT::sizeOf (), which should be bytes.
+  *
+  * Entries can be pinned while a consumer still works on them; pinned entries
+  * are never evicted. References returned by get () and tailItem () are only
+  * stable while the entry is pinned or while the caller serializes all access.
+  */
 template<typename KeyT, typename CacheItemT>
 class LRUCache
 {
@@ -31,11 +46,24 @@ public:
   typedef std::list<KeyT> KeyIndex;
   typedef typename KeyIndex::iterator KeyIndexIterator;
 
-  typedef std::map<KeyT, std::pair<CacheItemT, typename KeyIndex::iterator> > Cache;
+  struct CacheEntry
+  {
+    CacheEntry (const CacheItemT& value, const KeyIndexIterator& it, size_t item_size) :
+      item (value), key_it (it), size (item_size), pin_count (0)
+    {
+    }
+
+    CacheItemT item;
+    KeyIndexIterator key_it;
+    size_t size;
+    unsigned int pin_count;
+  };
+
+  typedef boost::unordered_map<KeyT, CacheEntry> Cache;
   typedef typename Cache::iterator CacheIterator;
 
   LRUCache (size_t c) :
-      capacity_ (c), size_ (0)
+      capacity_ (c), size_ (0), hits_ (0), misses_ (0), evictions_ (0), key_index_ (), cache_ (), mutex_ ()
   {
     assert(capacity_ != 0);
   }
@@ -43,72 +71,95 @@ public:
   bool
   hasKey (const KeyT& k)
   {
+    boost::mutex::scoped_lock lock (mutex_);
     return (cache_.find (k) != cache_.end ());
   }
 
   CacheItemT&
   get (const KeyT& k)
   {
+    boost::mutex::scoped_lock lock (mutex_);
+
     // Get existing key
     const CacheIterator it = cache_.find (k);
     assert(it != cache_.end ());
+    ++hits_;
 
     // Move key to MRU key index
-    key_index_.splice (key_index_.end (), key_index_, (*it).second.second);
+    key_index_.splice (key_index_.end (), key_index_, it->second.key_it);
 
     // Return the retrieved item
-    return it->second.first;
+    return it->second.item;
   }
 
-  void
-  touch (const KeyT& key)
+  /** \brief Copy the item stored under key into value and mark it most recently used.
+    * \return false (and count a miss) if the key is not cached
+    */
+  bool
+  find (const KeyT& key, CacheItemT& value)
   {
-    // Get existing key
+    boost::mutex::scoped_lock lock (mutex_);
+
     const CacheIterator it = cache_.find (key);
-    assert(it != cache_.end ());
+    if (it == cache_.end ())
+    {
+      ++misses_;
+      return (false);
+    }
 
-    // Move key to MRU key index
-    key_index_.splice (key_index_.end (), key_index_, it->second.second);
+    ++hits_;
+    key_index_.splice (key_index_.end (), key_index_, it->second.key_it);
+    value = it->second.item;
+    return (true);
+  }
+
+  void
+  touch (const KeyT& key)
+  {
+    boost::mutex::scoped_lock lock (mutex_);
+    touchUnlocked (key);
   }
 
   // Record a fresh key-value pair in the cache
   bool
   insert (const KeyT& key, const CacheItemT& value)
   {
+    boost::mutex::scoped_lock lock (mutex_);
+
     if (cache_.find (key) != cache_.end ())
     {
-      touch (key);
+      touchUnlocked (key);
       return true;
     }
 
-    size_t size = size_;
     size_t item_size = value.sizeOf ();
-    int evict_count = 0;
-
-    // Get LRU key iterator
-    KeyIndexIterator key_it = key_index_.begin ();
+    if (item_size > capacity_)
+      return false;
 
-    while (size + item_size >= capacity_)
+    // Walk from the LRU end and collect unpinned victims until the item fits
+    std::vector<KeyIndexIterator> victims;
+    size_t size = size_;
+    for (KeyIndexIterator key_it = key_index_.begin (); size + item_size > capacity_; ++key_it)
     {
-      const CacheIterator cache_it = cache_.find (*key_it);
+      if (key_it == key_index_.end ())
+        return false;
 
-      // Get tail item (Least Recently Used)
-      size_t tail_timestamp = cache_it->second.first.timestamp;
-      size_t tail_size = cache_it->second.first.sizeOf ();
+      const CacheIterator cache_it = cache_.find (*key_it);
+      if (cache_it->second.pin_count > 0)
+        continue;
 
       // Check timestamp to see if we've completely filled the cache in one go
-      if (value.timestamp == tail_timestamp)
-      {
+      if (value.timestamp == cache_it->second.item.timestamp)
         return false;
-      }
 
-      size -= tail_size;
-      key_it++;
-      evict_count++;
+      size -= cache_it->second.size;
+      victims.push_back (key_it);
     }
 
     // Evict enough items to make room for the new item
-    evict (evict_count);
+    for (size_t i = 0; i < victims.size (); ++i)
+      eraseUnlocked (victims[i]);
+    evictions_ += victims.size ();
 
     size_ += item_size;
 
@@ -116,22 +167,136 @@ public:
     KeyIndexIterator it = key_index_.insert (key_index_.end (), key);
 
     // Add to cache
-    cache_.insert (std::make_pair (key, std::make_pair (value, it)));
+    cache_.insert (std::make_pair (key, CacheEntry (value, it, item_size)));
 
     return true;
   }
 
+  /** \brief Remove key from the cache regardless of its position in the LRU order.
+    * \return false if the key is not cached or is currently pinned
+    */
+  bool
+  erase (const KeyT& key)
+  {
+    boost::mutex::scoped_lock lock (mutex_);
+
+    const CacheIterator it = cache_.find (key);
+    if (it == cache_.end () || it->second.pin_count > 0)
+      return (false);
+
+    eraseUnlocked (it->second.key_it);
+    return (true);
+  }
+
+  /** \brief Remove every unpinned entry from the cache. */
+  void
+  clear ()
+  {
+    boost::mutex::scoped_lock lock (mutex_);
+
+    KeyIndexIterator key_it = key_index_.begin ();
+    while (key_it != key_index_.end ())
+    {
+      KeyIndexIterator next = key_it;
+      ++next;
+      if (cache_.find (*key_it)->second.pin_count == 0)
+        eraseUnlocked (key_it);
+      key_it = next;
+    }
+  }
+
+  /** \brief Protect key from eviction until a matching unpin (); pins nest.
+    * \return false if the key is not cached
+    */
+  bool
+  pin (const KeyT& key)
+  {
+    boost::mutex::scoped_lock lock (mutex_);
+
+    const CacheIterator it = cache_.find (key);
+    if (it == cache_.end ())
+      return (false);
+
+    ++it->second.pin_count;
+    return (true);
+  }
+
+  bool
+  unpin (const KeyT& key)
+  {
+    boost::mutex::scoped_lock lock (mutex_);
+
+    const CacheIterator it = cache_.find (key);
+    if (it == cache_.end () || it->second.pin_count == 0)
+      return (false);
+
+    --it->second.pin_count;
+    return (true);
+  }
+
   void
   setCapacity (size_t capacity)
   {
+    boost::mutex::scoped_lock lock (mutex_);
     capacity_ = capacity;
   }
 
+  size_t
+  getCapacity () const
+  {
+    boost::mutex::scoped_lock lock (mutex_);
+    return (capacity_);
+  }
+
+  /** \brief Total size of all cached items, in the units of CacheItemT::sizeOf () */
+  size_t
+  getSize () const
+  {
+    boost::mutex::scoped_lock lock (mutex_);
+    return (size_);
+  }
+
+  size_t
+  getNumberOfItems () const
+  {
+    boost::mutex::scoped_lock lock (mutex_);
+    return (cache_.size ());
+  }
+
+  size_t
+  getHits () const
+  {
+    boost::mutex::scoped_lock lock (mutex_);
+    return (hits_);
+  }
+
+  size_t
+  getMisses () const
+  {
+    boost::mutex::scoped_lock lock (mutex_);
+    return (misses_);
+  }
+
+  size_t
+  getEvictions () const
+  {
+    boost::mutex::scoped_lock lock (mutex_);
+    return (evictions_);
+  }
+
+  void
+  resetStatistics ()
+  {
+    boost::mutex::scoped_lock lock (mutex_);
+    hits_ = misses_ = evictions_ = 0;
+  }
+
   CacheItemT&
   tailItem ()
   {
+    boost::mutex::scoped_lock lock (mutex_);
     const CacheIterator it = cache_.find (key_index_.front ());
-    return it->second.first;
+    return it->second.item;
   }
 
   size_t
@@ -140,39 +305,75 @@ public:
     return value.sizeOf ();
   }
 
-  // Evict the least-recently-used item from the cache
+  // Evict the least-recently-used unpinned items from the cache
   bool
   evict (int item_count=1)
   {
+    boost::mutex::scoped_lock lock (mutex_);
+
+    KeyIndexIterator key_it = key_index_.begin ();
     for (int i=0; i < item_count; i++)
     {
-      if (key_index_.empty ())
-        return false;
+      // Skip over pinned items
+      while (key_it != key_index_.end () && cache_.find (*key_it)->second.pin_count > 0)
+        ++key_it;
 
-      // Get LRU item
-      const CacheIterator it = cache_.find (key_index_.front ());
-      assert(it != cache_.end());
+      if (key_it == key_index_.end ())
+        return false;
 
-      // Remove LRU item from cache and key index
-      size_ -= it->second.first.sizeOf ();
-      cache_.erase (it);
-      key_index_.pop_front ();
+      KeyIndexIterator next = key_it;
+      ++next;
+      eraseUnlocked (key_it);
+      ++evictions_;
+      key_it = next;
     }
 
     return true;
   }
 
-  // Cache capacity in kilobytes
+  // Cache capacity in bytes
   size_t capacity_;
 
-  // Current cache size in kilobytes
+  // Current cache size in bytes
   size_t size_;
 
+  // Number of successful and failed lookups and of evicted items
+  size_t hits_;
+  size_t misses_;
+  size_t evictions_;
+
   // LRU key index LRU[0] ... MRU[N]
   KeyIndex key_index_;
 
   // LRU cache
   Cache cache_;
+
+private:
+
+  void
+  touchUnlocked (const KeyT& key)
+  {
+    // Get existing key
+    const CacheIterator it = cache_.find (key);
+    assert(it != cache_.end ());
+
+    // Move key to MRU key index
+    key_index_.splice (key_index_.end (), key_index_, it->second.key_it);
+  }
+
+  void
+  eraseUnlocked (const KeyIndexIterator& key_it)
+  {
+    const CacheIterator it = cache_.find (*key_it);
+    assert(it != cache_.end ());
+
+    size_ -= it->second.size;
+    cache_.erase (it);
+    key_index_.erase (key_it);
+  }
+
+  // Guards all members above
+  mutable boost::mutex mutex_;
 };
 
 #endif //__PCL_OUTOFCORE_LRU_CACHE__
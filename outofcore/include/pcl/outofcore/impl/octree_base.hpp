@@ -55,6 +55,8 @@
 #include <sstream>
 #include <string>
 #include <exception>
+#include <algorithm>
+#include <cmath>
 
 namespace pcl
 {
@@ -80,6 +82,10 @@ namespace pcl
       , metadata_ (new OutofcoreOctreeBaseMetadata ())
       , sample_percent_ (0.125)
       , lod_filter_ptr_ (new pcl::RandomSample<pcl::PCLPointCloud2> ())
+      , threads_ (0)
+      , node_cache_ ()
+      , node_cache_mutex_ ()
+      , node_cache_timestamp_ (0)
     {
       //validate the root filename
       if (!this->checkExtension (root_name))
@@ -108,6 +114,10 @@ namespace pcl
       , metadata_ (new OutofcoreOctreeBaseMetadata ())
       , sample_percent_ (0.125)
       , lod_filter_ptr_ (new pcl::RandomSample<pcl::PCLPointCloud2> ())
+      , threads_ (0)
+      , node_cache_ ()
+      , node_cache_mutex_ ()
+      , node_cache_timestamp_ (0)
     {
       //Enlarge the bounding box to a cube so our voxels will be cubes
       Eigen::Vector3d tmp_min = min;
@@ -130,6 +140,10 @@ namespace pcl
       , metadata_ (new OutofcoreOctreeBaseMetadata ())
       , sample_percent_ (0.125)
       , lod_filter_ptr_ (new pcl::RandomSample<pcl::PCLPointCloud2> ())
+      , threads_ (0)
+      , node_cache_ ()
+      , node_cache_mutex_ ()
+      , node_cache_timestamp_ (0)
     {
       //Create a new outofcore tree
       this->init (max_depth, min, max, root_node_name, coord_sys);
@@ -210,8 +224,16 @@ namespace pcl
       boost::unique_lock < boost::shared_mutex > lock (read_write_mutex_);
 
       const bool _FORCE_BB_CHECK = true;
-      
-      uint64_t pt_added = root_node_->addDataToLeaf (p, _FORCE_BB_CHECK);
+
+      std::vector<float> xyz (3 * p.size ());
+      for (size_t i = 0; i < p.size (); i++)
+      {
+        xyz[3 * i + 0] = p[i].x;
+        xyz[3 * i + 1] = p[i].y;
+        xyz[3 * i + 2] = p[i].z;
+      }
+
+      uint64_t pt_added = buildTree (p, xyz, BUILD_LEAVES, _FORCE_BB_CHECK);
 
       assert (p.size () == pt_added);
 
@@ -231,7 +253,17 @@ namespace pcl
     template<typename ContainerT, typename PointT> boost::uint64_t
     OutofcoreOctreeBase<ContainerT, PointT>::addPointCloud (pcl::PCLPointCloud2::Ptr &input_cloud, const bool skip_bb_check)
     {
-      uint64_t pt_added = this->root_node_->addPointCloud (input_cloud, skip_bb_check) ;
+      // The recursive insertion refuses to insert without the bounding box check; keep that behavior
+      if (skip_bb_check)
+        return (this->root_node_->addPointCloud (input_cloud, skip_bb_check));
+
+      boost::unique_lock < boost::shared_mutex > lock (read_write_mutex_);
+
+      std::vector<float> xyz;
+      if (!getXYZ (*input_cloud, xyz))
+        return (0);
+
+      uint64_t pt_added = buildTree (input_cloud, xyz, BUILD_LEAVES, false);
 //      assert (input_cloud->width*input_cloud->height == pt_added);
       return (pt_added);
     }
@@ -244,7 +276,16 @@ namespace pcl
     {
       // Lock the tree while writing
       boost::unique_lock < boost::shared_mutex > lock (read_write_mutex_);
-      boost::uint64_t pt_added = root_node_->addDataToLeaf_and_genLOD (point_cloud->points, false);
+
+      std::vector<float> xyz (3 * point_cloud->points.size ());
+      for (size_t i = 0; i < point_cloud->points.size (); i++)
+      {
+        xyz[3 * i + 0] = point_cloud->points[i].x;
+        xyz[3 * i + 1] = point_cloud->points[i].y;
+        xyz[3 * i + 2] = point_cloud->points[i].z;
+      }
+
+      boost::uint64_t pt_added = buildTree (point_cloud->points, xyz, BUILD_SAMPLED_LOD, true);
       return (pt_added);
     }
 
@@ -255,11 +296,14 @@ namespace pcl
     {
       // Lock the tree while writing
       boost::unique_lock < boost::shared_mutex > lock (read_write_mutex_);
-      boost::uint64_t pt_added = root_node_->addPointCloud_and_genLOD (input_cloud);
+
+      std::vector<float> xyz;
+      if (!getXYZ (*input_cloud, xyz))
+        return (0);
+
+      boost::uint64_t pt_added = buildTree (input_cloud, xyz, BUILD_PARTITIONED_LOD, false);
       
       PCL_DEBUG ("[pcl::outofcore::OutofcoreOctreeBase::%s] Points added %lu, points in input cloud, %lu\n",__FUNCTION__, pt_added, input_cloud->width*input_cloud->height );
- 
-      assert ( input_cloud->width*input_cloud->height == pt_added );
 
       return (pt_added);
     }
@@ -271,12 +315,273 @@ namespace pcl
     {
       // Lock the tree while writing
       boost::unique_lock < boost::shared_mutex > lock (read_write_mutex_);
-      boost::uint64_t pt_added = root_node_->addDataToLeaf_and_genLOD (src, false);
+
+      std::vector<float> xyz (3 * src.size ());
+      for (size_t i = 0; i < src.size (); i++)
+      {
+        xyz[3 * i + 0] = src[i].x;
+        xyz[3 * i + 1] = src[i].y;
+        xyz[3 * i + 2] = src[i].z;
+      }
+
+      boost::uint64_t pt_added = buildTree (src, xyz, BUILD_SAMPLED_LOD, true);
       return (pt_added);
     }
 
     ////////////////////////////////////////////////////////////////////////////////
 
+    template<typename ContainerT, typename PointT> template<typename InputT> boost::uint64_t
+    OutofcoreOctreeBase<ContainerT, PointT>::buildTree (const InputT& input, const std::vector<float>& xyz, const BuildMode mode, const bool check_bb)
+    {
+      const int nr_points = static_cast<int> (xyz.size () / 3);
+      const boost::uint64_t max_depth = this->getDepth ();
+
+      // Drop invalid points; octant_ids doubles as the validity mask here
+      std::vector<unsigned char> octant_ids (nr_points);
+#ifdef _OPENMP
+#pragma omp parallel for shared (octant_ids) num_threads(threads_)
+#endif
+      for (int i = 0; i < nr_points; i++)
+      {
+        PointT pt;
+        pt.x = xyz[3 * i + 0];
+        pt.y = xyz[3 * i + 1];
+        pt.z = xyz[3 * i + 2];
+        octant_ids[i] = pcl_isfinite (pt.x) && pcl_isfinite (pt.y) && pcl_isfinite (pt.z) &&
+                        (!check_bb || root_node_->pointInBoundingBox (pt));
+      }
+
+      std::vector<int> indices;
+      indices.reserve (nr_points);
+      for (int i = 0; i < nr_points; i++)
+      {
+        if (octant_ids[i])
+          indices.push_back (i);
+      }
+
+      if (indices.size () != static_cast<size_t> (nr_points))
+        PCL_WARN ("[pcl::outofcore::OutofcoreOctreeBase::buildTree] Dropped %d points which are not finite or not within the bounding box\n", nr_points - static_cast<int> (indices.size ()));
+
+      std::vector<int> sorted (indices.size ());
+      std::vector<BuildRange> level;
+      if (!indices.empty ())
+        level.push_back (BuildRange (root_node_, 0, indices.size ()));
+
+      boost::uint64_t points_added = 0;
+      for (boost::uint64_t depth = 0; !level.empty (); depth++)
+      {
+        const bool at_max_depth = (depth == max_depth);
+
+        // Write this level's node files from the worker pool
+        if (at_max_depth || mode != BUILD_LEAVES)
+        {
+          std::vector<boost::uint32_t> seeds (level.size ());
+          {
+            boost::mutex::scoped_lock lock (OutofcoreNodeType::rng_mutex_);
+            for (size_t r = 0; r < level.size (); r++)
+              seeds[r] = static_cast<boost::uint32_t> (OutofcoreNodeType::rand_gen_ ());
+          }
+
+          boost::uint64_t level_points = 0;
+#ifdef _OPENMP
+#pragma omp parallel for shared (level, indices, seeds) reduction (+:level_points) schedule (dynamic, 1) num_threads(threads_)
+#endif
+          for (int r = 0; r < static_cast<int> (level.size ()); r++)
+            level_points += storeBuildRange (input, indices, level[r], depth, mode, seeds[r]);
+
+          if (level_points > 0)
+            incrementPointsInLOD (depth, level_points);
+
+          if (at_max_depth || mode == BUILD_PARTITIONED_LOD)
+            points_added += level_points;
+        }
+
+        if (at_max_depth)
+          break;
+
+        // Split the level into chunks of points and compute the child octant of every point
+        const size_t chunk_size = 16384;
+        std::vector<std::pair<size_t, size_t> > chunks;
+        for (size_t r = 0; r < level.size (); r++)
+        {
+          for (size_t begin = level[r].begin; begin < level[r].end; begin += chunk_size)
+            chunks.push_back (std::make_pair (r, begin));
+        }
+
+#ifdef _OPENMP
+#pragma omp parallel for shared (chunks, level, indices, octant_ids) schedule (dynamic, 1) num_threads(threads_)
+#endif
+        for (int c = 0; c < static_cast<int> (chunks.size ()); c++)
+        {
+          const BuildRange& range = level[chunks[c].first];
+          const Eigen::Vector3d mid_xyz = range.node->node_metadata_->getVoxelCenter ();
+          const size_t end = std::min (chunks[c].second + chunk_size, range.end);
+          for (size_t i = chunks[c].second; i < end; i++)
+          {
+            const float* pt = &xyz[3 * indices[i]];
+            octant_ids[indices[i]] = static_cast<unsigned char> (((pt[2] >= mid_xyz[2]) << 2) | ((pt[1] >= mid_xyz[1]) << 1) | ((pt[0] >= mid_xyz[0]) << 0));
+          }
+        }
+
+        // Stable counting sort of every range by octant
+        std::vector<size_t> octant_begin (9 * level.size ());
+#ifdef _OPENMP
+#pragma omp parallel for shared (level, indices, sorted, octant_ids, octant_begin) schedule (dynamic, 1) num_threads(threads_)
+#endif
+        for (int r = 0; r < static_cast<int> (level.size ()); r++)
+        {
+          const BuildRange& range = level[r];
+          size_t* bounds = &octant_begin[9 * r];
+
+          size_t counts[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+          for (size_t i = range.begin; i < range.end; i++)
+            counts[octant_ids[indices[i]]]++;
+
+          bounds[0] = range.begin;
+          for (int o = 0; o < 8; o++)
+            bounds[o + 1] = bounds[o] + counts[o];
+
+          size_t offsets[8];
+          std::copy (bounds, bounds + 8, offsets);
+          for (size_t i = range.begin; i < range.end; i++)
+            sorted[offsets[octant_ids[indices[i]]]++] = indices[i];
+          std::copy (sorted.begin () + range.begin, sorted.begin () + range.end, indices.begin () + range.begin);
+        }
+
+        // Create the children sequentially, they write their metadata on creation
+        std::vector<BuildRange> next_level;
+        for (size_t r = 0; r < level.size (); r++)
+        {
+          OutofcoreNodeType* node = level[r].node;
+          const size_t* bounds = &octant_begin[9 * r];
+
+          if (bounds[0] != bounds[8] && node->hasUnloadedChildren ())
+            node->loadChildren (false);
+
+          for (size_t o = 0; o < 8; o++)
+          {
+            if (bounds[o] == bounds[o + 1])
+              continue;
+
+            if (!node->children_[o])
+              node->createChild (o);
+            next_level.push_back (BuildRange (node->children_[o], bounds[o], bounds[o + 1]));
+          }
+        }
+        level.swap (next_level);
+      }
+
+      return (points_added);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ContainerT, typename PointT> template<typename InputT> boost::uint64_t
+    OutofcoreOctreeBase<ContainerT, PointT>::storeBuildRange (const InputT& input, std::vector<int>& indices, BuildRange& range, const boost::uint64_t depth, const BuildMode mode, const boost::uint32_t seed)
+    {
+      const size_t count = range.end - range.begin;
+      std::vector<int> node_indices;
+
+      if (depth == this->getDepth () || (mode == BUILD_PARTITIONED_LOD && count < 8))
+      {
+        // Everything that reaches this node is stored here
+        node_indices.assign (indices.begin () + range.begin, indices.begin () + range.end);
+        range.end = range.begin;
+      }
+      else
+      {
+        boost::mt19937 rng (seed);
+        boost::uniform_01<boost::mt19937&> uniform (rng);
+
+        double percent = 0.125;
+        if (mode == BUILD_SAMPLED_LOD)
+          percent = std::pow (OutofcoreNodeType::sample_percent_, static_cast<double> (this->getDepth () - depth));
+        const size_t sample_size = static_cast<size_t> (percent * static_cast<double> (count));
+
+        // Selection sampling (Knuth, Algorithm S) keeps the input order; if no point
+        // would be selected fall back to a Bernoulli trial per point
+        size_t kept = range.begin;
+        size_t needed = sample_size;
+        for (size_t i = range.begin; i < range.end; i++)
+        {
+          bool selected;
+          if (sample_size > 0)
+            selected = (static_cast<double> (range.end - i) * uniform () < static_cast<double> (needed));
+          else
+            selected = (uniform () < percent);
+
+          if (selected)
+          {
+            node_indices.push_back (indices[i]);
+            if (needed > 0)
+              needed--;
+          }
+
+          // Points stored in a partitioned LOD are not passed further down
+          if (!selected || mode != BUILD_PARTITIONED_LOD)
+            indices[kept++] = indices[i];
+        }
+        range.end = kept;
+      }
+
+      if (!node_indices.empty ())
+        insertIndices (range.node, input, node_indices);
+
+      return (node_indices.size ());
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ContainerT, typename PointT> bool
+    OutofcoreOctreeBase<ContainerT, PointT>::getXYZ (const pcl::PCLPointCloud2& cloud, std::vector<float>& xyz)
+    {
+      const int x_idx = pcl::getFieldIndex (cloud, std::string ("x"));
+      const int y_idx = pcl::getFieldIndex (cloud, std::string ("y"));
+      const int z_idx = pcl::getFieldIndex (cloud, std::string ("z"));
+
+      if (x_idx < 0 || y_idx < 0 || z_idx < 0)
+      {
+        PCL_ERROR ("[pcl::outofcore::OutofcoreOctreeBase::getXYZ] Input cloud has no x, y and z fields\n");
+        return (false);
+      }
+
+      const size_t nr_points = cloud.width * cloud.height;
+      const uint32_t offsets[3] = { cloud.fields[x_idx].offset, cloud.fields[y_idx].offset, cloud.fields[z_idx].offset };
+
+      xyz.resize (3 * nr_points);
+      for (size_t i = 0; i < nr_points; i++)
+      {
+        for (int d = 0; d < 3; d++)
+          xyz[3 * i + d] = *(reinterpret_cast<const float*> (&cloud.data[i * cloud.point_step + offsets[d]]));
+      }
+      return (true);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ContainerT, typename PointT> void
+    OutofcoreOctreeBase<ContainerT, PointT>::insertIndices (OutofcoreNodeType* node, const AlignedPointTVector& input, const std::vector<int>& indices)
+    {
+      std::vector<const PointT*> points (indices.size ());
+      for (size_t i = 0; i < indices.size (); i++)
+        points[i] = &input[indices[i]];
+
+      node->payload_->insertRange (&points[0], points.size ());
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ContainerT, typename PointT> void
+    OutofcoreOctreeBase<ContainerT, PointT>::insertIndices (OutofcoreNodeType* node, const pcl::PCLPointCloud2::Ptr& input, const std::vector<int>& indices)
+    {
+      pcl::PCLPointCloud2::Ptr node_cloud (new pcl::PCLPointCloud2 ());
+      pcl::copyPointCloud (*input, indices, *node_cloud);
+
+      node->payload_->insertRange (node_cloud);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
     template<typename Container, typename PointT> void
     OutofcoreOctreeBase<Container, PointT>::queryFrustum (const double planes[24], std::list<std::string>& file_names) const
     {
@@ -358,6 +663,29 @@ namespace pcl
 
     ////////////////////////////////////////////////////////////////////////////////
 
+    template<typename ContainerT, typename PointT> void
+    OutofcoreOctreeBase<ContainerT, PointT>::setNodeCacheCapacity (const size_t capacity_bytes)
+    {
+      boost::unique_lock < boost::shared_mutex > lock (read_write_mutex_);
+
+      if (capacity_bytes == 0)
+        node_cache_.reset ();
+      else if (node_cache_)
+        node_cache_->setCapacity (capacity_bytes);
+      else
+        node_cache_.reset (new NodeCache (capacity_bytes));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ContainerT, typename PointT> size_t
+    OutofcoreOctreeBase<ContainerT, PointT>::nextNodeCacheTimestamp () const
+    {
+      boost::mutex::scoped_lock lock (node_cache_mutex_);
+      return (++node_cache_timestamp_);
+    }
+    ////////////////////////////////////////////////////////////////////////////////
+
     template<typename ContainerT, typename PointT> bool
     OutofcoreOctreeBase<ContainerT, PointT>::getBoundingBox (Eigen::Vector3d &min, Eigen::Vector3d &max) const
     {
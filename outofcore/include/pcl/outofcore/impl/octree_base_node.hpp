@@ -1551,9 +1551,8 @@ namespace pcl
           if (inBoundingBox (min_bb, max_bb))
           {
             //get all the points from the payload and return
-            AlignedPointTVector payload_cache;
-            payload_->readRange (0, payload_->size (), payload_cache);
-            v.insert (v.end (), payload_cache.begin (), payload_cache.end ());
+            boost::shared_ptr<const AlignedPointTVector> payload_ptr = readCachedPayload ();
+            v.insert (v.end (), payload_ptr->begin (), payload_ptr->end ());
             return;
           }
           //otherwise queried bounding box only partially intersects this
@@ -1562,10 +1561,10 @@ namespace pcl
           else
           {
             //read _all_ the points in from the disk container
-            AlignedPointTVector payload_cache;
-            payload_->readRange (0, payload_->size (), payload_cache);
+            boost::shared_ptr<const AlignedPointTVector> payload_ptr = readCachedPayload ();
+            const AlignedPointTVector& payload_cache = *payload_ptr;
         
-            uint64_t len = payload_->size ();
+            uint64_t len = payload_cache.size ();
             //iterate through each of them
             for (uint64_t i = 0; i < len; i++)
             {
@@ -1586,6 +1585,42 @@ namespace pcl
       }
     }
     
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ContainerT, typename PointT> boost::shared_ptr<const typename OutofcoreOctreeBaseNode<ContainerT, PointT>::AlignedPointTVector>
+    OutofcoreOctreeBaseNode<ContainerT, PointT>::readCachedPayload ()
+    {
+      typedef typename OutofcoreOctreeBase<ContainerT, PointT>::NodeCacheItem NodeCacheItem;
+
+      const OutofcoreOctreeBase<ContainerT, PointT>* tree = root_node_->m_tree_;
+      boost::shared_ptr<typename OutofcoreOctreeBase<ContainerT, PointT>::NodeCache> cache;
+      if (tree)
+        cache = tree->node_cache_;
+
+      const uint64_t num_points = payload_->size ();
+      std::string key;
+      if (cache)
+      {
+        key = node_metadata_->getPCDFilename ().string ();
+
+        // Entries are keyed by file only; a size mismatch means points were appended since
+        NodeCacheItem cached;
+        if (cache->find (key, cached) && cached.item->size () == num_points)
+          return (cached.item);
+      }
+
+      boost::shared_ptr<AlignedPointTVector> points (new AlignedPointTVector ());
+      payload_->readRange (0, num_points, *points);
+
+      if (cache)
+      {
+        cache->erase (key);
+        cache->insert (key, NodeCacheItem (points, tree->nextNodeCacheTimestamp ()));
+      }
+
+      return (points);
+    }
+
     ////////////////////////////////////////////////////////////////////////////////
     template<typename ContainerT, typename PointT> void
     OutofcoreOctreeBaseNode<ContainerT, PointT>::queryBBIncludes_subsample (const Eigen::Vector3d& min_bb, const Eigen::Vector3d& max_bb, boost::uint64_t query_depth, const pcl::PCLPointCloud2::Ptr& dst_blob, double percent)
@@ -1699,9 +1734,9 @@ namespace pcl
             //brute force selection of all valid points
             AlignedPointTVector payload_cache_within_region;
             {
-              AlignedPointTVector payload_cache;
-              payload_->readRange (0, payload_->size (), payload_cache);
-              for (size_t i = 0; i < payload_->size (); i++)
+              boost::shared_ptr<const AlignedPointTVector> payload_ptr = readCachedPayload ();
+              const AlignedPointTVector& payload_cache = *payload_ptr;
+              for (size_t i = 0; i < payload_cache.size (); i++)
               {
                 const PointT& p = payload_cache[i];
                 if (pointInBoundingBox (min_bb, max_bb, p))
@@ -44,6 +44,7 @@
 #include <sstream>
 #include <cassert>
 #include <ctime>
+#include <algorithm>
 
 // Boost
 #include <pcl/outofcore/boost.h>
@@ -249,16 +250,64 @@ namespace pcl
         PCL_THROW_EXCEPTION (PCLException, "[pcl::outofcore::OutofcoreOctreeDiskContainer] Outofcore Octree Exception: Read indices exceed range");
       }
 
+      //read the whole block of points on disk at once and copy the requested range
+      pcl::PointCloud<PointT> cloud;
+      readDiskBlock (cloud);
+
+      const uint64_t end = start + count;
+      const uint64_t disk_len = cloud.points.size ();
+      dst.reserve (dst.size () + count);
+      if (start < disk_len)
+      {
+        dst.insert (dst.end (), cloud.points.begin () + start, cloud.points.begin () + std::min (end, disk_len));
+      }
+      if (end > disk_len)
+      {
+        const uint64_t buff_start = (start > disk_len) ? start - disk_len : 0;
+        const uint64_t buff_end = std::min (end - disk_len, static_cast<uint64_t> (writebuff_.size ()));
+        if (buff_start < buff_end)
+          dst.insert (dst.end (), writebuff_.begin () + buff_start, writebuff_.begin () + buff_end);
+      }
+    }
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename PointT> void
+    OutofcoreOctreeDiskContainer<PointT>::readDiskBlock (pcl::PointCloud<PointT> &cloud) const
+    {
+      cloud.points.clear ();
+      if (!boost::filesystem::exists (*disk_storage_filename_))
+        return;
+
+      //the PCD reader maps the file into memory, so this is a single bulk read per call
       pcl::PCDReader reader;
-      typename pcl::PointCloud<PointT>::Ptr cloud (new pcl::PointCloud<PointT> ());
-      
-      int res = reader.read (*disk_storage_filename_, *cloud);
+      int res = reader.read (*disk_storage_filename_, cloud);
       (void)res;
       assert (res == 0);
-      
-      for (size_t i=0; i < cloud->points.size (); i++)
-        dst.push_back (cloud->points[i]);
-      
+    }
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename PointT> void
+    OutofcoreOctreeDiskContainer<PointT>::gatherFromDisk (const std::vector<uint64_t> &offsets, AlignedPointTVector &dst) const
+    {
+      if (offsets.empty ())
+        return;
+
+      pcl::PointCloud<PointT> cloud;
+      readDiskBlock (cloud);
+
+      //offsets are sorted, drop the ones past the end of the file and walk the block front to back
+      const int nr_offsets = static_cast<int> (std::lower_bound (offsets.begin (), offsets.end (),
+                                                                 static_cast<uint64_t> (cloud.points.size ())) - offsets.begin ());
+      const size_t dst_start = dst.size ();
+      dst.resize (dst_start + nr_offsets);
+
+#ifdef _OPENMP
+#pragma omp parallel for shared (cloud, dst) if (nr_offsets > 100000)
+#endif
+      for (int i = 0; i < nr_offsets; i++)
+      {
+        dst[dst_start + i] = cloud.points[offsets[i]];
+      }
     }
     ////////////////////////////////////////////////////////////////////////////////
 
@@ -314,7 +363,7 @@ namespace pcl
 
       if (filecount > 0)
       {
-        //pregen and then sort the offsets to reduce the amount of seek
+        //pregen the offsets, the points are then gathered from one block read
         std::vector < uint64_t > offsets;
         {
           boost::mutex::scoped_lock lock (rng_mutex_);
@@ -329,27 +378,8 @@ namespace pcl
             }
           }
         }
-        std::sort (offsets.begin (), offsets.end ());
-
-        FILE* f = fopen (disk_storage_filename_->c_str (), "rb");
-        assert (f != NULL);
-        PointT p;
-        char* loc = reinterpret_cast<char*> (&p);
-        
-        uint64_t filesamp = offsets.size ();
-        for (uint64_t i = 0; i < filesamp; i++)
-        {
-          int seekret = _fseeki64 (f, offsets[i] * static_cast<uint64_t> (sizeof(PointT)), SEEK_SET);
-          (void)seekret;
-          assert (seekret == 0);
-          size_t readlen = fread (loc, sizeof(PointT), 1, f);
-          (void)readlen;
-          assert (readlen == 1);
-
-          dst.push_back (p);
-        }
-
-        fclose (f);
+        //offsets are generated in increasing order, no need to sort them
+        gatherFromDisk (offsets, dst);
       }
     }
     ////////////////////////////////////////////////////////////////////////////////
@@ -414,7 +444,7 @@ namespace pcl
 
       if (filesamp > 0)
       {
-        //pregen and then sort the offsets to reduce the amount of seek
+        //pregen and then sort the offsets, so the points are gathered in file order
         std::vector < uint64_t > offsets;
         {
           boost::mutex::scoped_lock lock (rng_mutex_);
@@ -430,24 +460,7 @@ namespace pcl
         }
         std::sort (offsets.begin (), offsets.end ());
 
-        FILE* f = fopen (disk_storage_filename_->c_str (), "rb");
-        assert (f != NULL);
-        PointT p;
-        char* loc = reinterpret_cast<char*> (&p);
-        for (uint64_t i = 0; i < filesamp; i++)
-        {
-          int seekret = _fseeki64 (f, offsets[i] * static_cast<uint64_t> (sizeof(PointT)), SEEK_SET);
-          (void)seekret;
-          assert (seekret == 0);
-          size_t readlen = fread (loc, sizeof(PointT), 1, f);
-          (void)readlen;
-          assert (readlen == 1);
-
-          dst.push_back (p);
-        }
-        int res = fclose (f);
-        (void)res;
-        assert (res == 0);
+        gatherFromDisk (offsets, dst);
       }
     }
     ////////////////////////////////////////////////////////////////////////////////
@@ -486,14 +499,11 @@ namespace pcl
         tmp_cloud->height = 1;
       }            
 
-      for (size_t i = 0; i < src.size (); i++)
-        tmp_cloud->points.push_back (src[i]);
+      tmp_cloud->points.reserve (tmp_cloud->points.size () + count + writebuff_.size ());
+      tmp_cloud->points.insert (tmp_cloud->points.end (), src.begin (), src.end ());
       
       // If there are any points in the write cache writebuff_, a different write cache than this one, concatenate
-      for (size_t i = 0; i < writebuff_.size (); i++)
-      {
-        tmp_cloud->points.push_back (writebuff_[i]);
-      }
+      tmp_cloud->points.insert (tmp_cloud->points.end (), writebuff_.begin (), writebuff_.end ());
 
       //assume unorganized point cloud
       tmp_cloud->width = static_cast<uint32_t> (tmp_cloud->points.size ());
@@ -504,6 +514,10 @@ namespace pcl
       int res = writer.writeBinaryCompressed (*disk_storage_filename_, *tmp_cloud);
       (void)res;
       assert (res == 0);
+
+      //the write cache is on disk now
+      writebuff_.clear ();
+      filelen_ = tmp_cloud->points.size ();
     }
   
     ////////////////////////////////////////////////////////////////////////////////
@@ -535,7 +549,7 @@ namespace pcl
         assert (previous_num_pts == res_pts);
         
         writer.writeBinaryCompressed (*disk_storage_filename_, *tmp_cloud);
-            
+        filelen_ = res_pts;
       }
       else //otherwise create the point cloud which will be saved to the pcd file for the first time
       {
@@ -543,6 +557,7 @@ namespace pcl
         int res = writer.writeBinaryCompressed (*disk_storage_filename_, *input_cloud);
         (void)res;
         assert (res == 0);
+        filelen_ = input_cloud->width * input_cloud->height;
       }            
 
     }
@@ -645,17 +660,13 @@ namespace pcl
         tmp_cloud->height = 1;
       }            
 
+      tmp_cloud->points.reserve (tmp_cloud->points.size () + count + writebuff_.size ());
+
       // Add any points in the cache
-      for (size_t i = 0; i < writebuff_.size (); i++)
-      {
-        tmp_cloud->points.push_back (writebuff_ [i]);
-      }
+      tmp_cloud->points.insert (tmp_cloud->points.end (), writebuff_.begin (), writebuff_.end ());
 
       //add the new points passed with this function
-      for (size_t i = 0; i < count; i++)
-      {
-        tmp_cloud->points.push_back (*(start + i));
-      }
+      tmp_cloud->points.insert (tmp_cloud->points.end (), start, start + count);
 
       tmp_cloud->width = static_cast<uint32_t> (tmp_cloud->points.size ());
       tmp_cloud->height = 1;
@@ -666,6 +677,10 @@ namespace pcl
       int res = writer.writeBinaryCompressed (*disk_storage_filename_, *tmp_cloud);
       (void)res;
       assert (res == 0);
+
+      //the write cache is on disk now
+      writebuff_.clear ();
+      filelen_ = tmp_cloud->points.size ();
     }
     ////////////////////////////////////////////////////////////////////////////////
 
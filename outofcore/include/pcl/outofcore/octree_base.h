@@ -59,6 +59,9 @@
 #include <pcl/outofcore/metadata.h>
 #include <pcl/outofcore/outofcore_base_data.h>
 
+//outofcore node data cache
+#include <pcl/outofcore/impl/lru_cache.hpp>
+
 #include <pcl/filters/filter.h>
 #include <pcl/filters/random_sample.h>
 
@@ -187,6 +190,30 @@ namespace pcl
 
         typedef std::vector<PointT, Eigen::aligned_allocator<PointT> > AlignedPointTVector;
 
+        /** \brief Points of one node held in the node cache; sized in bytes */
+        class NodeCacheItem : public LRUCacheItem<boost::shared_ptr<const AlignedPointTVector> >
+        {
+          public:
+            NodeCacheItem ()
+            {
+              this->timestamp = 0;
+            }
+
+            NodeCacheItem (const boost::shared_ptr<const AlignedPointTVector> &points, size_t timestamp)
+            {
+              this->item = points;
+              this->timestamp = timestamp;
+            }
+
+            virtual size_t
+            sizeOf () const
+            {
+              return (sizeof (*this) + (this->item ? this->item->size () * sizeof (PointT) : 0));
+            }
+        };
+
+        typedef LRUCache<std::string, NodeCacheItem> NodeCache;
+
         // Constructors
         // -----------------------------------------------------------------------
 
@@ -237,7 +264,11 @@ namespace pcl
 
         // Point/Region INSERTION methods
         // --------------------------------------------------------------------------------
-        /** \brief Recursively add points to the tree 
+        /** \brief Add points to the leaves of the tree
+         *
+         *  Points are partitioned one level at a time in memory and the node
+         *  files of each level are written by a pool of setNumberOfThreads ()
+         *  workers.
          *  \note shared read_write_mutex lock occurs
          */
         boost::uint64_t
@@ -551,6 +582,23 @@ namespace pcl
         void
         setLODFilter (const pcl::Filter<pcl::PCLPointCloud2>::Ptr& filter_arg);
 
+        /** \brief Enable the in-memory cache of node points used by queryBBIncludes and
+         *  queryBBIncludes_subsample. Nodes are evicted least-recently-used first once
+         *  the budget is exceeded; the cache is disabled by default.
+         *  \param[in] capacity_bytes memory budget of the cache in bytes (0 disables the cache)
+         */
+        void
+        setNodeCacheCapacity (const size_t capacity_bytes);
+
+        /** \brief Returns the node cache, or NULL if it is disabled. Use it to inspect the
+         *  hit/miss/eviction counters or to pin nodes that must stay resident.
+         */
+        inline boost::shared_ptr<NodeCache>
+        getNodeCache () const
+        {
+          return (node_cache_);
+        }
+
         /** \brief Returns the sample_percent_ used when constructing the LOD. */
         double 
         getSamplePercent () const
@@ -558,6 +606,17 @@ namespace pcl
           return (sample_percent_);
         }
         
+        /** \brief Set the number of threads used to insert points and to build the LODs
+         *  while inserting (addDataToLeaf, addPointCloud, addPointCloud_and_genLOD and
+         *  addDataToLeaf_and_genLOD).
+         *  \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+         */
+        inline void
+        setNumberOfThreads (unsigned int nr_threads = 0)
+        {
+          threads_ = nr_threads;
+        }
+
         /** \brief Sets the sampling percent for constructing LODs. Each LOD gets sample_percent^d points. 
          * \param[in] sample_percent_arg Percentage between 0 and 1. */
         inline void 
@@ -603,6 +662,69 @@ namespace pcl
         inline void
         incrementPointsInLOD (boost::uint64_t depth, boost::uint64_t inc);
 
+        /** \brief How buildTree distributes the points over the branch nodes it passes through */
+        enum BuildMode
+        {
+          /** \brief store points in the nodes at the maximum depth only (addDataToLeaf) */
+          BUILD_LEAVES,
+          /** \brief additionally store a random sample of the points passing through each
+           *  branch node, sample_percent^(max depth - depth) of them (addDataToLeaf_and_genLOD) */
+          BUILD_SAMPLED_LOD,
+          /** \brief store 1/8 of the points reaching each branch node there and pass only the
+           *  rest down, so every point is stored once (addPointCloud_and_genLOD) */
+          BUILD_PARTITIONED_LOD
+        };
+
+        /** \brief A contiguous run of the sorted point indices that falls into one node */
+        struct BuildRange
+        {
+          BuildRange (OutofcoreNodeType* node_arg, size_t begin_arg, size_t end_arg) :
+            node (node_arg), begin (begin_arg), end (end_arg)
+          {
+          }
+
+          OutofcoreNodeType* node;
+          size_t begin;
+          size_t end;
+        };
+
+        /** \brief Insert points into the tree one level at a time.
+         *
+         *  At every depth the indices of the points are stably sorted by child octant within
+         *  the range of their node (using the node's voxel center, like the recursive
+         *  insertion), so the ranges of all nodes of a level are disjoint and their files are
+         *  written in parallel. Nodes are created sequentially between levels.
+         *
+         *  \param[in] input the points to insert, a point vector or a PCLPointCloud2
+         *  \param[in] xyz the coordinates of the points, packed as x, y, z triples
+         *  \param[in] mode how points are stored at the branch nodes
+         *  \param[in] check_bb drop points outside of the bounding box of the root node
+         *  \return the number of points inserted at the leaves (at every node for BUILD_PARTITIONED_LOD)
+         */
+        template <typename InputT> boost::uint64_t
+        buildTree (const InputT& input, const std::vector<float>& xyz, const BuildMode mode, const bool check_bb);
+
+        /** \brief Store the points of range in its node according to mode; for
+         *  BUILD_PARTITIONED_LOD the points stored are removed from the range.
+         *  \return the number of points written to the node
+         */
+        template <typename InputT> boost::uint64_t
+        storeBuildRange (const InputT& input, std::vector<int>& indices, BuildRange& range, const boost::uint64_t depth, const BuildMode mode, const boost::uint32_t seed);
+
+        /** \brief Copy the x, y and z fields of cloud into packed coordinate triples
+         *  \return false if cloud lacks one of the fields
+         */
+        static bool
+        getXYZ (const pcl::PCLPointCloud2& cloud, std::vector<float>& xyz);
+
+        /** \brief Append the points at indices to the payload of node */
+        void
+        insertIndices (OutofcoreNodeType* node, const AlignedPointTVector& input, const std::vector<int>& indices);
+
+        /** \brief Append the points at indices to the payload of node */
+        void
+        insertIndices (OutofcoreNodeType* node, const pcl::PCLPointCloud2::Ptr& input, const std::vector<int>& indices);
+
         /** \brief Auxiliary function to validate path_name extension is .octree
          *  
          *  \return 0 if bad; 1 if extension is .oct_idx
@@ -658,6 +780,22 @@ namespace pcl
         double sample_percent_;
 
         pcl::RandomSample<pcl::PCLPointCloud2>::Ptr lod_filter_ptr_;
+
+        /** \brief The number of threads the scheduler should use. */
+        unsigned int threads_;
+
+        /** \brief Returns a unique, increasing timestamp for items entering the node cache */
+        size_t
+        nextNodeCacheTimestamp () const;
+
+        /** \brief Cache of node points keyed by PCD filename; NULL when disabled */
+        boost::shared_ptr<NodeCache> node_cache_;
+
+        /** \brief Guards node_cache_timestamp_ */
+        mutable boost::mutex node_cache_mutex_;
+
+        /** \brief Timestamp handed to the next item entering the node cache */
+        mutable size_t node_cache_timestamp_;
         
     };
   }
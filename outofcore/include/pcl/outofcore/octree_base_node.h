@@ -523,6 +523,13 @@ namespace pcl
         void
         sortOctantIndices (const pcl::PCLPointCloud2::Ptr &input_cloud, std::vector< std::vector<int> > &indices, const Eigen::Vector3d &mid_xyz);
 
+        /** \brief Read all points stored in this node. When the tree has a node cache
+         *  enabled the points are served from (and added to) that cache; the returned
+         *  pointer keeps them alive even if the cache evicts the node meanwhile.
+         */
+        boost::shared_ptr<const AlignedPointTVector>
+        readCachedPayload ();
+
         /** \brief Enlarges the shortest two sidelengths of the
          *  bounding box to a cubic shape; operation is done in
          *  place.
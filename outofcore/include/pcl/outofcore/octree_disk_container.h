@@ -126,7 +126,8 @@ namespace pcl
 
         /** \brief Reads \b count points into memory from the disk container
          *
-         * Reads \b count points into memory from the disk container, reading at most 2 million elements at a time
+         * Reads \b count points into memory from the disk container. The points on disk are read in a single block,
+         * the requested range is then copied out of it.
          *
          * \param[in] start index of first point to read from disk
          * \param[in] count offset of last point to read from disk
@@ -224,35 +225,25 @@ namespace pcl
           {
             FILE* fxyz = fopen (path.string ().c_str (), "w");
 
-            FILE* f = fopen (disk_storage_filename_->c_str (), "rb");
-            assert (f != NULL);
+            pcl::PointCloud<PointT> cloud;
+            readDiskBlock (cloud);
 
-            uint64_t num = size ();
-            PointT p;
-            char* loc = reinterpret_cast<char*> ( &p );
-
-            for (uint64_t i = 0; i < num; i++)
+            std::stringstream ss;
+            ss << std::fixed;
+            ss.precision (16);
+            for (size_t i = 0; i < cloud.points.size (); i++)
             {
-              int seekret = _fseeki64 (f, i * sizeof (PointT), SEEK_SET);
-              (void)seekret;
-              assert (seekret == 0);
-              size_t readlen = fread (loc, sizeof (PointT), 1, f);
-              (void)readlen;
-              assert (readlen == 1);
-
-              //of << p.x << "\t" << p.y << "\t" << p.z << "\n";
-              std::stringstream ss;
-              ss << std::fixed;
-              ss.precision (16);
+              const PointT& p = cloud.points[i];
               ss << p.x << "\t" << p.y << "\t" << p.z << "\n";
-
-              fwrite (ss.str ().c_str (), 1, ss.str ().size (), fxyz);
             }
-            int res = fclose (f);
+
+            const std::string xyz = ss.str ();
+            size_t writelen = fwrite (xyz.c_str (), 1, xyz.size (), fxyz);
+            (void)writelen;
+            assert (writelen == xyz.size ());
+            int res = fclose (fxyz);
             (void)res;
             assert (res == 0);
-            res = fclose (fxyz);
-            assert (res == 0);
           }
         }
 
@@ -278,6 +269,20 @@ namespace pcl
 
         void
         flushWritebuff (const bool force_cache_dealloc);
+
+        /** \brief Reads all points stored on disk with a single PCD read (the file is memory mapped by the reader).
+         * Does not modify the container, so concurrent readers may call it under a shared lock.
+         * \param[out] cloud the points stored on disk
+         */
+        void
+        readDiskBlock (pcl::PointCloud<PointT> &cloud) const;
+
+        /** \brief Appends the points at the given offsets in the disk file to \c dst, reading the file only once.
+         * \param[in] offsets sorted point offsets into the disk file; offsets past its end are ignored
+         * \param[out] dst destination for the gathered points
+         */
+        void
+        gatherFromDisk (const std::vector<uint64_t> &offsets, AlignedPointTVector &dst) const;
     
         /** \brief Name of the storage file on disk (i.e., the PCD file) */
         boost::shared_ptr<std::string> disk_storage_filename_;
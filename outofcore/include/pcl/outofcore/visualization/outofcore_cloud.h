@@ -103,7 +103,8 @@ class OutofcoreCloud : public Object
       virtual size_t
       sizeOf() const
       {
-        return item->GetActualMemorySize();
+        // vtkDataObject reports kibibytes, the cache budget is in bytes
+        return item->GetActualMemorySize() * 1024;
       }
 
       std::string pcd_file;
@@ -47,7 +47,8 @@ boost::shared_ptr<boost::thread> OutofcoreCloud::pcd_reader_thread;
 //MonitorQueue<std::string> OutofcoreCloud::pcd_queue;
 
 //std::map<std::string, vtkSmartPointer<vtkPolyData> > OutofcoreCloud::cloud_data_cache;
-OutofcoreCloud::CloudDataCache OutofcoreCloud::cloud_data_cache(524288);
+// 512 MiB budget; item sizes are reported in bytes
+OutofcoreCloud::CloudDataCache OutofcoreCloud::cloud_data_cache(536870912);
 boost::mutex OutofcoreCloud::cloud_data_cache_mutex;
 
 OutofcoreCloud::PcdQueue OutofcoreCloud::pcd_queue;
@@ -73,12 +74,16 @@ OutofcoreCloud::pcdReaderThread ()
     {
       const PcdQueueItem *pcd_queue_item = &pcd_queue.top();
 
-      if (cloud_data_cache.hasKey(pcd_queue_item->pcd_file))
+      cloud_data_cache_mutex.lock();
+      bool cached = cloud_data_cache.hasKey(pcd_queue_item->pcd_file);
+      if (cached)
       {
         CloudDataCacheItem *cloud_data_cache_item = &cloud_data_cache.get(pcd_queue_item->pcd_file);
         cloud_data_cache_item->timestamp = timestamp;
       }
-      else
+      cloud_data_cache_mutex.unlock();
+
+      if (!cached)
       {
         vtkSmartPointer<vtkPolyData> cloud_data = vtkSmartPointer<vtkPolyData>::New ();
 
@@ -68,6 +68,8 @@ using pcl::console::print_info;
 
 #include <boost/foreach.hpp>
 
+#include <algorithm>
+
 typedef OutofcoreOctreeBase<> octree_disk;
 
 const int OCTREE_DEPTH (0);
@@ -95,7 +97,8 @@ getCloudFromFile (boost::filesystem::path pcd_path)
 
 int
 outofcoreProcess (std::vector<boost::filesystem::path> pcd_paths, boost::filesystem::path root_dir, 
-                  int depth, double resolution, int build_octree_with, bool gen_lod, bool overwrite, bool multiresolution)
+                  int depth, double resolution, int build_octree_with, bool gen_lod, bool overwrite, bool multiresolution,
+                  unsigned int nr_threads)
 {
   // Bounding box min/max pts
   PointT min_pt, max_pt;
@@ -176,7 +179,10 @@ outofcoreProcess (std::vector<boost::filesystem::path> pcd_paths, boost::filesys
     outofcore_octree = new octree_disk (bounding_box_min, bounding_box_max, resolution, octree_path_on_disk, "ECEF");
   }
 
+  outofcore_octree->setNumberOfThreads (nr_threads);
+
   uint64_t total_pts = 0;
+  double total_insert_time = 0;
 
   // Iterate over all pcd files adding points to the octree
   for (size_t i = 0; i < pcd_paths.size (); i++)
@@ -185,6 +191,7 @@ outofcoreProcess (std::vector<boost::filesystem::path> pcd_paths, boost::filesys
     PCLPointCloud2::Ptr cloud = getCloudFromFile (pcd_paths[i]);
 
     boost::uint64_t pts = 0;
+    pcl::StopWatch insert_timer;
     
     if (gen_lod && !multiresolution)
     {
@@ -196,7 +203,10 @@ outofcoreProcess (std::vector<boost::filesystem::path> pcd_paths, boost::filesys
       pts = outofcore_octree->addPointCloud (cloud, false);
     }
     
-    print_info ("Successfully added %lu points\n", pts);
+    const double insert_time = insert_timer.getTimeSeconds ();
+    total_insert_time += insert_time;
+
+    print_info ("Successfully added %lu points in %g s (%.0f points/s)\n", pts, insert_time, insert_time > 0 ? static_cast<double> (pts) / insert_time : 0.0);
     print_info ("%lu Points were dropped (probably NaN)\n", cloud->width*cloud->height - pts);
     
 //    assert ( pts == cloud->width * cloud->height );
@@ -205,6 +215,7 @@ outofcoreProcess (std::vector<boost::filesystem::path> pcd_paths, boost::filesys
   }
 
   print_info ("Added a total of %lu from %d clouds\n",total_pts, pcd_paths.size ());
+  print_info ("  Insertion: %g s (%.0f points/s)\n", total_insert_time, total_insert_time > 0 ? static_cast<double> (total_pts) / total_insert_time : 0.0);
   
 
   double x, y;
@@ -239,6 +250,7 @@ printHelp (int, char **argv)
   print_info ("\t -gen_lod                      \t Generate octree LODs\n");
   print_info ("\t -overwrite                    \t Overwrite existing octree\n");
   print_info ("\t -multiresolution              \t Generate multiresolutoin LOD\n");
+  print_info ("\t -threads <n>                  \t Number of threads used for insertion (default: 0, automatic)\n");
   print_info ("\t -h                            \t Display help\n");
   print_info ("\n");
 }
@@ -275,6 +287,7 @@ main (int argc, char* argv[])
   bool multiresolution = false;
   bool overwrite = false;
   int build_octree_with = OCTREE_DEPTH;
+  int nr_threads = 0;
 
   // If both depth and resolution specified
   if (find_switch (argc, argv, "-depth") && find_switch (argc, argv, "-resolution"))
@@ -290,6 +303,7 @@ main (int argc, char* argv[])
   // Parse options
   parse_argument (argc, argv, "-depth", depth);
   parse_argument (argc, argv, "-resolution", resolution);
+  parse_argument (argc, argv, "-threads", nr_threads);
   gen_lod = find_switch (argc, argv, "-gen_lod");
   overwrite = find_switch (argc, argv, "-overwrite");
 
@@ -329,5 +343,6 @@ main (int argc, char* argv[])
   if (root_dir.extension () == ".pcd")
     root_dir = root_dir.parent_path () / (root_dir.stem().string() + "_tree").c_str();
 
-  return outofcoreProcess (pcd_paths, root_dir, depth, resolution, build_octree_with, gen_lod, overwrite, multiresolution);
+  return outofcoreProcess (pcd_paths, root_dir, depth, resolution, build_octree_with, gen_lod, overwrite, multiresolution,
+                           static_cast<unsigned int> (std::max (nr_threads, 0)));
 }
@@ -47,6 +47,7 @@
 #include <pcl/common/transforms.h>
 #include <pcl/search/kdtree.h>
 #include <pcl/pcl_macros.h>
+#include <pcl/common/trace.h>
 
 #include <pcl/registration/correspondence_types.h>
 
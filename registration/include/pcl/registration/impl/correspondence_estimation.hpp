@@ -163,6 +163,8 @@ pcl::registration::CorrespondenceEstimation<PointSource, PointTarget, Scalar>::d
     }
   }
   correspondences.resize (nr_valid_correspondences);
+  // One nearest neighbor search per source index
+  PCL_TRACE_COUNTER ("search calls", indices_->size ());
   deinitCompute ();
 }
 
@@ -187,6 +189,8 @@ pcl::registration::CorrespondenceEstimation<PointSource, PointTarget, Scalar>::d
   std::vector<float> distance_reciprocal (1);
   pcl::Correspondence corr;
   unsigned int nr_valid_correspondences = 0;
+  // Source points within max_distance of the target, each needs a second search
+  size_t nr_reciprocal_searches = 0;
   int target_idx = 0;
 
   // Check if the template types are the same. If true, avoid a copy.
@@ -201,6 +205,7 @@ pcl::registration::CorrespondenceEstimation<PointSource, PointTarget, Scalar>::d
         continue;
 
       target_idx = index[0];
+      ++nr_reciprocal_searches;
 
       tree_reciprocal_->nearestKSearch (target_->points[target_idx], 1, index_reciprocal, distance_reciprocal);
       if (distance_reciprocal[0] > max_dist_sqr || *idx != index_reciprocal[0])
@@ -228,6 +233,7 @@ pcl::registration::CorrespondenceEstimation<PointSource, PointTarget, Scalar>::d
         continue;
 
       target_idx = index[0];
+      ++nr_reciprocal_searches;
 
       // Copy the target data to a target PointSource format so we can search in the tree_reciprocal
       copyPoint (target_->points[target_idx], pt_tgt);
@@ -243,6 +249,8 @@ pcl::registration::CorrespondenceEstimation<PointSource, PointTarget, Scalar>::d
     }
   }
   correspondences.resize (nr_valid_correspondences);
+  PCL_TRACE_COUNTER ("search calls", indices_->size () + nr_reciprocal_searches);
+  (void)nr_reciprocal_searches;
   deinitCompute ();
 }
 
@@ -171,6 +171,8 @@ pcl::IterativeClosestPoint<PointSource, PointTarget, Scalar>::computeTransformat
   // Repeat until convergence
   do
   {
+    PCL_TRACE_ZONE ("pcl::IterativeClosestPoint iteration");
+
     // Get blob data if needed
     PCLPointCloud2::Ptr input_transformed_blob;
     if (need_source_blob_)
@@ -186,10 +188,13 @@ pcl::IterativeClosestPoint<PointSource, PointTarget, Scalar>::computeTransformat
     if (correspondence_estimation_->requiresSourceNormals ())
       correspondence_estimation_->setSourceNormals (input_transformed_blob);
     // Estimate correspondences
-    if (use_reciprocal_correspondence_)
-      correspondence_estimation_->determineReciprocalCorrespondences (*correspondences_, corr_dist_threshold_);
-    else
-      correspondence_estimation_->determineCorrespondences (*correspondences_, corr_dist_threshold_);
+    {
+      PCL_TRACE_ZONE ("pcl::IterativeClosestPoint correspondences");
+      if (use_reciprocal_correspondence_)
+        correspondence_estimation_->determineReciprocalCorrespondences (*correspondences_, corr_dist_threshold_);
+      else
+        correspondence_estimation_->determineCorrespondences (*correspondences_, corr_dist_threshold_);
+    }
 
     //if (correspondence_rejectors_.empty ())
     CorrespondencesPtr temp_correspondences (new Correspondences (*correspondences_));
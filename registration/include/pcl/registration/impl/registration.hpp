@@ -160,8 +160,10 @@ pcl::Registration<PointSource, PointTarget, Scalar>::align (PointCloudSource &ou
 template <typename PointSource, typename PointTarget, typename Scalar> inline void
 pcl::Registration<PointSource, PointTarget, Scalar>::align (PointCloudSource &output, const Matrix4& guess)
 {
+  PCL_TRACE_ZONE (reg_name_);
   if (!initCompute ()) 
     return;
+  PCL_TRACE_COUNTER ("registration points", indices_->size ());
 
   // Resize the output dataset
   if (output.points.size () != indices_->size ())
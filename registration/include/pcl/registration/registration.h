@@ -44,6 +44,7 @@
 // PCL includes
 #include <pcl/pcl_base.h>
 #include <pcl/common/transforms.h>
+#include <pcl/common/trace.h>
 #include <pcl/pcl_macros.h>
 #include <pcl/search/kdtree.h>
 #include <pcl/kdtree/kdtree_flann.h>
@@ -60,6 +60,7 @@ namespace pcl
       using pcl::search::Search<PointT>::input_;
       using pcl::search::Search<PointT>::indices_;
       using pcl::search::Search<PointT>::sorted_results_;
+      using pcl::search::Search<PointT>::radiusSearchCount;
 
       struct Entry
       {
@@ -122,6 +123,16 @@ namespace pcl
                       std::vector<int> &k_indices, std::vector<float> &k_sqr_distances,
                       unsigned int max_nn = 0) const;
 
+        /** \brief Count the neighbors of the query point in a given radius, without collecting them.
+          * \param[in] point the given query point
+          * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+          * \param[in] max_count if given, the search stops after this many neighbors and returns \a max_count.
+          * If \a max_count is set to 0, all neighbors in \a radius are counted.
+          * \return number of neighbors found in radius, at most \a max_count
+          */
+        int
+        radiusSearchCount (const PointT& point, double radius, unsigned int max_count = 0) const;
+
       private:
         int
         denseKSearch (const PointT &point, int k, std::vector<int> &k_indices, std::vector<float> &k_distances) const;
@@ -0,0 +1,207 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef PCL_SEARCH_BRUTE_FORCE_SOA_H_
+#define PCL_SEARCH_BRUTE_FORCE_SOA_H_
+
+#include <pcl/point_cloud_soa.h>
+#include <vector>
+
+namespace pcl
+{
+  namespace search
+  {
+    namespace detail
+    {
+      /** \brief Compute the squared distances between a query point and \a n points given as
+        * separate x, y and z arrays. Compiled for several instruction sets, the variant is
+        * picked at runtime (see pcl::getDispatchCpuIsa ()).
+        * \param[in] x the x coordinates
+        * \param[in] y the y coordinates
+        * \param[in] z the z coordinates
+        * \param[in] n the number of points
+        * \param[in] qx the x coordinate of the query point
+        * \param[in] qy the y coordinate of the query point
+        * \param[in] qz the z coordinate of the query point
+        * \param[out] distances the \a n squared distances
+        */
+      PCL_EXPORTS void
+      squaredDistances (const float *x, const float *y, const float *z, size_t n,
+                        float qx, float qy, float qz, float *distances);
+    }
+
+    /** \brief Brute force nearest neighbor search on a structure-of-arrays point cloud.
+      *
+      * Squared distances are computed block-wise from the x, y and z columns of a
+      * pcl::PointCloudSoA, so the hot loop streams three float arrays and vectorizes,
+      * instead of striding over padded point structs as pcl::search::BruteForce does.
+      * Points with non-finite coordinates are never returned.
+      * \ingroup search
+      */
+    template<typename PointT>
+    class BruteForceSoA
+    {
+      public:
+        typedef boost::shared_ptr<BruteForceSoA<PointT> > Ptr;
+        typedef boost::shared_ptr<const BruteForceSoA<PointT> > ConstPtr;
+
+        typedef pcl::PointCloudSoA<PointT> PointCloud;
+        typedef typename PointCloud::ConstPtr PointCloudConstPtr;
+
+        /** \brief Constructor.
+          * \param[in] sorted_results whether radiusSearch should sort its results by distance
+          * (nearestKSearch results are always sorted)
+          */
+        BruteForceSoA (bool sorted_results = false)
+          : input_ ()
+          , sorted_results_ (sorted_results)
+        {
+        }
+
+        /** \brief Destructor. */
+        virtual
+        ~BruteForceSoA ()
+        {
+        }
+
+        /** \brief Set the cloud to search in.
+          * \param[in] cloud the structure-of-arrays point cloud
+          */
+        inline void
+        setInputCloud (const PointCloudConstPtr& cloud)
+        {
+          input_ = cloud;
+        }
+
+        /** \brief Get the cloud that is searched in. */
+        inline const PointCloudConstPtr&
+        getInputCloud () const
+        {
+          return (input_);
+        }
+
+        /** \brief Set whether radiusSearch should sort its results by distance. */
+        inline void
+        setSortedResults (bool sorted_results)
+        {
+          sorted_results_ = sorted_results;
+        }
+
+        /** \brief Search for the k-nearest neighbors for the given query point.
+          * \param[in] point the given query point
+          * \param[in] k the number of neighbors to search for
+          * \param[out] k_indices the resultant indices of the neighboring points
+          * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+          * \return number of neighbors found
+          */
+        int
+        nearestKSearch (const PointT &point, int k, std::vector<int> &k_indices,
+                        std::vector<float> &k_sqr_distances) const;
+
+        /** \brief Search for the k-nearest neighbors of the point at \a index in \a cloud.
+          * \param[in] cloud the cloud holding the query point
+          * \param[in] index the index of the query point in \a cloud
+          * \param[in] k the number of neighbors to search for
+          * \param[out] k_indices the resultant indices of the neighboring points
+          * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+          * \return number of neighbors found
+          */
+        inline int
+        nearestKSearch (const PointCloud &cloud, int index, int k, std::vector<int> &k_indices,
+                        std::vector<float> &k_sqr_distances) const
+        {
+          return (nearestKSearch (cloud.at (index), k, k_indices, k_sqr_distances));
+        }
+
+        /** \brief Search for all the nearest neighbors of the query point in a given radius.
+          * \param[in] point the given query point
+          * \param[in] radius the radius of the sphere bounding all of the query point's neighbors
+          * \param[out] k_indices the resultant indices of the neighboring points
+          * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+          * \param[in] max_nn if given, bounds the maximum returned neighbors to this value. If
+          * \a max_nn is set to 0 or to a number higher than the number of points in the input
+          * cloud, all neighbors in \a radius will be returned.
+          * \return number of neighbors found in radius
+          */
+        int
+        radiusSearch (const PointT &point, double radius, std::vector<int> &k_indices,
+                      std::vector<float> &k_sqr_distances, unsigned int max_nn = 0) const;
+
+        /** \brief Search for all the nearest neighbors of the point at \a index in \a cloud in a given radius.
+          * \param[in] cloud the cloud holding the query point
+          * \param[in] index the index of the query point in \a cloud
+          * \param[in] radius the radius of the sphere bounding all of the query point's neighbors
+          * \param[out] k_indices the resultant indices of the neighboring points
+          * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+          * \param[in] max_nn if given, bounds the maximum returned neighbors to this value
+          * \return number of neighbors found in radius
+          */
+        inline int
+        radiusSearch (const PointCloud &cloud, int index, double radius, std::vector<int> &k_indices,
+                      std::vector<float> &k_sqr_distances, unsigned int max_nn = 0) const
+        {
+          return (radiusSearch (cloud.at (index), radius, k_indices, k_sqr_distances, max_nn));
+        }
+
+      protected:
+        /** \brief Compute the squared distances from \a point to the input points [begin, end).
+          * \param[in] point the query point
+          * \param[in] begin the first point index of the block
+          * \param[in] end one past the last point index of the block
+          * \param[out] distances the squared distances, one per point of the block
+          */
+        void
+        computeSquaredDistances (const PointT &point, size_t begin, size_t end, float *distances) const;
+
+        /** \brief The number of points processed per distance block. */
+        static const size_t block_size_ = 256;
+
+        /** \brief The cloud that is searched in. */
+        PointCloudConstPtr input_;
+
+        /** \brief Whether radiusSearch results are sorted by distance. */
+        bool sorted_results_;
+    };
+  }
+}
+
+#ifdef PCL_NO_PRECOMPILE
+#include <pcl/search/impl/brute_force_soa.hpp>
+#endif
+
+#endif    // PCL_SEARCH_BRUTE_FORCE_SOA_H_
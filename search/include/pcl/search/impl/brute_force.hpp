@@ -349,6 +349,38 @@ pcl::search::BruteForce<PointT>::radiusSearch (
     return sparseRadiusSearch (point, radius, k_indices, k_sqr_distances, max_nn);
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::BruteForce<PointT>::radiusSearchCount (
+    const PointT& point, double radius, unsigned int max_count) const
+{
+  assert (isFinite (point) && "Invalid (NaN, Inf) point coordinates given to radiusSearchCount!");
+
+  if (radius <= 0)
+    return 0;
+  radius *= radius;
+
+  // Non-finite points never pass the distance test, so no separate sparse variant is needed
+  unsigned int count = 0;
+  if (indices_ != NULL)
+  {
+    for (std::vector<int>::const_iterator iIt = indices_->begin (); iIt != indices_->end (); ++iIt)
+    {
+      if (getDistSqr (input_->points[*iIt], point) <= radius && ++count == max_count) // never true if max_count = 0
+        break;
+    }
+  }
+  else
+  {
+    for (size_t index = 0; index < input_->size (); ++index)
+    {
+      if (getDistSqr (input_->points[index], point) <= radius && ++count == max_count) // never true if max_count = 0
+        break;
+    }
+  }
+  return (static_cast<int> (count));
+}
+
 #define PCL_INSTANTIATE_BruteForce(T) template class PCL_EXPORTS pcl::search::BruteForce<T>;
 
 #endif //PCL_SEARCH_IMPL_BRUTE_FORCE_SEARCH_H_
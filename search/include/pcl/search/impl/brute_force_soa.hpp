@@ -0,0 +1,163 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef PCL_SEARCH_IMPL_BRUTE_FORCE_SOA_H_
+#define PCL_SEARCH_IMPL_BRUTE_FORCE_SOA_H_
+
+#include <pcl/search/brute_force_soa.h>
+#include <pcl/point_types.h>
+#include <algorithm>
+#include <queue>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::search::BruteForceSoA<PointT>::computeSquaredDistances (
+    const PointT &point, size_t begin, size_t end, float *distances) const
+{
+  pcl::search::detail::squaredDistances (input_->x () + begin, input_->y () + begin, input_->z () + begin,
+                                         end - begin, point.x, point.y, point.z, distances);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::BruteForceSoA<PointT>::nearestKSearch (
+    const PointT &point, int k, std::vector<int> &k_indices, std::vector<float> &k_sqr_distances) const
+{
+  assert (isFinite (point) && "Invalid (NaN, Inf) point coordinates given to nearestKSearch!");
+
+  k_indices.clear ();
+  k_sqr_distances.clear ();
+  if (k < 1 || !input_ || input_->empty ())
+    return (0);
+
+  // Max-heap on (distance, index) holding the best k candidates seen so far
+  typedef std::pair<float, int> Entry;
+  std::priority_queue<Entry> queue;
+  const size_t max_k = static_cast<size_t> (k);
+  const size_t block = block_size_;
+  float distances[block_size_];
+
+  for (size_t begin = 0; begin < input_->size (); begin += block)
+  {
+    const size_t end = std::min (begin + block, input_->size ());
+    computeSquaredDistances (point, begin, end, distances);
+    for (size_t i = 0; i < end - begin; ++i)
+    {
+      // Non-finite points produce non-finite distances
+      if (!pcl_isfinite (distances[i]))
+        continue;
+      if (queue.size () < max_k)
+        queue.push (Entry (distances[i], static_cast<int> (begin + i)));
+      else if (distances[i] < queue.top ().first)
+      {
+        queue.pop ();
+        queue.push (Entry (distances[i], static_cast<int> (begin + i)));
+      }
+    }
+  }
+
+  k_indices.resize (queue.size ());
+  k_sqr_distances.resize (queue.size ());
+  for (size_t idx = queue.size (); idx > 0; --idx)
+  {
+    k_indices[idx - 1] = queue.top ().second;
+    k_sqr_distances[idx - 1] = queue.top ().first;
+    queue.pop ();
+  }
+  return (static_cast<int> (k_indices.size ()));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::BruteForceSoA<PointT>::radiusSearch (
+    const PointT &point, double radius, std::vector<int> &k_indices,
+    std::vector<float> &k_sqr_distances, unsigned int max_nn) const
+{
+  assert (isFinite (point) && "Invalid (NaN, Inf) point coordinates given to radiusSearch!");
+
+  k_indices.clear ();
+  k_sqr_distances.clear ();
+  if (!input_ || input_->empty ())
+    return (0);
+
+  const float sqr_radius = static_cast<float> (radius * radius);
+  const size_t block = block_size_;
+  float distances[block_size_];
+
+  for (size_t begin = 0; begin < input_->size (); begin += block)
+  {
+    const size_t end = std::min (begin + block, input_->size ());
+    computeSquaredDistances (point, begin, end, distances);
+    // NaN distances fail the comparison and are skipped
+    for (size_t i = 0; i < end - begin; ++i)
+    {
+      if (distances[i] <= sqr_radius)
+      {
+        k_indices.push_back (static_cast<int> (begin + i));
+        k_sqr_distances.push_back (distances[i]);
+      }
+    }
+    // Without sorting, the first max_nn neighbors in index order are as good as any
+    if (max_nn > 0 && !sorted_results_ && k_indices.size () >= max_nn)
+      break;
+  }
+
+  if (sorted_results_ && k_indices.size () > 1)
+  {
+    std::vector<std::pair<float, int> > entries (k_indices.size ());
+    for (size_t i = 0; i < entries.size (); ++i)
+      entries[i] = std::make_pair (k_sqr_distances[i], k_indices[i]);
+    std::sort (entries.begin (), entries.end ());
+    for (size_t i = 0; i < entries.size (); ++i)
+    {
+      k_sqr_distances[i] = entries[i].first;
+      k_indices[i] = entries[i].second;
+    }
+  }
+
+  if (max_nn > 0 && k_indices.size () > max_nn)
+  {
+    k_indices.resize (max_nn);
+    k_sqr_distances.resize (max_nn);
+  }
+  return (static_cast<int> (k_indices.size ()));
+}
+
+#define PCL_INSTANTIATE_BruteForceSoA(T) template class PCL_EXPORTS pcl::search::BruteForceSoA<T>;
+
+#endif //PCL_SEARCH_IMPL_BRUTE_FORCE_SOA_H_
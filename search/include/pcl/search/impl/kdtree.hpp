@@ -102,6 +102,14 @@ pcl::search::KdTree<PointT,Tree>::radiusSearch (
   return (tree_->radiusSearch (point, radius, k_indices, k_sqr_distances, max_nn));
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, class Tree> int
+pcl::search::KdTree<PointT,Tree>::radiusSearchCount (
+    const PointT& point, double radius, unsigned int max_count) const
+{
+  return (tree_->radiusSearchCount (point, radius, max_count));
+}
+
 #define PCL_INSTANTIATE_KdTree(T) template class PCL_EXPORTS pcl::search::KdTree<T>;
 
 #endif  //#ifndef _PCL_SEARCH_KDTREE_IMPL_HPP_
@@ -112,6 +112,39 @@ pcl::search::OrganizedNeighbor<PointT>::radiusSearch (const               PointT
   return (static_cast<int> (k_indices.size ()));
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> int
+pcl::search::OrganizedNeighbor<PointT>::radiusSearchCount (const PointT &query,
+                                                           const double radius,
+                                                           unsigned int max_count) const
+{
+  // NAN test
+  assert (isFinite (query) && "Invalid (NaN, Inf) point coordinates given to radiusSearchCount!");
+
+  // search window
+  unsigned left, right, top, bottom;
+  const double squared_radius = radius * radius;
+
+  this->getProjectedRadiusSearchBox (query, static_cast<float> (squared_radius), left, right, top, bottom);
+
+  unsigned count = 0;
+  for (unsigned y = top; y <= bottom; ++y)
+  {
+    for (unsigned idx = y * input_->width + left, xEnd = y * input_->width + right + 1; idx < xEnd; ++idx)
+    {
+      if (!mask_[idx] || !isFinite (input_->points[idx]))
+        continue;
+
+      float dist_x = input_->points[idx].x - query.x;
+      float dist_y = input_->points[idx].y - query.y;
+      float dist_z = input_->points[idx].z - query.z;
+      if (dist_x * dist_x + dist_y * dist_y + dist_z * dist_z <= squared_radius && ++count == max_count)
+        return (static_cast<int> (count));  // never reached if max_count = 0
+    }
+  }
+  return (static_cast<int> (count));
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointT> int
 pcl::search::OrganizedNeighbor<PointT>::nearestKSearch (const PointT &query,
@@ -190,6 +190,36 @@ pcl::search::Search<PointT>::radiusSearch (
   }
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::Search<PointT>::radiusSearchCount (
+    const PointT &point, double radius, unsigned int max_count) const
+{
+  std::vector<int> k_indices;
+  std::vector<float> k_sqr_distances;
+  int k = radiusSearch (point, radius, k_indices, k_sqr_distances, max_count);
+  if (max_count > 0 && k > static_cast<int> (max_count))
+    k = static_cast<int> (max_count);
+  return (k);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::Search<PointT>::radiusSearchCount (
+    int index, double radius, unsigned int max_count) const
+{
+  if (indices_ == NULL)
+  {
+    assert (index >= 0 && index < static_cast<int> (input_->points.size ()) && "Out-of-bounds error in radiusSearchCount!");
+    return (radiusSearchCount (input_->points[index], radius, max_count));
+  }
+  else
+  {
+    assert (index >= 0 && index < static_cast<int> (indices_->size ()) && "Out-of-bounds error in radiusSearchCount!");
+    return (radiusSearchCount (input_->points[(*indices_)[index]], radius, max_count));
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::search::Search<PointT>::sortResults (
@@ -74,6 +74,7 @@ namespace pcl
         using pcl::search::Search<PointT>::getInputCloud;
         using pcl::search::Search<PointT>::nearestKSearch;
         using pcl::search::Search<PointT>::radiusSearch;
+        using pcl::search::Search<PointT>::radiusSearchCount;
         using pcl::search::Search<PointT>::sorted_results_;
 
         typedef boost::shared_ptr<KdTree<PointT, Tree> > Ptr;
@@ -166,6 +167,16 @@ namespace pcl
                       std::vector<int> &k_indices, 
                       std::vector<float> &k_sqr_distances,
                       unsigned int max_nn = 0) const;
+
+        /** \brief Count the neighbors of the query point in a given radius, without collecting them.
+          * \param[in] point the given query point
+          * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+          * \param[in] max_count if given, the search stops after this many neighbors and returns \a max_count.
+          * If \a max_count is set to 0, all neighbors in \a radius are counted.
+          * \return number of neighbors found in radius, at most \a max_count
+          */
+        int
+        radiusSearchCount (const PointT& point, double radius, unsigned int max_count = 0) const;
       protected:
         /** \brief A pointer to the internal KdTree object. */
         KdTreePtr tree_;
@@ -76,6 +76,7 @@ namespace pcl
         using pcl::search::Search<PointT>::indices_;
         using pcl::search::Search<PointT>::sorted_results_;
         using pcl::search::Search<PointT>::input_;
+        using pcl::search::Search<PointT>::radiusSearchCount;
 
         /** \brief Constructor
           * \param[in] sorted_results whether the results should be return sorted in ascending order on the distances or not.
@@ -163,6 +164,18 @@ namespace pcl
                       std::vector<float> &k_sqr_distances,
                       unsigned int max_nn = 0) const;
 
+        /** \brief Count the neighbors of query point that are within a given radius, without collecting them.
+          * \param[in] p_q the given query point
+          * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+          * \param[in] max_count if given, the search stops after this many neighbors and returns \a max_count.
+          * If \a max_count is set to 0, all neighbors in \a radius are counted.
+          * \return number of neighbors found in radius, at most \a max_count
+          */
+        int
+        radiusSearchCount (const PointT &p_q,
+                           double radius,
+                           unsigned int max_count = 0) const;
+
         /** \brief estimated the projection matrix from the input cloud. */
         void 
         estimateProjectionMatrix ();
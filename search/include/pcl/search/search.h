@@ -396,6 +396,35 @@ namespace pcl
           }
         }
 
+        /** \brief Count the neighbors of the query point in a given radius, without collecting them.
+          *
+          * The default implementation falls back to \ref radiusSearch; search methods that can stop
+          * traversing once enough neighbors were found override it.
+          *
+          * \param[in] point the given query point
+          * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+          * \param[in] max_count if given, the search stops after this many neighbors and returns \a max_count.
+          * If \a max_count is set to 0, all neighbors in \a radius are counted.
+          * \return number of neighbors found in radius, at most \a max_count
+          */
+        virtual int
+        radiusSearchCount (const PointT &point, double radius, unsigned int max_count = 0) const;
+
+        /** \brief Count the neighbors of the query point in a given radius, without collecting them (zero-copy).
+          *
+          * \param[in] index a \a valid index representing a \a valid query point in the dataset given
+          * by \a setInputCloud. If indices were given in setInputCloud, index will be the position in
+          * the indices vector.
+          * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+          * \param[in] max_count if given, the search stops after this many neighbors and returns \a max_count.
+          * If \a max_count is set to 0, all neighbors in \a radius are counted.
+          * \return number of neighbors found in radius, at most \a max_count
+          *
+          * \exception asserts in debug mode if the index is not between 0 and the maximum number of points
+          */
+        int
+        radiusSearchCount (int index, double radius, unsigned int max_count = 0) const;
+
       protected:
         void 
         sortResults (std::vector<int>& indices, std::vector<float>& distances) const;
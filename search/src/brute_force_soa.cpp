@@ -0,0 +1,149 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <pcl/impl/instantiate.hpp>
+#include <pcl/point_types.h>
+#include <pcl/common/cpu_dispatch.h>
+#include <pcl/search/brute_force_soa.h>
+#include <pcl/search/impl/brute_force_soa.hpp>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#ifdef PCL_CPU_DISPATCH_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+  typedef void (*SquaredDistancesFn) (const float*, const float*, const float*, size_t,
+                                      float, float, float, float*);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void
+  squaredDistancesGeneric (const float *x, const float *y, const float *z, size_t n,
+                           float qx, float qy, float qz, float *distances)
+  {
+    for (size_t i = 0; i < n; ++i)
+    {
+      const float dx = x[i] - qx, dy = y[i] - qy, dz = z[i] - qz;
+      distances[i] = dx * dx + dy * dy + dz * dz;
+    }
+  }
+
+#if defined(__SSE2__)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void
+  squaredDistancesSSE2 (const float *x, const float *y, const float *z, size_t n,
+                        float qx, float qy, float qz, float *distances)
+  {
+    const __m128 vqx = _mm_set1_ps (qx), vqy = _mm_set1_ps (qy), vqz = _mm_set1_ps (qz);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+      const __m128 dx = _mm_sub_ps (_mm_loadu_ps (x + i), vqx);
+      const __m128 dy = _mm_sub_ps (_mm_loadu_ps (y + i), vqy);
+      const __m128 dz = _mm_sub_ps (_mm_loadu_ps (z + i), vqz);
+      _mm_storeu_ps (distances + i, _mm_add_ps (_mm_add_ps (_mm_mul_ps (dx, dx), _mm_mul_ps (dy, dy)), _mm_mul_ps (dz, dz)));
+    }
+    squaredDistancesGeneric (x + i, y + i, z + i, n - i, qx, qy, qz, distances + i);
+  }
+#endif
+
+#ifdef PCL_CPU_DISPATCH_X86
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  PCL_TARGET_AVX2 void
+  squaredDistancesAVX2 (const float *x, const float *y, const float *z, size_t n,
+                        float qx, float qy, float qz, float *distances)
+  {
+    const __m256 vqx = _mm256_set1_ps (qx), vqy = _mm256_set1_ps (qy), vqz = _mm256_set1_ps (qz);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+      const __m256 dx = _mm256_sub_ps (_mm256_loadu_ps (x + i), vqx);
+      const __m256 dy = _mm256_sub_ps (_mm256_loadu_ps (y + i), vqy);
+      const __m256 dz = _mm256_sub_ps (_mm256_loadu_ps (z + i), vqz);
+      _mm256_storeu_ps (distances + i, _mm256_fmadd_ps (dz, dz, _mm256_fmadd_ps (dy, dy, _mm256_mul_ps (dx, dx))));
+    }
+    squaredDistancesGeneric (x + i, y + i, z + i, n - i, qx, qy, qz, distances + i);
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  PCL_TARGET_AVX512 void
+  squaredDistancesAVX512 (const float *x, const float *y, const float *z, size_t n,
+                          float qx, float qy, float qz, float *distances)
+  {
+    const __m512 vqx = _mm512_set1_ps (qx), vqy = _mm512_set1_ps (qy), vqz = _mm512_set1_ps (qz);
+    for (size_t i = 0; i < n; i += 16)
+    {
+      // The last iteration is masked instead of falling back to scalar code
+      const __mmask16 m = n - i >= 16 ? static_cast<__mmask16> (0xffff) : static_cast<__mmask16> ((1u << (n - i)) - 1);
+      const __m512 dx = _mm512_sub_ps (_mm512_maskz_loadu_ps (m, x + i), vqx);
+      const __m512 dy = _mm512_sub_ps (_mm512_maskz_loadu_ps (m, y + i), vqy);
+      const __m512 dz = _mm512_sub_ps (_mm512_maskz_loadu_ps (m, z + i), vqz);
+      _mm512_mask_storeu_ps (distances + i, m, _mm512_fmadd_ps (dz, dz, _mm512_fmadd_ps (dy, dy, _mm512_mul_ps (dx, dx))));
+    }
+  }
+#endif
+
+  pcl::CpuDispatcher<SquaredDistancesFn>
+  makeSquaredDistancesDispatcher ()
+  {
+    pcl::CpuDispatcher<SquaredDistancesFn> dispatcher (&squaredDistancesGeneric);
+#if defined(__SSE2__)
+    dispatcher.add (pcl::CPU_ISA_SSE2, &squaredDistancesSSE2);
+#endif
+#ifdef PCL_CPU_DISPATCH_X86
+    dispatcher.add (pcl::CPU_ISA_AVX2, &squaredDistancesAVX2);
+    dispatcher.add (pcl::CPU_ISA_AVX512, &squaredDistancesAVX512);
+#endif
+    return (dispatcher);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::search::detail::squaredDistances (const float *x, const float *y, const float *z, size_t n,
+                                       float qx, float qy, float qz, float *distances)
+{
+  static const pcl::CpuDispatcher<SquaredDistancesFn> dispatcher = makeSquaredDistancesDispatcher ();
+  dispatcher.get () (x, y, z, n, qx, qy, qz, distances);
+}
+
+// Instantiations of specific point types
+PCL_INSTANTIATE (BruteForceSoA, PCL_XYZ_POINT_TYPES)
@@ -41,6 +41,7 @@
 #define PCL_EXTRACT_CLUSTERS_H_
 
 #include <pcl/pcl_base.h>
+#include <pcl/common/trace.h>
 
 #include <pcl/search/pcl_search.h>
 
@@ -48,11 +48,14 @@ pcl::extractEuclideanClusters (const PointCloud<PointT> &cloud,
                                unsigned int min_pts_per_cluster, 
                                unsigned int max_pts_per_cluster)
 {
+  PCL_TRACE_ZONE ("pcl::extractEuclideanClusters");
   if (tree->getInputCloud ()->points.size () != cloud.points.size ())
   {
     PCL_ERROR ("[pcl::extractEuclideanClusters] Tree built for a different point cloud dataset (%lu) than the input cloud (%lu)!\n", tree->getInputCloud ()->points.size (), cloud.points.size ());
     return;
   }
+  // Every point gets queued, and searched, exactly once
+  PCL_TRACE_COUNTER ("search calls", cloud.points.size ());
   // Check if the tree is sorted -- if it is we don't need to check the first element
   int nn_start_idx = tree->getSortedResults () ? 1 : 0;
   // Create a bool vector of processed point indices, and initialize it to false
@@ -124,6 +127,7 @@ pcl::extractEuclideanClusters (const PointCloud<PointT> &cloud,
 {
   // \note If the tree was created over <cloud, indices>, we guarantee a 1-1 mapping between what the tree returns
   //and indices[i]
+  PCL_TRACE_ZONE ("pcl::extractEuclideanClusters");
   if (tree->getInputCloud ()->points.size () != cloud.points.size ())
   {
     PCL_ERROR ("[pcl::extractEuclideanClusters] Tree built for a different point cloud dataset (%lu) than the input cloud (%lu)!\n", tree->getInputCloud ()->points.size (), cloud.points.size ());
@@ -134,6 +138,8 @@ pcl::extractEuclideanClusters (const PointCloud<PointT> &cloud,
     PCL_ERROR ("[pcl::extractEuclideanClusters] Tree built for a different set of indices (%lu) than the input set (%lu)!\n", tree->getIndices ()->size (), indices.size ());
     return;
   }
+  // Every point gets queued, and searched, exactly once
+  PCL_TRACE_COUNTER ("search calls", indices.size ());
   // Check if the tree is sorted -- if it is we don't need to check the first element
   int nn_start_idx = tree->getSortedResults () ? 1 : 0;
 
@@ -209,6 +215,7 @@ pcl::extractEuclideanClusters (const PointCloud<PointT> &cloud,
 template <typename PointT> void 
 pcl::EuclideanClusterExtraction<PointT>::extract (std::vector<PointIndices> &clusters)
 {
+  PCL_TRACE_ZONE ("pcl::EuclideanClusterExtraction::extract");
   if (!initCompute () || 
       (input_ != 0   && input_->points.empty ()) ||
       (indices_ != 0 && indices_->empty ()))
@@ -227,7 +234,10 @@ pcl::EuclideanClusterExtraction<PointT>::extract (std::vector<PointIndices> &clu
   }
 
   // Send the input dataset to the spatial locator
-  tree_->setInputCloud (input_, indices_);
+  {
+    PCL_TRACE_ZONE ("pcl::EuclideanClusterExtraction search tree");
+    tree_->setInputCloud (input_, indices_);
+  }
   extractEuclideanClusters (*input_, *indices_, tree_, static_cast<float> (cluster_tolerance_), clusters, min_pts_per_cluster_, max_pts_per_cluster_);
 
   //tree_->setInputCloud (input_);
@@ -74,6 +74,7 @@
 template <typename PointT> void
 pcl::SACSegmentation<PointT>::segment (PointIndices &inliers, ModelCoefficients &model_coefficients)
 {
+  PCL_TRACE_ZONE ("pcl::SACSegmentation::segment");
   // Copy the header information
   inliers.header = model_coefficients.header = input_->header;
 
@@ -82,6 +83,7 @@ pcl::SACSegmentation<PointT>::segment (PointIndices &inliers, ModelCoefficients
     inliers.indices.clear (); model_coefficients.values.clear ();
     return;
   }
+  PCL_TRACE_COUNTER ("segmentation points", indices_->size ());
 
   // Initialize the Sample Consensus model and set its parameters
   if (!initSACModel (model_type_))
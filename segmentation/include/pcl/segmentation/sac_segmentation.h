@@ -41,6 +41,7 @@
 #define PCL_SEGMENTATION_SAC_SEGMENTATION_H_
 
 #include <pcl/pcl_base.h>
+#include <pcl/common/trace.h>
 #include <pcl/PointIndices.h>
 #include <pcl/ModelCoefficients.h>
 
@@ -1009,6 +1009,87 @@ TEST (PCL, computeCentroid)
   EXPECT_FLOAT_EQ (-500, centroid.curvature);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, computeMeanAndCovarianceLargeCloud)
+{
+  // Large enough for the blocked double precision reduction, and far enough from the origin
+  // for the single pass float formula E[xx] - E[x]E[x] to lose all significant digits
+  const size_t size = 3 * pcl::detail::centroid_reduction_threshold + 17;
+  PointCloud<PointXYZ> cloud;
+  cloud.resize (size);
+  for (size_t i = 0; i < size; ++i)
+  {
+    cloud[i].x = 10000.0f + static_cast<float> (i % 101) * 0.01f;
+    cloud[i].y = -5000.0f + static_cast<float> (i % 37) * 0.02f;
+    cloud[i].z = 2000.0f + static_cast<float> ((i * 7) % 53) * 0.005f;
+  }
+  cloud[5].y = std::numeric_limits<float>::quiet_NaN ();
+  cloud[size - 1].z = std::numeric_limits<float>::infinity ();
+  cloud.is_dense = false;
+
+  std::vector<int> indices;
+  for (size_t i = 0; i < size; i += 2)
+    indices.push_back (static_cast<int> (i));
+
+  for (int use_indices = 0; use_indices < 2; ++use_indices)
+  {
+    // Two pass reference in long double
+    const size_t n = use_indices ? indices.size () : size;
+    long double mean[3] = { 0, 0, 0 }, cov[3][3] = { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } };
+    unsigned int count = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      const PointXYZ &pt = cloud[use_indices ? indices[i] : i];
+      if (!isFinite (pt))
+        continue;
+      for (int d = 0; d < 3; ++d)
+        mean[d] += pt.data[d];
+      ++count;
+    }
+    for (int d = 0; d < 3; ++d)
+      mean[d] /= count;
+    for (size_t i = 0; i < n; ++i)
+    {
+      const PointXYZ &pt = cloud[use_indices ? indices[i] : i];
+      if (!isFinite (pt))
+        continue;
+      for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 3; ++c)
+          cov[r][c] += (pt.data[r] - mean[r]) * (pt.data[c] - mean[c]);
+    }
+
+    Eigen::Vector4f centroid;
+    Eigen::Matrix3f covariance_matrix, covariance_two_pass;
+    Eigen::Vector4d centroid_d;
+    if (use_indices)
+    {
+      EXPECT_EQ (count, computeMeanAndCovarianceMatrix (cloud, indices, covariance_matrix, centroid));
+      EXPECT_EQ (count, compute3DCentroid (cloud, indices, centroid_d));
+      EXPECT_EQ (count, computeCovarianceMatrixNormalized (cloud, indices, centroid, covariance_two_pass));
+    }
+    else
+    {
+      EXPECT_EQ (count, computeMeanAndCovarianceMatrix (cloud, covariance_matrix, centroid));
+      EXPECT_EQ (count, compute3DCentroid (cloud, centroid_d));
+      EXPECT_EQ (count, computeCovarianceMatrixNormalized (cloud, centroid, covariance_two_pass));
+    }
+
+    for (int r = 0; r < 3; ++r)
+    {
+      EXPECT_NEAR (static_cast<double> (mean[r]), centroid[r], 1e-3);
+      EXPECT_NEAR (static_cast<double> (mean[r]), centroid_d[r], 1e-9);
+      for (int c = 0; c < 3; ++c)
+      {
+        const double expected = static_cast<double> (cov[r][c] / count);
+        EXPECT_NEAR (expected, covariance_matrix (r, c), 1e-6);
+        EXPECT_NEAR (expected, covariance_two_pass (r, c), 1e-6);
+      }
+    }
+    EXPECT_EQ (1.0f, centroid[3]);
+    EXPECT_EQ (1.0, centroid_d[3]);
+  }
+}
+
 int
 main (int argc, char** argv)
 {
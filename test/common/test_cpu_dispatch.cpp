@@ -0,0 +1,142 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include <gtest/gtest.h>
+#include <pcl/common/cpu_dispatch.h>
+
+using namespace pcl;
+
+int
+levelOne ()
+{
+  return (1);
+}
+
+int
+levelTwo ()
+{
+  return (2);
+}
+
+int
+levelFour ()
+{
+  return (4);
+}
+
+typedef int (*LevelFn) ();
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (CpuDispatch, ParseAndNames)
+{
+  CpuIsa isa = CPU_ISA_COUNT;
+  for (int i = 0; i < CPU_ISA_COUNT; ++i)
+  {
+    EXPECT_TRUE (parseCpuIsa (getCpuIsaName (static_cast<CpuIsa> (i)), isa));
+    EXPECT_EQ (i, isa);
+  }
+  EXPECT_TRUE (parseCpuIsa ("AVX2", isa));
+  EXPECT_EQ (CPU_ISA_AVX2, isa);
+  EXPECT_TRUE (parseCpuIsa ("sse42", isa));
+  EXPECT_EQ (CPU_ISA_SSE4_2, isa);
+  EXPECT_TRUE (parseCpuIsa ("AVX-512", isa));
+  EXPECT_EQ (CPU_ISA_AVX512, isa);
+  EXPECT_FALSE (parseCpuIsa ("neon", isa));
+  EXPECT_FALSE (parseCpuIsa ("", isa));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (CpuDispatch, Clamping)
+{
+  const CpuIsa host = getHostCpuIsa ();
+  const CpuIsa previous = getDispatchCpuIsa ();
+  EXPECT_LE (previous, host);
+
+  setDispatchCpuIsa (CPU_ISA_AVX512);
+  EXPECT_EQ (host, getDispatchCpuIsa ());
+  setDispatchCpuIsa (CPU_ISA_GENERIC);
+  EXPECT_EQ (CPU_ISA_GENERIC, getDispatchCpuIsa ());
+
+  setDispatchCpuIsa (previous);
+  EXPECT_EQ (previous, getDispatchCpuIsa ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (CpuDispatch, Dispatcher)
+{
+  const CpuIsa host = getHostCpuIsa ();
+  const CpuIsa previous = getDispatchCpuIsa ();
+
+  // Levels one, two and four registered, three missing
+  CpuDispatcher<LevelFn> dispatcher (&levelOne);
+  dispatcher.add (CPU_ISA_SSE4_2, &levelTwo).add (CPU_ISA_AVX512, &levelFour);
+
+  EXPECT_EQ (1, dispatcher.get (CPU_ISA_GENERIC) ());
+  EXPECT_EQ (CPU_ISA_GENERIC, dispatcher.resolve (CPU_ISA_SSE2));
+  for (int i = 0; i < CPU_ISA_COUNT; ++i)
+  {
+    const CpuIsa isa = static_cast<CpuIsa> (i);
+    const CpuIsa resolved = dispatcher.resolve (isa);
+    // Never above the request or the host, and never a missing level
+    EXPECT_LE (resolved, isa);
+    EXPECT_LE (resolved, host);
+    EXPECT_NE (CPU_ISA_SSE2, resolved);
+    EXPECT_NE (CPU_ISA_AVX2, resolved);
+    if (host >= CPU_ISA_SSE4_2 && isa >= CPU_ISA_SSE4_2 && isa < CPU_ISA_AVX512)
+      EXPECT_EQ (2, dispatcher.get (isa) ());
+  }
+  if (host == CPU_ISA_AVX512)
+    EXPECT_EQ (4, dispatcher.get (CPU_ISA_AVX512) ());
+
+  // get () follows the dispatch setting
+  setDispatchCpuIsa (CPU_ISA_GENERIC);
+  EXPECT_EQ (1, dispatcher.get () ());
+  setDispatchCpuIsa (CPU_ISA_AVX512);
+  EXPECT_EQ (dispatcher.get (host), dispatcher.get ());
+  setDispatchCpuIsa (previous);
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  testing::InitGoogleTest (&argc, argv);
+  return (RUN_ALL_TESTS ());
+}
+/* ]--- */
@@ -40,6 +40,7 @@
 #include <gtest/gtest.h>
 #include <pcl/point_types.h>
 #include <pcl/common/eigen.h>
+#include <pcl/common/cpu_dispatch.h>
 #include "boost.h"
 
 using namespace pcl;
@@ -799,6 +800,107 @@ TEST (PCL, eigen33f)
   EXPECT_LE (float(r_fail_count) / float(iterations), 0.01);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline bool
+isEigenPair (const Eigen::Matrix3f& matrix, float value, const Eigen::Vector3f& vector, float epsilon)
+{
+  const float norm = std::max (1.0f, matrix.cwiseAbs ().maxCoeff ());
+  return (std::abs (vector.norm () - 1.0f) <= epsilon &&
+          (matrix * vector - value * vector).norm () <= epsilon * norm);
+}
+
+// U * V * U^T = M with orthonormal U and ascending eigenvalues
+bool
+isDecomposition (const Eigen::Matrix3f& matrix, const Eigen::Matrix3f& evecs, const Eigen::Vector3f& evals, float epsilon)
+{
+  const float norm = std::max (1.0f, matrix.cwiseAbs ().maxCoeff ());
+  const Eigen::Matrix3f result = evecs * evals.asDiagonal () * evecs.transpose ();
+  return ((result - matrix).cwiseAbs ().sum () <= epsilon * norm &&
+          (evecs * evecs.transpose () - Eigen::Matrix3f::Identity ()).cwiseAbs ().sum () <= epsilon &&
+          evals[0] <= evals[1] && evals[1] <= evals[2]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// the batched solver runs once per instruction set the host supports; as for eigen33f the single precision errors
+// are checked against a failure rate instead of per matrix
+TEST (PCL, eigen33fBatch)
+{
+  const size_t count = 10007;   // not a multiple of any lane width
+  const float epsilon = 1e-3f;
+  std::vector<Eigen::Matrix3f, Eigen::aligned_allocator<Eigen::Matrix3f> > matrices (count);
+  for (size_t i = 0; i < count; ++i)
+    generateSymPosMatrix3x3 (matrices[i]);
+  // degenerate inputs: zero, scaled identity and a rank one matrix (whose eigenvectors for the smallest eigenvalue
+  // are left undefined by the scalar solver as well)
+  matrices[0].setZero ();
+  matrices[1] = 3.0f * Eigen::Matrix3f::Identity ();
+  matrices[2] = Eigen::Vector3f (1.0f, 2.0f, 2.0f) * Eigen::Vector3f (1.0f, 2.0f, 2.0f).transpose ();
+  // distinct eigenvalues whose eigenvector candidates have equal lengths, which exercises the tie breaking
+  matrices[3] = Eigen::Vector3f (1.0f, 2.0f, 3.0f).asDiagonal ();
+  matrices[4] = Eigen::Vector3f (3.0f, 1.0f, 2.0f).asDiagonal ();
+  matrices[5] << 2.0f, 1.0f, 0.0f, 1.0f, 2.0f, 0.0f, 0.0f, 0.0f, 5.0f;
+
+  std::vector<float> ref_values (count);
+  std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f> > ref_vectors (count);
+  std::vector<Eigen::Matrix3f, Eigen::aligned_allocator<Eigen::Matrix3f> > ref_evecs (count);
+  std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f> > ref_evals (count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    pcl::eigen33 (matrices[i], ref_values[i], ref_vectors[i]);
+    pcl::eigen33 (matrices[i], ref_evecs[i], ref_evals[i]);
+  }
+
+  const pcl::CpuIsa previous = pcl::getDispatchCpuIsa ();
+  for (int isa = pcl::CPU_ISA_GENERIC; isa <= pcl::getHostCpuIsa (); ++isa)
+  {
+    pcl::setDispatchCpuIsa (static_cast<pcl::CpuIsa> (isa));
+    SCOPED_TRACE (pcl::getCpuIsaName (static_cast<pcl::CpuIsa> (isa)));
+
+    std::vector<float> values (count);
+    std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f> > vectors (count);
+    pcl::eigen33 (&matrices[0], count, &values[0], &vectors[0]);
+
+    std::vector<Eigen::Matrix3f, Eigen::aligned_allocator<Eigen::Matrix3f> > evecs (count);
+    std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f> > evals (count);
+    pcl::eigen33 (&matrices[0], count, &evecs[0], &evals[0]);
+
+    EXPECT_EQ (0.0f, values[0]);
+    EXPECT_NEAR (3.0f, values[1], 1e-5f);
+    EXPECT_NEAR (0.0f, values[2], 1e-5f);
+    EXPECT_TRUE (evals[0].isZero ());
+    EXPECT_TRUE (evecs[1].isApprox (Eigen::Matrix3f::Identity ()));
+    EXPECT_TRUE (evals[2].isApprox (Eigen::Vector3f (0.0f, 0.0f, 9.0f)));
+    // the same vectors are rebuilt as by the scalar solver
+    for (int i = 3; i < 6; ++i)
+    {
+      EXPECT_TRUE (evals[i].isApprox (ref_evals[i], 1e-5f));
+      EXPECT_TRUE (evecs[i].isApprox (ref_evecs[i], 1e-5f));
+    }
+
+    unsigned pair_fail_count = 0;
+    unsigned full_fail_count = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+      // the smallest eigenvalue matches the scalar solver and its eigenvector solves M * v = lambda * v wherever the
+      // scalar eigenvector does
+      const float norm = std::max (1.0f, matrices[i].cwiseAbs ().maxCoeff ());
+      if (std::abs (values[i] - ref_values[i]) > epsilon * norm ||
+          (!isEigenPair (matrices[i], values[i], vectors[i], epsilon) &&
+           isEigenPair (matrices[i], ref_values[i], ref_vectors[i], epsilon)))
+        ++pair_fail_count;
+
+      // the full decomposition holds wherever the scalar one does
+      if (!isDecomposition (matrices[i], evecs[i], evals[i], epsilon) &&
+          isDecomposition (matrices[i], ref_evecs[i], ref_evals[i], epsilon))
+        ++full_fail_count;
+    }
+    // less than 1% failure rate
+    EXPECT_LE (float (pair_fail_count) / float (count), 0.01);
+    EXPECT_LE (float (full_fail_count) / float (count), 0.01);
+  }
+  pcl::setDispatchCpuIsa (previous);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, transformLine)
 {
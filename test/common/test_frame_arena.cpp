@@ -0,0 +1,198 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include <gtest/gtest.h>
+#include <pcl/common/frame_arena.h>
+#include <pcl/point_types.h>
+#include <boost/thread/thread.hpp>
+
+using namespace pcl;
+
+/** \brief A two stage pipeline: a filter writing size points into a cloud, and an index extraction. */
+void
+processFrame (FrameArena &arena, size_t size, PointCloud<PointXYZ>::Ptr &kept)
+{
+  PointCloud<PointXYZ>::Ptr filtered = arena.acquireCloud<PointXYZ> ();
+  {
+    FrameArena::ScopedStage stage (arena, "filter");
+    for (size_t i = 0; i < size; ++i)
+      filtered->push_back (PointXYZ (static_cast<float> (i), 0.0f, 0.0f));
+  }
+
+  IndicesPtr indices;
+  {
+    FrameArena::ScopedStage stage (arena, "indices");
+    indices = arena.acquireIndices ();
+    for (size_t i = 0; i < size; i += 2)
+      indices->push_back (static_cast<int> (i));
+  }
+  kept = filtered;
+}
+
+void
+acquireAndStore (FrameArena *&arena, PointCloud<PointXYZ>::Ptr &cloud)
+{
+  arena = &FrameArena::getThreadArena ();
+  cloud = arena->acquireCloud<PointXYZ> ();
+}
+
+void
+release (PointCloud<PointXYZ>::Ptr &cloud)
+{
+  cloud.reset ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (FrameArena, Recycling)
+{
+  FrameArena arena;
+  EXPECT_EQ ("default", arena.getStage ());
+
+  PointCloud<PointXYZ>::Ptr cloud = arena.acquireCloud<PointXYZ> ();
+  cloud->resize (1000);
+  cloud->header.frame_id = "sensor";
+  cloud->is_dense = false;
+  const PointCloud<PointXYZ> *address = cloud.get ();
+
+  // A cloud still referenced is not handed out again
+  PointCloud<PointXYZ>::Ptr other = arena.acquireCloud<PointXYZ> ();
+  EXPECT_NE (address, other.get ());
+  EXPECT_EQ (2u, arena.getNumberOfBuffersInUse ());
+
+  // Released clouds come back emptied, with their capacity
+  cloud.reset ();
+  cloud = arena.acquireCloud<PointXYZ> ();
+  EXPECT_EQ (address, cloud.get ());
+  EXPECT_TRUE (cloud->empty ());
+  EXPECT_EQ (0u, cloud->width);
+  EXPECT_TRUE (cloud->header.frame_id.empty ());
+  EXPECT_TRUE (cloud->is_dense);
+  EXPECT_LE (1000u, cloud->points.capacity ());
+
+  // Every type has its own buffers
+  PointCloud<Normal>::Ptr normals = arena.acquireCloud<Normal> ();
+  PointIndices::Ptr point_indices = arena.acquirePointIndices ();
+  point_indices->indices.resize (10);
+  IndicesPtr indices = arena.acquireIndices ();
+  EXPECT_EQ (5u, arena.getNumberOfBuffers ());
+  point_indices.reset ();
+  EXPECT_TRUE (arena.acquirePointIndices ()->indices.empty ());
+
+  // trim () frees exactly the buffers not in use
+  cloud.reset ();
+  normals.reset ();
+  arena.trim ();
+  EXPECT_EQ (2u, arena.getNumberOfBuffers ());
+  EXPECT_EQ (2u, arena.getNumberOfBuffersInUse ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (FrameArena, SteadyStateStatistics)
+{
+  FrameArena arena;
+  PointCloud<PointXYZ>::Ptr previous;
+
+  arena.beginFrame ();
+  processFrame (arena, 5000, previous);
+  const FrameArena::StatisticsMap &statistics = arena.getStatistics ();
+  ASSERT_EQ (1u, statistics.count ("filter"));
+  EXPECT_EQ (0u, statistics.find ("filter")->second.acquisitions);
+  EXPECT_LE (5000 * sizeof (PointXYZ), statistics.find ("filter")->second.bytes_allocated);
+  EXPECT_LE (2500 * sizeof (int), statistics.find ("indices")->second.bytes_allocated);
+  EXPECT_EQ (1u, statistics.find ("indices")->second.buffers_created);
+  EXPECT_LE (arena.getBytesAllocated (), arena.getBytesReserved ());
+
+  // The output of the previous frame is kept alive while the next one runs, so the
+  // pipeline settles on two clouds and one index buffer
+  arena.resetStatistics ();
+  for (int frame = 0; frame < 5; ++frame)
+  {
+    arena.beginFrame ();
+    processFrame (arena, 5000 - 100 * frame, previous);
+    if (frame == 0)
+      arena.resetStatistics ();
+  }
+  EXPECT_EQ (0u, arena.getBytesAllocated ());
+  EXPECT_EQ (3u, arena.getNumberOfBuffers ());
+  EXPECT_EQ (0u, arena.getStatistics ().find ("default")->second.buffers_created);
+  EXPECT_EQ (4u, arena.getStatistics ().find ("indices")->second.acquisitions);
+
+  // A larger frame charges the growth to the stage that was active while the buffers grew,
+  // not to the one that acquired them
+  processFrame (arena, 20000, previous);
+  EXPECT_LE (10000 * sizeof (int), arena.getStatistics ().find ("indices")->second.bytes_allocated);
+  EXPECT_LE (15000 * sizeof (PointXYZ), arena.getStatistics ().find ("filter")->second.bytes_allocated);
+  EXPECT_EQ (0u, arena.getStatistics ().find ("default")->second.bytes_allocated);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (FrameArena, ThreadArenas)
+{
+  FrameArena &arena = FrameArena::getThreadArena ();
+  EXPECT_EQ (&arena, &FrameArena::getThreadArena ());
+
+  FrameArena *first = NULL, *second = NULL;
+  PointCloud<PointXYZ>::Ptr first_cloud, second_cloud;
+  boost::thread first_thread (boost::bind (&acquireAndStore, boost::ref (first), boost::ref (first_cloud)));
+  boost::thread second_thread (boost::bind (&acquireAndStore, boost::ref (second), boost::ref (second_cloud)));
+  first_thread.join ();
+  second_thread.join ();
+  EXPECT_NE (first, second);
+  EXPECT_NE (&arena, first);
+
+  // Buffers outlive the arena of their thread
+  first_cloud->resize (10);
+  EXPECT_EQ (10u, first_cloud->size ());
+
+  // and may be released by another thread than the one owning the arena
+  PointCloud<PointXYZ>::Ptr cloud = arena.acquireCloud<PointXYZ> ();
+  const PointCloud<PointXYZ> *address = cloud.get ();
+  boost::thread release_thread (boost::bind (&release, boost::ref (cloud)));
+  release_thread.join ();
+  EXPECT_EQ (address, arena.acquireCloud<PointXYZ> ().get ());
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  testing::InitGoogleTest (&argc, argv);
+  return (RUN_ALL_TESTS ());
+}
+/* ]--- */
@@ -350,6 +350,73 @@ TEST (PCL, CopyPointCloudWithSameTypes)
   ASSERT_EQ (0, cloud_out.size ());
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, fromPCLPointCloud2Layouts)
+{
+  // A reordered layout with per point and per row padding, large enough to be converted in parallel
+  pcl::PCLPointCloud2 msg;
+  msg.width = 300;
+  msg.height = 250;
+  msg.point_step = 20;
+  msg.row_step = msg.width * msg.point_step + 8;
+  const char* names[] = { "rgb", "x", "y", "z" };
+  for (int f = 0; f < 4; ++f)
+  {
+    pcl::PCLPointField field;
+    field.name = names[f];
+    field.offset = f * 4;
+    field.datatype = pcl::PCLPointField::FLOAT32;
+    field.count = 1;
+    msg.fields.push_back (field);
+  }
+  msg.data.resize (msg.row_step * msg.height);
+  for (uint32_t row = 0; row < msg.height; ++row)
+    for (uint32_t col = 0; col < msg.width; ++col)
+    {
+      const uint32_t values[] = { row * 1000 + col, col, row, col + row };
+      for (int f = 0; f < 4; ++f)
+      {
+        float value = static_cast<float> (values[f]);
+        if (f == 0)
+          memcpy (&value, &values[0], sizeof (float));
+        memcpy (&msg.data[row * msg.row_step + col * msg.point_step + f * 4], &value, sizeof (float));
+      }
+    }
+
+  CloudXYZRGB cloud;
+  pcl::fromPCLPointCloud2 (msg, cloud);
+  ASSERT_EQ (msg.width * msg.height, cloud.size ());
+  for (uint32_t row = 0; row < msg.height; ++row)
+    for (uint32_t col = 0; col < msg.width; ++col)
+    {
+      const PointXYZRGB& p = cloud (col, row);
+      EXPECT_EQ (float (col), p.x);
+      EXPECT_EQ (float (row), p.y);
+      EXPECT_EQ (float (col + row), p.z);
+      EXPECT_EQ (row * 1000 + col, p.rgba);
+    }
+
+  // The conversion plan is cached per point type and field layout
+  boost::shared_ptr<const MsgFieldMap> field_map = pcl::getFieldMap<PointXYZRGB> (msg.fields);
+  EXPECT_EQ (field_map, pcl::getFieldMap<PointXYZRGB> (msg.fields));
+  EXPECT_NE (field_map, pcl::getFieldMap<PointXYZ> (msg.fields));
+  std::vector<pcl::PCLPointField> fields = msg.fields;
+  fields[1].offset = 16;
+  EXPECT_NE (field_map, pcl::getFieldMap<PointXYZRGB> (fields));
+
+  // Round trip through the contiguous path
+  CloudXYZRGB cloud2;
+  pcl::PCLPointCloud2 msg2;
+  pcl::toPCLPointCloud2 (cloud, msg2);
+  pcl::fromPCLPointCloud2 (msg2, cloud2);
+  ASSERT_EQ (cloud.size (), cloud2.size ());
+  for (size_t i = 0; i < cloud.size (); ++i)
+  {
+    EXPECT_XYZ_EQ (cloud[i], cloud2[i]);
+    EXPECT_EQ (cloud[i].rgba, cloud2[i].rgba);
+  }
+}
+
 /* ---[ */
 int
 main (int argc, char** argv)
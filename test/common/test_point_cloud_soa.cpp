@@ -0,0 +1,244 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <gtest/gtest.h>
+#include <pcl/pcl_tests.h>
+#include <pcl/point_types.h>
+#include <pcl/point_cloud_soa.h>
+#include <pcl/common/common.h>
+#include <pcl/common/centroid.h>
+#include <pcl/common/transforms.h>
+
+using namespace pcl;
+
+PointCloud<PointXYZRGBNormal> cloud;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PointCloudSoA, Layout)
+{
+  PointCloudSoA<PointXYZRGBNormal> soa (cloud);
+  EXPECT_EQ (cloud.size (), soa.size ());
+  EXPECT_EQ (cloud.width, soa.width);
+  EXPECT_EQ (cloud.height, soa.height);
+  EXPECT_EQ (cloud.is_dense, soa.is_dense);
+
+  // Padding is not stored
+  EXPECT_EQ (-1, soa.getFieldIndex ("_"));
+  ASSERT_GE (soa.getFieldIndex ("curvature"), 0);
+  EXPECT_EQ (sizeof (float), soa.getElementSize (soa.getFieldIndex ("curvature")));
+
+  // Typed access checks the datatype
+  EXPECT_TRUE (soa.getColumn<float> ("normal_y") != NULL);
+  EXPECT_TRUE (soa.getColumn<double> ("normal_y") == NULL);
+  EXPECT_TRUE (soa.getColumn<float> ("does_not_exist") == NULL);
+  EXPECT_EQ (soa.getColumn<float> ("x"), soa.x ());
+
+  const float *x = soa.x (), *y = soa.y (), *z = soa.z ();
+  const float *nz = soa.getColumn<float> ("normal_z");
+  for (size_t i = 0; i < cloud.size (); ++i)
+  {
+    EXPECT_EQ (cloud[i].x, x[i]);
+    EXPECT_EQ (cloud[i].y, y[i]);
+    EXPECT_EQ (cloud[i].z, z[i]);
+    EXPECT_EQ (cloud[i].normal_z, nz[i]);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PointCloudSoA, RoundTrip)
+{
+  PointCloudSoA<PointXYZRGBNormal> soa (cloud);
+  PointCloud<PointXYZRGBNormal> back;
+  soa.toPointCloud (back);
+  ASSERT_EQ (cloud.size (), back.size ());
+  EXPECT_EQ (cloud.width, back.width);
+  EXPECT_EQ (cloud.height, back.height);
+  for (size_t i = 0; i < cloud.size (); ++i)
+  {
+    EXPECT_XYZ_EQ (cloud[i], back[i]);
+    EXPECT_NORMAL_EQ (cloud[i], back[i]);
+    EXPECT_EQ (cloud[i].rgba, back[i].rgba);
+    EXPECT_EQ (cloud[i].curvature, back[i].curvature);
+  }
+
+  // Single point access
+  PointXYZRGBNormal pt = soa.at (3);
+  EXPECT_XYZ_EQ (cloud[3], pt);
+  pt.x = 42.0f;
+  pt.rgba = 0x00ff00ff;
+  soa.set (0, pt);
+  soa.push_back (pt);
+  EXPECT_EQ (cloud.size () + 1, soa.size ());
+  EXPECT_EQ (1, soa.height);
+  EXPECT_EQ (42.0f, soa.x ()[0]);
+  EXPECT_EQ (42.0f, soa.at (soa.size () - 1).x);
+  EXPECT_EQ (0x00ff00ffu, soa.at (0).rgba);
+  EXPECT_EQ (cloud[3].normal_x, soa.at (soa.size () - 1).normal_x);
+
+  soa.clear ();
+  EXPECT_TRUE (soa.empty ());
+  EXPECT_TRUE (soa.x () == NULL);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PointCloudSoA, PCLPointCloud2)
+{
+  PointCloudSoA<PointXYZRGBNormal> soa (cloud);
+
+  // The blob must be the one written for the array-of-structs cloud
+  PCLPointCloud2 msg, ref_msg;
+  toPCLPointCloud2 (soa, msg);
+  toPCLPointCloud2 (cloud, ref_msg);
+  EXPECT_EQ (ref_msg.width, msg.width);
+  EXPECT_EQ (ref_msg.height, msg.height);
+  EXPECT_EQ (ref_msg.point_step, msg.point_step);
+  EXPECT_EQ (ref_msg.row_step, msg.row_step);
+  ASSERT_EQ (ref_msg.fields.size (), msg.fields.size ());
+  for (size_t f = 0; f < msg.fields.size (); ++f)
+  {
+    EXPECT_EQ (ref_msg.fields[f].name, msg.fields[f].name);
+    EXPECT_EQ (ref_msg.fields[f].offset, msg.fields[f].offset);
+  }
+
+  PointCloudSoA<PointXYZRGBNormal> from_soa;
+  fromPCLPointCloud2 (ref_msg, from_soa);
+  ASSERT_EQ (cloud.size (), from_soa.size ());
+  for (size_t i = 0; i < cloud.size (); ++i)
+  {
+    PointXYZRGBNormal pt = from_soa.at (i);
+    EXPECT_XYZ_EQ (cloud[i], pt);
+    EXPECT_NORMAL_EQ (cloud[i], pt);
+    EXPECT_EQ (cloud[i].rgba, pt.rgba);
+  }
+
+  // Only the matching fields are filled
+  PointCloudSoA<PointXYZ> xyz;
+  fromPCLPointCloud2 (msg, xyz);
+  ASSERT_EQ (cloud.size (), xyz.size ());
+  for (size_t i = 0; i < cloud.size (); ++i)
+    EXPECT_XYZ_EQ (cloud[i], xyz.at (i));
+
+  // Fields missing from the blob are zeroed, not left from an earlier conversion
+  PCLPointCloud2 xyz_msg;
+  toPCLPointCloud2 (xyz, xyz_msg);
+  fromPCLPointCloud2 (xyz_msg, from_soa);
+  ASSERT_EQ (cloud.size (), from_soa.size ());
+  for (size_t i = 0; i < cloud.size (); ++i)
+  {
+    PointXYZRGBNormal pt = from_soa.at (i);
+    EXPECT_XYZ_EQ (cloud[i], pt);
+    EXPECT_EQ (0.0f, pt.normal_x);
+    EXPECT_EQ (0.0f, pt.curvature);
+    EXPECT_EQ (0u, pt.rgba);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PointCloudSoA, Kernels)
+{
+  PointCloud<PointXYZRGBNormal> sparse = cloud;
+  sparse.is_dense = false;
+  sparse[5].x = std::numeric_limits<float>::quiet_NaN ();
+  sparse[7].z = std::numeric_limits<float>::infinity ();
+  PointCloudSoA<PointXYZRGBNormal> soa (sparse);
+
+  Eigen::Vector4f min_pt, max_pt, ref_min_pt, ref_max_pt;
+  getMinMax3D (soa, min_pt, max_pt);
+  getMinMax3D (sparse, ref_min_pt, ref_max_pt);
+  EXPECT_EQ (ref_min_pt.head<3> (), min_pt.head<3> ());
+  EXPECT_EQ (ref_max_pt.head<3> (), max_pt.head<3> ());
+
+  Eigen::Vector4d centroid, ref_centroid;
+  EXPECT_EQ (compute3DCentroid (sparse, ref_centroid), compute3DCentroid (soa, centroid));
+  EXPECT_NEAR ((centroid - ref_centroid).norm (), 0.0, 1e-10);
+
+  Eigen::Affine3f transform = Eigen::Affine3f::Identity ();
+  transform.rotate (Eigen::AngleAxisf (0.3f, Eigen::Vector3f (1, 2, 3).normalized ()));
+  transform.translation () << 1.0f, -2.0f, 0.5f;
+
+  PointCloud<PointXYZRGBNormal> ref_out;
+  PointCloudSoA<PointXYZRGBNormal> out;
+  transformPointCloudWithNormals (sparse, ref_out, transform);
+  transformPointCloudWithNormals (soa, out, transform);
+  ASSERT_EQ (ref_out.size (), out.size ());
+  for (size_t i = 0; i < ref_out.size (); ++i)
+  {
+    PointXYZRGBNormal pt = out.at (i);
+    if (!isFinite (ref_out[i]))
+    {
+      EXPECT_FALSE (isFinite (pt));
+      continue;
+    }
+    EXPECT_XYZ_NEAR (ref_out[i], pt, 1e-5);
+    EXPECT_NORMAL_NEAR (ref_out[i], pt, 1e-5);
+    EXPECT_EQ (ref_out[i].rgba, pt.rgba);
+  }
+
+  // In place
+  transformPointCloud (soa, soa, transform);
+  for (size_t i = 0; i < soa.size (); ++i)
+  {
+    if (isFinite (ref_out[i]))
+      EXPECT_XYZ_NEAR (ref_out[i], soa.at (i), 1e-5);
+  }
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  const int size = 200;
+  cloud.width = size;
+  cloud.height = 1;
+  for (int i = 0; i < size; ++i)
+  {
+    PointXYZRGBNormal pt;
+    pt.x = static_cast<float> (i % 17) - 8.0f;
+    pt.y = static_cast<float> (i % 13) * 0.5f;
+    pt.z = static_cast<float> (i) * 0.01f;
+    Eigen::Vector3f normal (static_cast<float> (i % 5), 1.0f, static_cast<float> (i % 3));
+    pt.getNormalVector3fMap () = normal.normalized ();
+    pt.curvature = static_cast<float> (i) / size;
+    pt.rgba = 0xff000000 | static_cast<uint32_t> (i);
+    cloud.push_back (pt);
+  }
+
+  testing::InitGoogleTest (&argc, argv);
+  return (RUN_ALL_TESTS ());
+}
+/* ]--- */
@@ -0,0 +1,145 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include <gtest/gtest.h>
+#include <pcl/range_image/range_image.h>
+#include <pcl/range_image/range_image_planar.h>
+#include <pcl/common/task_scheduler.h>
+#include <pcl/point_types.h>
+#include <boost/random.hpp>
+
+using namespace pcl;
+
+/** \brief Points on two nested spheres around the origin, so that the z-buffer has to resolve occlusions. */
+void
+createScan (PointCloud<PointXYZ> &cloud, size_t size)
+{
+  boost::mt19937 rng (42);
+  boost::uniform_real<float> angle (-1.0f, 1.0f);
+  boost::uniform_real<float> noise (0.0f, 0.02f);
+  cloud.resize (size);
+  for (size_t i = 0; i < size; ++i)
+  {
+    const float azimuth = static_cast<float> (M_PI) * angle (rng),
+                elevation = 0.5f * static_cast<float> (M_PI) * angle (rng) * angle (rng),
+                radius = (i % 3 == 0 ? 5.0f : 10.0f) + noise (rng);
+    cloud[i].x = radius * std::cos (elevation) * std::sin (azimuth);
+    cloud[i].y = radius * std::sin (elevation);
+    cloud[i].z = radius * std::cos (elevation) * std::cos (azimuth);
+  }
+  cloud[7].x = std::numeric_limits<float>::quiet_NaN ();
+  cloud[8].getVector3fMap () *= 0.01f;  // below the minimum range
+}
+
+void
+expectEqualImages (const RangeImage &expected, const RangeImage &image)
+{
+  ASSERT_EQ (expected.width, image.width);
+  ASSERT_EQ (expected.height, image.height);
+  size_t mismatches = 0;
+  for (size_t i = 0; i < expected.size (); ++i)
+  {
+    const PointWithRange &e = expected[i], &p = image[i];
+    const bool both_unobserved = pcl_isinf (e.range) && pcl_isinf (p.range);
+    if (!both_unobserved && (e.range != p.range || e.x != p.x || e.y != p.y || e.z != p.z))
+      ++mismatches;
+  }
+  EXPECT_EQ (0u, mismatches);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (RangeImage, ParallelCreation)
+{
+  PointCloud<PointXYZ> cloud;
+  createScan (cloud, 300000);
+  const float resolution = pcl::deg2rad (0.5f);
+
+  // Serial z-buffer
+  RangeImage::max_no_of_threads = 1;
+  RangeImage serial;
+  serial.createFromPointCloud (cloud, resolution, pcl::deg2rad (360.0f), pcl::deg2rad (180.0f),
+                               Eigen::Affine3f::Identity (), RangeImage::CAMERA_FRAME, 0.05f, 0.2f, 1);
+  EXPECT_LT (0u, serial.width);
+  size_t observed = 0, near = 0;
+  for (size_t i = 0; i < serial.size (); ++i)
+    if (pcl_isfinite (serial[i].range))
+    {
+      ++observed;
+      if (serial[i].range < 7.5f)
+        ++near;
+    }
+  // A third of the points lie on the nearer sphere, which occludes the other one in most pixels
+  EXPECT_LT (serial.size () / 2, observed);
+  EXPECT_LT (observed / 2, near);
+
+  // Points are sorted into bands of rows, and the result must not depend on how many
+  const unsigned int previous_concurrency = TaskScheduler::getInstance ().getConcurrency ();
+  const unsigned int thread_counts[] = {2, 3, 8};
+  for (size_t t = 0; t < sizeof (thread_counts) / sizeof (thread_counts[0]); ++t)
+  {
+    TaskScheduler::getInstance ().setConcurrency (thread_counts[t]);
+    RangeImage::max_no_of_threads = thread_counts[t];
+    RangeImage parallel;
+    parallel.createFromPointCloud (cloud, resolution, pcl::deg2rad (360.0f), pcl::deg2rad (180.0f),
+                                   Eigen::Affine3f::Identity (), RangeImage::CAMERA_FRAME, 0.05f, 0.2f, 1);
+    expectEqualImages (serial, parallel);
+
+    RangeImagePlanar planar, planar_serial;
+    std::vector<float> depth (640 * 480);
+    for (size_t i = 0; i < depth.size (); ++i)
+      depth[i] = (i % 97 == 0) ? 0.0f : 1.0f + 0.001f * static_cast<float> (i % 640);
+    planar.setDepthImage (&depth[0], 640, 480, 320.0f, 240.0f, 525.0f, 525.0f);
+    RangeImage::max_no_of_threads = 1;
+    planar_serial.setDepthImage (&depth[0], 640, 480, 320.0f, 240.0f, 525.0f, 525.0f);
+    expectEqualImages (planar_serial, planar);
+    EXPECT_TRUE (pcl_isinf (planar.getPoint (0, 0).range));
+    EXPECT_FLOAT_EQ (1.001f, planar.getPoint (1, 0).z);
+  }
+  TaskScheduler::getInstance ().setConcurrency (previous_concurrency);
+  RangeImage::max_no_of_threads = 1;
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  testing::InitGoogleTest (&argc, argv);
+  return (RUN_ALL_TESTS ());
+}
+/* ]--- */
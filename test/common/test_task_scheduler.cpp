@@ -0,0 +1,218 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include <gtest/gtest.h>
+#include <pcl/common/task_scheduler.h>
+#include <boost/thread/thread.hpp>
+#include <numeric>
+#include <vector>
+
+using namespace pcl;
+
+/** \brief Sets values[i] = i for every index of a subrange. */
+struct Iota
+{
+  Iota (std::vector<int> &values) : values_ (values) {}
+
+  void
+  operator () (int begin, int end) const
+  {
+    for (int i = begin; i < end; ++i)
+      values_[i] = i;
+  }
+
+  std::vector<int> &values_;
+};
+
+/** \brief Runs a parallel_for from inside each subrange of another one. */
+struct Nested
+{
+  Nested (std::vector<std::vector<int> > &rows) : rows_ (rows) {}
+
+  void
+  operator () (int begin, int end) const
+  {
+    for (int row = begin; row < end; ++row)
+      parallel_for (0, static_cast<int> (rows_[row].size ()), Iota (rows_[row]));
+  }
+
+  std::vector<std::vector<int> > &rows_;
+};
+
+/** \brief Counts the indices of a subrange on which TaskScheduler::inTask () was false. */
+struct CountOutsideTasks
+{
+  CountOutsideTasks (boost::mutex &mutex, int &counter) : mutex_ (mutex), counter_ (counter) {}
+
+  void
+  operator () (int begin, int end) const
+  {
+    if (TaskScheduler::inTask ())
+      return;
+    boost::mutex::scoped_lock lock (mutex_);
+    counter_ += end - begin;
+  }
+
+  boost::mutex &mutex_;
+  int &counter_;
+};
+
+void
+increment (boost::mutex &mutex, int &counter)
+{
+  boost::mutex::scoped_lock lock (mutex);
+  ++counter;
+}
+
+void
+runPipeline (std::vector<int> &values)
+{
+  parallel_for (0, static_cast<int> (values.size ()), Iota (values), 16);
+}
+
+bool
+isIota (const std::vector<int> &values)
+{
+  for (size_t i = 0; i < values.size (); ++i)
+    if (values[i] != static_cast<int> (i))
+      return (false);
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (TaskScheduler, TaskGroup)
+{
+  TaskScheduler scheduler (3);
+  EXPECT_EQ (3u, scheduler.getConcurrency ());
+
+  boost::mutex mutex;
+  int counter = 0;
+  {
+    TaskGroup group (scheduler);
+    for (int i = 0; i < 1000; ++i)
+      group.run (boost::bind (&increment, boost::ref (mutex), boost::ref (counter)));
+    group.wait ();
+    EXPECT_EQ (1000, counter);
+
+    // A group can be reused after wait (), and waits again when destroyed
+    for (int i = 0; i < 10; ++i)
+      group.run (boost::bind (&increment, boost::ref (mutex), boost::ref (counter)));
+  }
+  EXPECT_EQ (1010, counter);
+
+  // Without workers the waiting thread runs every task itself
+  scheduler.setConcurrency (1);
+  EXPECT_EQ (1u, scheduler.getConcurrency ());
+  TaskGroup group (scheduler);
+  for (int i = 0; i < 10; ++i)
+    group.run (boost::bind (&increment, boost::ref (mutex), boost::ref (counter)));
+  group.wait ();
+  EXPECT_EQ (1020, counter);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (TaskScheduler, ParallelFor)
+{
+  const unsigned int concurrencies[] = { 1, 2, 4 };
+  const unsigned int previous = TaskScheduler::getInstance ().getConcurrency ();
+  for (int c = 0; c < 3; ++c)
+  {
+    TaskScheduler::getInstance ().setConcurrency (concurrencies[c]);
+
+    const int sizes[] = { 0, 1, 7, 1000, 100003 };
+    for (int s = 0; s < 5; ++s)
+    {
+      std::vector<int> values (sizes[s], -1);
+      parallel_for (0, sizes[s], Iota (values));
+      EXPECT_TRUE (isIota (values));
+
+      std::fill (values.begin (), values.end (), -1);
+      parallel_for (0, sizes[s], Iota (values), 64, 3);
+      EXPECT_TRUE (isIota (values));
+    }
+
+    // Nested loops share the same threads instead of waiting on each other
+    std::vector<std::vector<int> > rows (64, std::vector<int> (5000, -1));
+    parallel_for (0, static_cast<int> (rows.size ()), Nested (rows));
+    for (size_t row = 0; row < rows.size (); ++row)
+      EXPECT_TRUE (isIota (rows[row]));
+  }
+  TaskScheduler::getInstance ().setConcurrency (previous);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (TaskScheduler, InTask)
+{
+  const unsigned int previous = TaskScheduler::getInstance ().getConcurrency ();
+  TaskScheduler::getInstance ().setConcurrency (4);
+  EXPECT_FALSE (TaskScheduler::inTask ());
+
+  // Every subrange, including the one of the calling thread, runs as a task
+  boost::mutex mutex;
+  int outside = 0;
+  parallel_for (0, 1000, CountOutsideTasks (mutex, outside), 10);
+  EXPECT_EQ (0, outside);
+  EXPECT_FALSE (TaskScheduler::inTask ());
+
+  TaskScheduler::getInstance ().setConcurrency (previous);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (TaskScheduler, ConcurrentPipelines)
+{
+  // Several threads outside of the pool submitting to the shared scheduler at once
+  std::vector<std::vector<int> > values (8, std::vector<int> (20000, -1));
+  std::vector<boost::shared_ptr<boost::thread> > threads;
+  for (size_t i = 0; i < values.size (); ++i)
+    threads.push_back (boost::shared_ptr<boost::thread> (
+          new boost::thread (boost::bind (&runPipeline, boost::ref (values[i])))));
+  for (size_t i = 0; i < threads.size (); ++i)
+    threads[i]->join ();
+  for (size_t i = 0; i < values.size (); ++i)
+    EXPECT_TRUE (isIota (values[i]));
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  testing::InitGoogleTest (&argc, argv);
+  return (RUN_ALL_TESTS ());
+}
+/* ]--- */
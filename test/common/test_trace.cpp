@@ -0,0 +1,138 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include <gtest/gtest.h>
+#include <pcl/common/trace.h>
+#include <boost/thread/thread.hpp>
+#include <sstream>
+
+using namespace pcl;
+
+void
+recordZones (int count)
+{
+  for (int i = 0; i < count; ++i)
+  {
+    trace::Zone zone ("worker zone");
+    trace::addCounter ("worker items", 2);
+  }
+}
+
+size_t
+countOccurrences (const std::string &text, const std::string &pattern)
+{
+  size_t count = 0;
+  for (size_t pos = text.find (pattern); pos != std::string::npos; pos = text.find (pattern, pos + 1))
+    ++count;
+  return (count);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (Trace, ZonesAndCounters)
+{
+  trace::clear ();
+  trace::setEnabled (false);
+  {
+    trace::Zone zone ("disabled");
+  }
+
+  trace::setEnabled (true);
+  EXPECT_TRUE (trace::isEnabled ());
+  {
+    trace::Zone outer ("outer");
+    {
+      trace::Zone inner (std::string ("inner \"quoted\""));
+      trace::addCounter ("points", 10);
+    }
+    trace::addCounter ("points", 5);
+  }
+  trace::setEnabled (false);
+  EXPECT_EQ (15, trace::getCounter ("points"));
+  EXPECT_EQ (0, trace::getCounter ("unknown"));
+
+  std::ostringstream stream;
+  trace::writeChromeTrace (stream);
+  const std::string json = stream.str ();
+  EXPECT_EQ (std::string::npos, json.find ("\"disabled\""));
+  EXPECT_NE (std::string::npos, json.find ("\"name\":\"outer\""));
+  EXPECT_NE (std::string::npos, json.find ("\"name\":\"inner \\\"quoted\\\"\""));
+  EXPECT_EQ (2u, countOccurrences (json, "\"ph\":\"X\""));
+  // Counters are written as running totals
+  EXPECT_NE (std::string::npos, json.find ("\"args\":{\"value\":10}"));
+  EXPECT_NE (std::string::npos, json.find ("\"args\":{\"value\":15}"));
+  EXPECT_EQ (0u, json.find ("{"));
+  EXPECT_EQ (json.size () - 3, json.rfind ("]}"));
+
+  trace::clear ();
+  EXPECT_EQ (0, trace::getCounter ("points"));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (Trace, RingBufferAndThreads)
+{
+  const size_t previous = trace::getBufferSize ();
+  trace::setBufferSize (100);
+  EXPECT_EQ (100u, trace::getBufferSize ());
+  trace::setEnabled (true);
+
+  // Each thread records into its own buffer and keeps only its most recent events
+  boost::thread first (boost::bind (&recordZones, 10));
+  boost::thread second (boost::bind (&recordZones, 1000));
+  first.join ();
+  second.join ();
+  trace::setEnabled (false);
+
+  // 20 events of the first thread, and the last 100 (50 counter additions) of the second
+  EXPECT_EQ (2 * (10 + 50), trace::getCounter ("worker items"));
+  std::ostringstream stream;
+  trace::writeChromeTrace (stream);
+  EXPECT_EQ (60u, countOccurrences (stream.str (), "\"ph\":\"X\""));
+  EXPECT_EQ (2u, countOccurrences (stream.str (), "\"thread_name\""));
+
+  trace::setBufferSize (previous);
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  testing::InitGoogleTest (&argc, argv);
+  return (RUN_ALL_TESTS ());
+}
+/* ]--- */
@@ -0,0 +1,247 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <gtest/gtest.h>
+#include <pcl/pcl_tests.h>
+#include <pcl/point_types.h>
+#include <pcl/common/transforms.h>
+#include <pcl/common/cpu_dispatch.h>
+#include <pcl/common/time.h>
+#include <pcl/common/io.h>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+using namespace pcl;
+
+// The transformation kernel has no SSE4.2 variant
+const CpuIsa kernels[] = { CPU_ISA_GENERIC, CPU_ISA_SSE2, CPU_ISA_AVX2, CPU_ISA_AVX512 };
+const int nr_kernels = 4;
+
+PointCloud<PointNormal> cloud;
+Eigen::Affine3f transform;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/** \brief Reference result, computed in double precision one point at a time. */
+void
+referenceTransform (const PointNormal &in, PointNormal &out)
+{
+  const Eigen::Affine3d t = transform.cast<double> ();
+  out = in;
+  out.getVector3fMap () = (t * in.getVector3fMap ().cast<double> ()).cast<float> ();
+  out.getNormalVector3fMap () = (t.linear () * in.getNormalVector3fMap ().cast<double> ()).cast<float> ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+runKernel (const PointCloud<PointNormal> &in, const std::vector<int> *indices, PointCloud<PointNormal> &out,
+           bool with_normals, CpuIsa kernel)
+{
+  const CpuIsa previous = getDispatchCpuIsa ();
+  setDispatchCpuIsa (kernel);
+  float matrix[12];
+  for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 4; ++c)
+      matrix[r * 4 + c] = transform (r, c);
+  detail::transformPoints (&in[0].x, &out[0].x, out.size (), sizeof (PointNormal), indices ? &(*indices)[0] : NULL,
+                           with_normals, reinterpret_cast<const char*> (&in[0].normal_x) - reinterpret_cast<const char*> (&in[0].x),
+                           matrix, !in.is_dense);
+  setDispatchCpuIsa (previous);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (TransformKernels, Accuracy)
+{
+  // An odd size exercises the remainder loops of the wide kernels
+  PointCloud<PointNormal> sparse;
+  sparse.points.assign (cloud.begin (), cloud.begin () + 1001);
+  sparse.width = static_cast<uint32_t> (sparse.size ());
+  sparse.height = 1;
+  sparse.is_dense = false;
+  sparse[3].x = std::numeric_limits<float>::quiet_NaN ();
+  sparse[17].z = std::numeric_limits<float>::infinity ();
+  sparse[1000].y = -std::numeric_limits<float>::infinity ();
+
+  std::vector<int> indices;
+  for (int i = static_cast<int> (sparse.size ()) - 1; i >= 0; i -= 3)
+    indices.push_back (i);
+
+  for (int k = 0; k < nr_kernels; ++k)
+  {
+    if (kernels[k] > getHostCpuIsa ())
+      continue;
+    SCOPED_TRACE (getCpuIsaName (kernels[k]));
+
+    for (int with_normals = 0; with_normals < 2; ++with_normals)
+    {
+      // Full cloud, marker values in the output show which points were left untouched
+      PointCloud<PointNormal> out = sparse;
+      for (size_t i = 0; i < out.size (); ++i)
+        out[i].data[3] = out[i].data_n[3] = static_cast<float> (i);
+      runKernel (sparse, NULL, out, with_normals != 0, kernels[k]);
+      for (size_t i = 0; i < out.size (); ++i)
+      {
+        EXPECT_EQ (static_cast<float> (i), out[i].data[3]);
+        EXPECT_EQ (static_cast<float> (i), out[i].data_n[3]);
+        if (!isFinite (sparse[i]))
+        {
+          EXPECT_EQ (0, memcmp (sparse[i].data, out[i].data, 3 * sizeof (float)));
+          continue;
+        }
+        PointNormal ref;
+        referenceTransform (sparse[i], ref);
+        EXPECT_XYZ_NEAR (ref, out[i], 1e-4);
+        if (with_normals)
+          EXPECT_NORMAL_NEAR (ref, out[i], 1e-5);
+        else
+          EXPECT_NORMAL_EQ (sparse[i], out[i]);
+      }
+
+      // Indexed input
+      PointCloud<PointNormal> out_idx;
+      out_idx.resize (indices.size ());
+      runKernel (sparse, &indices, out_idx, with_normals != 0, kernels[k]);
+      for (size_t i = 0; i < indices.size (); ++i)
+      {
+        if (!isFinite (sparse[indices[i]]))
+          continue;
+        PointNormal ref;
+        referenceTransform (sparse[indices[i]], ref);
+        EXPECT_XYZ_NEAR (ref, out_idx[i], 1e-4);
+        if (with_normals)
+          EXPECT_NORMAL_NEAR (ref, out_idx[i], 1e-5);
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (TransformKernels, TransformPointCloud)
+{
+  // The public functions must agree with the per point Eigen code used for double precision
+  PointCloud<PointNormal> out_f, out_d;
+  transformPointCloudWithNormals (cloud, out_f, transform);
+  transformPointCloudWithNormals (cloud, out_d, Eigen::Affine3d (transform.cast<double> ()));
+  ASSERT_EQ (out_d.size (), out_f.size ());
+  for (size_t i = 0; i < out_f.size (); ++i)
+  {
+    EXPECT_XYZ_NEAR (out_d[i], out_f[i], 1e-4);
+    EXPECT_NORMAL_NEAR (out_d[i], out_f[i], 1e-5);
+    EXPECT_EQ (cloud[i].curvature, out_f[i].curvature);
+  }
+
+  PointCloud<PointXYZ> xyz, xyz_f, xyz_d;
+  copyPointCloud (cloud, xyz);
+  std::vector<int> indices;
+  for (size_t i = 0; i < xyz.size (); i += 7)
+    indices.push_back (static_cast<int> (i));
+  transformPointCloud (xyz, indices, xyz_f, transform);
+  transformPointCloud (xyz, indices, xyz_d, Eigen::Affine3d (transform.cast<double> ()));
+  ASSERT_EQ (indices.size (), xyz_f.size ());
+  for (size_t i = 0; i < xyz_f.size (); ++i)
+    EXPECT_XYZ_NEAR (xyz_d[i], xyz_f[i], 1e-4);
+
+  // In place
+  transformPointCloud (xyz, xyz, transform);
+  for (size_t i = 0; i < xyz.size (); ++i)
+    EXPECT_XYZ_NEAR (out_d[i], xyz[i], 1e-4);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/** \brief Timings of every kernel the host supports, run with --gtest_also_run_disabled_tests. */
+TEST (TransformKernels, DISABLED_Benchmark)
+{
+  const int iterations = 10;
+  PointCloud<PointNormal> out = cloud;
+  std::vector<int> indices;
+  for (int i = static_cast<int> (cloud.size ()) - 1; i >= 0; i -= 2)
+    indices.push_back (i);
+  std::cout << "Transforming " << cloud.size () << " points (" << iterations << " runs), best kernel: "
+            << getCpuIsaName (getDispatchCpuIsa ()) << std::endl;
+
+  const char *variants[] = { "xyz:                 ", "xyz+normal:          ",
+                             "xyz, indices:        ", "xyz+normal, indices: " };
+  for (int k = 0; k < nr_kernels; ++k)
+  {
+    if (kernels[k] > getHostCpuIsa ())
+      continue;
+    for (int variant = 0; variant < 4; ++variant)
+    {
+      const bool with_normals = (variant & 1) != 0;
+      const std::vector<int> *variant_indices = (variant & 2) ? &indices : NULL;
+      out.resize (variant_indices ? indices.size () : cloud.size ());
+      StopWatch timer;
+      for (int it = 0; it < iterations; ++it)
+        runKernel (cloud, variant_indices, out, with_normals, kernels[k]);
+      std::cout << "  " << std::left << std::setw (8) << getCpuIsaName (kernels[k]) << variants[variant]
+                << timer.getTime () / iterations << " ms" << std::endl;
+    }
+  }
+
+  // The per point Eigen code used for double precision transforms, for comparison
+  const Eigen::Affine3d transform_d (transform.cast<double> ());
+  StopWatch timer;
+  for (int it = 0; it < iterations; ++it)
+    transformPointCloudWithNormals (cloud, out, transform_d);
+  std::cout << "  eigen (double) xyz+normal:   " << timer.getTime () / iterations << " ms" << std::endl;
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  const int size = 1 << 20;
+  cloud.resize (size);
+  for (int i = 0; i < size; ++i)
+  {
+    cloud[i].x = static_cast<float> (i % 101) * 0.1f - 5.0f;
+    cloud[i].y = static_cast<float> (i % 97) * 0.05f;
+    cloud[i].z = static_cast<float> (i % 89) * 0.2f + 1.0f;
+    Eigen::Vector3f normal (static_cast<float> (i % 7) - 3.0f, 1.0f, static_cast<float> (i % 5));
+    cloud[i].getNormalVector3fMap () = normal.normalized ();
+    cloud[i].curvature = static_cast<float> (i % 11);
+  }
+
+  transform = Eigen::Affine3f::Identity ();
+  transform.rotate (Eigen::AngleAxisf (0.7f, Eigen::Vector3f (0.3f, -1.0f, 0.5f).normalized ()));
+  transform.translation () << 0.5f, -1.5f, 2.0f;
+
+  testing::InitGoogleTest (&argc, argv);
+  return (RUN_ALL_TESTS ());
+}
+/* ]--- */
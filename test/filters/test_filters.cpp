@@ -39,6 +39,7 @@
  */
 
 #include <gtest/gtest.h>
+#include <set>
 #include <pcl/point_types.h>
 #include <pcl/io/pcd_io.h>
 #include <pcl/features/normal_3d.h>
@@ -46,19 +47,28 @@
 #include <pcl/filters/passthrough.h>
 #include <pcl/filters/shadowpoints.h>
 #include <pcl/filters/frustum_culling.h>
+#include <pcl/filters/multi_frustum_culling.h>
 #include <pcl/filters/sampling_surface_normal.h>
+#include <pcl/filters/uniform_sampling.h>
 #include <pcl/filters/voxel_grid.h>
+#include <pcl/filters/voxel_grid_accumulator.h>
 #include <pcl/filters/voxel_grid_covariance.h>
+#include <pcl/filters/voxel_grid_occlusion_estimation.h>
 #include <pcl/filters/extract_indices.h>
+#include <pcl/filters/filter_chain.h>
+#include <pcl/filters/crop_box.h>
+#include <pcl/filters/crop_hull.h>
 #include <pcl/filters/project_inliers.h>
 #include <pcl/filters/radius_outlier_removal.h>
 #include <pcl/filters/statistical_outlier_removal.h>
 #include <pcl/filters/conditional_removal.h>
 #include <pcl/filters/median_filter.h>
 #include <pcl/filters/normal_refinement.h>
+#include <pcl/search/brute_force.h>
 
 #include <pcl/common/transforms.h>
 #include <pcl/common/eigen.h>
+#include <pcl/common/common.h>
 
 #include <pcl/segmentation/sac_segmentation.h>
 
@@ -1245,6 +1255,103 @@ TEST (VoxelGrid_XYZNormal, Filters)
 #endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Orders centroids by the 0.1 sized voxel they lie in
+bool
+compareVoxelCentroids (const PointXYZRGB &a, const PointXYZRGB &b)
+{
+  const Eigen::Vector3i ia = (a.getVector3fMap () * 10.0f).array ().floor ().cast<int> ();
+  const Eigen::Vector3i ib = (b.getVector3fMap () * 10.0f).array ().floor ().cast<int> ();
+  return (std::lexicographical_compare (ia.data (), ia.data () + 3, ib.data (), ib.data () + 3));
+}
+
+TEST (VoxelGridAccumulator, Filters)
+{
+  // Two overlapping scans with a few invalid points
+  PointCloud<PointXYZRGB>::Ptr scans[2];
+  PointCloud<PointXYZRGB> all;
+  srand (12345);
+  for (int s = 0; s < 2; ++s)
+  {
+    scans[s].reset (new PointCloud<PointXYZRGB>);
+    for (int i = 0; i < 5000; ++i)
+    {
+      PointXYZRGB p;
+      p.x = static_cast<float> (rand ()) / static_cast<float> (RAND_MAX) + 0.5f * static_cast<float> (s);
+      p.y = static_cast<float> (rand ()) / static_cast<float> (RAND_MAX);
+      p.z = (i % 500 == 0) ? std::numeric_limits<float>::quiet_NaN () : static_cast<float> (rand ()) / static_cast<float> (RAND_MAX);
+      p.r = static_cast<uint8_t> (rand () % 256);
+      p.g = static_cast<uint8_t> (rand () % 256);
+      p.b = static_cast<uint8_t> (rand () % 256);
+      scans[s]->push_back (p);
+    }
+    scans[s]->is_dense = false;
+    all += *scans[s];
+  }
+
+  for (int all_data = 0; all_data < 2; ++all_data)
+  {
+    // Reference: one VoxelGrid over the concatenated scans
+    PointCloud<PointXYZRGB> expected;
+    VoxelGrid<PointXYZRGB> grid;
+    grid.setLeafSize (0.1f, 0.1f, 0.1f);
+    grid.setDownsampleAllData (all_data != 0);
+    grid.setMinimumPointsNumberPerVoxel (2);
+    grid.setInputCloud (all.makeShared ());
+    grid.filter (expected);
+
+    VoxelGridAccumulator<PointXYZRGB> accumulator;
+    accumulator.setLeafSize (0.1f, 0.1f, 0.1f);
+    accumulator.setDownsampleAllData (all_data != 0);
+    accumulator.setMinimumPointsNumberPerVoxel (2);
+    accumulator.addCloud (*scans[0]);
+    std::vector<int> indices;
+    for (int i = 0; i < static_cast<int> (scans[1]->size ()); ++i)
+      indices.push_back (i);
+    accumulator.addCloud (*scans[1], indices);
+
+    PointCloud<PointXYZRGB> output;
+    std::vector<unsigned int> counts;
+    accumulator.getCentroids (output, counts);
+    ASSERT_EQ (expected.size (), output.size ());
+    ASSERT_EQ (output.size (), counts.size ());
+    EXPECT_GE (accumulator.getNumberOfVoxels (), output.size ());
+
+    std::sort (expected.points.begin (), expected.points.end (), compareVoxelCentroids);
+    std::sort (output.points.begin (), output.points.end (), compareVoxelCentroids);
+    for (size_t i = 0; i < output.size (); ++i)
+    {
+      EXPECT_NEAR (expected.points[i].x, output.points[i].x, 1e-5);
+      EXPECT_NEAR (expected.points[i].y, output.points[i].y, 1e-5);
+      EXPECT_NEAR (expected.points[i].z, output.points[i].z, 1e-5);
+      if (all_data)
+        EXPECT_EQ (expected.points[i].rgba, output.points[i].rgba);
+    }
+  }
+
+  // Eviction around the sensor origin of the last scan
+  VoxelGridAccumulator<PointXYZRGB> accumulator;
+  accumulator.setLeafSize (0.1f, 0.1f, 0.1f);
+  scans[1]->sensor_origin_ = Eigen::Vector4f (1.0f, 0.5f, 0.5f, 0.0f);
+  accumulator.addCloud (*scans[0]);
+  const size_t nr_voxels = accumulator.getNumberOfVoxels ();
+  accumulator.setEvictionRadius (0.5f);
+  accumulator.addCloud (*scans[1]);
+  PointCloud<PointXYZRGB> output;
+  accumulator.getCentroids (output);
+  EXPECT_LT (output.size (), nr_voxels);
+  for (size_t i = 0; i < output.size (); ++i)
+    EXPECT_LE ((output.points[i].getVector3fMap () - Eigen::Vector3f (1.0f, 0.5f, 0.5f)).norm (), 0.5f + 1e-5f);
+
+  EXPECT_GT (accumulator.removeVoxelsOutside (Eigen::Vector3f (1.0f, 0.0f, 0.0f), Eigen::Vector3f (2.0f, 1.0f, 1.0f)), 0);
+  accumulator.getCentroids (output);
+  for (size_t i = 0; i < output.size (); ++i)
+    EXPECT_GE (output.points[i].x, 1.0f);
+
+  accumulator.clear ();
+  EXPECT_EQ (0, int (accumulator.getNumberOfVoxels ()));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
 TEST (VoxelGridCovariance, Filters)
 {
   // Test the PointCloud<PointT> method
@@ -1327,6 +1434,170 @@ TEST (VoxelGridCovariance, Filters)
   EXPECT_NEAR (leaves[2]->getMean ()[2], 0.0508024, 1e-4);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (VoxelGridCovarianceIncremental, Filters)
+{
+  PointCloud<PointXYZ> output, output_incremental;
+  VoxelGridCovariance<PointXYZ> grid, grid_incremental;
+
+  grid.setLeafSize (0.02f, 0.02f, 0.02f);
+  grid.setInputCloud (cloud);
+  grid.filter (output, true);
+
+  // Build the same structure from two halves of the cloud, the second one extending the grid bounds
+  PointCloud<PointXYZ>::Ptr first_half (new PointCloud<PointXYZ>), second_half (new PointCloud<PointXYZ>);
+  for (size_t i = 0; i < cloud->points.size (); ++i)
+  {
+    if (cloud->points[i].y < 0.1f)
+      first_half->push_back (cloud->points[i]);
+    else
+      second_half->push_back (cloud->points[i]);
+  }
+  grid_incremental.setLeafSize (0.02f, 0.02f, 0.02f);
+  grid_incremental.setNumberOfThreads (2);
+  grid_incremental.setInputCloud (first_half);
+  grid_incremental.filter (true);
+  grid_incremental.addCloud (second_half);
+  output_incremental = *grid_incremental.getCentroids ();
+
+  ASSERT_EQ (output.points.size (), output_incremental.points.size ());
+  EXPECT_EQ (grid.getLeaves ().size (), grid_incremental.getLeaves ().size ());
+  for (size_t i = 0; i < output.points.size (); ++i)
+  {
+    EXPECT_NEAR (output.points[i].x, output_incremental.points[i].x, 1e-5);
+    EXPECT_NEAR (output.points[i].y, output_incremental.points[i].y, 1e-5);
+    EXPECT_NEAR (output.points[i].z, output_incremental.points[i].z, 1e-5);
+
+    VoxelGridCovariance<PointXYZ>::LeafConstPtr leaf = grid.getLeaf (output.points[i]);
+    VoxelGridCovariance<PointXYZ>::LeafConstPtr leaf_incremental = grid_incremental.getLeaf (output.points[i]);
+    ASSERT_TRUE (leaf != NULL);
+    ASSERT_TRUE (leaf_incremental != NULL);
+    EXPECT_EQ (leaf->getPointCount (), leaf_incremental->getPointCount ());
+    EXPECT_LE ((leaf->getMean () - leaf_incremental->getMean ()).norm (), 1e-9);
+    EXPECT_LE ((leaf->getCov () - leaf_incremental->getCov ()).norm (), 1e-9);
+  }
+
+  // The direct voxel lookup must find exactly the centroids inside the radius, sorted by distance
+  vector<VoxelGridCovariance<PointXYZ>::LeafConstPtr> leaves;
+  vector<float> distances;
+  for (size_t i = 0; i < cloud->points.size (); i += 50)
+  {
+    const PointXYZ &query = cloud->points[i];
+    for (int r = 1; r <= 3; ++r)
+    {
+      const double radius = 0.02 * r;
+      size_t expected = 0;
+      for (size_t j = 0; j < output.points.size (); ++j)
+        if ((query.getVector3fMap () - output.points[j].getVector3fMap ()).squaredNorm () < radius * radius)
+          ++expected;
+
+      EXPECT_EQ (int (expected), grid.radiusSearch (query, radius, leaves, distances));
+      ASSERT_EQ (leaves.size (), distances.size ());
+      for (size_t j = 0; j < leaves.size (); ++j)
+      {
+        EXPECT_LT (distances[j], radius * radius);
+        if (j > 0)
+          EXPECT_LE (distances[j - 1], distances[j]);
+      }
+    }
+  }
+  EXPECT_EQ (1, grid.radiusSearch (cloud->points[0], 0.06, leaves, distances, 1));
+
+  // Neighboring voxels are at most one leaf away
+  vector<VoxelGridCovariance<PointXYZ>::LeafConstPtr> neighbors;
+  int nr_neighbors = grid.getNeighborhoodAtPoint (cloud->points[38], neighbors);
+  EXPECT_GT (nr_neighbors, 0);
+  EXPECT_EQ (nr_neighbors, int (neighbors.size ()));
+  for (size_t i = 0; i < neighbors.size (); ++i)
+  {
+    EXPECT_GE (neighbors[i]->getPointCount (), grid.getMinPointPerVoxel ());
+    Eigen::Vector3f offset = neighbors[i]->getMean ().cast<float> () - cloud->points[38].getVector3fMap ();
+    EXPECT_LE (offset.cwiseAbs ().maxCoeff (), 2 * 0.02f);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (VoxelGridOcclusionEstimation, Filters)
+{
+  // A wall at z = 1.5 in front of a sensor at the origin, and a back plane at z = 2
+  PointCloud<PointXYZ>::Ptr scene (new PointCloud<PointXYZ>);
+  scene->push_back (PointXYZ (-0.5f, -0.5f, 1.0f));
+  for (int i = 0; i <= 20; ++i)
+    for (int j = 0; j <= 20; ++j)
+    {
+      scene->push_back (PointXYZ (-0.5f + 0.05f * float (i), -0.5f + 0.05f * float (j), 2.0f));
+      if (i >= 5 && i <= 15 && j >= 5 && j <= 15)
+        scene->push_back (PointXYZ (-0.5f + 0.05f * float (i), -0.5f + 0.05f * float (j), 1.5f));
+    }
+  scene->sensor_origin_ = Eigen::Vector4f (0.0f, 0.0f, 0.0f, 0.0f);
+
+  VoxelGridOcclusionEstimation<PointXYZ> occlusion;
+  occlusion.setInputCloud (scene);
+  occlusion.setLeafSize (0.1f, 0.1f, 0.1f);
+  occlusion.setNumberOfThreads (2);
+  occlusion.initializeVoxelGrid ();
+
+  std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> > occluded_voxels;
+  EXPECT_EQ (0, occlusion.occlusionEstimationAll (occluded_voxels));
+  EXPECT_GT (occluded_voxels.size (), 0);
+
+  // Every occluded voxel lies behind the wall or the corner point and agrees with the single ray estimation
+  int state;
+  std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> > ray;
+  for (size_t i = 0; i < occluded_voxels.size (); ++i)
+  {
+    EXPECT_TRUE (occluded_voxels[i][2] >= 15 || (occluded_voxels[i][0] <= -4 && occluded_voxels[i][1] <= -4));
+    EXPECT_EQ (0, occlusion.occlusionEstimation (state, occluded_voxels[i]));
+    EXPECT_EQ (1, state);
+  }
+
+  // The voxel right behind the center of the wall is occluded, the rays stay inside the grid
+  EXPECT_EQ (0, occlusion.occlusionEstimation (state, ray, Eigen::Vector3i (0, 0, 17)));
+  EXPECT_EQ (1, state);
+  EXPECT_EQ (ray.back (), Eigen::Vector3i (0, 0, 17));
+  for (size_t i = 1; i < ray.size (); ++i)
+    EXPECT_EQ (1, (ray[i] - ray[i - 1]).cwiseAbs ().sum ());
+
+  // Free voxels in front of the wall are visible
+  EXPECT_EQ (0, occlusion.occlusionEstimation (state, Eigen::Vector3i (0, 0, 12)));
+  EXPECT_EQ (0, state);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (UniformSampling, Filters)
+{
+  PointCloud<PointXYZ> output, output_single;
+  UniformSampling<PointXYZ> us (true);
+  us.setInputCloud (cloud);
+  us.setRadiusSearch (0.01);
+  us.setNumberOfThreads (4);
+  us.filter (output);
+
+  // Every input point is either kept or removed
+  IndicesConstPtr removed = us.getRemovedIndices ();
+  EXPECT_EQ (cloud->size (), output.size () + removed->size ());
+  EXPECT_EQ (output.width, output.size ());
+  EXPECT_EQ (bool (output.is_dense), true);
+
+  // One point per leaf
+  std::set<std::vector<int> > leaves;
+  for (size_t i = 0; i < output.size (); ++i)
+  {
+    std::vector<int> ijk (3);
+    ijk[0] = int (floor (output.points[i].x / 0.01f));
+    ijk[1] = int (floor (output.points[i].y / 0.01f));
+    ijk[2] = int (floor (output.points[i].z / 0.01f));
+    EXPECT_TRUE (leaves.insert (ijk).second);
+  }
+
+  // The result does not depend on the number of threads
+  us.setNumberOfThreads (1);
+  us.filter (output_single);
+  ASSERT_EQ (output.size (), output_single.size ());
+  for (size_t i = 0; i < output.size (); ++i)
+    EXPECT_EQ (output.points[i].getVector3fMap (), output_single.points[i].getVector3fMap ());
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (ProjectInliers, Filters)
 {
@@ -1433,6 +1704,33 @@ TEST (RadiusOutlierRemoval, Filters)
   EXPECT_NEAR (cloud_out.points[cloud_out.points.size () - 1].z, -0.021299, 1e-4);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (RadiusOutlierRemoval, ParallelCount)
+{
+  RadiusOutlierRemoval<PointXYZ> outrem (true);
+  outrem.setInputCloud (cloud);
+  outrem.setRadiusSearch (0.02);
+  outrem.setMinNeighborsInRadius (14);
+  outrem.setNumberOfThreads (1);
+  std::vector<int> serial;
+  outrem.filter (serial);
+  EXPECT_EQ (int (serial.size ()), 307);
+
+  // The result must not depend on the number of threads or on the search method
+  outrem.setNumberOfThreads (4);
+  outrem.setSearchMethod (search::Search<PointXYZ>::Ptr (new search::BruteForce<PointXYZ>));
+  std::vector<int> parallel;
+  outrem.filter (parallel);
+  EXPECT_EQ (serial, parallel);
+  EXPECT_EQ (parallel.size () + outrem.getRemovedIndices ()->size (), cloud->points.size ());
+
+  outrem.setNegative (true);
+  std::vector<int> negative;
+  outrem.filter (negative);
+  EXPECT_EQ (*outrem.getRemovedIndices (), serial);
+  EXPECT_EQ (int (negative.size ()), int (cloud->points.size ()) - 307);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (StatisticalOutlierRemoval, Filters)
 {
@@ -1548,6 +1846,71 @@ TEST (StatisticalOutlierRemoval, Filters)
   EXPECT_NEAR (output.points[output.points.size () - 1].z, -0.0444, 1e-4);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (StatisticalOutlierRemoval, ParallelAndSharedGraph)
+{
+  StatisticalOutlierRemoval<PointXYZ> outrem (true);
+  outrem.setInputCloud (cloud);
+  outrem.setMeanK (50);
+  outrem.setStddevMulThresh (1.0);
+  outrem.setNumberOfThreads (1);
+  std::vector<int> serial;
+  outrem.filter (serial);
+  EXPECT_EQ (int (serial.size ()), 352);
+
+  // The result must not depend on the number of threads
+  outrem.setNumberOfThreads (4);
+  std::vector<int> parallel;
+  outrem.filter (parallel);
+  EXPECT_EQ (serial, parallel);
+
+  // Reusing a precomputed kNN graph gives the same result without searching again
+  search::KdTree<PointXYZ> tree (false);
+  tree.setInputCloud (cloud);
+  boost::shared_ptr<std::vector<std::vector<int> > > graph_indices (new std::vector<std::vector<int> >);
+  boost::shared_ptr<std::vector<std::vector<float> > > graph_dists (new std::vector<std::vector<float> >);
+  tree.nearestKSearch (*cloud, std::vector<int> (), 51, *graph_indices, *graph_dists);
+  StatisticalOutlierRemoval<PointXYZ> outrem_graph;
+  outrem_graph.setInputCloud (cloud);
+  outrem_graph.setMeanK (50);
+  outrem_graph.setStddevMulThresh (1.0);
+  outrem_graph.setNeighborGraph (graph_indices, graph_dists);
+  std::vector<int> shared;
+  outrem_graph.filter (shared);
+  EXPECT_EQ (serial, shared);
+
+  // Estimating the statistics on a subsample only moves the threshold slightly
+  outrem.setStatisticsSampleSize (100);
+  EXPECT_EQ (outrem.getStatisticsSampleSize (), 100);
+  std::vector<int> sampled;
+  outrem.filter (sampled);
+  EXPECT_NEAR (double (sampled.size ()), 352.0, 0.05 * cloud->points.size ());
+  EXPECT_EQ (sampled.size () + outrem.getRemovedIndices ()->size (), cloud->points.size ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (StatisticalOutlierRemoval, Duplicates)
+{
+  // A line of points and, far from it, a point and its exact duplicate. The search may return the duplicate
+  // before the query itself, which must not make the pair look like two close neighbors of each other
+  PointCloud<PointXYZ>::Ptr line (new PointCloud<PointXYZ>);
+  for (int i = 0; i < 100; ++i)
+    line->push_back (PointXYZ (static_cast<float> (i), 0.0f, 0.0f));
+  line->push_back (PointXYZ (0.0f, 100.0f, 0.0f));
+  line->push_back (PointXYZ (0.0f, 100.0f, 0.0f));
+
+  StatisticalOutlierRemoval<PointXYZ> outrem (true);
+  outrem.setInputCloud (line);
+  outrem.setMeanK (2);
+  outrem.setStddevMulThresh (1.0);
+  std::vector<int> inliers;
+  outrem.filter (inliers);
+  EXPECT_EQ (100, int (inliers.size ()));
+  ASSERT_EQ (2, int (outrem.getRemovedIndices ()->size ()));
+  EXPECT_EQ (100, (*outrem.getRemovedIndices ())[0]);
+  EXPECT_EQ (101, (*outrem.getRemovedIndices ())[1]);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 TEST (ConditionalRemoval, Filters)
 {
@@ -1937,6 +2300,321 @@ TEST (FrustumCulling, Filters)
 
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (MultiFrustumCulling, Filters)
+{
+  PointCloud<PointXYZ>::Ptr input (new PointCloud<PointXYZ>);
+  srand (12345);
+  for (int i = 0; i < 10000; ++i)
+    input->push_back (PointXYZ (20.0f * static_cast<float> (rand ()) / static_cast<float> (RAND_MAX) - 10.0f,
+                                20.0f * static_cast<float> (rand ()) / static_cast<float> (RAND_MAX) - 10.0f,
+                                20.0f * static_cast<float> (rand ()) / static_cast<float> (RAND_MAX) - 10.0f));
+
+  // More than 64 cameras, so that the masks use several words per point
+  const int nr_cameras = 70;
+  MultiFrustumCulling<PointXYZ> mfc;
+  mfc.setInputCloud (input);
+  std::vector<FrustumCulling<PointXYZ>, Eigen::aligned_allocator<FrustumCulling<PointXYZ> > > frustums (nr_cameras);
+  for (int c = 0; c < nr_cameras; ++c)
+  {
+    Eigen::Matrix4f pose = Eigen::Matrix4f::Identity ();
+    pose.topLeftCorner<3, 3> () = Eigen::AngleAxisf (0.09f * static_cast<float> (c), Eigen::Vector3f::UnitY ()).toRotationMatrix () *
+                                  Eigen::AngleAxisf (0.05f * static_cast<float> (c), Eigen::Vector3f::UnitZ ()).toRotationMatrix ();
+    pose.block<3, 1> (0, 3) = Eigen::Vector3f (0.1f * static_cast<float> (c % 7), -0.2f * static_cast<float> (c % 5), 0.3f);
+    frustums[c].setCameraPose (pose);
+    frustums[c].setHorizontalFOV (30.0f + static_cast<float> (c % 4) * 15.0f);
+    frustums[c].setVerticalFOV (20.0f + static_cast<float> (c % 3) * 10.0f);
+    frustums[c].setNearPlaneDistance (0.1f * static_cast<float> (c % 6));
+    frustums[c].setFarPlaneDistance (4.0f + static_cast<float> (c % 5));
+    frustums[c].setInputCloud (input);
+    if (c % 2 == 0)
+      EXPECT_EQ (c, int (mfc.addCamera (frustums[c])));
+    else
+      EXPECT_EQ (c, int (mfc.addCamera (pose, frustums[c].getHorizontalFOV (), frustums[c].getVerticalFOV (),
+                                        frustums[c].getNearPlaneDistance (), frustums[c].getFarPlaneDistance ())));
+  }
+  EXPECT_EQ (nr_cameras, int (mfc.getNumberOfCameras ()));
+  EXPECT_EQ (2, int (mfc.getWordsPerPoint ()));
+
+  std::vector<std::vector<int> > visible;
+  std::vector<uint64_t> masks;
+  for (unsigned int nr_threads = 1; nr_threads <= 4; nr_threads += 3)
+  {
+    mfc.setNumberOfThreads (nr_threads);
+    mfc.computeVisibleIndices (visible);
+    mfc.computeVisibilityMasks (masks);
+    ASSERT_EQ (size_t (nr_cameras), visible.size ());
+    ASSERT_EQ (input->size () * 2, masks.size ());
+
+    size_t nr_visible = 0;
+    for (int c = 0; c < nr_cameras; ++c)
+    {
+      std::vector<int> expected;
+      frustums[c].filter (expected);
+      nr_visible += expected.size ();
+
+      // The plane equations are evaluated in a different order than in FrustumCulling, which may
+      // only matter for points (almost) on a plane
+      Eigen::Matrix<float, 4, 6> planes;
+      frustums[c].getFrustumPlanes (planes);
+      std::vector<bool> in_expected (input->size (), false), in_visible (input->size (), false);
+      for (size_t i = 0; i < expected.size (); ++i)
+        in_expected[expected[i]] = true;
+      for (size_t i = 0; i < visible[c].size (); ++i)
+        in_visible[visible[c][i]] = true;
+      for (size_t i = 0; i < input->size (); ++i)
+      {
+        EXPECT_EQ (bool (in_visible[i]), ((masks[2 * i + c / 64] >> (c % 64)) & 1) != 0);
+        if (in_visible[i] != in_expected[i])
+          EXPECT_LT ((input->points[i].getVector4fMap ().transpose () * planes).cwiseAbs ().minCoeff (), 1e-4f);
+      }
+      for (size_t i = 1; i < visible[c].size (); ++i)
+        EXPECT_LT (visible[c][i - 1], visible[c][i]);
+    }
+    EXPECT_GT (nr_visible, 1000);
+  }
+
+  mfc.clearCameras ();
+  mfc.computeVisibleIndices (visible);
+  EXPECT_EQ (0, int (visible.size ()));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (CropHull, Filters)
+{
+  // Random points in [-1, 1]^3
+  PointCloud<PointXYZ>::Ptr input (new PointCloud<PointXYZ>);
+  srand (12345);
+  for (int i = 0; i < 20000; ++i)
+    input->push_back (PointXYZ (2.0f * static_cast<float> (rand ()) / static_cast<float> (RAND_MAX) - 1.0f,
+                                2.0f * static_cast<float> (rand ()) / static_cast<float> (RAND_MAX) - 1.0f,
+                                2.0f * static_cast<float> (rand ()) / static_cast<float> (RAND_MAX) - 1.0f));
+
+  // 3D: the triangulated cube [-0.5, 0.5]^3
+  PointCloud<PointXYZ>::Ptr cube (new PointCloud<PointXYZ>);
+  for (int i = 0; i < 8; ++i)
+    cube->push_back (PointXYZ ((i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f));
+  const int faces[6][4] = {{0, 1, 3, 2}, {4, 5, 7, 6}, {0, 1, 5, 4}, {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 3, 7, 5}};
+  std::vector<Vertices> triangles;
+  for (int f = 0; f < 6; ++f)
+  {
+    Vertices t1, t2;
+    t1.vertices.push_back (faces[f][0]); t1.vertices.push_back (faces[f][1]); t1.vertices.push_back (faces[f][2]);
+    t2.vertices.push_back (faces[f][0]); t2.vertices.push_back (faces[f][2]); t2.vertices.push_back (faces[f][3]);
+    triangles.push_back (t1);
+    triangles.push_back (t2);
+  }
+
+  CropHull<PointXYZ> crop_hull;
+  crop_hull.setInputCloud (input);
+  crop_hull.setHullCloud (cube);
+  crop_hull.setHullIndices (triangles);
+  crop_hull.setDim (3);
+  for (unsigned int nr_threads = 1; nr_threads <= 4; nr_threads += 3)
+  {
+    crop_hull.setNumberOfThreads (nr_threads);
+    for (int crop_outside = 0; crop_outside < 2; ++crop_outside)
+    {
+      crop_hull.setCropOutside (crop_outside != 0);
+      std::vector<int> kept;
+      crop_hull.filter (kept);
+      std::vector<bool> is_kept (input->size (), false);
+      for (size_t i = 0; i < kept.size (); ++i)
+        is_kept[kept[i]] = true;
+      int nr_checked = 0;
+      for (size_t i = 0; i < input->size (); ++i)
+      {
+        const Eigen::Vector3f d = input->points[i].getVector3fMap ().cwiseAbs ();
+        if (std::abs (d.maxCoeff () - 0.5f) < 1e-3f)
+          continue;
+        EXPECT_EQ ((d.maxCoeff () < 0.5f) == (crop_outside != 0), bool (is_kept[i]));
+        ++nr_checked;
+      }
+      EXPECT_GT (nr_checked, 19000);
+
+      PointCloud<PointXYZ> output;
+      crop_hull.filter (output);
+      EXPECT_EQ (kept.size (), output.size ());
+    }
+  }
+
+  // 2D: a many sided disc of radius 0.5 and a square in the z = 0 plane
+  PointCloud<PointXYZ>::Ptr input_2d (new PointCloud<PointXYZ>);
+  for (size_t i = 0; i < input->size (); ++i)
+    input_2d->push_back (PointXYZ (input->points[i].x, input->points[i].y, 0.0f));
+  PointCloud<PointXYZ>::Ptr outline (new PointCloud<PointXYZ>);
+  std::vector<Vertices> polygons (2);
+  const int nr_sides = 500;
+  for (int i = 0; i < nr_sides; ++i)
+  {
+    const float angle = 2.0f * static_cast<float> (M_PI) * static_cast<float> (i) / static_cast<float> (nr_sides);
+    outline->push_back (PointXYZ (0.5f * std::cos (angle), 0.5f * std::sin (angle), 0.0f));
+    polygons[0].vertices.push_back (i);
+  }
+  outline->push_back (PointXYZ (0.6f, 0.6f, 0.0f));
+  outline->push_back (PointXYZ (0.9f, 0.6f, 0.0f));
+  outline->push_back (PointXYZ (0.9f, 0.9f, 0.0f));
+  outline->push_back (PointXYZ (0.6f, 0.9f, 0.0f));
+  for (int i = 0; i < 4; ++i)
+    polygons[1].vertices.push_back (nr_sides + i);
+
+  crop_hull.setInputCloud (input_2d);
+  crop_hull.setHullCloud (outline);
+  crop_hull.setHullIndices (polygons);
+  crop_hull.setDim (2);
+  crop_hull.setCropOutside (true);
+  std::vector<int> kept;
+  crop_hull.filter (kept);
+  std::vector<bool> is_kept (input_2d->size (), false);
+  for (size_t i = 0; i < kept.size (); ++i)
+    is_kept[kept[i]] = true;
+  for (size_t i = 0; i < input_2d->size (); ++i)
+  {
+    const PointXYZ &p = input_2d->points[i];
+    const float r = std::sqrt (p.x * p.x + p.y * p.y);
+    const bool in_square = p.x > 0.6f && p.x < 0.9f && p.y > 0.6f && p.y < 0.9f;
+    // The 500-gon deviates from the circle by less than 1e-5
+    if (std::abs (r - 0.5f) < 1e-3f || std::abs (p.x - 0.6f) < 1e-3f || std::abs (p.x - 0.9f) < 1e-3f ||
+        std::abs (p.y - 0.6f) < 1e-3f || std::abs (p.y - 0.9f) < 1e-3f)
+      continue;
+    EXPECT_EQ (r < 0.5f || in_square, bool (is_kept[i]));
+  }
+
+  // Polygons without vertices select no point, in 2D and in 3D
+  polygons.push_back (Vertices ());
+  crop_hull.setHullIndices (polygons);
+  std::vector<int> kept_2d;
+  crop_hull.filter (kept_2d);
+  EXPECT_EQ (kept, kept_2d);
+
+  crop_hull.setInputCloud (input);
+  crop_hull.setHullCloud (cube);
+  crop_hull.setHullIndices (triangles);
+  crop_hull.setDim (3);
+  std::vector<int> kept_3d, kept_3d_empty, kept_empty;
+  crop_hull.filter (kept_3d);
+  triangles.push_back (Vertices ());
+  crop_hull.setHullIndices (triangles);
+  crop_hull.filter (kept_3d_empty);
+  EXPECT_EQ (kept_3d, kept_3d_empty);
+  crop_hull.setHullIndices (std::vector<Vertices> (1));
+  crop_hull.filter (kept_empty);
+  EXPECT_TRUE (kept_empty.empty ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (FilterChain, Filters)
+{
+  Eigen::Vector4f min_pt, max_pt;
+  getMinMax3D (*cloud, min_pt, max_pt);
+  const Eigen::Vector4f center = 0.5f * (min_pt + max_pt);
+
+  PassThrough<PointXYZ>::Ptr pass (new PassThrough<PointXYZ>);
+  pass->setFilterFieldName ("z");
+  pass->setFilterLimits (min_pt[2], center[2]);
+
+  CropBox<PointXYZ>::Ptr crop_box (new CropBox<PointXYZ>);
+  crop_box->setMin (Eigen::Vector4f (min_pt[0], min_pt[1], min_pt[2], 1.0f));
+  crop_box->setMax (Eigen::Vector4f (center[0], max_pt[1], max_pt[2], 1.0f));
+  crop_box->setRotation (Eigen::Vector3f (0.0f, 0.0f, 0.1f));
+
+  FrustumCulling<PointXYZ>::Ptr frustum (new FrustumCulling<PointXYZ>);
+  Eigen::Matrix4f camera_pose = Eigen::Matrix4f::Identity ();
+  camera_pose.block<3, 1> (0, 3) = center.head<3> () - Eigen::Vector3f (0.5f, 0.0f, 0.0f);
+  frustum->setCameraPose (camera_pose);
+  frustum->setHorizontalFOV (20);
+  frustum->setVerticalFOV (20);
+  frustum->setNearPlaneDistance (0.0);
+  frustum->setFarPlaneDistance (10);
+
+  ExtractIndices<PointXYZ>::Ptr extract (new ExtractIndices<PointXYZ>);
+  IndicesPtr every_third (new std::vector<int>);
+  for (int i = 0; i < int (cloud->points.size ()); i += 3)
+    every_third->push_back (i);
+  extract->setIndices (every_third);
+  extract->setNegative (true);
+
+  RadiusOutlierRemoval<PointXYZ>::Ptr outrem (new RadiusOutlierRemoval<PointXYZ>);
+  outrem->setRadiusSearch (0.02);
+  outrem->setMinNeighborsInRadius (5);
+
+  // Reference: run the stages one after the other on the surviving indices
+  std::vector<int> expected (cloud->points.size ());
+  for (int i = 0; i < int (expected.size ()); ++i)
+    expected[i] = i;
+  std::vector<int> excluded (expected.size (), 0);
+  for (size_t i = 0; i < every_third->size (); ++i)
+    excluded[(*every_third)[i]] = 1;
+  FilterIndices<PointXYZ>::Ptr stages[] = {pass, crop_box, frustum, outrem};
+  for (int si = 0; si < 4; ++si)
+  {
+    if (si == 3)
+    {
+      std::vector<int> kept;
+      for (size_t i = 0; i < expected.size (); ++i)
+        if (!excluded[expected[i]])
+          kept.push_back (expected[i]);
+      expected.swap (kept);
+    }
+    IndicesPtr stage_indices (new std::vector<int> (expected));
+    stages[si]->setInputCloud (cloud);
+    stages[si]->setIndices (stage_indices);
+    stages[si]->filter (expected);
+  }
+  EXPECT_GT (int (expected.size ()), 0);
+  EXPECT_LT (expected.size (), cloud->points.size () / 4);
+  const IndicesPtr outrem_indices = outrem->getIndices ();
+
+  FilterChain<PointXYZ> chain (true);
+  chain.addFilter (pass);
+  chain.addFilter (crop_box);
+  chain.addFilter (frustum);
+  chain.addFilter (extract);
+  chain.addFilter (outrem);
+  EXPECT_EQ (chain.getNumberOfFilters (), 5);
+  chain.setInputCloud (cloud);
+
+  std::vector<int> indices;
+  chain.filter (indices);
+  EXPECT_EQ (indices, expected);
+  EXPECT_EQ (indices.size () + chain.getRemovedIndices ()->size (), cloud->points.size ());
+  // The stage that was not fused keeps its own indices
+  EXPECT_EQ (outrem->getIndices (), outrem_indices);
+
+  PointCloud<PointXYZ> output;
+  chain.filter (output);
+  ASSERT_EQ (output.points.size (), expected.size ());
+  EXPECT_EQ (output.points.back ().x, cloud->points[expected.back ()].x);
+
+  chain.setNegative (true);
+  chain.filter (indices);
+  EXPECT_EQ (indices.size (), cloud->points.size () - expected.size ());
+  EXPECT_EQ (*chain.getRemovedIndices (), expected);
+
+  // A stage without indices of its own is left without them, and indices outside of the
+  // input select no point
+  RadiusOutlierRemoval<PointXYZ>::Ptr outrem_all (new RadiusOutlierRemoval<PointXYZ>);
+  outrem_all->setRadiusSearch (0.02);
+  outrem_all->setMinNeighborsInRadius (5);
+  ExtractIndices<PointXYZ>::Ptr extract_invalid (new ExtractIndices<PointXYZ>);
+  IndicesPtr invalid (new std::vector<int>);
+  invalid->push_back (-1);
+  invalid->push_back (0);
+  invalid->push_back (int (cloud->points.size ()));
+  extract_invalid->setIndices (invalid);
+  extract_invalid->setNegative (true);
+
+  FilterChain<PointXYZ> second_chain;
+  second_chain.addFilter (extract_invalid);
+  second_chain.addFilter (outrem_all);
+  second_chain.setInputCloud (cloud);
+  second_chain.filter (indices);
+  EXPECT_FALSE (outrem_all->getIndices ());
+  ASSERT_FALSE (indices.empty ());
+  EXPECT_NE (indices[0], 0);
+  EXPECT_LE (indices.back (), int (cloud->points.size ()) - 1);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 TEST (ConditionalRemovalTfQuadraticXYZComparison, Filters)
 {
@@ -2022,6 +2700,79 @@ TEST (ConditionalRemovalTfQuadraticXYZComparison, Filters)
   EXPECT_EQ (input->points[5].z, output.points[5].z);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (ConditionalRemovalCompiled, Filters)
+{
+  // Random colored points, some of them invalid
+  PointCloud<PointXYZRGB>::Ptr input (new PointCloud<PointXYZRGB>);
+  input->width = 100;
+  input->height = 100;
+  input->is_dense = false;
+  input->points.resize (input->width * input->height);
+  srand (12345);
+  for (size_t i = 0; i < input->points.size (); ++i)
+  {
+    PointXYZRGB &p = input->points[i];
+    p.x = static_cast<float> (rand ()) / static_cast<float> (RAND_MAX) - 0.5f;
+    p.y = static_cast<float> (rand ()) / static_cast<float> (RAND_MAX) - 0.5f;
+    p.z = (i % 97 == 0) ? std::numeric_limits<float>::quiet_NaN () : static_cast<float> (rand ()) / static_cast<float> (RAND_MAX);
+    p.r = static_cast<uint8_t> (rand () % 256);
+    p.g = static_cast<uint8_t> (rand () % 256);
+    p.b = static_cast<uint8_t> (rand () % 256);
+  }
+
+  // (0.2 < z <= 0.8 AND (r > 128 OR hue < 0 OR (g == b OR x < 0))) mixes compiled and opaque steps
+  ConditionOr<PointXYZRGB>::Ptr nested_cond (new ConditionOr<PointXYZRGB> ());
+  nested_cond->addComparison (PackedRGBComparison<PointXYZRGB>::ConstPtr (new PackedRGBComparison<PointXYZRGB> ("g", ComparisonOps::EQ, 100.0)));
+  nested_cond->addComparison (FieldComparison<PointXYZRGB>::ConstPtr (new FieldComparison<PointXYZRGB> ("x", ComparisonOps::LT, 0.0)));
+  ConditionOr<PointXYZRGB>::Ptr color_cond (new ConditionOr<PointXYZRGB> ());
+  color_cond->addComparison (PackedRGBComparison<PointXYZRGB>::ConstPtr (new PackedRGBComparison<PointXYZRGB> ("r", ComparisonOps::GT, 128.0)));
+  color_cond->addComparison (PackedHSIComparison<PointXYZRGB>::ConstPtr (new PackedHSIComparison<PointXYZRGB> ("h", ComparisonOps::LT, 0.0)));
+  color_cond->addCondition (nested_cond);
+  ConditionAnd<PointXYZRGB>::Ptr cond (new ConditionAnd<PointXYZRGB> ());
+  cond->addComparison (FieldComparison<PointXYZRGB>::ConstPtr (new FieldComparison<PointXYZRGB> ("z", ComparisonOps::GT, 0.2)));
+  cond->addComparison (FieldComparison<PointXYZRGB>::ConstPtr (new FieldComparison<PointXYZRGB> ("z", ComparisonOps::LE, 0.8)));
+  cond->addCondition (color_cond);
+
+  // Reference: evaluate the tree point by point
+  std::vector<int> expected;
+  for (size_t i = 0; i < input->points.size (); ++i)
+    if (pcl_isfinite (input->points[i].z) && cond->evaluate (input->points[i]))
+      expected.push_back (static_cast<int> (i));
+  EXPECT_GT (expected.size (), 0);
+  EXPECT_LT (expected.size (), input->points.size ());
+
+  ConditionProgram<PointXYZRGB> program;
+  program.compile (*cond);
+  EXPECT_EQ (9, int (program.size ()));
+
+  ConditionalRemoval<PointXYZRGB> condrem (true);
+  condrem.setCondition (cond);
+  condrem.setInputCloud (input);
+  for (unsigned int nr_threads = 1; nr_threads <= 4; nr_threads += 3)
+  {
+    condrem.setNumberOfThreads (nr_threads);
+
+    PointCloud<PointXYZRGB> output;
+    condrem.setKeepOrganized (false);
+    condrem.filter (output);
+    ASSERT_EQ (expected.size (), output.points.size ());
+    for (size_t i = 0; i < expected.size (); ++i)
+      EXPECT_EQ (input->points[expected[i]].rgba, output.points[i].rgba);
+    EXPECT_EQ (input->points.size () - expected.size (), condrem.getRemovedIndices ()->size ());
+
+    condrem.setKeepOrganized (true);
+    condrem.filter (output);
+    ASSERT_EQ (input->points.size (), output.points.size ());
+    size_t nr_valid = 0;
+    for (size_t i = 0; i < output.points.size (); ++i)
+      if (pcl_isfinite (output.points[i].x))
+        ++nr_valid;
+    // The organized version evaluates invalid points as well, NaN never passes z > 0.2
+    EXPECT_EQ (expected.size (), nr_valid);
+  }
+}
+
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 TEST (MedianFilter, Filters)
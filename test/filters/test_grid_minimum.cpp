@@ -78,6 +78,45 @@ TEST (Grid, Minimum)
   EXPECT_EQ (gm.getResolution (), 2.0f);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (Grid, MinimumParallel)
+{
+  PointCloud<PointXYZ>::Ptr cloud_in (new PointCloud<PointXYZ>);
+  PointCloud<PointXYZ> cloud_out, cloud_out_single;
+
+  srand (42);
+  for (int i = 0; i < 20000; ++i)
+    cloud_in->push_back (PointXYZ (10.0f * static_cast<float> (rand ()) / static_cast<float> (RAND_MAX),
+                                   10.0f * static_cast<float> (rand ()) / static_cast<float> (RAND_MAX),
+                                   static_cast<float> (rand () % 100) / 10.0f));
+
+  GridMinimum<PointXYZ> gm (0.5f);
+  gm.setInputCloud (cloud_in);
+  gm.setNumberOfThreads (4);
+  gm.filter (cloud_out);
+  gm.setNumberOfThreads (1);
+  gm.filter (cloud_out_single);
+
+  // The result does not depend on the number of threads, even with ties in z
+  ASSERT_EQ (cloud_out.size (), cloud_out_single.size ());
+  for (size_t i = 0; i < cloud_out.size (); ++i)
+  {
+    EXPECT_EQ (cloud_out[i].x, cloud_out_single[i].x);
+    EXPECT_EQ (cloud_out[i].y, cloud_out_single[i].y);
+    EXPECT_EQ (cloud_out[i].z, cloud_out_single[i].z);
+  }
+
+  // Every cell is reported once with its minimum
+  EXPECT_EQ (cloud_out.size (), 400);
+  for (size_t i = 0; i < cloud_in->size (); ++i)
+  {
+    const PointXYZ &p = cloud_in->points[i];
+    for (size_t j = 0; j < cloud_out.size (); ++j)
+      if (floor (cloud_out[j].x * 2.0f) == floor (p.x * 2.0f) && floor (cloud_out[j].y * 2.0f) == floor (p.y * 2.0f))
+        EXPECT_LE (cloud_out[j].z, p.z);
+  }
+}
+
 /* ---[ */
 int
 main (int argc, char** argv)
@@ -39,6 +39,7 @@
 #include <gtest/gtest.h>
 
 #include <vector>
+#include <algorithm>
 
 #include <stdio.h>
 
@@ -1070,6 +1071,63 @@ TEST (PCL, Octree_Pointcloud_Change_Detector_Test)
 
 }
 
+TEST (PCL, Octree_Pointcloud_Change_Detector_Streaming_Test)
+{
+  srand (static_cast<unsigned int> (time (NULL)));
+
+  OctreePointCloudChangeDetector<PointXYZ> octree (0.1f);
+
+  // frame 1 covers x in [0, 2), frame 2 covers x in [1, 3)
+  PointCloud<PointXYZ>::Ptr frame1 (new PointCloud<PointXYZ> ());
+  PointCloud<PointXYZ>::Ptr frame2 (new PointCloud<PointXYZ> ());
+  for (int i = 0; i < 5000; i++)
+  {
+    PointXYZ p (static_cast<float> (1.0 * rand () / RAND_MAX),
+                static_cast<float> (1.0 * rand () / RAND_MAX),
+                static_cast<float> (1.0 * rand () / RAND_MAX));
+    frame1->push_back (p);
+    p.x += 1.0f;
+    frame1->push_back (p);
+    frame2->push_back (p);
+    p.x += 1.0f;
+    frame2->push_back (p);
+  }
+  OctreePointCloudChangeDetector<PointXYZ>::AlignedPointTVector new_centers, removed_centers;
+
+  octree.defineBoundingBox (0.0, 0.0, 0.0, 4.0, 4.0, 4.0);
+  octree.setInputCloud (frame1);
+  octree.addPointsFromInputCloud ();
+  octree.getChangedVoxelCenters (new_centers, removed_centers);
+  EXPECT_EQ (octree.getLeafCount (), new_centers.size ());
+  EXPECT_EQ (0, removed_centers.size ());
+
+  // keys computed in parallel result in the same voxels
+  OctreePointCloudPointVector<PointXYZ> reference (0.1f);
+  reference.defineBoundingBox (0.0, 0.0, 0.0, 4.0, 4.0, 4.0);
+  reference.setInputCloud (frame1);
+  reference.addPointsFromInputCloud ();
+  EXPECT_EQ (reference.getLeafCount (), octree.getLeafCount ());
+
+  octree.switchBuffers ();
+  octree.setInputCloud (frame2);
+  octree.addPointsFromInputCloud ();
+  octree.getChangedVoxelCenters (new_centers, removed_centers);
+
+  ASSERT_GT (new_centers.size (), 0);
+  ASSERT_GT (removed_centers.size (), 0);
+  for (size_t i = 0; i < new_centers.size (); ++i)
+    EXPECT_GT (new_centers[i].x, 2.0f);
+  for (size_t i = 0; i < removed_centers.size (); ++i)
+    EXPECT_LT (removed_centers[i].x, 1.0f);
+
+  // new point indices only refer to the part of frame 2 which was not observed before
+  vector<int> new_point_indices;
+  octree.getPointIndicesFromNewVoxels (new_point_indices);
+  ASSERT_GT (new_point_indices.size (), 0);
+  for (size_t i = 0; i < new_point_indices.size (); ++i)
+    EXPECT_GT (frame2->points[new_point_indices[i]].x, 2.0f);
+}
+
 TEST (PCL, Octree_Pointcloud_Voxel_Centroid_Test)
 {
 
@@ -1675,6 +1733,97 @@ TEST (PCL, Octree_Pointcloud_Adjacency)
   }
 }
 
+TEST (PCL, Octree_Pointcloud_Adjacency_Incremental)
+{
+  srand (static_cast<unsigned int> (time (NULL)));
+
+  const float resolution = 0.05f;
+  PointCloud<PointXYZ>::Ptr cloud_a (new PointCloud<PointXYZ> ());
+  PointCloud<PointXYZ>::Ptr cloud_b (new PointCloud<PointXYZ> ());
+  PointCloud<PointXYZ>::Ptr cloud_all (new PointCloud<PointXYZ> ());
+  //This is done to define the same grid for both octrees
+  cloud_a->push_back (PointXYZ (2, 2, 2));
+  cloud_a->push_back (PointXYZ (-2, -2, -2));
+  *cloud_all = *cloud_a;
+  for (int i = 0; i < 2000; ++i)
+  {
+    PointXYZ p (static_cast<float> (1.0 * rand () / RAND_MAX),
+                static_cast<float> (1.0 * rand () / RAND_MAX),
+                static_cast<float> (1.0 * rand () / RAND_MAX));
+    if (i % 2)
+      cloud_b->push_back (p);
+    else
+      cloud_a->push_back (p);
+    cloud_all->push_back (p);
+  }
+
+  OctreePointCloudAdjacency<PointXYZ> octree_full (resolution);
+  octree_full.setInputCloud (cloud_all);
+  octree_full.addPointsFromInputCloud ();
+
+  OctreePointCloudAdjacency<PointXYZ> octree_incremental (resolution);
+  octree_incremental.setInputCloud (cloud_a);
+  octree_incremental.addNewPointsFromInputCloud ();
+  const size_t first_batch_size = octree_incremental.size ();
+  octree_incremental.setInputCloud (cloud_b);
+  octree_incremental.addNewPointsFromInputCloud ();
+
+  ASSERT_GT (octree_incremental.size (), first_batch_size);
+  ASSERT_EQ (octree_incremental.getLeafCount (), octree_incremental.size ());
+
+  // adjacency does not depend on how the voxel grid was built
+  for (size_t i = 0; i < cloud_all->size (); ++i)
+  {
+    OctreePointCloudAdjacencyContainer<PointXYZ> *leaf_incremental = octree_incremental.getLeafContainerAtPoint (cloud_all->points[i]);
+    ASSERT_TRUE (leaf_incremental != NULL);
+    OctreePointCloudAdjacencyContainer<PointXYZ> *leaf_full = octree_full.getLeafContainerAtPoint (cloud_all->points[i]);
+    EXPECT_EQ (leaf_full->getPointCounter (), leaf_incremental->getPointCounter ());
+    EXPECT_EQ (leaf_full->size (), leaf_incremental->size ());
+  }
+  size_t nr_edges_full = 0, nr_edges_incremental = 0;
+  for (size_t i = 0; i < octree_full.size (); ++i)
+    nr_edges_full += octree_full.at (i)->size ();
+  for (size_t i = 0; i < octree_incremental.size (); ++i)
+    nr_edges_incremental += octree_incremental.at (i)->size ();
+  EXPECT_EQ (nr_edges_full, nr_edges_incremental);
+
+  // CSR export mirrors the neighbor lists
+  std::vector<int> row_offsets, neighbor_indices;
+  octree_incremental.getAdjacencyCSR (row_offsets, neighbor_indices);
+  ASSERT_EQ (octree_incremental.size () + 1, row_offsets.size ());
+  ASSERT_EQ (nr_edges_incremental, neighbor_indices.size ());
+  for (size_t i = 0; i < octree_incremental.size (); ++i)
+  {
+    ASSERT_EQ (octree_incremental.at (i)->size (), static_cast<size_t> (row_offsets[i + 1] - row_offsets[i]));
+    OctreePointCloudAdjacencyContainer<PointXYZ>::const_iterator neighbor_itr = octree_incremental.at (i)->cbegin ();
+    for (int j = row_offsets[i]; j < row_offsets[i + 1]; ++j, ++neighbor_itr)
+      EXPECT_EQ (*neighbor_itr, octree_incremental.at (neighbor_indices[j]));
+  }
+
+  // points outside of the current bounding box grow the octree, adjacency stays symmetric
+  PointCloud<PointXYZ>::Ptr cloud_c (new PointCloud<PointXYZ> ());
+  cloud_c->push_back (PointXYZ (10.0f, 0.0f, 0.0f));
+  cloud_c->push_back (PointXYZ (10.0f + resolution, 0.0f, 0.0f));
+  cloud_c->push_back (PointXYZ (1.0f + resolution, 0.5f, 0.5f));
+  const size_t second_batch_size = octree_incremental.size ();
+  octree_incremental.setInputCloud (cloud_c);
+  octree_incremental.addNewPointsFromInputCloud ();
+  ASSERT_LT (second_batch_size, octree_incremental.size ());
+  ASSERT_EQ (octree_incremental.getLeafCount (), octree_incremental.size ());
+  ASSERT_TRUE (octree_incremental.getLeafContainerAtPoint (cloud_c->points[0]) != NULL);
+  octree_incremental.getAdjacencyCSR (row_offsets, neighbor_indices);
+  for (size_t i = 0; i < octree_incremental.size (); ++i)
+  {
+    for (int j = row_offsets[i]; j < row_offsets[i + 1]; ++j)
+    {
+      const int neighbor = neighbor_indices[j];
+      EXPECT_TRUE (std::find (neighbor_indices.begin () + row_offsets[neighbor],
+                              neighbor_indices.begin () + row_offsets[neighbor + 1],
+                              static_cast<int> (i)) != neighbor_indices.begin () + row_offsets[neighbor + 1]);
+    }
+  }
+}
+
 TEST (PCL, Octree_Pointcloud_Bounds)
 {
     const double SOME_RESOLUTION (10 + 1/3.0);
@@ -66,6 +66,7 @@ using namespace pcl::outofcore;
 #include <boost/random/uniform_real.hpp>
 #include <boost/random/normal_distribution.hpp>
 #include <boost/foreach.hpp>
+#include <boost/thread/thread.hpp>
 
 /** \brief Unit tests for UR out of core octree code which test public interface of OutofcoreOctreeBase 
  */
@@ -949,6 +950,285 @@ TEST_F (OutofcoreTest, PointCloud2_Query)
   cleanUpFilesystem ();
 }
 
+//test that the disk container reads back the requested ranges and subsamples from its block reads
+TEST_F (OutofcoreTest, DiskContainer_ReadRange)
+{
+  cleanUpFilesystem ();
+
+  const boost::filesystem::path container_dir = filename_otreeA.parent_path ();
+  boost::filesystem::create_directory (container_dir);
+
+  AlignedPointTVector src;
+  for (size_t i = 0; i < 1000; i++)
+    src.push_back (PointT (static_cast<float> (i), 0.0f, 0.0f));
+
+  {
+    OutofcoreOctreeDiskContainer<PointT> container (container_dir);
+    container.insertRange (src);
+    container.insertRange (&src[0], 500);
+    ASSERT_EQ (1500, container.size ());
+
+    AlignedPointTVector dst;
+    container.readRange (990, 20, dst);
+    ASSERT_EQ (20, dst.size ());
+    for (size_t i = 0; i < dst.size (); i++)
+      EXPECT_TRUE (compPt (dst[i], src[(990 + i) % 1000]));
+
+    container.readRangeSubSample (0, container.size (), 0.1, dst);
+    EXPECT_EQ (150, dst.size ());
+
+    container.readRangeSubSample_bernoulli (0, container.size (), 1.0, dst);
+    ASSERT_EQ (1500, dst.size ());
+    for (size_t i = 0; i < dst.size (); i++)
+      EXPECT_TRUE (compPt (dst[i], src[i % 1000]));
+  }
+
+  cleanUpFilesystem ();
+}
+
+//test that the level-wise parallel insertion places every point in a node that contains it
+TEST_F (OutofcoreTest, Outofcore_ParallelBuild)
+{
+  cleanUpFilesystem ();
+
+  const Eigen::Vector3d min (-32.0, -32.0, -32.0);
+  const Eigen::Vector3d max (32.0, 32.0, 32.0);
+
+  boost::mt19937 rng (rngseed);
+  boost::uniform_real<float> dist (-32.0f, 31.9f);
+  boost::variate_generator<boost::mt19937&, boost::uniform_real<float> > die (rng, dist);
+
+  pcl::PointCloud<PointT>::Ptr test_cloud (new pcl::PointCloud<PointT> ());
+  for (size_t i = 0; i < numPts; i++)
+    test_cloud->points.push_back (PointT (die (), die (), die ()));
+  //points on the voxel boundaries and an invalid point
+  test_cloud->points.push_back (PointT (0.0f, 0.0f, 0.0f));
+  test_cloud->points.push_back (PointT (-16.0f, 8.0f, 16.0f));
+  test_cloud->points.push_back (PointT (std::numeric_limits<float>::quiet_NaN (), 0.0f, 0.0f));
+  test_cloud->width = static_cast<uint32_t> (test_cloud->points.size ());
+  test_cloud->height = 1;
+
+  pcl::PCLPointCloud2::Ptr blob (new pcl::PCLPointCloud2 ());
+  pcl::toPCLPointCloud2 (*test_cloud, *blob);
+
+  octree_disk octreeA (3, min, max, filename_otreeA, "ECEF");
+  octree_disk octreeB (3, min, max, filename_otreeB, "ECEF");
+  octreeA.setNumberOfThreads (4);
+  octreeB.setNumberOfThreads (4);
+
+  EXPECT_EQ (numPts + 2, octreeA.addPointCloud (blob, false));
+  EXPECT_EQ (numPts + 2, octreeB.addPointCloud_and_genLOD (blob));
+
+  boost::uint64_t total_points_b = 0;
+  for (boost::uint64_t depth = 0; depth <= octreeB.getDepth (); depth++)
+    total_points_b += octreeB.getNumPointsAtDepth (depth);
+  EXPECT_EQ (numPts + 2, total_points_b);
+  EXPECT_EQ (numPts + 2, octreeA.getNumPointsAtDepth (octreeA.getDepth ()));
+
+  octree_disk* trees[2] = { &octreeA, &octreeB };
+  for (int t = 0; t < 2; t++)
+  {
+    boost::uint64_t points_in_nodes = 0;
+    octree_disk::BreadthFirstIterator it (*trees[t]);
+    while (*it != 0)
+    {
+      octree_disk_node* node = *it;
+      it++;
+      if (!boost::filesystem::exists (node->getPCDFilename ()))
+        continue;
+
+      pcl::PCLPointCloud2::Ptr node_blob (new pcl::PCLPointCloud2 ());
+      node->read (node_blob);
+
+      pcl::PointCloud<PointT> node_cloud;
+      pcl::fromPCLPointCloud2 (*node_blob, node_cloud);
+
+      Eigen::Vector3d node_min, node_max;
+      node->getBoundingBox (node_min, node_max);
+      for (size_t i = 0; i < node_cloud.points.size (); i++)
+      {
+        const PointT& p = node_cloud.points[i];
+        EXPECT_TRUE (p.x >= node_min[0] && p.x < node_max[0] && p.y >= node_min[1] && p.y < node_max[1] && p.z >= node_min[2] && p.z < node_max[2]);
+      }
+      points_in_nodes += node_cloud.points.size ();
+    }
+    EXPECT_EQ (numPts + 2, points_in_nodes);
+  }
+
+  cleanUpFilesystem ();
+}
+
+//cache items whose byte size is simply their payload value
+class SizedCacheItem : public LRUCacheItem<size_t>
+{
+  public:
+    SizedCacheItem (size_t bytes, size_t timestamp)
+    {
+      this->item = bytes;
+      this->timestamp = timestamp;
+    }
+
+    virtual size_t
+    sizeOf () const
+    {
+      return (item);
+    }
+};
+
+TEST (PCL, Outofcore_LRUCache_ByteBudget)
+{
+  LRUCache<int, SizedCacheItem> cache (100);
+
+  EXPECT_TRUE (cache.insert (0, SizedCacheItem (40, 0)));
+  EXPECT_TRUE (cache.insert (1, SizedCacheItem (40, 1)));
+  EXPECT_EQ (80, cache.getSize ());
+
+  //key 0 is pinned, so making room for key 2 has to evict key 1
+  EXPECT_TRUE (cache.pin (0));
+  EXPECT_TRUE (cache.insert (2, SizedCacheItem (50, 2)));
+  EXPECT_TRUE (cache.hasKey (0));
+  EXPECT_FALSE (cache.hasKey (1));
+  EXPECT_EQ (90, cache.getSize ());
+  EXPECT_EQ (1, cache.getEvictions ());
+
+  //nothing but the pinned entry and key 2 can go; key 2 alone does not free enough
+  EXPECT_FALSE (cache.insert (3, SizedCacheItem (70, 3)));
+  EXPECT_FALSE (cache.insert (4, SizedCacheItem (101, 4)));
+
+  SizedCacheItem value (0, 0);
+  EXPECT_TRUE (cache.find (2, value));
+  EXPECT_EQ (50, value.item);
+  EXPECT_FALSE (cache.find (1, value));
+  EXPECT_EQ (1, cache.getHits ());
+  EXPECT_EQ (1, cache.getMisses ());
+
+  EXPECT_FALSE (cache.erase (0));
+  EXPECT_TRUE (cache.unpin (0));
+  cache.clear ();
+  EXPECT_EQ (0, cache.getNumberOfItems ());
+  EXPECT_EQ (0, cache.getSize ());
+}
+
+//test that queries served from the node cache match uncached queries and stay current after insertion
+TEST_F (OutofcoreTest, Outofcore_NodeCache_Query)
+{
+  cleanUpFilesystem ();
+
+  const Eigen::Vector3d min (-100.1, -100.1, -100.1);
+  const Eigen::Vector3d max (100.1, 100.1, 100.1);
+  const Eigen::Vector3d qmin (-60.0, -60.0, -60.0);
+  const Eigen::Vector3d qmax (-20.0, -20.0, -20.0);
+
+  AlignedPointTVector src;
+  for (size_t i = 0; i < numPts; i++)
+    src.push_back (PointT (static_cast<float> (i % 100) - 50, static_cast<float> (i % 100) - 50, static_cast<float> (i % 100) - 50));
+
+  octree_disk octreeA (2, min, max, filename_otreeA, "ECEF");
+  octreeA.addDataToLeaf (src);
+
+  AlignedPointTVector uncached;
+  octreeA.queryBBIncludes (qmin, qmax, octreeA.getDepth (), uncached);
+  ASSERT_FALSE (octreeA.getNodeCache ());
+
+  octreeA.setNodeCacheCapacity (64 * 1024 * 1024);
+  boost::shared_ptr<octree_disk::NodeCache> cache = octreeA.getNodeCache ();
+  ASSERT_TRUE (cache);
+
+  AlignedPointTVector first, second;
+  octreeA.queryBBIncludes (qmin, qmax, octreeA.getDepth (), first);
+  const size_t misses = cache->getMisses ();
+  EXPECT_GT (misses, 0);
+  EXPECT_EQ (0, cache->getHits ());
+
+  octreeA.queryBBIncludes (qmin, qmax, octreeA.getDepth (), second);
+  EXPECT_EQ (misses, cache->getMisses ());
+  EXPECT_EQ (misses, cache->getHits ());
+
+  ASSERT_EQ (uncached.size (), first.size ());
+  ASSERT_EQ (uncached.size (), second.size ());
+  for (size_t i = 0; i < uncached.size (); i++)
+  {
+    EXPECT_TRUE (compPt (uncached[i], first[i]));
+    EXPECT_TRUE (compPt (uncached[i], second[i]));
+  }
+
+  //appending to a cached node must not return the stale point set
+  octreeA.addDataToLeaf (src);
+  AlignedPointTVector third;
+  octreeA.queryBBIncludes (qmin, qmax, octreeA.getDepth (), third);
+  EXPECT_EQ (2 * uncached.size (), third.size ());
+
+  cleanUpFilesystem ();
+}
+
+//runs the same bounding box query repeatedly and counts the results that differ from the reference
+void
+queryRepeatedly (const octree_disk* octree, const Eigen::Vector3d* qmin, const Eigen::Vector3d* qmax,
+                 const AlignedPointTVector* reference, int iterations, int* mismatches)
+{
+  for (int i = 0; i < iterations; i++)
+  {
+    AlignedPointTVector result;
+    octree->queryBBIncludes (*qmin, *qmax, octree->getDepth (), result);
+    if (result.size () != reference->size ())
+    {
+      (*mismatches)++;
+      continue;
+    }
+    for (size_t j = 0; j < result.size (); j++)
+    {
+      if (!compPt (result[j], (*reference)[j]))
+      {
+        (*mismatches)++;
+        break;
+      }
+    }
+  }
+}
+
+//test that concurrent queries read the node payloads without disturbing each other, with and without the node cache
+TEST_F (OutofcoreTest, Outofcore_ConcurrentQuery)
+{
+  cleanUpFilesystem ();
+
+  const Eigen::Vector3d min (-100.1, -100.1, -100.1);
+  const Eigen::Vector3d max (100.1, 100.1, 100.1);
+  const Eigen::Vector3d qmin (-60.0, -60.0, -60.0);
+  const Eigen::Vector3d qmax (40.0, 40.0, 40.0);
+
+  AlignedPointTVector src;
+  for (size_t i = 0; i < numPts; i++)
+    src.push_back (PointT (static_cast<float> (i % 100) - 50, static_cast<float> (i % 97) - 50, static_cast<float> (i % 89) - 50));
+
+  octree_disk octreeA (2, min, max, filename_otreeA, "ECEF");
+  octreeA.addDataToLeaf (src);
+
+  AlignedPointTVector reference;
+  octreeA.queryBBIncludes (qmin, qmax, octreeA.getDepth (), reference);
+  ASSERT_FALSE (reference.empty ());
+
+  const int nr_threads = 8;
+  const int iterations = 20;
+  //no cache, then a cache too small to hold every node so entries keep being evicted and reloaded
+  const size_t capacities[2] = { 0, reference.size () * sizeof (PointT) / 4 };
+  for (int c = 0; c < 2; c++)
+  {
+    if (capacities[c] > 0)
+      octreeA.setNodeCacheCapacity (capacities[c]);
+
+    std::vector<int> mismatches (nr_threads, 0);
+    boost::thread_group threads;
+    for (int t = 0; t < nr_threads; t++)
+      threads.create_thread (boost::bind (&queryRepeatedly, &octreeA, &qmin, &qmax, &reference, iterations, &mismatches[t]));
+    threads.join_all ();
+
+    for (int t = 0; t < nr_threads; t++)
+      EXPECT_EQ (0, mismatches[t]);
+  }
+
+  cleanUpFilesystem ();
+}
+
 /* [--- */
 int
 main (int argc, char** argv)
@@ -37,6 +37,7 @@
 
 #include <gtest/gtest.h>
 #include <pcl/search/brute_force.h>
+#include <pcl/search/brute_force_soa.h>
 #include <pcl/search/kdtree.h>
 #include <pcl/search/organized.h>
 #include <pcl/search/octree.h>
@@ -395,6 +396,12 @@ testRadiusSearch (typename PointCloud<PointT>::ConstPtr point_cloud, vector<sear
         passed [sIdx] = passed [sIdx] && testUniqueness (indices [sIdx], search_methods [sIdx]->getName ());
         passed [sIdx] = passed [sIdx] && testOrder (distances [sIdx], search_methods [sIdx]->getName ());
         passed [sIdx] = passed [sIdx] && testResultValidity<PointT>(point_cloud, indices_mask, nan_mask, indices [sIdx], input_indices, search_methods [sIdx]->getName ());
+
+        // counting must agree with the collected neighbors, also when stopping early
+        int count = search_methods [sIdx]->radiusSearchCount (point_cloud->points[*qIt], radius);
+        int bounded_count = search_methods [sIdx]->radiusSearchCount (point_cloud->points[*qIt], radius, 3);
+        passed [sIdx] = passed [sIdx] && count == static_cast<int> (indices [sIdx].size ());
+        passed [sIdx] = passed [sIdx] && bounded_count == std::min (count, 3);
       }
       
       // compare results to each other
@@ -519,6 +526,40 @@ TEST (PCL, Organized_Sparse_View_Radius)
 }
 #endif
 
+TEST (PCL, unorganized_sparse_cloud_BruteForceSoA)
+{
+  pcl::PointCloudSoA<pcl::PointXYZ>::Ptr soa (new pcl::PointCloudSoA<pcl::PointXYZ> (*unorganized_sparse_cloud));
+  pcl::search::BruteForceSoA<pcl::PointXYZ> soa_search (true);
+  soa_search.setInputCloud (soa);
+  pcl::search::BruteForce<pcl::PointXYZ> reference (true);
+  reference.setInputCloud (unorganized_sparse_cloud);
+
+  std::vector<int> indices, ref_indices;
+  std::vector<float> distances, ref_distances;
+  for (size_t q = 0; q < unorganized_sparse_cloud_query_indices.size (); ++q)
+  {
+    const PointXYZ& query = unorganized_sparse_cloud->points[unorganized_sparse_cloud_query_indices[q]];
+
+    soa_search.nearestKSearch (query, 10, indices, distances);
+    reference.nearestKSearch (query, 10, ref_indices, ref_distances);
+    EXPECT_EQ (ref_indices, indices);
+    for (size_t i = 0; i < distances.size (); ++i)
+      EXPECT_NEAR (ref_distances[i], distances[i], 1e-6);
+
+    soa_search.radiusSearch (query, 0.05, indices, distances);
+    reference.radiusSearch (query, 0.05, ref_indices, ref_distances);
+    ASSERT_EQ (ref_indices.size (), indices.size ());
+    for (size_t i = 0; i < distances.size (); ++i)
+      EXPECT_NEAR (ref_distances[i], distances[i], 1e-6);
+
+    // Bounded search returns the closest max_nn neighbors
+    soa_search.radiusSearch (query, 0.05, indices, distances, 3);
+    EXPECT_EQ (std::min<size_t> (3, ref_indices.size ()), indices.size ());
+    for (size_t i = 0; i < indices.size (); ++i)
+      EXPECT_EQ (ref_indices[i], indices[i]);
+  }
+}
+
 /** \brief create subset of point in cloud to use as query points
   * \param[out] query_indices resulting query indices - not guaranteed to have size of query_count but guaranteed not to exceed that value
   * \param cloud input cloud required to check for nans and to get number of points